@@ -1,5 +1,6 @@
 #include <iostream>
 #include <Renderer/RenderingApp.h>
+#include "Trace.h"
 //bool VKfoo();
 
 
@@ -7,6 +8,8 @@ int main() {
 	//std::cout << VKfoo() << "\n";
 	VulkanRenderApp app(1920,1080);
 	app.initRt();
+	// Solo escribe algo si se compilo con RENDERER_TRACING
+	trace::writeChromeTrace("trace.json");
 
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,150 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @brief Mesh in the layout of defineMesh, already welded and reordered by MeshOptimizer
+ */
+struct AssetMesh {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<uint32_t> indices;
+};
+
+/**
+ * @brief Placement of an AssetMesh (one glTF node per primitive). OBJ files have none
+ */
+struct AssetInstance {
+    size_t mesh;
+    glm::mat4 transform;
+    glm::vec3 color;
+};
+
+/**
+ * @brief Result of parsing one model file
+ */
+struct LoadedAsset {
+    std::string path;
+    bool ok = false;                    ///< false if the file could not be read or parsed
+    bool cached = false;                ///< true if it came from the .meshcache
+    double parseMs = 0.0;               ///< time spent on the worker, queue time not included
+    std::vector<AssetMesh> meshes;
+    std::vector<AssetInstance> instances;
+    glm::vec3 boundsMin = glm::vec3(0.0f);  ///< bounds of the whole model, instances applied
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+};
+
+/**
+ * @brief Asynchronous model loading service. The parse stage of each file (mesh cache, OBJ parser, glTF import and
+ * MeshOptimizer) runs on a fixed pool of worker threads and the result comes back as a future, so a scene with
+ * several models loads in about the time of the largest one. Device uploads are not done here: defineMesh is not
+ * thread safe, so the caller consumes the futures with ForEachReady and defines each model as soon as it arrives
+ */
+class AssetLoader {
+public:
+    /**
+     * @param threads worker threads, 0 = std::thread::hardware_concurrency()
+     */
+    explicit AssetLoader(unsigned int threads = 0);
+
+    /**
+     * @brief Waits for the queued loads and joins the workers
+     */
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    /**
+     * @brief Queues the load of a model (.obj, .gltf or .glb)
+     * @param path file path
+     * @param useCache read / write <path>.meshcache
+     * @return future of the parsed model
+     */
+    std::future<LoadedAsset> load(const std::string& path, bool useCache = true);
+
+    /**
+     * @brief Queues several models at once
+     * @return one future per path, in the same order
+     */
+    std::vector<std::future<LoadedAsset>> loadAll(const std::vector<std::string>& paths, bool useCache = true);
+
+    /**
+     * @brief Parses a model on the calling thread. This is what the workers run
+     * @param path file path
+     * @param useCache read / write <path>.meshcache
+     * @param out parsed model
+     * @return out.ok
+     */
+    static bool Load(const std::string& path, bool useCache, LoadedAsset& out);
+
+    /**
+     * @brief OBJ path of Load: mesh cache or ObjParser + MeshOptimizer, one mesh
+     */
+    static bool LoadOBJ(const std::string& path, bool useCache, LoadedAsset& out);
+
+    /**
+     * @brief glTF path of Load: mesh cache or tinygltf + GLTFHelper + MeshOptimizer, one mesh per primitive and
+     * one instance per primitive of each node
+     */
+    static bool LoadGLTF(const std::string& path, bool useCache, LoadedAsset& out);
+
+    /**
+     * @brief Fills out.boundsMin / boundsMax from the meshes and their instances (each mesh once at the origin
+     * when there are none)
+     */
+    static void ComputeBounds(LoadedAsset& out);
+
+    /**
+     * @brief Calls fn(index, asset) for every future in the order in which they complete, on the calling thread
+     * @param futures futures returned by load / loadAll (all of them are consumed)
+     * @param fn callback, typically the defineMesh of the model
+     */
+    template<typename Fn>
+    static void ForEachReady(std::vector<std::future<LoadedAsset>>& futures, Fn fn) {
+        std::vector<bool> done(futures.size(), false);
+        size_t remaining = futures.size();
+        while (remaining > 0) {
+            bool progress = false;
+            for (size_t i = 0; i < futures.size(); i++) {
+                if (done[i] || futures[i].wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+                    continue;
+                }
+                LoadedAsset asset = futures[i].get();
+                fn(i, asset);
+                done[i] = true;
+                remaining--;
+                progress = true;
+            }
+            // Nada listo: esperar un poco a la primera pendiente en vez de girar
+            if (!progress) {
+                for (size_t i = 0; i < futures.size(); i++) {
+                    if (!done[i]) {
+                        futures[i].wait_for(std::chrono::milliseconds(1));
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+};
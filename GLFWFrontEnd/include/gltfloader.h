@@ -1,12 +1,68 @@
 #pragma once
 #include <glm/ext.hpp>
 #include <vector>
-#include <windows.data.json.h>
 #include <tiny_gltf.h>
 #include <stdio.h> // fprintf, stderr
 #include <stdlib.h>
+#include <string.h>
 #include <iostream>
 
+/**
+ * @brief Typed view of a glTF accessor inside its buffer, without copying. Honors bufferView.byteStride, so it
+ * reads interleaved vertex buffers correctly
+ */
+template <typename T>
+struct AccessorView {
+    const unsigned char* data = nullptr;
+    size_t count = 0;
+    size_t stride = 0;
+
+    bool empty() const { return data == nullptr; }
+    bool isContiguous() const { return stride == sizeof(T); }
+
+    // memcpy: en buffers entrelazados los elementos no tienen por que estar alineados
+    T operator[](size_t i) const {
+        T value;
+        memcpy(&value, data + i * stride, sizeof(T));
+        return value;
+    }
+
+    /**
+     * @brief Copies the elements to out (count elements), in a single memcpy when the accessor is tightly packed
+     */
+    void copyTo(T* out) const {
+        if (isContiguous()) {
+            memcpy(out, data, count * sizeof(T));
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            memcpy(out + i, data + i * stride, sizeof(T));
+        }
+    }
+};
+
+/**
+ * @brief Geometry of one glTF primitive, in the layout of Renderer::defineMesh
+ */
+struct GLTFPrimitiveData {
+    int mesh = -1;          ///< index in model.meshes
+    int primitive = -1;     ///< index in model.meshes[mesh].primitives
+    int material = -1;
+    bool valid = false;     ///< false if the primitive was skipped (not triangles, unsupported format...)
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<uint32_t> indices;
+};
+
+/**
+ * @brief One node of a glTF scene that references a mesh, with its world transform
+ */
+struct GLTFInstance {
+    int node = -1;
+    int mesh = -1;
+    glm::mat4 transform = glm::mat4(1.0f);
+};
 
 class GLTFHelper {
 public:
@@ -15,4 +71,62 @@ public:
         std::vector<glm::vec3>& outNormals,
         std::vector<glm::vec2>& outUVs,
         std::vector<uint32_t>& outIndices);
-};
\ No newline at end of file
+
+    /**
+     * @brief Decodes the EXT_meshopt_compression buffer views into their (fallback) buffers, in parallel. Call it
+     * after loading and before extracting; a model without compressed views is left untouched
+     * @param model loaded model
+     * @param threads worker threads, 0 = every core (an AssetLoader worker's share of them)
+     * @return false if a compressed view is malformed
+     */
+    bool DecompressBufferViews(tinygltf::Model& model, unsigned int threads = 0);
+
+    /**
+     * @brief Extracts every primitive of every mesh, in parallel (largest primitives first). Attributes can be
+     * float or KHR_mesh_quantization integers, which are converted straight into the output arrays
+     * @param model loaded model
+     * @param out one entry per primitive, in mesh / primitive order
+     * @param threads worker threads, 0 = every core (an AssetLoader worker's share of them)
+     * @return number of valid primitives
+     */
+    size_t ExtractPrimitives(const tinygltf::Model& model, std::vector<GLTFPrimitiveData>& out, unsigned int threads = 0);
+
+    /**
+     * @brief Walks the node hierarchy of a scene and returns one instance per node with a mesh. A mesh referenced
+     * by several nodes is meant to be defined once and added once per instance
+     * @param model loaded model
+     * @param out instances, in depth-first order
+     * @param scene scene index, -1 = model.defaultScene (or the first scene). A model without scenes uses the
+     * nodes that are nobody's child as roots, and one without nodes every mesh at the origin
+     * @return number of instances
+     */
+    size_t CollectInstances(const tinygltf::Model& model, std::vector<GLTFInstance>& out, int scene = -1);
+
+    /**
+     * @brief Local transform of a node: its matrix, or translation * rotation * scale
+     */
+    static glm::mat4 NodeTransform(const tinygltf::Node& node);
+
+    /**
+     * @brief Base color factor of a material (white without material)
+     */
+    static glm::vec3 MaterialColor(const tinygltf::Model& model, int material);
+
+    /**
+     * @brief Typed view of an accessor
+     * @param model loaded model
+     * @param accessorIndex accessor
+     * @param view view of the accessor elements (sizeof(T) bytes each)
+     * @return false if the accessor is sparse, has no buffer view or falls outside its buffer
+     */
+    template <typename T>
+    static bool GetAccessorView(const tinygltf::Model& model, int accessorIndex, AccessorView<T>& view) {
+        return AccessorData(model, accessorIndex, sizeof(T), view.data, view.stride, view.count);
+    }
+
+private:
+    static bool ReadAttribute(const tinygltf::Model& model, int accessorIndex, int type, float* out, const char* name);
+
+    static bool AccessorData(const tinygltf::Model& model, int accessorIndex, size_t elementSize,
+        const unsigned char*& data, size_t& stride, size_t& count);
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <stddef.h>
+#include <string>
+
+/**
+ * @brief Read-only memory mapping of a whole file (MapViewOfFile on Windows, mmap elsewhere). The pages are
+ * loaded by the OS as they are touched, so several threads can parse different parts of the file without copies
+ */
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps the file, closing the previous one
+     * @param path file path
+     * @return false if the file cannot be opened or mapped. An empty file is opened with size() == 0
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Unmaps the file. data() is no longer valid
+     */
+    void close();
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool isOpen() const { return m_open; }
+
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_open = false;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
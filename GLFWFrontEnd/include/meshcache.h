@@ -0,0 +1,149 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "mappedfile.h"
+
+/**
+ * @brief Range of one submesh (an OBJ file or a glTF primitive) inside the cached arrays. Its indices are
+ * relative to firstVertex, so every submesh can be passed to defineMesh on its own
+ */
+struct MeshCacheSubmesh {
+    uint32_t firstVertex;
+    uint32_t vertexCount;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+
+/**
+ * @brief Placement of a submesh in the source scene (a glTF node). A submesh can have several instances
+ */
+struct MeshCacheInstance {
+    glm::mat4 transform;
+    uint32_t submesh;
+    glm::vec3 color;
+};
+
+/**
+ * @brief Post-import geometry of a whole source file, ready for defineMesh. Without instances every submesh is
+ * placed once at the origin
+ */
+struct MeshCacheData {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<uint32_t> indices;
+    std::vector<MeshCacheSubmesh> submeshes;
+    std::vector<MeshCacheInstance> instances;
+
+    /**
+     * @brief Appends one mesh as a new submesh and computes its bounds
+     * @return false if the attribute arrays do not have the same size
+     */
+    bool addSubmesh(const std::vector<glm::vec3>& vtcs, const std::vector<glm::vec3>& nrmls,
+        const std::vector<glm::vec2>& uv, const std::vector<uint32_t>& inds);
+};
+
+/**
+ * @brief Versioned binary container of imported meshes ("<source>.meshcache" next to the source file).
+ *
+ * The file is a 64-byte header (magic, version, size / modification time / hash of the source, bounds) followed by
+ * a table of typed sections (positions, normals, UVs, indices, submeshes, optional instances), 16-byte aligned, so
+ * a later load is a memory mapping and a few copies. Unknown section types are skipped, so new optional sections can be added
+ * without breaking older readers. The cache is valid while the source keeps its size and modification time; if
+ * only the time changed (a copy, a checkout) the source is hashed and the cache kept when the contents match.
+ * A .gltf is checked the same way against every external buffer it references
+ */
+class MeshCache {
+public:
+    // 2: geometria soldada y reordenada por MeshOptimizer
+    // 3: seccion opcional de instancias (jerarquia de nodos glTF)
+    // 4: seccion de buffers externos de los .gltf
+    // 5: limites de la cabecera con las instancias aplicadas
+    static const uint32_t Version = 5;
+
+    /**
+     * @brief Cache file used for a source file
+     * @param sourcePath OBJ / glTF path
+     * @return sourcePath + ".meshcache"
+     */
+    static std::string CachePath(const std::string& sourcePath);
+
+    /**
+     * @brief Maps the cache of a source file and checks it against the source
+     * @param sourcePath OBJ / glTF path
+     * @return false if there is no cache, it is stale, from another version or corrupt
+     */
+    bool open(const std::string& sourcePath);
+
+    /**
+     * @brief Reads only the header of the cache: the bounds of the whole source (instances applied), without
+     * mapping the file or validating its contents. Meant for placeholders before the real load
+     * @param sourcePath OBJ / glTF path
+     * @return false if there is no cache, it is from another version, or the source size or modification time changed
+     */
+    static bool ReadBounds(const std::string& sourcePath, glm::vec3& bmin, glm::vec3& bmax);
+
+    /**
+     * @brief Unmaps the cache
+     */
+    void close();
+
+    bool isOpen() const { return m_file.isOpen(); }
+    size_t submeshCount() const { return m_submeshCount; }
+    const MeshCacheSubmesh& submesh(size_t i) const { return m_submeshes[i]; }
+    const glm::vec3& boundsMin() const { return m_boundsMin; }
+    const glm::vec3& boundsMax() const { return m_boundsMax; }
+    size_t instanceCount() const { return m_instanceCount; }
+    const MeshCacheInstance& instance(size_t i) const { return m_instances[i]; }
+
+    /**
+     * @brief Copies one submesh out of the mapping, in the layout of defineMesh
+     * @param i submesh index
+     */
+    void copySubmesh(size_t i, std::vector<glm::vec3>& vtcs, std::vector<glm::vec3>& nrmls,
+        std::vector<glm::vec2>& uv, std::vector<uint32_t>& inds) const;
+
+    /**
+     * @brief Copies the whole cache
+     * @param out geometry and submeshes
+     */
+    void copyAll(MeshCacheData& out) const;
+
+    /**
+     * @brief Writes the cache of a source file. Written to a temporary file with a unique name and renamed, so a
+     * concurrent reader never maps a partial cache and concurrent writers do not clobber each other
+     * @param sourcePath OBJ / glTF path the data was imported from
+     * @param data imported geometry
+     * @return false if the source cannot be read or the cache cannot be written (e.g. read-only asset folder)
+     */
+    static bool write(const std::string& sourcePath, const MeshCacheData& data);
+
+    /**
+     * @brief 64-bit hash of a byte range, the one stored in the header
+     * @param data bytes
+     * @param size size in bytes
+     * @return hash
+     */
+    static uint64_t Hash(const void* data, size_t size);
+
+private:
+    MappedFile m_file;
+    const glm::vec3* m_vertices = nullptr;
+    const glm::vec3* m_normals = nullptr;
+    const glm::vec2* m_uvs = nullptr;
+    const uint32_t* m_indices = nullptr;
+    const MeshCacheSubmesh* m_submeshes = nullptr;
+    const MeshCacheInstance* m_instances = nullptr;
+    size_t m_vertexCount = 0;
+    size_t m_indexCount = 0;
+    size_t m_submeshCount = 0;
+    size_t m_instanceCount = 0;
+    glm::vec3 m_boundsMin = glm::vec3(0.0f);
+    glm::vec3 m_boundsMax = glm::vec3(0.0f);
+};
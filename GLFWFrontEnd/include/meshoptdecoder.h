@@ -0,0 +1,56 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Decoders of the EXT_meshopt_compression bitstreams (the meshoptimizer codecs): attribute buffers
+ * (mode ATTRIBUTES), triangle lists (TRIANGLES) and index sequences (INDICES), plus the post-decode filters
+ */
+class MeshoptDecoder {
+public:
+    enum Filter {
+        FILTER_NONE,
+        FILTER_OCTAHEDRAL,
+        FILTER_QUATERNION,
+        FILTER_EXPONENTIAL
+    };
+
+    /**
+     * @brief Decodes an attribute buffer (mode ATTRIBUTES)
+     * @param destination count * stride bytes
+     * @param count number of elements
+     * @param stride element size, multiple of 4 and at most 256
+     * @param buffer compressed data
+     * @param size compressed size
+     * @return false if the data is malformed
+     */
+    static bool DecodeVertexBuffer(void* destination, size_t count, size_t stride, const unsigned char* buffer, size_t size);
+
+    /**
+     * @brief Decodes a triangle list (mode TRIANGLES)
+     * @param destination count indices of indexSize bytes
+     * @param count number of indices, multiple of 3
+     * @param indexSize 2 or 4
+     * @return false if the data is malformed
+     */
+    static bool DecodeIndexBuffer(void* destination, size_t count, size_t indexSize, const unsigned char* buffer, size_t size);
+
+    /**
+     * @brief Decodes an index sequence (mode INDICES)
+     * @param destination count indices of indexSize bytes
+     * @param count number of indices
+     * @param indexSize 2 or 4
+     * @return false if the data is malformed
+     */
+    static bool DecodeIndexSequence(void* destination, size_t count, size_t indexSize, const unsigned char* buffer, size_t size);
+
+    /**
+     * @brief Applies a filter in place to decoded attributes
+     * @param filter filter of the buffer view
+     * @param data decoded elements
+     * @param count number of elements
+     * @param stride element size (4 or 8 for octahedral, 8 for quaternion, multiple of 4 for exponential)
+     * @return false if the stride is not valid for the filter
+     */
+    static bool ApplyFilter(Filter filter, void* data, size_t count, size_t stride);
+};
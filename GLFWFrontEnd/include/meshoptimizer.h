@@ -0,0 +1,68 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @brief Tolerances of MeshOptimizer::WeldVertices. Two vertices are merged when all three attributes are within them
+ */
+struct WeldOptions {
+    float positionTolerance = 1e-6f;    ///< distance, relative to the diagonal of the mesh bounds
+    float normalTolerance = 0.999f;     ///< minimum cosine between the normals (0.999 = about 2.5 degrees)
+    float uvTolerance = 1e-4f;          ///< per-component UV difference
+};
+
+/**
+ * @brief Import-time mesh optimization for the layout of defineMesh (separate position, normal and UV arrays plus
+ * 32-bit indices): vertex welding on a hash grid, triangle reordering for the post-transform vertex cache and
+ * vertex reordering for fetch locality. Fewer and better ordered vertices mean smaller device buffers, faster
+ * BLAS builds and more coherent fetches in the hit shaders
+ */
+class MeshOptimizer {
+public:
+    /**
+     * @brief Weld + vertex cache + vertex fetch, logging the before / after counts
+     */
+    static void Optimize(std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& normals, std::vector<glm::vec2>& uvs,
+        std::vector<uint32_t>& indices, const WeldOptions& options = WeldOptions());
+
+    /**
+     * @brief Merges vertices within the tolerances in O(n): each vertex only looks at the grid cells that overlap
+     * its tolerance box. Triangles that become degenerate are removed
+     * @return number of vertices removed
+     */
+    static size_t WeldVertices(std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& normals, std::vector<glm::vec2>& uvs,
+        std::vector<uint32_t>& indices, const WeldOptions& options = WeldOptions());
+
+    /**
+     * @brief Reorders the triangles for a post-transform vertex cache (Forsyth's linear-speed algorithm)
+     * @param indices triangle list, reordered in place
+     * @param vertexCount number of vertices referenced by the indices
+     */
+    static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+    /**
+     * @brief Renumbers the vertices in order of first use by the indices, so consecutive triangles read nearby
+     * memory. Unreferenced vertices are dropped
+     */
+    static void OptimizeVertexFetch(std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& normals, std::vector<glm::vec2>& uvs,
+        std::vector<uint32_t>& indices);
+
+    /**
+     * @brief Average cache miss ratio (transformed vertices per triangle) of a FIFO cache, between 0.5 and 3
+     * @param indices triangle list
+     * @param vertexCount number of vertices
+     * @param cacheSize FIFO size
+     * @return ACMR
+     */
+    static float AverageCacheMissRatio(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 32);
+
+    /**
+     * @brief Number of distinct positions, two positions being equal when closer than epsilon. O(n) on a hash grid
+     * @param vertices positions
+     * @param epsilon absolute distance
+     * @return distinct positions
+     */
+    static size_t CountUniquePositions(const std::vector<glm::vec3>& vertices, float epsilon);
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @brief Options of ObjParser. The defaults give the same layout as OBJLoader's Assimp import
+ * (aiProcess_FlipUVs and aiProcess_GenSmoothNormals)
+ */
+struct ObjParseOptions {
+    unsigned int threads = 0;       ///< worker threads, 0 = every core (an AssetLoader worker's share of them)
+    bool flipUVs = true;            ///< v = 1 - v
+    bool generateNormals = true;    ///< smooth, area-weighted normals for the vertices without vn
+};
+
+/**
+ * @brief Indexed mesh in the layout that Renderer::defineMesh expects: one normal and one UV per vertex
+ */
+struct ObjMeshData {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<uint32_t> indices;
+};
+
+/**
+ * @brief Native Wavefront OBJ parser for large files. The file is memory mapped and split into chunks at line
+ * boundaries; the v/vn/vt/f records of each chunk are parsed on its own thread with hand-written number parsing.
+ * Polygons are triangulated as fans, every distinct v/vt/vn corner becomes one vertex (numbered in order of first
+ * use) and all the objects and groups are merged into a single mesh. Materials, lines and points are ignored
+ */
+class ObjParser {
+public:
+    /**
+     * @brief Parses an OBJ file
+     * @param path file path
+     * @param out parsed mesh (cleared first)
+     * @param options parse options
+     * @return false if the file cannot be read, has a malformed record or an index out of range
+     */
+    bool parse(const std::string& path, ObjMeshData& out, const ObjParseOptions& options = ObjParseOptions());
+
+    /**
+     * @brief Parses OBJ text already in memory
+     * @param data text (not necessarily null terminated)
+     * @param size size in bytes
+     * @param out parsed mesh (cleared first)
+     * @param options parse options
+     * @return false on a malformed record or an index out of range
+     */
+    bool parseMemory(const char* data, size_t size, ObjMeshData& out, const ObjParseOptions& options = ObjParseOptions());
+};
@@ -0,0 +1,105 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Renderer.h"
+#include "assetloader.h"
+
+/**
+ * @brief Where a streamed model goes once it is resident
+ */
+struct StreamPlacement {
+    glm::mat4 transform = glm::mat4(1.0f);
+    glm::vec3 color = glm::vec3(1.0f);
+    bool light = false;                     ///< addLight instead of addMesh
+    Renderer::LightId lightId = 0;
+    Renderer::TextureId textureId = 0;
+};
+
+/**
+ * @brief Progressive scene loading: the scene is rendered while its models are still parsing. Models are parsed on
+ * the AssetLoader pool; update() (once per frame, before render) defines the meshes that have arrived within a time
+ * budget and adds the instances of a model once all its meshes are defined, so every frame only pays for a batch
+ * of new BLASes. Until then each placement shows a bounding box proxy: from the header of the mesh cache when there
+ * is one, otherwise from the parsed bounds while the meshes of a large model are still being defined
+ */
+class SceneStreamer {
+public:
+    /**
+     * @param renderer renderer that receives the meshes (used from the calling thread only)
+     * @param threads parse threads, 0 = std::thread::hardware_concurrency()
+     */
+    explicit SceneStreamer(Renderer& renderer, unsigned int threads = 0);
+
+    /**
+     * @brief Queues a model (.obj, .gltf or .glb) and adds its proxies
+     * @param path file path
+     * @param placements where it goes; empty = the instances of the file (glTF nodes), or once at the origin
+     * @return request index
+     */
+    size_t request(const std::string& path, const std::vector<StreamPlacement>& placements = {});
+
+    /**
+     * @brief Makes resident the models that have finished parsing, mesh by mesh, until budgetMs is spent (at least
+     * one mesh per call, so a large mesh never stalls the stream)
+     * @param budgetMs time budget of this call
+     * @return number of meshes defined
+     */
+    size_t update(float budgetMs = 8.0f);
+
+    /**
+     * @brief Runs update until at least one model is resident (or every request failed), so the first render()
+     * has geometry to trace
+     */
+    void waitForFirstModel();
+
+    /**
+     * @return true when every requested model is resident or has failed
+     */
+    bool isComplete() const { return m_pending == 0; }
+
+    size_t pendingModels() const { return m_pending; }
+    size_t residentModels() const { return m_resident; }
+
+    /**
+     * @brief Mesh ids of a resident model, one per mesh of the file (empty while it is loading or if it failed)
+     * @param request index returned by request()
+     */
+    const std::vector<Renderer::MeshId>& meshIds(size_t request) const { return m_requests[request]->ids; }
+
+private:
+    struct Request {
+        std::string path;
+        std::vector<StreamPlacement> placements;
+        std::future<LoadedAsset> future;
+        LoadedAsset asset;
+        bool parsed = false;
+        bool done = false;
+        size_t nextMesh = 0;                        // siguiente malla por definir
+        std::vector<Renderer::MeshId> ids;
+        bool hasProxy = false;
+        Renderer::MeshId proxy = 0;
+    };
+
+    void addProxy(Request& request, const glm::vec3& bmin, const glm::vec3& bmax);
+    void finish(Request& request);
+
+    /**
+     * @brief Box of 12 triangles with per-face normals
+     */
+    static void BoxMesh(const glm::vec3& bmin, const glm::vec3& bmax, std::vector<glm::vec3>& vertices,
+        std::vector<glm::vec3>& normals, std::vector<glm::vec2>& uvs, std::vector<uint32_t>& indices);
+
+    Renderer& m_renderer;
+    AssetLoader m_loader;
+    std::vector<std::unique_ptr<Request>> m_requests;
+    size_t m_pending = 0;
+    size_t m_resident = 0;
+    std::chrono::steady_clock::time_point m_start;
+};
@@ -4537,6 +4537,25 @@ static bool ParseBuffer(Buffer *buffer, std::string *err, const detail::json &o,
   buffer->uri.clear();
   ParseStringProperty(&buffer->uri, err, o, "uri", false, "Buffer");
 
+  // EXT_meshopt_compression: a fallback buffer has no uri of its own. Its
+  // contents are decoded by the application from the compressed buffer views,
+  // so it is only allocated here.
+  if (buffer->uri.empty()) {
+    ExtensionMap extensions;
+    ParseExtensionsProperty(&extensions, err, o);
+    ExtensionMap::const_iterator meshopt =
+        extensions.find("EXT_meshopt_compression");
+    if (meshopt != extensions.end() && meshopt->second.IsObject() &&
+        meshopt->second.Get("fallback").IsBool() &&
+        meshopt->second.Get("fallback").Get<bool>()) {
+      buffer->data.resize(byteLength);
+      ParseStringProperty(&buffer->name, err, o, "name", false);
+      ParseExtrasAndExtensions(buffer, err, o,
+                               store_original_json_for_extras_and_extensions);
+      return true;
+    }
+  }
+
   // having an empty uri for a non embedded image should not be valid
   if (!is_binary && buffer->uri.empty()) {
     if (err) {
@@ -7,9 +7,41 @@
 #include <string>
 #include <fstream>
 
+#include "Trace.h"
+#include "Log.h"
+#include "assetloader.h"
+#include "meshoptimizer.h"
+
 class OBJLoader {
 public:
-    bool loadOBJ(const std::string& filepath) {
+    // Parser propio (fichero mapeado en memoria, trozos en paralelo). Misma disposicion que loadOBJAssimp:
+    // UVs invertidas y normales suaves donde el fichero no las trae.
+    // Despues de parsear se sueldan los vertices y se reordenan para la cache de vertices (MeshOptimizer).
+    // Con useCache se lee <fichero>.meshcache si sigue valido, y si no se escribe ya optimizado.
+    // Es el mismo camino que usa AssetLoader en sus hilos
+    bool loadOBJ(const std::string& filepath, bool useCache = true) {
+        TRACE_SCOPE_DETAIL("loadOBJ", "frontend", filepath);
+        LoadedAsset asset;
+        fromCache = false;
+        if (!AssetLoader::LoadOBJ(filepath, useCache, asset)) {
+            return false;
+        }
+        AssetMesh& mesh = asset.meshes[0];
+        vertices = std::move(mesh.vertices);
+        normals = std::move(mesh.normals);
+        texCoords = std::move(mesh.uvs);
+        indices = std::move(mesh.indices);
+        fromCache = asset.cached;
+        return true;
+    }
+
+    // true si la ultima llamada a loadOBJ leyo la cache
+    bool isFromCache() const {
+        return fromCache;
+    }
+
+    bool loadOBJAssimp(const std::string& filepath) {
+        TRACE_SCOPE_DETAIL("loadOBJAssimp", "frontend", filepath);
         // Limpiar vectores anteriores
         vertices.clear();
         normals.clear();
@@ -34,23 +66,23 @@ public:
         //    0
         //);
 
-        printf("Imported mesh at %s\n", filepath);
+        LOG_DEBUG("loader", "Imported mesh at %s", filepath.c_str());
 
         // Verificar que la carga fue exitosa
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-            std::cerr << "Error al cargar el archivo OBJ: " << importer.GetErrorString() << std::endl;
+            LOG_ERROR("loader", "Error al cargar el archivo OBJ: %s", importer.GetErrorString());
             return false;
         }
 
         // Procesar todos los meshes en la escena
         processNode(scene->mRootNode, scene);
 
-        std::cout << "Archivo OBJ cargado exitosamente!" << std::endl;
-        std::cout << "Vertices: " << vertices.size() << std::endl;
-        std::cout << "Normales: " << normals.size() << std::endl;
-        std::cout << "Coordenadas de textura: " << texCoords.size() << std::endl;
-        std::cout << "Indices: " << indices.size() << std::endl;
-        std::cout << "Tringulos: " << indices.size() / 3 << std::endl;
+        LOG_INFO("loader", "Archivo OBJ cargado exitosamente!");
+        LOG_DEBUG("loader", "Vertices: %zu", (size_t)vertices.size());
+        LOG_DEBUG("loader", "Normales: %zu", (size_t)normals.size());
+        LOG_DEBUG("loader", "Coordenadas de textura: %zu", (size_t)texCoords.size());
+        LOG_DEBUG("loader", "Indices: %zu", (size_t)indices.size());
+        LOG_DEBUG("loader", "Tringulos: %zu", (size_t)(indices.size() / 3));
 
         //validateNormals();
 
@@ -59,6 +91,7 @@ public:
 
     // Versin alternativa que intenta optimizar vrtices duplicados
     bool loadOBJOptimized(const std::string& filepath) {
+        TRACE_SCOPE_DETAIL("loadOBJOptimized", "frontend", filepath);
         vertices.clear();
         normals.clear();
         texCoords.clear();
@@ -74,54 +107,36 @@ public:
         );
 
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-            std::cerr << "Error al cargar el archivo OBJ: " << importer.GetErrorString() << std::endl;
+            LOG_ERROR("loader", "Error al cargar el archivo OBJ: %s", importer.GetErrorString());
             return false;
         }
 
-        std::cout << "=== INFORMACIN DE CARGA OPTIMIZADA ===" << std::endl;
-        std::cout << "Nmero de meshes en la escena: " << scene->mNumMeshes << std::endl;
+        LOG_DEBUG("loader", "=== INFORMACIN DE CARGA OPTIMIZADA ===");
+        LOG_DEBUG("loader", "Nmero de meshes en la escena: %u", scene->mNumMeshes);
 
         processNode(scene->mRootNode, scene);
 
-        std::cout << "\n=== ESTADSTICAS OPTIMIZADAS ===" << std::endl;
-        std::cout << "Vrtices procesados: " << vertices.size() << std::endl;
-        std::cout << "Normales: " << normals.size() << std::endl;
-        std::cout << "Coordenadas de textura: " << texCoords.size() << std::endl;
-        std::cout << "ndices: " << indices.size() << std::endl;
-        std::cout << "Tringulos: " << indices.size() / 3 << std::endl;
+        LOG_DEBUG("loader", "=== ESTADSTICAS OPTIMIZADAS ===");
+        LOG_DEBUG("loader", "Vrtices procesados: %zu", (size_t)vertices.size());
+        LOG_DEBUG("loader", "Normales: %zu", (size_t)normals.size());
+        LOG_DEBUG("loader", "Coordenadas de textura: %zu", (size_t)texCoords.size());
+        LOG_DEBUG("loader", "ndices: %zu", (size_t)indices.size());
+        LOG_DEBUG("loader", "Tringulos: %zu", (size_t)(indices.size() / 3));
 
         return true;
     }
 
     void analyzeVertexDuplication() const {
-        std::cout << "\n=== ANLISIS DE DUPLICACIN DE VRTICES ===" << std::endl;
-
-        std::vector<glm::vec3> uniquePositions;
-
-        int duplicateCount = 0;
-
-        for (const auto& vertex : vertices) {
-            bool found = false;
-            for (const auto& unique : uniquePositions) {
-                if (glm::distance(vertex, unique) < 0.0001f) { // Tolerancia pequea
-                    found = true;
-                    duplicateCount++;
-                    break;
-                }
-            }
-            if (!found) {
-
-                uniquePositions.push_back(vertex);
-                //uniqueVertices.push_back(vertex);
-            }
-        }
-
+        LOG_DEBUG("loader", "=== ANLISIS DE DUPLICACIN DE VRTICES ===");
 
+        // Rejilla hash, O(n)
+        size_t uniquePositions = MeshOptimizer::CountUniquePositions(vertices, 0.0001f); // Tolerancia pequea
+        int duplicateCount = (int)(vertices.size() - uniquePositions);
 
-        std::cout << "Posiciones nicas: " << uniquePositions.size() << std::endl;
-        std::cout << "Vrtices duplicados: " << duplicateCount << std::endl;
-        std::cout << "Total de vrtices: " << vertices.size() << std::endl;
-        std::cout << "Ratio de duplicacin: " << (float)duplicateCount / vertices.size() * 100.0f << "%" << std::endl;
+        LOG_DEBUG("loader", "Posiciones nicas: %zu", uniquePositions);
+        LOG_DEBUG("loader", "Vrtices duplicados: %d", duplicateCount);
+        LOG_DEBUG("loader", "Total de vrtices: %zu", (size_t)vertices.size());
+        LOG_DEBUG("loader", "Ratio de duplicacin: %g%%", (float)duplicateCount / vertices.size() * 100.0f);
     }
 
     // Mtodos getter para acceder a los datos
@@ -222,12 +237,12 @@ public:
 
     // Mtodo para imprimir estadsticas
     void printStats() const {
-        std::cout << "\n=== Estadsticas del modelo ===" << std::endl;
-        std::cout << "Nmero de vrtices: " << vertices.size() << std::endl;
-        std::cout << "Nmero de normales: " << normals.size() << std::endl;
-        std::cout << "Nmero de coordenadas de textura: " << texCoords.size() << std::endl;
-        std::cout << "Nmero de ndices: " << indices.size() << std::endl;
-        std::cout << "Nmero de tringulos: " << indices.size() / 3 << std::endl;
+        LOG_DEBUG("loader", "=== Estadsticas del modelo ===");
+        LOG_DEBUG("loader", "Nmero de vrtices: %zu", (size_t)vertices.size());
+        LOG_DEBUG("loader", "Nmero de normales: %zu", (size_t)normals.size());
+        LOG_DEBUG("loader", "Nmero de coordenadas de textura: %zu", (size_t)texCoords.size());
+        LOG_DEBUG("loader", "Nmero de ndices: %zu", (size_t)indices.size());
+        LOG_DEBUG("loader", "Nmero de tringulos: %zu", (size_t)(indices.size() / 3));
 
         // Informacin del bounding box
         if (!vertices.empty()) {
@@ -244,12 +259,12 @@ public:
                 maxBounds.z = std::max(maxBounds.z, vertex.z);
             }
 
-            std::cout << "Bounding Box:" << std::endl;
-            std::cout << "  Min: (" << minBounds.x << ", " << minBounds.y << ", " << minBounds.z << ")" << std::endl;
-            std::cout << "  Max: (" << maxBounds.x << ", " << maxBounds.y << ", " << maxBounds.z << ")" << std::endl;
+            LOG_DEBUG("loader", "Bounding Box:");
+            LOG_DEBUG("loader", "  Min: (%g, %g, %g)", minBounds.x, minBounds.y, minBounds.z);
+            LOG_DEBUG("loader", "  Max: (%g, %g, %g)", maxBounds.x, maxBounds.y, maxBounds.z);
 
             glm::vec3 size = maxBounds - minBounds;
-            std::cout << "  Tamao: (" << size.x << ", " << size.y << ", " << size.z << ")" << std::endl;
+            LOG_DEBUG("loader", "  Tamao: (%g, %g, %g)", size.x, size.y, size.z);
         }
     }
 
@@ -312,7 +327,7 @@ private:
                 }
             }
             else {
-                std::cerr << "Advertencia: Face con " << face.mNumIndices << " vrtices encontrada" << std::endl;
+                LOG_WARN("loader", "Advertencia: Face con %u vrtices encontrada", face.mNumIndices);
             }
         }
     }
@@ -320,7 +335,7 @@ private:
 
     // Mtodo para validar las normales generadas
     void validateNormals() {
-        std::cout << "\n=== VALIDANDO NORMALES GENERADAS ===" << std::endl;
+        LOG_DEBUG("loader", "=== VALIDANDO NORMALES GENERADAS ===");
 
         int validNormals = 0;
         int invalidNormals = 0;
@@ -346,15 +361,15 @@ private:
             }
         }
 
-        std::cout << "Normales vlidas: " << validNormals << std::endl;
-        std::cout << "Normales corregidas: " << invalidNormals << std::endl;
+        LOG_DEBUG("loader", "Normales vlidas: %d", validNormals);
+        LOG_DEBUG("loader", "Normales corregidas: %d", invalidNormals);
 
         // Verificar consistencia geomtrica en una muestra
         validateGeometricConsistency();
     }
 
     void validateGeometricConsistency() {
-        std::cout << "Verificando consistencia geomtrica..." << std::endl;
+        LOG_DEBUG("loader", "Verificando consistencia geomtrica...");
 
         int consistentTriangles = 0;
         int inconsistentTriangles = 0;
@@ -395,15 +410,15 @@ private:
             }
         }
 
-        std::cout << "Muestra de " << sampleSize << " tringulos:" << std::endl;
-        std::cout << "  Consistentes: " << consistentTriangles << std::endl;
-        std::cout << "  Inconsistentes: " << inconsistentTriangles << std::endl;
+        LOG_DEBUG("loader", "Muestra de %d tringulos:", sampleSize);
+        LOG_DEBUG("loader", "  Consistentes: %d", consistentTriangles);
+        LOG_DEBUG("loader", "  Inconsistentes: %d", inconsistentTriangles);
 
         float consistencyRatio = (float)consistentTriangles / (consistentTriangles + inconsistentTriangles);
-        std::cout << "  Ratio de consistencia: " << (consistencyRatio * 100.0f) << "%" << std::endl;
+        LOG_DEBUG("loader", "  Ratio de consistencia: %g%%", (consistencyRatio * 100.0f));
 
         if (consistencyRatio < 0.8f) {
-            std::cout << "ADVERTENCIA: Baja consistencia en normales. Considera usar aiProcess_GenNormals en lugar de aiProcess_GenSmoothNormals" << std::endl;
+            LOG_WARN("loader", "ADVERTENCIA: Baja consistencia en normales. Considera usar aiProcess_GenNormals en lugar de aiProcess_GenSmoothNormals");
         }
     }
 
@@ -414,4 +429,5 @@ private:
     std::vector<unsigned int> indices;
     std::vector<glm::vec2> texCoords;
 
+    bool fromCache = false;
 };
\ No newline at end of file
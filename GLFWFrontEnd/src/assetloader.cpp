@@ -0,0 +1,259 @@
+#include "assetloader.h"
+#include <algorithm>
+#include <ctype.h>
+#include <memory>
+
+#include "gltfloader.h"
+#include "meshcache.h"
+#include "meshoptimizer.h"
+#include "objparser.h"
+#include "parallelfor.h"
+#include "Trace.h"
+#include "Log.h"
+
+namespace {
+    bool EndsWith(const std::string& str, const std::string& suffix) {
+        if (str.size() < suffix.size()) {
+            return false;
+        }
+        std::string tail = str.substr(str.size() - suffix.size());
+        std::transform(tail.begin(), tail.end(), tail.begin(), [](unsigned char c) { return (char)tolower(c); });
+        return tail == suffix;
+    }
+}
+
+AssetLoader::AssetLoader(unsigned int threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // Los parsers paralelos de cada carga se reparten los nucleos entre los workers
+    unsigned int budget = std::max(1u, std::thread::hardware_concurrency() / threads);
+    for (unsigned int i = 0; i < threads; i++) {
+        m_workers.emplace_back([this, budget]() {
+            ParallelThreadBudget() = budget;
+            workerLoop();
+        });
+    }
+}
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void AssetLoader::workerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+            // Al destruir se vacia la cola antes de salir: ningun future queda sin valor
+            if (m_queue.empty()) {
+                return;
+            }
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        job();
+    }
+}
+
+std::future<LoadedAsset> AssetLoader::load(const std::string& path, bool useCache) {
+    // std::function necesita un objeto copiable: la tarea va en un shared_ptr
+    auto task = std::make_shared<std::packaged_task<LoadedAsset()>>([path, useCache]() {
+        LoadedAsset asset;
+        Load(path, useCache, asset);
+        return asset;
+    });
+    std::future<LoadedAsset> result = task->get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back([task]() { (*task)(); });
+    }
+    m_cv.notify_one();
+    return result;
+}
+
+std::vector<std::future<LoadedAsset>> AssetLoader::loadAll(const std::vector<std::string>& paths, bool useCache) {
+    std::vector<std::future<LoadedAsset>> futures;
+    futures.reserve(paths.size());
+    for (const std::string& path : paths) {
+        futures.push_back(load(path, useCache));
+    }
+    return futures;
+}
+
+bool AssetLoader::Load(const std::string& path, bool useCache, LoadedAsset& out) {
+    TRACE_SCOPE_DETAIL("loadAsset", "frontend", path);
+    auto start = std::chrono::steady_clock::now();
+    out = LoadedAsset();
+    out.path = path;
+    if (EndsWith(path, ".obj")) {
+        out.ok = LoadOBJ(path, useCache, out);
+    }
+    else if (EndsWith(path, ".gltf") || EndsWith(path, ".glb")) {
+        out.ok = LoadGLTF(path, useCache, out);
+    }
+    else {
+        LOG_ERROR("loader", "Unknown model format: %s", path.c_str());
+    }
+    if (out.ok) {
+        ComputeBounds(out);
+    }
+    out.parseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (out.ok) {
+        LOG_INFO("loader", "Loaded %s (%zu meshes%s) in %.1f ms", path.c_str(), out.meshes.size(),
+            out.cached ? ", cached" : "", out.parseMs);
+    }
+    return out.ok;
+}
+
+void AssetLoader::ComputeBounds(LoadedAsset& out) {
+    std::vector<glm::vec3> meshMin(out.meshes.size(), glm::vec3(1e30f)), meshMax(out.meshes.size(), glm::vec3(-1e30f));
+    for (size_t i = 0; i < out.meshes.size(); i++) {
+        for (const glm::vec3& v : out.meshes[i].vertices) {
+            meshMin[i] = glm::min(meshMin[i], v);
+            meshMax[i] = glm::max(meshMax[i], v);
+        }
+    }
+    glm::vec3 bmin(1e30f), bmax(-1e30f);
+    auto addBox = [&](size_t mesh, const glm::mat4& transform) {
+        if (mesh >= out.meshes.size() || out.meshes[mesh].vertices.empty()) {
+            return;
+        }
+        for (int corner = 0; corner < 8; corner++) {
+            glm::vec3 p((corner & 1) ? meshMax[mesh].x : meshMin[mesh].x, (corner & 2) ? meshMax[mesh].y : meshMin[mesh].y,
+                (corner & 4) ? meshMax[mesh].z : meshMin[mesh].z);
+            glm::vec3 world = glm::vec3(transform * glm::vec4(p, 1.0f));
+            bmin = glm::min(bmin, world);
+            bmax = glm::max(bmax, world);
+        }
+    };
+    if (out.instances.empty()) {
+        for (size_t i = 0; i < out.meshes.size(); i++) {
+            addBox(i, glm::mat4(1.0f));
+        }
+    }
+    for (const AssetInstance& instance : out.instances) {
+        addBox(instance.mesh, instance.transform);
+    }
+    if (bmin.x <= bmax.x) {
+        out.boundsMin = bmin;
+        out.boundsMax = bmax;
+    }
+}
+
+bool AssetLoader::LoadOBJ(const std::string& path, bool useCache, LoadedAsset& out) {
+    out.meshes.resize(1);
+    AssetMesh& mesh = out.meshes[0];
+    if (useCache) {
+        MeshCache cache;
+        if (cache.open(path) && cache.submeshCount() == 1) {
+            cache.copySubmesh(0, mesh.vertices, mesh.normals, mesh.uvs, mesh.indices);
+            out.cached = true;
+            return true;
+        }
+    }
+
+    ObjMeshData parsed;
+    if (!ObjParser().parse(path, parsed)) {
+        out.meshes.clear();
+        return false;
+    }
+    mesh.vertices = std::move(parsed.vertices);
+    mesh.normals = std::move(parsed.normals);
+    mesh.uvs = std::move(parsed.uvs);
+    mesh.indices = std::move(parsed.indices);
+    MeshOptimizer::Optimize(mesh.vertices, mesh.normals, mesh.uvs, mesh.indices);
+
+    if (useCache) {
+        MeshCacheData data;
+        data.addSubmesh(mesh.vertices, mesh.normals, mesh.uvs, mesh.indices);
+        MeshCache::write(path, data);
+    }
+    return true;
+}
+
+bool AssetLoader::LoadGLTF(const std::string& path, bool useCache, LoadedAsset& out) {
+    // Una submesh de la cache por primitiva, y una instancia de la cache por primitiva de cada nodo
+    if (useCache) {
+        MeshCache cache;
+        if (cache.open(path)) {
+            out.meshes.resize(cache.submeshCount());
+            for (size_t i = 0; i < cache.submeshCount(); i++) {
+                AssetMesh& mesh = out.meshes[i];
+                cache.copySubmesh(i, mesh.vertices, mesh.normals, mesh.uvs, mesh.indices);
+            }
+            for (size_t i = 0; i < cache.instanceCount(); i++) {
+                const MeshCacheInstance& instance = cache.instance(i);
+                out.instances.push_back({ instance.submesh, instance.transform, instance.color });
+            }
+            out.cached = true;
+            return !out.meshes.empty();
+        }
+    }
+
+    tinygltf::TinyGLTF loader;
+    tinygltf::Model model;
+    std::string err, warn;
+    bool ret = EndsWith(path, ".glb") ? loader.LoadBinaryFromFile(&model, &err, &warn, path)
+        : loader.LoadASCIIFromFile(&model, &err, &warn, path);
+    if (!warn.empty()) {
+        LOG_WARN("loader", "%s: %s", path.c_str(), warn.c_str());
+    }
+    if (!ret) {
+        LOG_ERROR("loader", "Failed to load %s: %s", path.c_str(), err.c_str());
+        return false;
+    }
+
+    GLTFHelper helper;
+    if (!helper.DecompressBufferViews(model)) {
+        LOG_ERROR("loader", "Failed to decode the compressed buffers of %s", path.c_str());
+        return false;
+    }
+    std::vector<GLTFPrimitiveData> primitives;
+    helper.ExtractPrimitives(model, primitives);
+
+    // Primitivas validas de cada malla glTF: cada nodo que la usa las instancia todas
+    std::vector<std::vector<size_t>> meshPrimitives(model.meshes.size());
+    std::vector<glm::vec3> colors;
+    for (GLTFPrimitiveData& prim : primitives) {
+        if (!prim.valid) {
+            continue;
+        }
+        meshPrimitives[prim.mesh].push_back(out.meshes.size());
+        colors.push_back(GLTFHelper::MaterialColor(model, prim.material));
+        AssetMesh mesh;
+        mesh.vertices = std::move(prim.vertices);
+        mesh.normals = std::move(prim.normals);
+        mesh.uvs = std::move(prim.uvs);
+        mesh.indices = std::move(prim.indices);
+        MeshOptimizer::Optimize(mesh.vertices, mesh.normals, mesh.uvs, mesh.indices);
+        out.meshes.push_back(std::move(mesh));
+    }
+    std::vector<GLTFInstance> nodes;
+    helper.CollectInstances(model, nodes);
+    for (const GLTFInstance& node : nodes) {
+        for (size_t m : meshPrimitives[node.mesh]) {
+            out.instances.push_back({ m, node.transform, colors[m] });
+        }
+    }
+
+    if (useCache && !out.meshes.empty()) {
+        MeshCacheData data;
+        for (const AssetMesh& mesh : out.meshes) {
+            data.addSubmesh(mesh.vertices, mesh.normals, mesh.uvs, mesh.indices);
+        }
+        for (const AssetInstance& instance : out.instances) {
+            data.instances.push_back({ instance.transform, (uint32_t)instance.mesh, instance.color });
+        }
+        MeshCache::write(path, data);
+    }
+    return !out.meshes.empty();
+}
@@ -1,6 +1,7 @@
 // camera_glfw.cpp
 #include "glfwcamera.h"
 #include <iostream>
+#include "Log.h"
 
 // Variables estticas
 CameraFirstPerson* CameraGLFWController::s_camera = nullptr;
@@ -19,12 +20,12 @@ void CameraGLFWController::setupCallbacks(GLFWwindow* window, CameraFirstPerson*
     // Configurar modo de cursor inicial
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 
-    std::cout << "Controles de cmara configurados:" << std::endl;
-    std::cout << "- WASD: Movimiento" << std::endl;
-    std::cout << "- O/L: Subir/Bajar" << std::endl;
-    std::cout << "- P: Velocidad rpida" << std::endl;
-    std::cout << "- Click derecho + mouse: Mirar alrededor" << std::endl;
-    std::cout << "- Tab: Capturar/liberar cursor" << std::endl;
+    LOG_INFO("frontend", "Controles de cmara configurados:");
+    LOG_INFO("frontend", "- WASD: Movimiento");
+    LOG_INFO("frontend", "- O/L: Subir/Bajar");
+    LOG_INFO("frontend", "- P: Velocidad rpida");
+    LOG_INFO("frontend", "- Click derecho + mouse: Mirar alrededor");
+    LOG_INFO("frontend", "- Tab: Capturar/liberar cursor");
 }
 
 void CameraGLFWController::cleanup() {
@@ -96,5 +97,5 @@ void CameraGLFWController::scrollCallback(GLFWwindow* window, double xoffset, do
     float speedChange = static_cast<float>(yoffset) * 0.5f;
     s_camera->m_maxSpeed = std::max(0.1f, s_camera->m_maxSpeed + speedChange);
 
-    std::cout << "Velocidad de cmara: " << s_camera->m_maxSpeed << std::endl;
+    LOG_DEBUG("frontend", "Velocidad de cmara: %g", s_camera->m_maxSpeed);
 }
\ No newline at end of file
@@ -1,91 +1,530 @@
 #include "gltfloader.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <math.h>
+#include <thread>
+#include <type_traits>
 
- bool GLTFHelper::ExtractMeshAttributes(const tinygltf::Model& model, const tinygltf::Primitive& primitive,
+#include "meshoptdecoder.h"
+#include "parallelfor.h"
+#include "Trace.h"
+#include "Log.h"
+
+namespace {
+
+    int FindAttribute(const tinygltf::Primitive& primitive, const char* name) {
+        auto it = primitive.attributes.find(name);
+        return it == primitive.attributes.end() ? -1 : it->second;
+    }
+
+    // KHR_mesh_quantization: los normalizados pasan a [-1, 1] / [0, 1]; los no normalizados quedan como el entero,
+    // y la escala de decuantizacion va en la transformacion del nodo
+    template <typename T>
+    void ConvertComponents(const unsigned char* data, size_t stride, size_t count, int components, bool normalized, float* out) {
+        const float scale = normalized ? 1.0f / (float)std::numeric_limits<T>::max() : 1.0f;
+        for (size_t i = 0; i < count; i++) {
+            const unsigned char* element = data + i * stride;
+            for (int c = 0; c < components; c++) {
+                T value;
+                memcpy(&value, element + c * sizeof(T), sizeof(T));
+                float f = (float)value * scale;
+                out[i * components + c] = (std::is_signed<T>::value && normalized) ? std::max(f, -1.0f) : f;
+            }
+        }
+    }
+
+    double ExtensionNumber(const tinygltf::Value& extension, const char* key, double defaultValue) {
+        const tinygltf::Value& value = extension.Get(key);
+        return value.IsNumber() ? value.GetNumberAsDouble() : defaultValue;
+    }
+
+    std::string ExtensionString(const tinygltf::Value& extension, const char* key, const char* defaultValue) {
+        const tinygltf::Value& value = extension.Get(key);
+        return value.IsString() ? value.Get<std::string>() : std::string(defaultValue);
+    }
+
+    // Decodifica una vista EXT_meshopt_compression en su rango del buffer de la vista
+    bool DecodeMeshoptView(tinygltf::Model& model, size_t viewIndex, size_t& compressedBytes) {
+        tinygltf::BufferView& view = model.bufferViews[viewIndex];
+        const tinygltf::Value& extension = view.extensions.at("EXT_meshopt_compression");
+        if (!extension.IsObject()) {
+            return false;
+        }
+        int source = (int)ExtensionNumber(extension, "buffer", -1.0);
+        size_t byteOffset = (size_t)ExtensionNumber(extension, "byteOffset", 0.0);
+        size_t byteLength = (size_t)ExtensionNumber(extension, "byteLength", 0.0);
+        size_t stride = (size_t)ExtensionNumber(extension, "byteStride", 0.0);
+        size_t count = (size_t)ExtensionNumber(extension, "count", 0.0);
+        std::string mode = ExtensionString(extension, "mode", "");
+        std::string filter = ExtensionString(extension, "filter", "NONE");
+
+        if (source < 0 || source >= (int)model.buffers.size() || view.buffer < 0 || view.buffer >= (int)model.buffers.size()) {
+            return false;
+        }
+        const std::vector<unsigned char>& input = model.buffers[source].data;
+        std::vector<unsigned char>& output = model.buffers[view.buffer].data;
+        if (byteOffset + byteLength > input.size() || count * stride > view.byteLength ||
+            view.byteOffset + view.byteLength > output.size()) {
+            return false;
+        }
+        const unsigned char* src = input.data() + byteOffset;
+        unsigned char* dst = output.data() + view.byteOffset;
+        compressedBytes = byteLength;
+
+        if (mode == "ATTRIBUTES") {
+            MeshoptDecoder::Filter f = MeshoptDecoder::FILTER_NONE;
+            if (filter == "OCTAHEDRAL") {
+                f = MeshoptDecoder::FILTER_OCTAHEDRAL;
+            }
+            else if (filter == "QUATERNION") {
+                f = MeshoptDecoder::FILTER_QUATERNION;
+            }
+            else if (filter == "EXPONENTIAL") {
+                f = MeshoptDecoder::FILTER_EXPONENTIAL;
+            }
+            else if (filter != "NONE") {
+                return false;
+            }
+            return MeshoptDecoder::DecodeVertexBuffer(dst, count, stride, src, byteLength) &&
+                MeshoptDecoder::ApplyFilter(f, dst, count, stride);
+        }
+        if (mode == "TRIANGLES") {
+            return MeshoptDecoder::DecodeIndexBuffer(dst, count, stride, src, byteLength);
+        }
+        if (mode == "INDICES") {
+            return MeshoptDecoder::DecodeIndexSequence(dst, count, stride, src, byteLength);
+        }
+        return false;
+    }
+
+    // KHR_texture_transform de la textura base: el renderer no aplica transformaciones de textura, se hornean
+    // en las UVs (es ademas como se decuantizan las UVs no normalizadas de KHR_mesh_quantization)
+    void ApplyTextureTransform(const tinygltf::Model& model, int material, std::vector<glm::vec2>& uvs) {
+        if (material < 0 || material >= (int)model.materials.size()) {
+            return;
+        }
+        const tinygltf::TextureInfo& texture = model.materials[material].pbrMetallicRoughness.baseColorTexture;
+        auto it = texture.extensions.find("KHR_texture_transform");
+        if (texture.index < 0 || texture.texCoord != 0 || it == texture.extensions.end() || !it->second.IsObject()) {
+            return;
+        }
+        const tinygltf::Value& transform = it->second;
+        glm::vec2 offset(0.0f), scale(1.0f);
+        const tinygltf::Value& offsetValue = transform.Get("offset");
+        const tinygltf::Value& scaleValue = transform.Get("scale");
+        if (offsetValue.IsArray() && offsetValue.ArrayLen() == 2) {
+            offset = glm::vec2((float)offsetValue.Get(0).GetNumberAsDouble(), (float)offsetValue.Get(1).GetNumberAsDouble());
+        }
+        if (scaleValue.IsArray() && scaleValue.ArrayLen() == 2) {
+            scale = glm::vec2((float)scaleValue.Get(0).GetNumberAsDouble(), (float)scaleValue.Get(1).GetNumberAsDouble());
+        }
+        float rotation = (float)ExtensionNumber(transform, "rotation", 0.0);
+        float c = cosf(rotation), s = sinf(rotation);
+        // uv' = T * R * S * uv
+        for (glm::vec2& uv : uvs) {
+            float x = uv.x * scale.x, y = uv.y * scale.y;
+            uv = glm::vec2(c * x + s * y + offset.x, -s * x + c * y + offset.y);
+        }
+    }
+
+    template <typename T>
+    bool ReadIndices(const tinygltf::Model& model, int accessorIndex, std::vector<uint32_t>& out) {
+        AccessorView<T> view;
+        if (!GLTFHelper::GetAccessorView(model, accessorIndex, view)) {
+            return false;
+        }
+        out.resize(view.count);
+        for (size_t i = 0; i < view.count; i++) {
+            out[i] = view[i];
+        }
+        return true;
+    }
+
+}
+
+bool GLTFHelper::AccessorData(const tinygltf::Model& model, int accessorIndex, size_t elementSize,
+    const unsigned char*& data, size_t& stride, size_t& count) {
+    data = nullptr;
+    stride = 0;
+    count = 0;
+    if (accessorIndex < 0 || accessorIndex >= (int)model.accessors.size()) {
+        return false;
+    }
+    const auto& accessor = model.accessors[accessorIndex];
+    if (accessor.sparse.isSparse || accessor.bufferView < 0 || accessor.bufferView >= (int)model.bufferViews.size()) {
+        LOG_ERROR("loader", "Accessor %d is sparse or has no buffer view", accessorIndex);
+        return false;
+    }
+    const auto& view = model.bufferViews[accessor.bufferView];
+    if (view.buffer < 0 || view.buffer >= (int)model.buffers.size()) {
+        return false;
+    }
+    const auto& buffer = model.buffers[view.buffer];
+
+    // byteStride 0 = elementos contiguos
+    size_t elementStride = view.byteStride != 0 ? view.byteStride : elementSize;
+    size_t viewEnd = std::min(view.byteOffset + view.byteLength, buffer.data.size());
+    size_t begin = view.byteOffset + accessor.byteOffset;
+    if (accessor.count > 0 && (elementStride < elementSize ||
+        begin + elementStride * (accessor.count - 1) + elementSize > viewEnd)) {
+        LOG_ERROR("loader", "Accessor %d is out of the bounds of its buffer view", accessorIndex);
+        return false;
+    }
+
+    data = buffer.data.data() + begin;
+    stride = elementStride;
+    count = accessor.count;
+    return true;
+}
+
+bool GLTFHelper::ReadAttribute(const tinygltf::Model& model, int accessorIndex, int type, float* out, const char* name) {
+    const auto& accessor = model.accessors[accessorIndex];
+    int components = tinygltf::GetNumComponentsInType((uint32_t)type);
+    int componentSize = tinygltf::GetComponentSizeInBytes((uint32_t)accessor.componentType);
+    if (accessor.type != type || componentSize <= 0) {
+        LOG_ERROR("loader", "Unsupported %s format (component type %d, type %d)", name, accessor.componentType, accessor.type);
+        return false;
+    }
+    const unsigned char* data = nullptr;
+    size_t stride = 0, count = 0;
+    if (!AccessorData(model, accessorIndex, (size_t)(components * componentSize), data, stride, count)) {
+        return false;
+    }
+
+    switch (accessor.componentType) {
+    case TINYGLTF_COMPONENT_TYPE_FLOAT:
+        if (stride == (size_t)components * sizeof(float)) {
+            memcpy(out, data, count * stride);
+        }
+        else {
+            for (size_t i = 0; i < count; i++) {
+                memcpy(out + i * components, data + i * stride, components * sizeof(float));
+            }
+        }
+        return true;
+    case TINYGLTF_COMPONENT_TYPE_BYTE:
+        ConvertComponents<int8_t>(data, stride, count, components, accessor.normalized, out);
+        return true;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+        ConvertComponents<uint8_t>(data, stride, count, components, accessor.normalized, out);
+        return true;
+    case TINYGLTF_COMPONENT_TYPE_SHORT:
+        ConvertComponents<int16_t>(data, stride, count, components, accessor.normalized, out);
+        return true;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+        ConvertComponents<uint16_t>(data, stride, count, components, accessor.normalized, out);
+        return true;
+    default:
+        LOG_ERROR("loader", "Unsupported %s component type %d", name, accessor.componentType);
+        return false;
+    }
+}
+
+bool GLTFHelper::DecompressBufferViews(tinygltf::Model& model, unsigned int threads) {
+    TRACE_SCOPE("DecompressBufferViews", "frontend");
+    std::vector<size_t> compressed;
+    for (size_t i = 0; i < model.bufferViews.size(); i++) {
+        if (model.bufferViews[i].extensions.count("EXT_meshopt_compression")) {
+            compressed.push_back(i);
+        }
+    }
+    if (compressed.empty()) {
+        return true;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    // Cada vista escribe en su propio rango del buffer de respaldo: se decodifican en paralelo
+    if (threads == 0) {
+        threads = DefaultParallelThreads();
+    }
+    std::atomic<bool> ok{ true };
+    std::atomic<size_t> compressedBytes{ 0 }, decodedBytes{ 0 };
+    ParallelFor(threads, compressed.size(), [&](size_t i) {
+        size_t bytes = 0;
+        if (!DecodeMeshoptView(model, compressed[i], bytes)) {
+            LOG_ERROR("loader", "Cannot decode the meshopt-compressed buffer view %zu", compressed[i]);
+            ok = false;
+            return;
+        }
+        compressedBytes += bytes;
+        decodedBytes += model.bufferViews[compressed[i]].byteLength;
+    });
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("loader", "Decoded %zu meshopt buffer views (%zu -> %zu bytes) in %.1f ms", compressed.size(),
+        (size_t)compressedBytes, (size_t)decodedBytes, ms);
+    return ok;
+}
+
+bool GLTFHelper::ExtractMeshAttributes(const tinygltf::Model& model, const tinygltf::Primitive& primitive,
     std::vector<glm::vec3>& outVertices,
     std::vector<glm::vec3>& outNormals,
     std::vector<glm::vec2>& outUVs,
     std::vector<uint32_t>& outIndices) {
-    auto getBufferViewData = [&](int accessorIndex) -> const unsigned char* {
-        const auto& accessor = model.accessors[accessorIndex];
-        const auto& view = model.bufferViews[accessor.bufferView];
-        const auto& buffer = model.buffers[view.buffer];
-        return &buffer.data[view.byteOffset + accessor.byteOffset];
-        };
+    TRACE_SCOPE("ExtractMeshAttributes", "frontend");
 
-    // === INDICES ===
-    if (primitive.indices < 0) {
-        std::cerr << "Mesh has no indices, skipping." << std::endl;
+    if (primitive.mode != -1 && primitive.mode != TINYGLTF_MODE_TRIANGLES) {
+        LOG_WARN("loader", "Primitive mode %d is not a triangle list, skipping.", primitive.mode);
         return false;
     }
 
-    const auto& indexAccessor = model.accessors[primitive.indices];
-    const auto& indexView = model.bufferViews[indexAccessor.bufferView];
-    const auto& indexBuffer = model.buffers[indexView.buffer];
-    const unsigned char* indexData = &indexBuffer.data[indexView.byteOffset + indexAccessor.byteOffset];
+    // === POSITION ===
+    int positionAccessor = FindAttribute(primitive, "POSITION");
+    if (positionAccessor < 0) {
+        LOG_ERROR("loader", "Mesh missing POSITION attribute");
+        return false;
+    }
+    size_t vertexCount = model.accessors[positionAccessor].count;
+    // Un accessor vacio es glTF valido, pero no hay nada que trazar (y defineMesh necesita al menos un triangulo)
+    if (vertexCount == 0) {
+        LOG_WARN("loader", "Primitive without vertices, skipping.");
+        return false;
+    }
 
-    outIndices.resize(indexAccessor.count);
+    // === NORMAL / TEXCOORD_0 (opcionales) ===
+    int normalAccessor = FindAttribute(primitive, "NORMAL");
+    int uvAccessor = FindAttribute(primitive, "TEXCOORD_0");
+    if ((normalAccessor >= 0 && model.accessors[normalAccessor].count != vertexCount) ||
+        (uvAccessor >= 0 && model.accessors[uvAccessor].count != vertexCount)) {
+        LOG_ERROR("loader", "Primitive attributes have different counts");
+        return false;
+    }
 
-    for (size_t i = 0; i < indexAccessor.count; ++i) {
-        switch (indexAccessor.componentType) {
+    // === INDICES ===
+    if (primitive.indices >= 0) {
+        bool read = false;
+        switch (model.accessors[primitive.indices].componentType) {
         case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-            outIndices[i] = ((const uint16_t*)indexData)[i];
+            read = ReadIndices<uint16_t>(model, primitive.indices, outIndices);
             break;
         case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-            outIndices[i] = ((const uint32_t*)indexData)[i];
+            read = ReadIndices<uint32_t>(model, primitive.indices, outIndices);
             break;
         case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-            outIndices[i] = ((const uint8_t*)indexData)[i];
+            read = ReadIndices<uint8_t>(model, primitive.indices, outIndices);
             break;
         default:
-            std::cerr << "Unsupported index type\n";
+            LOG_ERROR("loader", "Unsupported index type %d", model.accessors[primitive.indices].componentType);
+            return false;
+        }
+        if (!read) {
             return false;
         }
+        for (uint32_t index : outIndices) {
+            if (index >= vertexCount) {
+                LOG_ERROR("loader", "Index %u out of range (%zu vertices)", index, vertexCount);
+                return false;
+            }
+        }
+    }
+    else {
+        // Sin indices: cada 3 vertices consecutivos son un triangulo
+        outIndices.resize(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++) {
+            outIndices[i] = (uint32_t)i;
+        }
     }
 
-    // === POSITION ===
-    if (primitive.attributes.find("POSITION") == primitive.attributes.end()) {
-        std::cerr << "Mesh missing POSITION attribute\n";
+    // Cada atributo se convierte directamente en el array de salida (memcpy si es float sin entrelazar)
+    outVertices.resize(vertexCount);
+    if (!ReadAttribute(model, positionAccessor, TINYGLTF_TYPE_VEC3, &outVertices[0].x, "POSITION")) {
         return false;
     }
-    const float* positionData = reinterpret_cast<const float*>(getBufferViewData(primitive.attributes.at("POSITION")));
 
-    // === NORMAL ===
-    const float* normalData = nullptr;
-    if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
-        normalData = reinterpret_cast<const float*>(getBufferViewData(primitive.attributes.at("NORMAL")));
+    if (normalAccessor >= 0) {
+        outNormals.resize(vertexCount);
+        if (!ReadAttribute(model, normalAccessor, TINYGLTF_TYPE_VEC3, &outNormals[0].x, "NORMAL")) {
+            return false;
+        }
+        // Las normales cuantizadas a 8/16 bits no salen con longitud 1
+        if (model.accessors[normalAccessor].componentType != TINYGLTF_COMPONENT_TYPE_FLOAT) {
+            for (glm::vec3& n : outNormals) {
+                float len = glm::length(n);
+                n = len > 0.0f ? n / len : n;
+            }
+        }
+    }
+    else {
+        outNormals.assign(vertexCount, glm::vec3(0.0f));  // dummy normal
     }
 
-    // === TEXCOORD_0 ===
-    const float* uvData = nullptr;
-    if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end()) {
-        uvData = reinterpret_cast<const float*>(getBufferViewData(primitive.attributes.at("TEXCOORD_0")));
+    if (uvAccessor >= 0) {
+        outUVs.resize(vertexCount);
+        if (!ReadAttribute(model, uvAccessor, TINYGLTF_TYPE_VEC2, &outUVs[0].x, "TEXCOORD_0")) {
+            return false;
+        }
+        ApplyTextureTransform(model, primitive.material, outUVs);
+    }
+    else {
+        outUVs.assign(vertexCount, glm::vec2(0.0f));  // dummy UV
     }
 
-    size_t vertexCount = model.accessors[primitive.attributes.at("POSITION")].count;
-    outVertices.reserve(vertexCount);
-    outNormals.reserve(vertexCount);
-    outUVs.reserve(vertexCount);
+    return true;
+}
 
-    for (size_t i = 0; i < vertexCount; ++i) {
-        glm::vec3 pos(positionData[i * 3 + 0], positionData[i * 3 + 1], positionData[i * 3 + 2]);
-        outVertices.push_back(pos);
+size_t GLTFHelper::ExtractPrimitives(const tinygltf::Model& model, std::vector<GLTFPrimitiveData>& out, unsigned int threads) {
+    TRACE_SCOPE("ExtractPrimitives", "frontend");
+    auto start = std::chrono::steady_clock::now();
 
-        if (normalData) {
-            glm::vec3 n(normalData[i * 3 + 0], normalData[i * 3 + 1], normalData[i * 3 + 2]);
-            outNormals.push_back(n);
+    out.clear();
+    for (size_t m = 0; m < model.meshes.size(); m++) {
+        const auto& primitives = model.meshes[m].primitives;
+        for (size_t p = 0; p < primitives.size(); p++) {
+            GLTFPrimitiveData data;
+            data.mesh = (int)m;
+            data.primitive = (int)p;
+            data.material = primitives[p].material;
+            out.push_back(std::move(data));
+        }
+    }
+
+    // Las primitivas grandes primero, para que no quede una sola al final en un hilo
+    auto vertexCount = [&](const GLTFPrimitiveData& data) -> size_t {
+        int accessor = FindAttribute(model.meshes[data.mesh].primitives[data.primitive], "POSITION");
+        return accessor >= 0 && accessor < (int)model.accessors.size() ? model.accessors[accessor].count : 0;
+    };
+    std::vector<size_t> order(out.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return vertexCount(out[a]) > vertexCount(out[b]);
+    });
+
+    if (threads == 0) {
+        threads = DefaultParallelThreads();
+    }
+    std::atomic<size_t> valid{ 0 };
+    ParallelFor(threads, order.size(), [&](size_t i) {
+        GLTFPrimitiveData& data = out[order[i]];
+        const auto& primitive = model.meshes[data.mesh].primitives[data.primitive];
+        data.valid = ExtractMeshAttributes(model, primitive, data.vertices, data.normals, data.uvs, data.indices);
+        if (data.valid) {
+            valid++;
         }
         else {
-            outNormals.push_back(glm::vec3(0.0f));  // dummy normal
+            LOG_WARN("loader", "Skipped primitive %d of mesh %d (%s)", data.primitive, data.mesh,
+                model.meshes[data.mesh].name.c_str());
         }
+    });
 
-        if (uvData) {
-            glm::vec2 uv(uvData[i * 2 + 0], uvData[i * 2 + 1]);
-            outUVs.push_back(uv);
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("loader", "Extracted %zu of %zu glTF primitives in %.1f ms", (size_t)valid, out.size(), ms);
+    return valid;
+}
+
+glm::mat4 GLTFHelper::NodeTransform(const tinygltf::Node& node) {
+    // matrix esta en column-major, como glm
+    if (node.matrix.size() == 16) {
+        glm::mat4 m(1.0f);
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) {
+                m[c][r] = (float)node.matrix[c * 4 + r];
+            }
         }
-        else {
-            outUVs.push_back(glm::vec2(0.0f));  // dummy UV
+        return m;
+    }
+    glm::mat4 m(1.0f);
+    if (node.translation.size() == 3) {
+        m = glm::translate(m, glm::vec3((float)node.translation[0], (float)node.translation[1], (float)node.translation[2]));
+    }
+    if (node.rotation.size() == 4) {
+        // glTF guarda el cuaternio como x, y, z, w; el constructor de glm recibe w primero
+        glm::quat q((float)node.rotation[3], (float)node.rotation[0], (float)node.rotation[1], (float)node.rotation[2]);
+        m = m * glm::mat4_cast(q);
+    }
+    if (node.scale.size() == 3) {
+        m = glm::scale(m, glm::vec3((float)node.scale[0], (float)node.scale[1], (float)node.scale[2]));
+    }
+    return m;
+}
+
+glm::vec3 GLTFHelper::MaterialColor(const tinygltf::Model& model, int material) {
+    if (material < 0 || material >= (int)model.materials.size()) {
+        return glm::vec3(1.0f);
+    }
+    const std::vector<double>& factor = model.materials[material].pbrMetallicRoughness.baseColorFactor;
+    if (factor.size() < 3) {
+        return glm::vec3(1.0f);
+    }
+    return glm::vec3((float)factor[0], (float)factor[1], (float)factor[2]);
+}
+
+size_t GLTFHelper::CollectInstances(const tinygltf::Model& model, std::vector<GLTFInstance>& out, int scene) {
+    TRACE_SCOPE("CollectInstances", "frontend");
+    out.clear();
+
+    std::vector<int> roots;
+    if (scene < 0) {
+        scene = model.defaultScene >= 0 ? model.defaultScene : (model.scenes.empty() ? -1 : 0);
+    }
+    if (scene >= 0 && scene < (int)model.scenes.size()) {
+        roots = model.scenes[scene].nodes;
+    }
+    else if (!model.nodes.empty()) {
+        // Sin escenas: raices = nodos que no son hijos de nadie
+        std::vector<bool> isChild(model.nodes.size(), false);
+        for (const auto& node : model.nodes) {
+            for (int child : node.children) {
+                if (child >= 0 && child < (int)model.nodes.size()) {
+                    isChild[child] = true;
+                }
+            }
         }
+        for (size_t i = 0; i < model.nodes.size(); i++) {
+            if (!isChild[i]) {
+                roots.push_back((int)i);
+            }
+        }
+    }
+    else {
+        // Sin nodos: cada malla una vez en el origen
+        for (size_t m = 0; m < model.meshes.size(); m++) {
+            GLTFInstance instance;
+            instance.mesh = (int)m;
+            out.push_back(instance);
+        }
+        return out.size();
     }
 
-    return true;
-}
\ No newline at end of file
+    // Recorrido en profundidad con pila explicita. En glTF los nodos forman arboles disjuntos: un nodo que
+    // aparece dos veces (ciclo o dos padres) es un fichero invalido y se ignora la segunda vez
+    struct Entry {
+        int node;
+        glm::mat4 parent;
+    };
+    std::vector<Entry> stack;
+    std::vector<bool> visited(model.nodes.size(), false);
+    for (auto it = roots.rbegin(); it != roots.rend(); ++it) {
+        stack.push_back({ *it, glm::mat4(1.0f) });
+    }
+    while (!stack.empty()) {
+        Entry entry = stack.back();
+        stack.pop_back();
+        if (entry.node < 0 || entry.node >= (int)model.nodes.size()) {
+            continue;
+        }
+        if (visited[entry.node]) {
+            LOG_WARN("loader", "Node %d is reached twice in the hierarchy, ignored", entry.node);
+            continue;
+        }
+        visited[entry.node] = true;
+        const tinygltf::Node& node = model.nodes[entry.node];
+        glm::mat4 world = entry.parent * NodeTransform(node);
+        if (node.mesh >= 0 && node.mesh < (int)model.meshes.size()) {
+            GLTFInstance instance;
+            instance.node = entry.node;
+            instance.mesh = node.mesh;
+            instance.transform = world;
+            out.push_back(instance);
+        }
+        for (auto it = node.children.rbegin(); it != node.children.rend(); ++it) {
+            stack.push_back({ *it, world });
+        }
+    }
+
+    LOG_DEBUG("loader", "Scene %d: %zu mesh instances of %zu meshes", scene, out.size(), model.meshes.size());
+    return out.size();
+}
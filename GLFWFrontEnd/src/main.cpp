@@ -6,12 +6,16 @@
 
 #include "OBJ_Loader.h"
 #include "OBJloader.cpp"
+#include "assetloader.h"
+#include "scenestreamer.h"
 
 #include <GLFW/glfw3.h>
 #ifdef _WIN32
 #include <GLFW/glfw3native.h>  // Importante: debes incluir esto
 #endif
 #include <Renderer/VulkanRenderer.h>
+#include "Trace.h"
+#include "Log.h"
 #include "core_fpcamera.h"
 
 #include <windows.h>
@@ -19,6 +23,8 @@
 #include <GL/gl.h>
 
 #include "json.hpp"
+// gltfloader.h incluye tiny_gltf.h: antes de TINYGLTF_IMPLEMENTATION para no compilar la implementacion dos veces
+#include "gltfloader.h"
 #define TINYGLTF_IMPLEMENTATION
 #include "tiny_gltf.h"
 
@@ -37,7 +43,7 @@
 #pragma region setup
 // Funcin para manejar errores de GLFW
 void error_callback(int error, const char* description) {
-    fprintf(stderr, "Error: %s (%d)\n", description, error);
+    LOG_ERROR("frontend", "Error: %s (%d)", description, error);
 }
 
 static struct Vertex {
@@ -78,7 +84,7 @@ GLuint loadTexture(const char* imagePath) {
     unsigned char* data = stbi_load(imagePath, &width, &height, &channels, 0);
 
     if (!data) {
-        std::cerr << "Error: No se pudo cargar la imagen: " << imagePath << std::endl;
+        LOG_ERROR("frontend", "Error: No se pudo cargar la imagen: %s", imagePath);
         return 0;
     }
 
@@ -101,7 +107,7 @@ GLuint loadTexture(const char* imagePath) {
     else if (channels == 4)
         format = GL_RGBA;
     else {
-        std::cerr << "Error: Formato de imagen no soportado" << std::endl;
+        LOG_ERROR("frontend", "Error: Formato de imagen no soportado");
         stbi_image_free(data);
         return 0;
     }
@@ -113,14 +119,14 @@ GLuint loadTexture(const char* imagePath) {
     // Liberar memoria de la imagen
     stbi_image_free(data);
 
-    std::cout << "Textura cargada: " << imagePath << " (" << width << "x" << height << ", " << channels << " canales)" << std::endl;
+    LOG_INFO("frontend", "Textura cargada: %s (%dx%d, %d canales)", imagePath, width, height, channels);
 
     return textureID;
 }
 
 GLuint createTextureFromData(uint8_t* data, int width, int height, int channels) {
     if (!data) {
-        std::cerr << "Error: Datos de imagen nulos" << std::endl;
+        LOG_ERROR("frontend", "Error: Datos de imagen nulos");
         return 0;
     }
 
@@ -149,13 +155,13 @@ GLuint createTextureFromData(uint8_t* data, int width, int height, int channels)
         format = GL_RGBA;
     }
     else {
-        std::cerr << "Error: Formato de imagen no soportado" << std::endl;
+        LOG_ERROR("frontend", "Error: Formato de imagen no soportado");
         return 0;
     }
 
     glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 
-    std::cout << "Textura creada desde datos del renderer: " << width << "x" << height << ", " << channels << " canales" << std::endl;
+    LOG_DEBUG("frontend", "Textura creada desde datos del renderer: %dx%d, %d canales", width, height, channels);
 
     return textureID;
 }
@@ -163,7 +169,7 @@ GLuint createTextureFromData(uint8_t* data, int width, int height, int channels)
 void checkGLError(const char* operation) {
     GLenum error = glGetError();
     if (error != GL_NO_ERROR) {
-        std::cerr << "Error OpenGL en " << operation << ": " << error << std::endl;
+        LOG_ERROR("frontend", "Error OpenGL en %s: %u", operation, error);
     }
 }
 
@@ -171,7 +177,7 @@ void checkGLError(const char* operation) {
 void renderTexturedQuad(GLuint textureID) {
 
     if (!glIsTexture(textureID)) {
-        std::cerr << "Error: Textura invlida: " << textureID << std::endl;
+        LOG_ERROR("frontend", "Error: Textura invlida: %u", textureID);
         return;
     }
 
@@ -217,7 +223,6 @@ CameraFirstPerson* m_pCamera;
 
 #pragma region Pruebas
 
-
 /*
     VEHICULOS A PROBAR
 
@@ -227,24 +232,14 @@ CameraFirstPerson* m_pCamera;
     Chevrolet Camaro:           1969_Chevrolet_Camaro_Publish
 */
 
-void Prueba1(VulkanRenderer* m_Renderer) {
-
-    OBJLoader loader;
+void Prueba1(VulkanRenderer* m_Renderer, SceneStreamer& streamer) {
 
     /*
         Cargar primero el modelo de la Volkswagen touran
     */
 
 
-    loader.loadOBJ("../GLFWFrontEnd/OBJ/VW_Touran_2007.obj");
-
-    auto vertices = loader.getVertices();
-    auto normals = loader.getNormals();
-    auto indices = loader.getIndices();
-    auto uvs = loader.getTexCoords();
-
-    uint32_t vanId = m_Renderer->defineMesh(vertices, normals, uvs, indices);
-    m_Renderer->addMesh(glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.f, 0.f)),glm::radians(180.f),glm::vec3(1.f,0.f,0.f)), glm::vec3(1.0f), vanId);
+    streamer.request("../GLFWFrontEnd/OBJ/VW_Touran_2007.obj", { { glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.f, 0.f)),glm::radians(180.f),glm::vec3(1.f,0.f,0.f)), glm::vec3(1.0f) } });
 
 
     /*
@@ -283,208 +278,155 @@ void Prueba1(VulkanRenderer* m_Renderer) {
             , glm::vec3(0.0f, -60.0f, -35.0f)), backMeshId, glm::vec3(1.0f, 1.0f, 1.0f), 1, 1);
 
 }
-void Prueba2(VulkanRenderer* m_Renderer) {
-
-    OBJLoader loader;
+void Prueba2(VulkanRenderer* m_Renderer, SceneStreamer& streamer) {
 
     /*
         Cargar primero el modelo del tesla
     */
 
 
-    loader.loadOBJ("../GLFWFrontEnd/OBJ/Tesla.obj");
-
-    auto vertices = loader.getVertices();
-    auto normals = loader.getNormals();
-    auto indices = loader.getIndices();
-    auto uvs = loader.getTexCoords();
-
-    uint32_t vanId = m_Renderer->defineMesh(vertices, normals, uvs, indices);
-    m_Renderer->addMesh(glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 01.f, 0.f)), glm::radians(180.f), glm::vec3(1.f, 0.f, 0.f)), glm::vec3(1.0f), vanId);
+    // Carga progresiva: los dos modelos se parsean a la vez y cada uno aparece en cuanto esta listo
+    streamer.request("../GLFWFrontEnd/OBJ/Tesla.obj", { {
+        glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 01.f, 0.f)), glm::radians(180.f), glm::vec3(1.f, 0.f, 0.f)),
+        glm::vec3(1.0f) } });
 
 
     /*
     Cargar arco Luz cubo
     */
     
-    loader.loadOBJ("../GLFWFrontEnd/OBJ/Cubo.obj");
-
-    vertices = loader.getVertices();
-    normals = loader.getNormals();
-    indices = loader.getIndices();
-    uvs = loader.getTexCoords();
-
-    uint32_t luightId = m_Renderer->defineMesh(vertices, normals, uvs, indices);
-    m_Renderer->addLight(glm::scale(
+    std::vector<StreamPlacement> cubeLights;
+    cubeLights.push_back({ glm::scale(
             glm::translate(glm::mat4(1.0f), glm::vec3(10.0f, 0.f, 0.f))
         , glm::vec3(0.6f)), 
-        luightId, glm::vec3(1.0f,0.0f,0.0f),0,0);
+        glm::vec3(1.0f,0.0f,0.0f), true });
 
-    m_Renderer->addLight(glm::scale(
+    cubeLights.push_back({ glm::scale(
         glm::translate(glm::mat4(1.0f), glm::vec3(7.50f, -07.5f, 0.f))
         , glm::vec3(0.6f)),
-        luightId, glm::vec3(0.0f, 1.0f, 0.0f), 0, 0);
+        glm::vec3(0.0f, 1.0f, 0.0f), true });
 
-    m_Renderer->addLight(glm::scale(
+    cubeLights.push_back({ glm::scale(
         glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -10.f, 0.f))
         , glm::vec3(0.6f)),
-        luightId, glm::vec3(0.0f, 0.0f, 1.0f), 0, 0);
+        glm::vec3(0.0f, 0.0f, 1.0f), true });
 
-    m_Renderer->addLight(glm::scale(
+    cubeLights.push_back({ glm::scale(
         glm::translate(glm::mat4(1.0f), glm::vec3(-7.50f, -7.5f, 0.f))
         , glm::vec3(0.6f)),
-        luightId, glm::vec3(0.70f, 0.70f, 0.0f), 0, 0);
+        glm::vec3(0.70f, 0.70f, 0.0f), true });
 
-    m_Renderer->addLight(glm::scale(
+    cubeLights.push_back({ glm::scale(
         glm::translate(glm::mat4(1.0f), glm::vec3(-10.0f, 0.f, 0.f))
         , glm::vec3(0.6f)),
-        luightId, glm::vec3(0.0f, 0.70f, 0.70f), 0, 0);
+        glm::vec3(0.0f, 0.70f, 0.70f), true });
+    streamer.request("../GLFWFrontEnd/OBJ/Cubo.obj", cubeLights);
 
 
 
 }
-void Prueba3(VulkanRenderer* m_Renderer) {
-
-    OBJLoader loader;
+void Prueba3(VulkanRenderer* m_Renderer, SceneStreamer& streamer) {
 
     /*
         Cargar primero el modelo de la Volkswagen touran
     */
 
 
-    loader.loadOBJ("../GLFWFrontEnd/OBJ/VW_Touran_2007.obj");
-
-    auto vertices = loader.getVertices();
-    auto normals = loader.getNormals();
-    auto indices = loader.getIndices();
-    auto uvs = loader.getTexCoords();
-
-    uint32_t vanId = m_Renderer->defineMesh(vertices, normals, uvs, indices);
-    m_Renderer->addMesh(
+    // Carga progresiva: los dos modelos se parsean a la vez y cada uno aparece en cuanto esta listo
+    streamer.request("../GLFWFrontEnd/OBJ/VW_Touran_2007.obj", { {
         glm::scale(
             glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 01.f, 0.f)), glm::radians(180.f), glm::vec3(1.f, 0.f, 0.f)),
             glm::vec3(1.25f)),
-        glm::vec3(1.0f), vanId);
+        glm::vec3(1.0f) } });
 
 
     /*
      Cargar arco Luz cubo
      */
 
-    loader.loadOBJ("../GLFWFrontEnd/OBJ/Cubo.obj");
-
-    vertices = loader.getVertices();
-    normals = loader.getNormals();
-    indices = loader.getIndices();
-    uvs = loader.getTexCoords();
-
-    uint32_t luightId = m_Renderer->defineMesh(vertices, normals, uvs, indices);
-    m_Renderer->addLight(glm::scale(
+    std::vector<StreamPlacement> cubeLights;
+    cubeLights.push_back({ glm::scale(
         glm::translate(glm::mat4(1.0f), glm::vec3(10.0f, 0.f, 0.f))
         , glm::vec3(0.6f)),
-        luightId, glm::vec3(1.0f, 0.0f, 0.0f), 0, 0);
+        glm::vec3(1.0f, 0.0f, 0.0f), true });
 
-    m_Renderer->addLight(glm::scale(
+    cubeLights.push_back({ glm::scale(
         glm::translate(glm::mat4(1.0f), glm::vec3(7.50f, -07.5f, 0.f))
         , glm::vec3(0.6f)),
-        luightId, glm::vec3(0.0f, 1.0f, 0.0f), 0, 0);
+        glm::vec3(0.0f, 1.0f, 0.0f), true });
 
-    m_Renderer->addLight(glm::scale(
+    cubeLights.push_back({ glm::scale(
         glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -10.f, 0.f))
         , glm::vec3(0.6f)),
-        luightId, glm::vec3(0.0f, 0.0f, 1.0f), 0, 0);
+        glm::vec3(0.0f, 0.0f, 1.0f), true });
 
-    m_Renderer->addLight(glm::scale(
+    cubeLights.push_back({ glm::scale(
         glm::translate(glm::mat4(1.0f), glm::vec3(-7.50f, -7.5f, 0.f))
         , glm::vec3(0.6f)),
-        luightId, glm::vec3(0.70f, 0.70f, 0.0f), 0, 0);
+        glm::vec3(0.70f, 0.70f, 0.0f), true });
 
-    m_Renderer->addLight(glm::scale(
+    cubeLights.push_back({ glm::scale(
         glm::translate(glm::mat4(1.0f), glm::vec3(-10.0f, 0.f, 0.f))
         , glm::vec3(0.6f)),
-        luightId, glm::vec3(0.0f, 0.70f, 0.70f), 0, 0);
+        glm::vec3(0.0f, 0.70f, 0.70f), true });
+    streamer.request("../GLFWFrontEnd/OBJ/Cubo.obj", cubeLights);
 
 }
-void Prueba4(VulkanRenderer* m_Renderer) {
-
-    OBJLoader loader;
+void Prueba4(VulkanRenderer* m_Renderer, SceneStreamer& streamer) {
 
     /*
         Cargar primero el modelo de la Volkswagen touran
     */
 
 
-    loader.loadOBJ("../GLFWFrontEnd/OBJ/1969_Chevrolet_Camaro_Publish.obj");
-
-    auto vertices = loader.getVertices();
-    auto normals = loader.getNormals();
-    auto indices = loader.getIndices();
-    auto uvs = loader.getTexCoords();
-
-    uint32_t vanId = m_Renderer->defineMesh(vertices, normals, uvs, indices);
-    m_Renderer->addMesh(
+    // Carga progresiva: los dos modelos se parsean a la vez y cada uno aparece en cuanto esta listo
+    streamer.request("../GLFWFrontEnd/OBJ/1969_Chevrolet_Camaro_Publish.obj", { {
         glm::scale(
             glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 01.f, 0.f)), glm::radians(180.f), glm::vec3(1.f, 0.f, 0.f)),
         glm::vec3(1.25f)),
-        glm::vec3(1.0f), vanId);
+        glm::vec3(1.0f) } });
 
 
     /*
     Cargar arco Luz cubo
     */
 
-    loader.loadOBJ("../GLFWFrontEnd/OBJ/Cubo.obj");
-
-    vertices = loader.getVertices();
-    normals = loader.getNormals();
-    indices = loader.getIndices();
-    uvs = loader.getTexCoords();
-
-    uint32_t luightId = m_Renderer->defineMesh(vertices, normals, uvs, indices);
-    m_Renderer->addLight(glm::scale(
+    std::vector<StreamPlacement> cubeLights;
+    cubeLights.push_back({ glm::scale(
         glm::translate(glm::mat4(1.0f), glm::vec3(10.0f, 0.f, 0.f))
         , glm::vec3(0.6f)),
-        luightId, glm::vec3(1.0f, 0.0f, 0.0f), 0, 0);
+        glm::vec3(1.0f, 0.0f, 0.0f), true });
 
-    m_Renderer->addLight(glm::scale(
+    cubeLights.push_back({ glm::scale(
         glm::translate(glm::mat4(1.0f), glm::vec3(7.50f, -07.5f, 0.f))
         , glm::vec3(0.6f)),
-        luightId, glm::vec3(0.0f, 1.0f, 0.0f), 0, 0);
+        glm::vec3(0.0f, 1.0f, 0.0f), true });
 
-    m_Renderer->addLight(glm::scale(
+    cubeLights.push_back({ glm::scale(
         glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -10.f, 0.f))
         , glm::vec3(0.6f)),
-        luightId, glm::vec3(0.0f, 0.0f, 1.0f), 0, 0);
+        glm::vec3(0.0f, 0.0f, 1.0f), true });
 
-    m_Renderer->addLight(glm::scale(
+    cubeLights.push_back({ glm::scale(
         glm::translate(glm::mat4(1.0f), glm::vec3(-7.50f, -7.5f, 0.f))
         , glm::vec3(0.6f)),
-        luightId, glm::vec3(0.70f, 0.70f, 0.0f), 0, 0);
+        glm::vec3(0.70f, 0.70f, 0.0f), true });
 
-    m_Renderer->addLight(glm::scale(
+    cubeLights.push_back({ glm::scale(
         glm::translate(glm::mat4(1.0f), glm::vec3(-10.0f, 0.f, 0.f))
         , glm::vec3(0.6f)),
-        luightId, glm::vec3(0.0f, 0.70f, 0.70f), 0, 0);
+        glm::vec3(0.0f, 0.70f, 0.70f), true });
+    streamer.request("../GLFWFrontEnd/OBJ/Cubo.obj", cubeLights);
 
 }
-void PruebaBaseline(VulkanRenderer* m_Renderer) {
-
-    OBJLoader loader;
+void PruebaBaseline(VulkanRenderer* m_Renderer, SceneStreamer& streamer) {
 
     /*
         Cargar primero el modelo de la Volkswagen touran
     */
 
 
-    loader.loadOBJ("../GLFWFrontEnd/OBJ/free_car_001.obj");
-
-    auto vertices = loader.getVertices();
-    auto normals = loader.getNormals();
-    auto indices = loader.getIndices();
-    auto uvs = loader.getTexCoords();
-
-    uint32_t vanId = m_Renderer->defineMesh(vertices, normals, uvs, indices);
-    m_Renderer->addMesh(glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.f, 0.f)), glm::radians(180.f), glm::vec3(1.f, 0.f, 0.f)), glm::vec3(1.0f), vanId);
+    streamer.request("../GLFWFrontEnd/OBJ/free_car_001.obj", { { glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.f, 0.f)), glm::radians(180.f), glm::vec3(1.f, 0.f, 0.f)), glm::vec3(1.0f) } });
 
 
     /*
@@ -534,7 +476,7 @@ int main(int argc, char* argv[]) {
 
     // Inicializar GLFW
     if (!glfwInit()) {
-        std::cerr << "Error: No se pudo inicializar GLFW" << std::endl;
+        LOG_ERROR("frontend", "Error: No se pudo inicializar GLFW");
         return -1;
     }
 
@@ -553,7 +495,7 @@ int main(int argc, char* argv[]) {
 
     // Verificar si se pudo crear la ventana
     if (!window) {
-        std::cerr << "Error: No se pudo crear la ventana" << std::endl;
+        LOG_ERROR("frontend", "Error: No se pudo crear la ventana");
         glfwTerminate();
         return -2;
     }
@@ -565,7 +507,7 @@ int main(int argc, char* argv[]) {
     // Activar v-sync
     glfwSwapInterval(1);
 
-    std::cout << "Size of glm::vec3: " << sizeof(glm::vec3)<<std::endl;
+    LOG_DEBUG("frontend", "Size of glm::vec3: %zu", sizeof(glm::vec3));
 
     CreateCamera(glm::vec3(1.f, 0.f, 1.f));
     CameraGLFWController::setupCallbacks(window, m_pCamera);
@@ -576,26 +518,32 @@ int main(int argc, char* argv[]) {
 
     float preload = static_cast<float>(glfwGetTime());
 
-    switch (prueba) {
-    case 1:
-        Prueba1(&m_Renderer);
-        break;
-    case 2:
-        Prueba2(&m_Renderer);
-        break;
-    case 3:
-        Prueba3(&m_Renderer);
-        break;
-    case 4:
-        Prueba4(&m_Renderer);
-        break;
-    default:
-        PruebaBaseline(&m_Renderer);
-        break;
+    // Vive hasta el final del bucle: los modelos que falten se hacen residentes frame a frame
+    SceneStreamer streamer(m_Renderer);
+    {
+        TRACE_SCOPE("loadScene", "frontend");
+        switch (prueba) {
+        case 1:
+            Prueba1(&m_Renderer, streamer);
+            break;
+        case 2:
+            Prueba2(&m_Renderer, streamer);
+            break;
+        case 3:
+            Prueba3(&m_Renderer, streamer);
+            break;
+        case 4:
+            Prueba4(&m_Renderer, streamer);
+            break;
+        default:
+            PruebaBaseline(&m_Renderer, streamer);
+            break;
+        }
     }
 
+    streamer.waitForFirstModel();
     float postload = static_cast<float>(glfwGetTime());
-    printf("Tiempo en cargar modelo: %f\n", postload - preload);
+    LOG_INFO("frontend", "Tiempo hasta el primer modelo: %f", postload - preload);
 
     m_Renderer.setOutputResolution(m_windowwidth, m_windowheight);
     m_Renderer.save(false);
@@ -611,13 +559,13 @@ int main(int argc, char* argv[]) {
     size_t bytesWritten = m_Renderer.copyResultBytes(imageBuffer, bufferSize);
 
     if (bytesWritten == 0) {
-        std::cerr << "Error: No se pudieron copiar los bytes del resultado" << std::endl;
+        LOG_ERROR("frontend", "Error: No se pudieron copiar los bytes del resultado");
         delete[] imageBuffer;
         glfwTerminate();
         return -5;
     }
 
-    printf("Datos copiados al bufer\n");
+    LOG_DEBUG("frontend", "Datos copiados al bufer");
     // Crea la textura OpenGL usando los datos copiados
     GLuint textureID = createTextureFromData(imageBuffer, m_windowwidth, m_windowheight, 4);
 
@@ -627,16 +575,16 @@ int main(int argc, char* argv[]) {
 
     
     if (!glIsTexture(textureID)) {
-        std::cerr << "Textura no vlida despus de getResultTextureId" << std::endl;
+        LOG_ERROR("frontend", "Textura no vlida despus de getResultTextureId");
     }
 
-    printf("texture created at: %zd\n", textureID);
-    std::cout << "Textura cargada" << std::endl;
+    LOG_DEBUG("frontend", "texture created at: %u", textureID);
+    LOG_DEBUG("frontend", "Textura cargada");
 
     // Configurar OpenGL
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // Fondo negro
 
-    std::cout << "Aplicacin iniciada. Presiona ESC para salir." << std::endl;
+    LOG_INFO("frontend", "Aplicacin iniciada. Presiona ESC para salir.");
 
     glm::mat4 prevmat = m_pCamera->GetVPMatrix();
 
@@ -644,6 +592,9 @@ int main(int argc, char* argv[]) {
 
     bool first = true;
     bool second = false;
+    bool traceKeyDown = false;
+
+    uint64_t shownVersion = m_Renderer.getResultVersion();
 
     // Bucle principal
     while (!glfwWindowShouldClose(window)) {
@@ -654,7 +605,7 @@ int main(int argc, char* argv[]) {
 
         if (second) {
             second = false;
-            printf("Loading time: %f\n", deltaTime);
+            LOG_INFO("frontend", "Loading time: %f", deltaTime);
         }
 
         m_pCamera->Update(deltaTime);
@@ -668,8 +619,15 @@ int main(int argc, char* argv[]) {
         }
 
         if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-            printf("Time since last frame: %.4f\n", deltaTime);
+            LOG_DEBUG("frontend", "Time since last frame: %.4f", deltaTime);
+        }
+
+        // Volcar la traza de CPU (solo si se compilo con RENDERER_TRACING)
+        bool traceKey = glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS;
+        if (traceKey && !traceKeyDown) {
+            trace::writeChromeTrace("trace.json");
         }
+        traceKeyDown = traceKey;
 
         // Limpiar pantalla
         glClear(GL_COLOR_BUFFER_BIT);
@@ -679,12 +637,17 @@ int main(int argc, char* argv[]) {
         renderTexturedQuad(textureID);
         //printf("Rendered quad\n");
         m_Renderer.setCamera(m_pCamera->GetVPMatrix(), glm::mat4(1.0f));
-        m_Renderer.copyResultBytes(imageBuffer, bufferSize);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_windowwidth, m_windowheight, GL_RGBA, GL_UNSIGNED_BYTE, imageBuffer);
-        checkGLError("glTexSubImage2D");
+        // Solo se copia la imagen si el renderer ha trazado algo nuevo
+        if (m_Renderer.getResultVersion() != shownVersion) {
+            shownVersion = m_Renderer.getResultVersion();
+            m_Renderer.copyResultBytes(imageBuffer, bufferSize);
+            glBindTexture(GL_TEXTURE_2D, textureID);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_windowwidth, m_windowheight, GL_RGBA, GL_UNSIGNED_BYTE, imageBuffer);
+            checkGLError("glTexSubImage2D");
+        }
 
         //Rerenderizar vulkan
+        streamer.update();
         m_Renderer.render();
 
         // Intercambiar buffers
@@ -710,6 +673,7 @@ void initOBJ_l() {
     objl::Loader Loader;
 
     // Load .obj File
+    TRACE_SCOPE("objl::LoadFile", "frontend");
     bool loadout = Loader.LoadFile("../GLFWFrontEnd/OBJ/VW_Touran_2007.obj");
 
     std::vector<glm::vec3> vertices = {};
@@ -879,7 +843,7 @@ void initRT(){
 
 
     uint32_t meshid = m_Renderer.defineMesh(vertData, normData, uvData, indices);
-    printf("Mesh Defined\n");
+    LOG_DEBUG("frontend", "Mesh Defined");
 
     m_Renderer.addLight(glm::translate(glm::mat4(1.0f), glm::vec3(1.4f, 0.f, 0.f)), meshid, glm::vec3(1.0f,0.0f,0.0f),0,0);
     m_Renderer.addMesh(glm::translate(glm::mat4(1.0f), glm::vec3(3.0f, 0.f, 0.f)), glm::vec3(1.0f, 0.0f, 0.0f), meshid);
@@ -893,15 +857,9 @@ void initRT(){
     m_Renderer.setCamera(m_pCamera->GetVPMatrix(), glm::mat4(1.0f));
     //m_Renderer.setCamera(glm::mat4(1.0f), glm::mat4(1.0f));
 
-    printf("Rendered everything\n");
+    LOG_DEBUG("frontend", "Rendered everything");
 }
 
-bool ExtractMeshAttributes(const tinygltf::Model& model, const tinygltf::Primitive& primitive,
-    std::vector<glm::vec3>& outVertices,
-    std::vector<glm::vec3>& outNormals,
-    std::vector<glm::vec2>& outUVs,
-    std::vector<uint32_t>& outIndices);
-
 void initGLTF() {
     tinygltf::TinyGLTF loader;
     tinygltf::Model model;
@@ -912,33 +870,51 @@ void initGLTF() {
 
     //free_car_001.obj
     //VW_Touran_2007
+    TRACE_SCOPE("initGLTF", "frontend");
     bool ret = loader.LoadBinaryFromFile(&model, &err, &warn, "../GLFWFrontEnd/OBJ/VW_Touran_2007.glb");
     //bool ret = loader.LoadBinaryFromFile(&model, &err, &warn, "../GLFWFrontEnd/OBJ/free_car_001.glb");
 
     if (!warn.empty()) {
-        std::cout << "Warning: " << warn << std::endl;
+        LOG_WARN("frontend", "Warning: %s", warn.c_str());
     }
     if (!err.empty()) {
-        std::cerr << "Error: " << err << std::endl;
+        LOG_ERROR("frontend", "Error: %s", err.c_str());
     }
     if (!ret) {
-        std::cerr << "Failed to load .glb" << std::endl;
+        LOG_ERROR("frontend", "Failed to load .glb");
         return;
     }
 
-    for (const auto& mesh : model.meshes) {
-        for (const auto& prim : mesh.primitives) {
-            std::vector<glm::vec3> vertices;
-            std::vector<glm::vec3> normals;
-            std::vector<glm::vec2> uvs;
-            std::vector<uint32_t> indices;
+    // Extraccion en paralelo; defineMesh sigue en este hilo. Cada malla glTF se define una vez
+    // y cada nodo que la referencia la anade con su transformacion global
+    GLTFHelper helper;
+    if (!helper.DecompressBufferViews(model)) {
+        LOG_ERROR("frontend", "Failed to decode the compressed buffers of the .glb");
+        return;
+    }
+    std::vector<GLTFPrimitiveData> primitives;
+    helper.ExtractPrimitives(model, primitives);
+    std::vector<std::vector<std::pair<uint32_t, glm::vec3>>> meshIds(model.meshes.size());
+    for (const GLTFPrimitiveData& prim : primitives) {
+        if (prim.valid) {
+            uint32_t id = m_Renderer.defineMesh(prim.vertices, prim.normals, prim.uvs, prim.indices);
+            meshIds[prim.mesh].push_back({ id, GLTFHelper::MaterialColor(model, prim.material) });
+        }
+    }
 
-            if (ExtractMeshAttributes(model, prim, vertices, normals, uvs, indices)) {
-                uint32_t id = m_Renderer.defineMesh(vertices, normals, uvs, indices);
-                m_Renderer.addMesh(glm::mat4(1.0f), glm::vec3(1.0f), id);
+    std::vector<GLTFInstance> instances;
+    helper.CollectInstances(model, instances);
+    bool full = false;
+    for (size_t i = 0; i < instances.size() && !full; i++) {
+        for (const auto& mesh : meshIds[instances[i].mesh]) {
+            if (!m_Renderer.addMesh(instances[i].transform, mesh.second, mesh.first)) {
+                LOG_ERROR("frontend", "glTF: the scene is full, node instances from %zu on are skipped", i);
+                full = true;
+                break;
             }
         }
     }
+    LOG_INFO("frontend", "glTF: %zu primitives, %zu node instances", primitives.size(), instances.size());
 
     // 6. MALLA TRASERA (plano vertical al fondo)
     std::vector<Vertex> backMesh = {
@@ -955,96 +931,6 @@ void initGLTF() {
 
 }
 
-bool ExtractMeshAttributes(const tinygltf::Model& model, const tinygltf::Primitive& primitive,
-    std::vector<glm::vec3>& outVertices,
-    std::vector<glm::vec3>& outNormals,
-    std::vector<glm::vec2>& outUVs,
-    std::vector<uint32_t>& outIndices) {
-    auto getBufferViewData = [&](int accessorIndex) -> const unsigned char* {
-        const auto& accessor = model.accessors[accessorIndex];
-        const auto& view = model.bufferViews[accessor.bufferView];
-        const auto& buffer = model.buffers[view.buffer];
-        return &buffer.data[view.byteOffset + accessor.byteOffset];
-        };
-
-    // === INDICES ===
-    if (primitive.indices < 0) {
-        std::cerr << "Mesh has no indices, skipping." << std::endl;
-        return false;
-    }
-
-    const auto& indexAccessor = model.accessors[primitive.indices];
-    const auto& indexView = model.bufferViews[indexAccessor.bufferView];
-    const auto& indexBuffer = model.buffers[indexView.buffer];
-    const unsigned char* indexData = &indexBuffer.data[indexView.byteOffset + indexAccessor.byteOffset];
-
-    outIndices.resize(indexAccessor.count);
-
-    for (size_t i = 0; i < indexAccessor.count; ++i) {
-        switch (indexAccessor.componentType) {
-        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-            outIndices[i] = ((const uint16_t*)indexData)[i];
-            break;
-        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-            outIndices[i] = ((const uint32_t*)indexData)[i];
-            break;
-        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-            outIndices[i] = ((const uint8_t*)indexData)[i];
-            break;
-        default:
-            std::cerr << "Unsupported index type\n";
-            return false;
-        }
-    }
-
-    // === POSITION ===
-    if (primitive.attributes.find("POSITION") == primitive.attributes.end()) {
-        std::cerr << "Mesh missing POSITION attribute\n";
-        return false;
-    }
-    const float* positionData = reinterpret_cast<const float*>(getBufferViewData(primitive.attributes.at("POSITION")));
-
-    // === NORMAL ===
-    const float* normalData = nullptr;
-    if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
-        normalData = reinterpret_cast<const float*>(getBufferViewData(primitive.attributes.at("NORMAL")));
-    }
-
-    // === TEXCOORD_0 ===
-    const float* uvData = nullptr;
-    if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end()) {
-        uvData = reinterpret_cast<const float*>(getBufferViewData(primitive.attributes.at("TEXCOORD_0")));
-    }
-
-    size_t vertexCount = model.accessors[primitive.attributes.at("POSITION")].count;
-    outVertices.reserve(vertexCount);
-    outNormals.reserve(vertexCount);
-    outUVs.reserve(vertexCount);
-
-    for (size_t i = 0; i < vertexCount; ++i) {
-        glm::vec3 pos(positionData[i * 3 + 0], positionData[i * 3 + 1], positionData[i * 3 + 2]);
-        outVertices.push_back(pos);
-
-        if (normalData) {
-            glm::vec3 n(normalData[i * 3 + 0], normalData[i * 3 + 1], normalData[i * 3 + 2]);
-            outNormals.push_back(n);
-        }
-        else {
-            outNormals.push_back(glm::vec3(0.0f));  // dummy normal
-        }
-
-        if (uvData) {
-            glm::vec2 uv(uvData[i * 2 + 0], uvData[i * 2 + 1]);
-            outUVs.push_back(uv);
-        }
-        else {
-            outUVs.push_back(glm::vec2(0.0f));  // dummy UV
-        }
-    }
-
-    return true;
-}
-
 #pragma endregion
 
 #pragma region camera
@@ -1054,12 +940,12 @@ void CreateCamera(glm::vec3 pos) {
     float znear = 0.1f;
     float zfar = 1000.0f;
     CreateCamera(pos, FOV, znear, zfar);
-    printf("Created camera");
+    LOG_DEBUG("frontend", "Created camera");
 }
 
 void CreateCamera(glm::vec3 pos, float FOV, float znear, float zfar) {
     if ((m_windowwidth == 0) || (m_windowheight == 0)) {
-        printf("Invalid window dims");
+        LOG_ERROR("frontend", "Invalid window dims");
         exit(1);
     }
 
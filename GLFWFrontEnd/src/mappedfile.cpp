@@ -0,0 +1,103 @@
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Log.h"
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("loader", "Cannot open %s", path.c_str());
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        LOG_ERROR("loader", "Cannot get the size of %s", path.c_str());
+        return false;
+    }
+    m_file = file;
+    m_size = (size_t)fileSize.QuadPart;
+    m_open = true;
+    // CreateFileMapping no acepta ficheros vacios
+    if (m_size == 0) {
+        return true;
+    }
+    m_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_mapping) {
+        m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (!m_data) {
+        LOG_ERROR("loader", "Cannot map %s (error %lu)", path.c_str(), GetLastError());
+        close();
+        return false;
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("loader", "Cannot open %s", path.c_str());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        LOG_ERROR("loader", "Cannot get the size of %s", path.c_str());
+        return false;
+    }
+    m_size = (size_t)st.st_size;
+    m_open = true;
+    if (m_size > 0) {
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            LOG_ERROR("loader", "Cannot map %s", path.c_str());
+            m_size = 0;
+            m_open = false;
+            return false;
+        }
+        // Se recorre entero: que el kernel lea por delante
+        madvise(data, m_size, MADV_WILLNEED);
+        m_data = (const char*)data;
+    }
+    // El mapeo sigue siendo valido sin el descriptor
+    ::close(fd);
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle((HANDLE)m_mapping);
+    }
+    if (m_file) {
+        CloseHandle((HANDLE)m_file);
+    }
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    if (m_data) {
+        munmap((void*)m_data, m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
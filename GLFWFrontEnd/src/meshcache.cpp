@@ -0,0 +1,551 @@
+#include "meshcache.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <system_error>
+#include <thread>
+
+#include "json.hpp"
+#include "Trace.h"
+#include "Log.h"
+
+namespace {
+
+    const char MAGIC[4] = { 'V', 'R', 'M', 'C' };
+    const uint64_t SECTION_ALIGNMENT = 16;
+
+    enum MeshCacheSectionType : uint32_t {
+        SECTION_POSITIONS = 1,
+        SECTION_NORMALS = 2,
+        SECTION_UVS = 3,
+        SECTION_INDICES = 4,
+        SECTION_SUBMESHES = 5,
+        SECTION_INSTANCES = 6,
+        SECTION_DEPENDENCIES = 7
+    };
+
+    struct MeshCacheHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t headerSize;
+        uint32_t sectionCount;
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        uint64_t sourceHash;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    struct MeshCacheSection {
+        uint32_t type;
+        uint32_t elementSize;
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    // Buffer externo de un .gltf, en el mismo orden que su array "buffers"
+    struct MeshCacheDependency {
+        uint64_t size;
+        int64_t time;
+        uint64_t hash;
+    };
+
+    static_assert(sizeof(MeshCacheHeader) == 64, "MeshCacheHeader layout");
+    static_assert(sizeof(MeshCacheSection) == 24, "MeshCacheSection layout");
+    static_assert(sizeof(MeshCacheSubmesh) == 40, "MeshCacheSubmesh layout");
+    static_assert(sizeof(MeshCacheInstance) == 80, "MeshCacheInstance layout");
+    static_assert(sizeof(MeshCacheDependency) == 24, "MeshCacheDependency layout");
+    static_assert(sizeof(glm::vec3) == 12 && sizeof(glm::vec2) == 8, "packed glm vectors");
+
+    struct SourceInfo {
+        uint64_t size = 0;
+        int64_t time = 0;
+    };
+
+    bool GetSourceInfo(const std::string& path, SourceInfo& info) {
+        std::error_code ec;
+        info.size = (uint64_t)std::filesystem::file_size(path, ec);
+        if (ec) {
+            return false;
+        }
+        info.time = (int64_t)std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+        return !ec;
+    }
+
+    bool HashFile(const std::string& path, uint64_t& hash) {
+        TRACE_SCOPE_DETAIL("HashSource", "frontend", path);
+        MappedFile source;
+        if (!source.open(path)) {
+            return false;
+        }
+        hash = MeshCache::Hash(source.data(), source.size());
+        return true;
+    }
+
+    std::string DecodeUri(const std::string& uri) {
+        std::string out;
+        for (size_t i = 0; i < uri.size(); i++) {
+            if (uri[i] == '%' && i + 2 < uri.size() && isxdigit((unsigned char)uri[i + 1]) && isxdigit((unsigned char)uri[i + 2])) {
+                out += (char)strtol(uri.substr(i + 1, 2).c_str(), nullptr, 16);
+                i += 2;
+            }
+            else {
+                out += uri[i];
+            }
+        }
+        return out;
+    }
+
+    // La geometria de un .gltf esta en sus buffers externos (.bin), no solo en el JSON: sus rutas, en el orden de
+    // "buffers". Los data: URI van dentro del JSON y ya cuentan en su tamano y hash. Un .glb o un .obj no tiene ninguno
+    bool ExternalBuffers(const std::string& sourcePath, std::vector<std::string>& paths) {
+        paths.clear();
+        if (sourcePath.size() < 5 || sourcePath.compare(sourcePath.size() - 5, 5, ".gltf") != 0) {
+            return true;
+        }
+        MappedFile source;
+        if (!source.open(sourcePath)) {
+            return false;
+        }
+        nlohmann::json doc = nlohmann::json::parse(source.data(), source.data() + source.size(), nullptr, false);
+        if (doc.is_discarded()) {
+            return false;
+        }
+        auto buffers = doc.find("buffers");
+        if (buffers == doc.end() || !buffers->is_array()) {
+            return true;
+        }
+        std::filesystem::path dir = std::filesystem::path(sourcePath).parent_path();
+        for (const nlohmann::json& buffer : *buffers) {
+            auto uri = buffer.find("uri");
+            if (uri == buffer.end() || !uri->is_string()) {
+                continue;
+            }
+            std::string value = uri->get<std::string>();
+            if (value.compare(0, 5, "data:") != 0) {
+                paths.push_back((dir / DecodeUri(value)).string());
+            }
+        }
+        return true;
+    }
+
+    // Mismo criterio que para la fuente: tamano y fecha iguales, o solo la fecha distinta y el mismo hash
+    bool DependenciesMatch(const std::string& sourcePath, const MeshCacheDependency* dependencies, size_t count) {
+        std::vector<std::string> paths;
+        if (!ExternalBuffers(sourcePath, paths) || paths.size() != count) {
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            SourceInfo info;
+            if (!GetSourceInfo(paths[i], info) || info.size != dependencies[i].size) {
+                return false;
+            }
+            uint64_t hash = 0;
+            if (info.time != dependencies[i].time && (!HashFile(paths[i], hash) || hash != dependencies[i].hash)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Nombre temporal unico por escritura: varios hilos del AssetLoader (o varios procesos) pueden escribir la cache
+    // del mismo fichero a la vez, y cada uno renombra solo el suyo
+    std::string TempPath(const std::string& cachePath) {
+        static std::atomic<uint32_t> counter(0);
+        size_t thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+        long long tick = (long long)std::chrono::steady_clock::now().time_since_epoch().count();
+        return cachePath + "." + std::to_string(thread) + "." + std::to_string(tick) + "." + std::to_string(counter++) + ".tmp";
+    }
+
+    inline uint64_t Rotl(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline uint64_t ReadWord(const uint8_t* p) {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        return w;
+    }
+
+    const uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+    const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+
+    inline uint64_t Round(uint64_t acc, uint64_t word) {
+        return Rotl(acc + word * PRIME2, 31) * PRIME1;
+    }
+
+    // Secciones alineadas: cada una empieza en un multiplo de SECTION_ALIGNMENT
+    inline uint64_t Align(uint64_t offset) {
+        return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+    }
+
+    // Busca una seccion y comprueba que cabe en el fichero
+    const void* FindSection(const char* data, size_t size, const MeshCacheSection* sections, uint32_t sectionCount,
+        uint32_t type, uint32_t elementSize, size_t& count) {
+        for (uint32_t i = 0; i < sectionCount; i++) {
+            const MeshCacheSection& section = sections[i];
+            if (section.type != type) {
+                continue;
+            }
+            if (section.elementSize != elementSize || section.offset % SECTION_ALIGNMENT != 0 || section.offset > size ||
+                section.count > (size - section.offset) / elementSize) {
+                return nullptr;
+            }
+            count = (size_t)section.count;
+            return data + section.offset;
+        }
+        return nullptr;
+    }
+}
+
+bool MeshCacheData::addSubmesh(const std::vector<glm::vec3>& vtcs, const std::vector<glm::vec3>& nrmls,
+    const std::vector<glm::vec2>& uv, const std::vector<uint32_t>& inds) {
+    if (vtcs.size() != nrmls.size() || vtcs.size() != uv.size()) {
+        return false;
+    }
+    MeshCacheSubmesh submesh;
+    submesh.firstVertex = (uint32_t)vertices.size();
+    submesh.vertexCount = (uint32_t)vtcs.size();
+    submesh.firstIndex = (uint32_t)indices.size();
+    submesh.indexCount = (uint32_t)inds.size();
+    submesh.boundsMin = glm::vec3(0.0f);
+    submesh.boundsMax = glm::vec3(0.0f);
+    if (!vtcs.empty()) {
+        submesh.boundsMin = submesh.boundsMax = vtcs[0];
+        for (const glm::vec3& v : vtcs) {
+            submesh.boundsMin = glm::min(submesh.boundsMin, v);
+            submesh.boundsMax = glm::max(submesh.boundsMax, v);
+        }
+    }
+    vertices.insert(vertices.end(), vtcs.begin(), vtcs.end());
+    normals.insert(normals.end(), nrmls.begin(), nrmls.end());
+    uvs.insert(uvs.end(), uv.begin(), uv.end());
+    indices.insert(indices.end(), inds.begin(), inds.end());
+    submeshes.push_back(submesh);
+    return true;
+}
+
+std::string MeshCache::CachePath(const std::string& sourcePath) {
+    return sourcePath + ".meshcache";
+}
+
+uint64_t MeshCache::Hash(const void* data, size_t size) {
+    const uint8_t* p = (const uint8_t*)data;
+    const uint8_t* end = p + size;
+
+    // Cuatro acumuladores independientes para no quedar limitados por la latencia de la multiplicacion
+    uint64_t acc[4] = { PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1 };
+    for (; end - p >= 32; p += 32) {
+        acc[0] = Round(acc[0], ReadWord(p));
+        acc[1] = Round(acc[1], ReadWord(p + 8));
+        acc[2] = Round(acc[2], ReadWord(p + 16));
+        acc[3] = Round(acc[3], ReadWord(p + 24));
+    }
+    uint64_t h = Rotl(acc[0], 1) + Rotl(acc[1], 7) + Rotl(acc[2], 12) + Rotl(acc[3], 18) + (uint64_t)size;
+    for (; end - p >= 8; p += 8) {
+        h = Rotl(h ^ Round(0, ReadWord(p)), 27) * PRIME1 + PRIME2;
+    }
+    for (; p < end; p++) {
+        h = Rotl(h ^ (*p * PRIME1), 11) * PRIME2;
+    }
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME1;
+    h ^= h >> 32;
+    return h;
+}
+
+bool MeshCache::ReadBounds(const std::string& sourcePath, glm::vec3& bmin, glm::vec3& bmax) {
+    TRACE_SCOPE_DETAIL("MeshCache::ReadBounds", "frontend", sourcePath);
+    SourceInfo source;
+    if (!GetSourceInfo(sourcePath, source)) {
+        return false;
+    }
+    FILE* f = fopen(CachePath(sourcePath).c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    MeshCacheHeader header;
+    bool ok = fread(&header, sizeof(header), 1, f) == 1;
+    fclose(f);
+    // Sin hash ni buffers externos: si la fecha no coincide no hay limites, open() decide despues
+    if (!ok || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != Version ||
+        header.headerSize != sizeof(header) || header.sourceSize != source.size || header.sourceTime != source.time) {
+        return false;
+    }
+    bmin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    bmax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    return true;
+}
+
+bool MeshCache::open(const std::string& sourcePath) {
+    TRACE_SCOPE_DETAIL("MeshCache::open", "frontend", sourcePath);
+    close();
+
+    std::string cachePath = CachePath(sourcePath);
+    SourceInfo source;
+    if (!GetSourceInfo(sourcePath, source) || !std::filesystem::exists(cachePath)) {
+        return false;
+    }
+    if (!m_file.open(cachePath)) {
+        return false;
+    }
+
+    const char* data = m_file.data();
+    size_t size = m_file.size();
+    MeshCacheHeader header;
+    if (size < sizeof(header)) {
+        LOG_WARN("loader", "Mesh cache %s is truncated, ignored", cachePath.c_str());
+        close();
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != Version || header.headerSize != sizeof(header) ||
+        header.sectionCount > (size - sizeof(header)) / sizeof(MeshCacheSection)) {
+        LOG_INFO("loader", "Mesh cache %s is from another version, ignored", cachePath.c_str());
+        close();
+        return false;
+    }
+
+    // Tamano y fecha iguales: valida. Solo la fecha distinta (copia, checkout): se compara el hash del contenido
+    if (header.sourceSize != source.size) {
+        LOG_INFO("loader", "Mesh cache %s is stale", cachePath.c_str());
+        close();
+        return false;
+    }
+    if (header.sourceTime != source.time) {
+        uint64_t hash = 0;
+        if (!HashFile(sourcePath, hash) || hash != header.sourceHash) {
+            LOG_INFO("loader", "Mesh cache %s is stale", cachePath.c_str());
+            close();
+            return false;
+        }
+        // Se actualiza la fecha para no volver a calcular el hash en la siguiente carga. Copia con la cabecera
+        // nueva y rename, como save(): otro lector nunca ve la cache a medio escribir
+        MeshCacheHeader touched = header;
+        touched.sourceTime = source.time;
+        std::string tmpPath = TempPath(cachePath);
+        FILE* f = fopen(tmpPath.c_str(), "wb");
+        bool ok = f && fwrite(&touched, sizeof(touched), 1, f) == 1 &&
+            fwrite(data + sizeof(touched), 1, size - sizeof(touched), f) == size - sizeof(touched);
+        ok = f && (fclose(f) == 0) && ok;
+        // La proyeccion se cierra antes del rename: en Windows no se puede reemplazar un fichero proyectado
+        close();
+        std::error_code ec;
+        if (ok) {
+            std::filesystem::rename(tmpPath, cachePath, ec);
+        }
+        if (!ok || ec) {
+            std::filesystem::remove(tmpPath, ec);
+        }
+        LOG_DEBUG("loader", "Mesh cache %s: source touched but unchanged", cachePath.c_str());
+        if (!m_file.open(cachePath)) {
+            return false;
+        }
+        data = m_file.data();
+        size = m_file.size();
+    }
+
+    const MeshCacheSection* sections = (const MeshCacheSection*)(data + sizeof(header));
+    size_t normalCount = 0, uvCount = 0;
+    m_vertices = (const glm::vec3*)FindSection(data, size, sections, header.sectionCount, SECTION_POSITIONS, sizeof(glm::vec3), m_vertexCount);
+    m_normals = (const glm::vec3*)FindSection(data, size, sections, header.sectionCount, SECTION_NORMALS, sizeof(glm::vec3), normalCount);
+    m_uvs = (const glm::vec2*)FindSection(data, size, sections, header.sectionCount, SECTION_UVS, sizeof(glm::vec2), uvCount);
+    m_indices = (const uint32_t*)FindSection(data, size, sections, header.sectionCount, SECTION_INDICES, sizeof(uint32_t), m_indexCount);
+    m_submeshes = (const MeshCacheSubmesh*)FindSection(data, size, sections, header.sectionCount, SECTION_SUBMESHES, sizeof(MeshCacheSubmesh), m_submeshCount);
+    // Opcional: sin ella cada submesh va una vez en el origen
+    m_instances = (const MeshCacheInstance*)FindSection(data, size, sections, header.sectionCount, SECTION_INSTANCES, sizeof(MeshCacheInstance), m_instanceCount);
+    if (!m_instances) {
+        m_instanceCount = 0;
+    }
+    size_t dependencyCount = 0;
+    const MeshCacheDependency* dependencies = (const MeshCacheDependency*)FindSection(data, size, sections, header.sectionCount,
+        SECTION_DEPENDENCIES, sizeof(MeshCacheDependency), dependencyCount);
+    if (!dependencies) {
+        dependencyCount = 0;
+    }
+    if (!DependenciesMatch(sourcePath, dependencies, dependencyCount)) {
+        LOG_INFO("loader", "Mesh cache %s is stale (external buffers changed)", cachePath.c_str());
+        close();
+        return false;
+    }
+
+    bool valid = m_vertices && m_normals && m_uvs && m_indices && m_submeshes &&
+        normalCount == m_vertexCount && uvCount == m_vertexCount;
+    for (size_t i = 0; valid && i < m_submeshCount; i++) {
+        const MeshCacheSubmesh& sub = m_submeshes[i];
+        valid = (uint64_t)sub.firstVertex + sub.vertexCount <= m_vertexCount &&
+            (uint64_t)sub.firstIndex + sub.indexCount <= m_indexCount;
+        // Un indice fuera de rango acabaria en el dispositivo: se recorren una vez al abrir
+        for (uint32_t j = 0; valid && j < sub.indexCount; j++) {
+            valid = m_indices[sub.firstIndex + j] < sub.vertexCount;
+        }
+    }
+    for (size_t i = 0; valid && i < m_instanceCount; i++) {
+        valid = m_instances[i].submesh < m_submeshCount;
+    }
+    if (!valid) {
+        LOG_WARN("loader", "Mesh cache %s is corrupt, ignored", cachePath.c_str());
+        close();
+        return false;
+    }
+
+    m_boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    m_boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    LOG_DEBUG("loader", "Mesh cache %s: %zu submeshes, %zu instances, %zu vertices, %zu triangles", cachePath.c_str(),
+        m_submeshCount, m_instanceCount, m_vertexCount, m_indexCount / 3);
+    return true;
+}
+
+void MeshCache::close() {
+    m_file.close();
+    m_vertices = nullptr;
+    m_normals = nullptr;
+    m_uvs = nullptr;
+    m_indices = nullptr;
+    m_submeshes = nullptr;
+    m_instances = nullptr;
+    m_vertexCount = m_indexCount = m_submeshCount = m_instanceCount = 0;
+    m_boundsMin = m_boundsMax = glm::vec3(0.0f);
+}
+
+void MeshCache::copySubmesh(size_t i, std::vector<glm::vec3>& vtcs, std::vector<glm::vec3>& nrmls,
+    std::vector<glm::vec2>& uv, std::vector<uint32_t>& inds) const {
+    const MeshCacheSubmesh& sub = m_submeshes[i];
+    vtcs.assign(m_vertices + sub.firstVertex, m_vertices + sub.firstVertex + sub.vertexCount);
+    nrmls.assign(m_normals + sub.firstVertex, m_normals + sub.firstVertex + sub.vertexCount);
+    uv.assign(m_uvs + sub.firstVertex, m_uvs + sub.firstVertex + sub.vertexCount);
+    inds.assign(m_indices + sub.firstIndex, m_indices + sub.firstIndex + sub.indexCount);
+}
+
+void MeshCache::copyAll(MeshCacheData& out) const {
+    out.vertices.assign(m_vertices, m_vertices + m_vertexCount);
+    out.normals.assign(m_normals, m_normals + m_vertexCount);
+    out.uvs.assign(m_uvs, m_uvs + m_vertexCount);
+    out.indices.assign(m_indices, m_indices + m_indexCount);
+    out.submeshes.assign(m_submeshes, m_submeshes + m_submeshCount);
+    out.instances.assign(m_instances, m_instances + m_instanceCount);
+}
+
+bool MeshCache::write(const std::string& sourcePath, const MeshCacheData& data) {
+    TRACE_SCOPE_DETAIL("MeshCache::write", "frontend", sourcePath);
+    std::string cachePath = CachePath(sourcePath);
+
+    MeshCacheHeader header = {};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = Version;
+    header.headerSize = sizeof(header);
+    SourceInfo source;
+    if (!GetSourceInfo(sourcePath, source) || !HashFile(sourcePath, header.sourceHash)) {
+        return false;
+    }
+    header.sourceSize = source.size;
+    header.sourceTime = source.time;
+
+    std::vector<std::string> bufferPaths;
+    std::vector<MeshCacheDependency> dependencies;
+    if (!ExternalBuffers(sourcePath, bufferPaths)) {
+        return false;
+    }
+    for (const std::string& path : bufferPaths) {
+        SourceInfo info;
+        MeshCacheDependency dependency = {};
+        if (!GetSourceInfo(path, info) || !HashFile(path, dependency.hash)) {
+            LOG_WARN("loader", "Cannot read %s, referenced by %s: mesh cache not written", path.c_str(), sourcePath.c_str());
+            return false;
+        }
+        dependency.size = info.size;
+        dependency.time = info.time;
+        dependencies.push_back(dependency);
+    }
+
+    // Limites de la escena: con instancias, las cajas de las submeshes colocadas por cada una
+    glm::vec3 bmin(0.0f), bmax(0.0f);
+    if (data.instances.empty()) {
+        for (size_t i = 0; i < data.submeshes.size(); i++) {
+            bmin = (i == 0) ? data.submeshes[i].boundsMin : glm::min(bmin, data.submeshes[i].boundsMin);
+            bmax = (i == 0) ? data.submeshes[i].boundsMax : glm::max(bmax, data.submeshes[i].boundsMax);
+        }
+    }
+    for (size_t i = 0; i < data.instances.size(); i++) {
+        if (data.instances[i].submesh >= data.submeshes.size()) {
+            return false;
+        }
+        const MeshCacheSubmesh& submesh = data.submeshes[data.instances[i].submesh];
+        for (int corner = 0; corner < 8; corner++) {
+            glm::vec3 p((corner & 1) ? submesh.boundsMax.x : submesh.boundsMin.x,
+                (corner & 2) ? submesh.boundsMax.y : submesh.boundsMin.y,
+                (corner & 4) ? submesh.boundsMax.z : submesh.boundsMin.z);
+            glm::vec3 world = glm::vec3(data.instances[i].transform * glm::vec4(p, 1.0f));
+            bmin = (i == 0 && corner == 0) ? world : glm::min(bmin, world);
+            bmax = (i == 0 && corner == 0) ? world : glm::max(bmax, world);
+        }
+    }
+    for (int k = 0; k < 3; k++) {
+        header.boundsMin[k] = bmin[k];
+        header.boundsMax[k] = bmax[k];
+    }
+
+    struct Payload {
+        uint32_t type;
+        uint32_t elementSize;
+        const void* data;
+        size_t count;
+    };
+    const Payload payloads[] = {
+        { SECTION_POSITIONS, sizeof(glm::vec3), data.vertices.data(), data.vertices.size() },
+        { SECTION_NORMALS, sizeof(glm::vec3), data.normals.data(), data.normals.size() },
+        { SECTION_UVS, sizeof(glm::vec2), data.uvs.data(), data.uvs.size() },
+        { SECTION_INDICES, sizeof(uint32_t), data.indices.data(), data.indices.size() },
+        { SECTION_SUBMESHES, sizeof(MeshCacheSubmesh), data.submeshes.data(), data.submeshes.size() },
+        { SECTION_INSTANCES, sizeof(MeshCacheInstance), data.instances.data(), data.instances.size() },
+        { SECTION_DEPENDENCIES, sizeof(MeshCacheDependency), dependencies.data(), dependencies.size() }
+    };
+    const uint32_t sectionCount = sizeof(payloads) / sizeof(payloads[0]);
+    header.sectionCount = sectionCount;
+
+    MeshCacheSection sections[sectionCount];
+    uint64_t offset = Align(sizeof(header) + sizeof(sections));
+    for (uint32_t i = 0; i < sectionCount; i++) {
+        sections[i] = { payloads[i].type, payloads[i].elementSize, offset, (uint64_t)payloads[i].count };
+        offset = Align(offset + (uint64_t)payloads[i].count * payloads[i].elementSize);
+    }
+
+    std::string tmpPath = TempPath(cachePath);
+    FILE* f = fopen(tmpPath.c_str(), "wb");
+    if (!f) {
+        LOG_WARN("loader", "Cannot write the mesh cache %s", cachePath.c_str());
+        return false;
+    }
+    static const char zeros[SECTION_ALIGNMENT] = {};
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(sections, sizeof(sections), 1, f) == 1;
+    uint64_t written = sizeof(header) + sizeof(sections);
+    for (uint32_t i = 0; ok && i < sectionCount; i++) {
+        ok = fwrite(zeros, 1, (size_t)(sections[i].offset - written), f) == sections[i].offset - written;
+        size_t bytes = payloads[i].count * payloads[i].elementSize;
+        ok = ok && (bytes == 0 || fwrite(payloads[i].data, 1, bytes, f) == bytes);
+        written = sections[i].offset + bytes;
+    }
+    ok = (fclose(f) == 0) && ok;
+
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tmpPath, cachePath, ec);
+    }
+    if (!ok || ec) {
+        std::filesystem::remove(tmpPath, ec);
+        LOG_WARN("loader", "Cannot write the mesh cache %s", cachePath.c_str());
+        return false;
+    }
+    LOG_DEBUG("loader", "Mesh cache %s written (%zu submeshes, %llu bytes)", cachePath.c_str(), data.submeshes.size(),
+        (unsigned long long)written);
+    return true;
+}
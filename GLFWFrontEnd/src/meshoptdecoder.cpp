@@ -0,0 +1,416 @@
+#include "meshoptdecoder.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+    // Formato de atributos (version 0)
+    const unsigned char VERTEX_HEADER = 0xa0;
+    const size_t VERTEX_BLOCK_SIZE_BYTES = 8192;
+    const size_t VERTEX_BLOCK_MAX_SIZE = 256;
+    const size_t BYTE_GROUP_SIZE = 16;
+    const size_t BYTE_GROUP_DECODE_LIMIT = 24;
+    const size_t TAIL_MIN_SIZE = 32;
+
+    // Formato de indices (versiones 0 y 1)
+    const unsigned char INDEX_HEADER = 0xe0;
+    const unsigned char SEQUENCE_HEADER = 0xd0;
+
+    size_t VertexBlockSize(size_t vertexSize) {
+        size_t result = VERTEX_BLOCK_SIZE_BYTES / vertexSize;
+        result &= ~(BYTE_GROUP_SIZE - 1);
+        return result < VERTEX_BLOCK_MAX_SIZE ? result : VERTEX_BLOCK_MAX_SIZE;
+    }
+
+    inline unsigned char Unzigzag8(unsigned char v) {
+        return (unsigned char)((0 - (v & 1)) ^ (v >> 1));
+    }
+
+    // 16 bytes codificados con 0, 2, 4 u 8 bits; los valores que no caben en 2/4 bits van despues, enteros
+    const unsigned char* DecodeBytesGroup(const unsigned char* data, unsigned char* buffer, int bitslog2) {
+        switch (bitslog2) {
+        case 0:
+            memset(buffer, 0, BYTE_GROUP_SIZE);
+            return data;
+        case 1:
+        case 2: {
+            int bits = 1 << bitslog2;
+            int perByte = 8 / bits;
+            unsigned char escape = (unsigned char)((1 << bits) - 1);
+            const unsigned char* extra = data + BYTE_GROUP_SIZE / perByte;
+            for (size_t i = 0; i < BYTE_GROUP_SIZE / perByte; i++) {
+                unsigned char byte = data[i];
+                for (int k = 0; k < perByte; k++) {
+                    unsigned char enc = (unsigned char)(byte >> (8 - bits));
+                    byte = (unsigned char)(byte << bits);
+                    if (enc == escape) {
+                        *buffer++ = *extra++;
+                    }
+                    else {
+                        *buffer++ = enc;
+                    }
+                }
+            }
+            return extra;
+        }
+        default:
+            memcpy(buffer, data, BYTE_GROUP_SIZE);
+            return data + BYTE_GROUP_SIZE;
+        }
+    }
+
+    const unsigned char* DecodeBytes(const unsigned char* data, const unsigned char* end, unsigned char* buffer, size_t size) {
+        // 2 bits de cabecera por grupo de 16 bytes
+        size_t headerSize = (size / BYTE_GROUP_SIZE + 3) / 4;
+        if ((size_t)(end - data) < headerSize) {
+            return nullptr;
+        }
+        const unsigned char* header = data;
+        data += headerSize;
+        for (size_t i = 0; i < size; i += BYTE_GROUP_SIZE) {
+            // Un grupo lee como mucho 24 bytes; la cola del flujo garantiza ese margen en datos validos
+            if ((size_t)(end - data) < BYTE_GROUP_DECODE_LIMIT) {
+                return nullptr;
+            }
+            size_t group = i / BYTE_GROUP_SIZE;
+            int bitslog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+            data = DecodeBytesGroup(data, buffer + i, bitslog2);
+        }
+        return data;
+    }
+
+    // Cada byte de cada vertice va en su propio flujo, como delta zigzag respecto al vertice anterior
+    const unsigned char* DecodeVertexBlock(const unsigned char* data, const unsigned char* end, unsigned char* vertexData,
+        size_t vertexCount, size_t vertexSize, unsigned char lastVertex[256]) {
+        unsigned char buffer[VERTEX_BLOCK_MAX_SIZE];
+        size_t alignedCount = (vertexCount + BYTE_GROUP_SIZE - 1) & ~(BYTE_GROUP_SIZE - 1);
+        for (size_t k = 0; k < vertexSize; k++) {
+            data = DecodeBytes(data, end, buffer, alignedCount);
+            if (!data) {
+                return nullptr;
+            }
+            unsigned char p = lastVertex[k];
+            for (size_t i = 0; i < vertexCount; i++) {
+                unsigned char v = (unsigned char)(Unzigzag8(buffer[i]) + p);
+                vertexData[i * vertexSize + k] = v;
+                p = v;
+            }
+        }
+        memcpy(lastVertex, vertexData + vertexSize * (vertexCount - 1), vertexSize);
+        return data;
+    }
+
+    inline uint32_t DecodeVByte(const unsigned char*& data) {
+        unsigned char lead = *data++;
+        if (lead < 128) {
+            return lead;
+        }
+        // Como mucho 4 bytes mas, aunque los datos esten corruptos
+        uint32_t result = lead & 127;
+        uint32_t shift = 7;
+        for (int i = 0; i < 4; i++) {
+            unsigned char group = *data++;
+            result |= (uint32_t)(group & 127) << shift;
+            shift += 7;
+            if (group < 128) {
+                break;
+            }
+        }
+        return result;
+    }
+
+    inline uint32_t DecodeIndex(const unsigned char*& data, uint32_t last) {
+        uint32_t v = DecodeVByte(data);
+        uint32_t d = (v >> 1) ^ (0u - (v & 1));
+        return last + d;
+    }
+
+    inline void WriteIndex(void* destination, size_t i, size_t indexSize, uint32_t value) {
+        if (indexSize == 2) {
+            ((uint16_t*)destination)[i] = (uint16_t)value;
+        }
+        else {
+            ((uint32_t*)destination)[i] = value;
+        }
+    }
+
+    inline void PushVertex(uint32_t* fifo, uint32_t v, uint32_t& offset, uint32_t advance = 1) {
+        fifo[offset] = v;
+        offset = (offset + advance) & 15;
+    }
+
+    inline void PushEdge(uint32_t (*fifo)[2], uint32_t a, uint32_t b, uint32_t& offset) {
+        fifo[offset][0] = a;
+        fifo[offset][1] = b;
+        offset = (offset + 1) & 15;
+    }
+
+    template <typename T>
+    void DecodeOctahedral(T* data, size_t count) {
+        const float maxValue = (float)((1 << (sizeof(T) * 8 - 1)) - 1);
+        for (size_t i = 0; i < count; i++) {
+            // z guarda 1.0 con los mismos bits; se reconstruye y se deshace el plegado del octaedro para z < 0
+            float x = (float)data[i * 4 + 0];
+            float y = (float)data[i * 4 + 1];
+            float z = (float)data[i * 4 + 2] - fabsf(x) - fabsf(y);
+            float t = z >= 0.0f ? 0.0f : z;
+            x += x >= 0.0f ? t : -t;
+            y += y >= 0.0f ? t : -t;
+            float l = sqrtf(x * x + y * y + z * z);
+            float s = maxValue / l;
+            data[i * 4 + 0] = (T)(int)(x * s + (x >= 0.0f ? 0.5f : -0.5f));
+            data[i * 4 + 1] = (T)(int)(y * s + (y >= 0.0f ? 0.5f : -0.5f));
+            data[i * 4 + 2] = (T)(int)(z * s + (z >= 0.0f ? 0.5f : -0.5f));
+        }
+    }
+
+    void DecodeQuaternion(int16_t* data, size_t count) {
+        const float scale = 1.0f / sqrtf(2.0f);
+        for (size_t i = 0; i < count; i++) {
+            // La escala va en los bits altos de la cuarta componente y el indice de la omitida en los 2 bajos
+            int sf = data[i * 4 + 3] | 3;
+            float ss = scale / (float)sf;
+            float x = (float)data[i * 4 + 0] * ss;
+            float y = (float)data[i * 4 + 1] * ss;
+            float z = (float)data[i * 4 + 2] * ss;
+            float ww = 1.0f - x * x - y * y - z * z;
+            float w = sqrtf(ww >= 0.0f ? ww : 0.0f);
+            int xf = (int)(x * 32767.0f + (x >= 0.0f ? 0.5f : -0.5f));
+            int yf = (int)(y * 32767.0f + (y >= 0.0f ? 0.5f : -0.5f));
+            int zf = (int)(z * 32767.0f + (z >= 0.0f ? 0.5f : -0.5f));
+            int wf = (int)(w * 32767.0f + 0.5f);
+            int qc = data[i * 4 + 3] & 3;
+            data[i * 4 + ((qc + 1) & 3)] = (int16_t)xf;
+            data[i * 4 + ((qc + 2) & 3)] = (int16_t)yf;
+            data[i * 4 + ((qc + 3) & 3)] = (int16_t)zf;
+            data[i * 4 + ((qc + 0) & 3)] = (int16_t)wf;
+        }
+    }
+
+    void DecodeExponential(uint32_t* data, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            // Mantisa de 24 bits con signo y exponente de 8: ldexp(m, e)
+            uint32_t v = data[i];
+            int32_t m = (int32_t)(v << 8) >> 8;
+            int32_t e = (int32_t)v >> 24;
+            uint32_t bits = (uint32_t)(e + 127) << 23;
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            f *= (float)m;
+            memcpy(&data[i], &f, sizeof(f));
+        }
+    }
+
+}
+
+bool MeshoptDecoder::DecodeVertexBuffer(void* destination, size_t count, size_t stride, const unsigned char* buffer, size_t size) {
+    if (stride == 0 || stride > 256 || stride % 4 != 0) {
+        return false;
+    }
+    if (size < 1 + stride) {
+        return false;
+    }
+    const unsigned char* data = buffer;
+    const unsigned char* end = buffer + size;
+    if ((*data++ & 0xf0) != VERTEX_HEADER || (buffer[0] & 0x0f) != 0) {
+        return false;
+    }
+
+    // El primer vertice de referencia va al final del flujo
+    unsigned char lastVertex[256];
+    memcpy(lastVertex, end - stride, stride);
+
+    unsigned char* vertexData = (unsigned char*)destination;
+    size_t blockSize = VertexBlockSize(stride);
+    for (size_t offset = 0; offset < count; offset += blockSize) {
+        size_t blockCount = count - offset < blockSize ? count - offset : blockSize;
+        data = DecodeVertexBlock(data, end, vertexData + offset * stride, blockCount, stride, lastVertex);
+        if (!data) {
+            return false;
+        }
+    }
+
+    size_t tailSize = stride < TAIL_MIN_SIZE ? TAIL_MIN_SIZE : stride;
+    return (size_t)(end - data) == tailSize;
+}
+
+bool MeshoptDecoder::DecodeIndexBuffer(void* destination, size_t count, size_t indexSize, const unsigned char* buffer, size_t size) {
+    if (count % 3 != 0 || (indexSize != 2 && indexSize != 4)) {
+        return false;
+    }
+    // Cabecera, un byte de codigo por triangulo y la tabla auxiliar de 16 bytes al final
+    if (size < 1 + count / 3 + 16) {
+        return false;
+    }
+    if ((buffer[0] & 0xf0) != INDEX_HEADER) {
+        return false;
+    }
+    int version = buffer[0] & 0x0f;
+    if (version > 1) {
+        return false;
+    }
+
+    uint32_t edgeFifo[16][2];
+    uint32_t vertexFifo[16];
+    memset(edgeFifo, -1, sizeof(edgeFifo));
+    memset(vertexFifo, -1, sizeof(vertexFifo));
+    uint32_t edgeOffset = 0, vertexOffset = 0;
+    uint32_t next = 0, last = 0;
+    int fecmax = version >= 1 ? 13 : 15;
+
+    const unsigned char* code = buffer + 1;
+    const unsigned char* data = code + count / 3;
+    const unsigned char* dataSafeEnd = buffer + size - 16;
+    const unsigned char* codeauxTable = dataSafeEnd;
+
+    for (size_t i = 0; i < count; i += 3) {
+        // Cada triangulo lee como mucho 16 bytes de datos; la tabla final hace de margen
+        if (data > dataSafeEnd) {
+            return false;
+        }
+        unsigned char codetri = *code++;
+
+        if (codetri < 0xf0) {
+            // Arista de la FIFO de aristas + tercer vertice
+            int fe = codetri >> 4;
+            uint32_t a = edgeFifo[(edgeOffset - 1 - fe) & 15][0];
+            uint32_t b = edgeFifo[(edgeOffset - 1 - fe) & 15][1];
+            int fec = codetri & 15;
+            uint32_t c;
+            if (fec < fecmax) {
+                c = fec == 0 ? next : vertexFifo[(vertexOffset - 1 - fec) & 15];
+                uint32_t fec0 = fec == 0;
+                next += fec0;
+                PushVertex(vertexFifo, c, vertexOffset, fec0);
+            }
+            else {
+                // 13 y 14 (version 1) son el ultimo indice libre -1 / +1; 15 un indice libre codificado
+                c = last = (fec != 15) ? last + (fec - (fec ^ 3)) : DecodeIndex(data, last);
+                PushVertex(vertexFifo, c, vertexOffset);
+            }
+            WriteIndex(destination, i + 0, indexSize, a);
+            WriteIndex(destination, i + 1, indexSize, b);
+            WriteIndex(destination, i + 2, indexSize, c);
+            PushEdge(edgeFifo, c, b, edgeOffset);
+            PushEdge(edgeFifo, a, c, edgeOffset);
+        }
+        else if (codetri < 0xfe) {
+            // Triangulo que empieza en next, los otros dos de la tabla auxiliar
+            unsigned char codeaux = codeauxTable[codetri & 15];
+            int feb = codeaux >> 4;
+            int fec = codeaux & 15;
+            uint32_t a = next++;
+            uint32_t b = feb == 0 ? next : vertexFifo[(vertexOffset - feb) & 15];
+            uint32_t feb0 = feb == 0;
+            next += feb0;
+            uint32_t c = fec == 0 ? next : vertexFifo[(vertexOffset - fec) & 15];
+            uint32_t fec0 = fec == 0;
+            next += fec0;
+
+            WriteIndex(destination, i + 0, indexSize, a);
+            WriteIndex(destination, i + 1, indexSize, b);
+            WriteIndex(destination, i + 2, indexSize, c);
+            PushVertex(vertexFifo, a, vertexOffset);
+            PushVertex(vertexFifo, b, vertexOffset, feb0);
+            PushVertex(vertexFifo, c, vertexOffset, fec0);
+            PushEdge(edgeFifo, b, a, edgeOffset);
+            PushEdge(edgeFifo, c, b, edgeOffset);
+            PushEdge(edgeFifo, a, c, edgeOffset);
+        }
+        else {
+            // Caso general: codigo auxiliar en el flujo de datos; codeaux 0 reinicia next
+            unsigned char codeaux = *data++;
+            int fea = codetri == 0xfe ? 0 : 15;
+            int feb = codeaux >> 4;
+            int fec = codeaux & 15;
+            if (codeaux == 0) {
+                next = 0;
+            }
+            uint32_t a = fea == 0 ? next++ : 0;
+            uint32_t b = feb == 0 ? next++ : vertexFifo[(vertexOffset - feb) & 15];
+            uint32_t c = fec == 0 ? next++ : vertexFifo[(vertexOffset - fec) & 15];
+            if (fea == 15) {
+                last = a = DecodeIndex(data, last);
+            }
+            if (feb == 15) {
+                last = b = DecodeIndex(data, last);
+            }
+            if (fec == 15) {
+                last = c = DecodeIndex(data, last);
+            }
+
+            WriteIndex(destination, i + 0, indexSize, a);
+            WriteIndex(destination, i + 1, indexSize, b);
+            WriteIndex(destination, i + 2, indexSize, c);
+            PushVertex(vertexFifo, a, vertexOffset);
+            PushVertex(vertexFifo, b, vertexOffset, (feb == 0) | (feb == 15));
+            PushVertex(vertexFifo, c, vertexOffset, (fec == 0) | (fec == 15));
+            PushEdge(edgeFifo, b, a, edgeOffset);
+            PushEdge(edgeFifo, c, b, edgeOffset);
+            PushEdge(edgeFifo, a, c, edgeOffset);
+        }
+    }
+    return data == dataSafeEnd;
+}
+
+bool MeshoptDecoder::DecodeIndexSequence(void* destination, size_t count, size_t indexSize, const unsigned char* buffer, size_t size) {
+    if (indexSize != 2 && indexSize != 4) {
+        return false;
+    }
+    // Cabecera, al menos un byte por indice y una cola de 4 bytes
+    if (size < 1 + count + 4) {
+        return false;
+    }
+    if ((buffer[0] & 0xf0) != SEQUENCE_HEADER || (buffer[0] & 0x0f) > 1) {
+        return false;
+    }
+
+    const unsigned char* data = buffer + 1;
+    const unsigned char* dataSafeEnd = buffer + size - 4;
+    // Dos bases: el bit bajo de cada valor elige contra cual va la delta
+    uint32_t last[2] = { 0, 0 };
+    for (size_t i = 0; i < count; i++) {
+        if (data >= dataSafeEnd) {
+            return false;
+        }
+        uint32_t v = DecodeVByte(data);
+        uint32_t current = v & 1;
+        v >>= 1;
+        uint32_t d = (v >> 1) ^ (0u - (v & 1));
+        uint32_t index = last[current] + d;
+        last[current] = index;
+        WriteIndex(destination, i, indexSize, index);
+    }
+    return data == dataSafeEnd;
+}
+
+bool MeshoptDecoder::ApplyFilter(Filter filter, void* data, size_t count, size_t stride) {
+    switch (filter) {
+    case FILTER_NONE:
+        return true;
+    case FILTER_OCTAHEDRAL:
+        if (stride == 4) {
+            DecodeOctahedral((int8_t*)data, count);
+            return true;
+        }
+        if (stride == 8) {
+            DecodeOctahedral((int16_t*)data, count);
+            return true;
+        }
+        return false;
+    case FILTER_QUATERNION:
+        if (stride != 8) {
+            return false;
+        }
+        DecodeQuaternion((int16_t*)data, count);
+        return true;
+    case FILTER_EXPONENTIAL:
+        if (stride % 4 != 0) {
+            return false;
+        }
+        DecodeExponential((uint32_t*)data, count * (stride / 4));
+        return true;
+    }
+    return false;
+}
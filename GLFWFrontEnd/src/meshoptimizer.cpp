@@ -0,0 +1,445 @@
+#include "meshoptimizer.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#include "Trace.h"
+#include "Log.h"
+
+namespace {
+
+    const uint32_t INVALID = 0xFFFFFFFFu;
+
+    // Tamanyo de la cache simulada por OptimizeVertexCache
+    const int CACHE_SIZE = 32;
+    // Valencias mayores puntuan igual que la ultima
+    const int MAX_VALENCE = 64;
+
+    struct Bounds {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    Bounds ComputeBounds(const std::vector<glm::vec3>& vertices) {
+        Bounds b = { glm::vec3(0.0f), glm::vec3(0.0f) };
+        if (vertices.empty()) {
+            return b;
+        }
+        b.min = b.max = vertices[0];
+        for (const glm::vec3& v : vertices) {
+            b.min = glm::min(b.min, v);
+            b.max = glm::max(b.max, v);
+        }
+        return b;
+    }
+
+    uint64_t HashCell(int64_t x, int64_t y, int64_t z) {
+        uint64_t h = (uint64_t)x * 0x9E3779B97F4A7C15ull;
+        h ^= (uint64_t)y * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+        h ^= (uint64_t)z * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+        h ^= h >> 31;
+        return h;
+    }
+
+    // Rejilla hash: cada celda guarda una lista enlazada de vertices representantes.
+    // Tabla de direccionamiento abierto (celda -> cabeza) + next[] por vertice, sin reservas por celda
+    class HashGrid {
+    public:
+        HashGrid(const Bounds& bounds, float tolerance, size_t capacity) : m_tolerance(tolerance) {
+            // Con celdas de 2 * tolerancia la caja [p - t, p + t] toca como mucho 2 celdas por eje.
+            // El minimo relativo a la diagonal mantiene las coordenadas de celda dentro de int64
+            float diagonal = glm::length(bounds.max - bounds.min);
+            m_cellSize = std::max(2.0f * tolerance, diagonal * 1e-9f);
+            if (m_cellSize <= 0.0f) {
+                m_cellSize = 1.0f;
+            }
+            m_invCellSize = 1.0f / m_cellSize;
+
+            size_t tableSize = 16;
+            while (tableSize < capacity * 2) {
+                tableSize <<= 1;
+            }
+            m_mask = tableSize - 1;
+            m_keys.resize(tableSize);
+            m_heads.assign(tableSize, INVALID);
+            m_next.assign(capacity, INVALID);
+        }
+
+        void insert(const glm::vec3& p, uint32_t vertex) {
+            uint64_t key = HashCell(Cell(p.x), Cell(p.y), Cell(p.z));
+            size_t slot = Find(key);
+            if (m_heads[slot] == INVALID) {
+                m_keys[slot] = key;
+            }
+            m_next[vertex] = m_heads[slot];
+            m_heads[slot] = vertex;
+        }
+
+        // Llama a fn(vertice) para los vertices de las celdas que tocan la caja de tolerancia de p,
+        // hasta que fn devuelva true. Devuelve ese vertice o INVALID
+        template <typename Fn>
+        uint32_t find(const glm::vec3& p, Fn&& fn) const {
+            int64_t lo[3], hi[3];
+            for (int a = 0; a < 3; a++) {
+                lo[a] = Cell(p[a] - m_tolerance);
+                hi[a] = Cell(p[a] + m_tolerance);
+            }
+            for (int64_t x = lo[0]; x <= hi[0]; x++) {
+                for (int64_t y = lo[1]; y <= hi[1]; y++) {
+                    for (int64_t z = lo[2]; z <= hi[2]; z++) {
+                        size_t slot = Find(HashCell(x, y, z));
+                        // Dos celdas con la misma clave comparten lista; fn compara posiciones reales
+                        for (uint32_t v = m_heads[slot]; v != INVALID; v = m_next[v]) {
+                            if (fn(v)) {
+                                return v;
+                            }
+                        }
+                    }
+                }
+            }
+            return INVALID;
+        }
+
+    private:
+        int64_t Cell(float x) const {
+            return (int64_t)floorf(x * m_invCellSize);
+        }
+
+        size_t Find(uint64_t key) const {
+            size_t slot = (size_t)key & m_mask;
+            while (m_heads[slot] != INVALID && m_keys[slot] != key) {
+                slot = (slot + 1) & m_mask;
+            }
+            return slot;
+        }
+
+        float m_tolerance;
+        float m_cellSize = 1.0f;
+        float m_invCellSize = 1.0f;
+        size_t m_mask = 0;
+        std::vector<uint64_t> m_keys;
+        std::vector<uint32_t> m_heads;
+        std::vector<uint32_t> m_next;
+    };
+
+    float DistanceSquared(const glm::vec3& a, const glm::vec3& b) {
+        glm::vec3 d = a - b;
+        return glm::dot(d, d);
+    }
+
+    // Puntuacion de Forsyth: los 3 ultimos vertices usados puntuan fijo (el triangulo anterior no gana nada
+    // repitiendolos), el resto decae con la posicion en la cache, y la valencia restante prioriza los vertices
+    // a los que les quedan pocos triangulos para sacarlos pronto de la cache
+    struct VertexScoreTable {
+        float cache[CACHE_SIZE];
+        float valence[MAX_VALENCE + 1];
+
+        VertexScoreTable() {
+            for (int i = 0; i < CACHE_SIZE; i++) {
+                cache[i] = i < 3 ? 0.75f : powf(1.0f - (float)(i - 3) / (CACHE_SIZE - 3), 1.5f);
+            }
+            valence[0] = 0.0f;
+            for (int i = 1; i <= MAX_VALENCE; i++) {
+                valence[i] = 2.0f / sqrtf((float)i);
+            }
+        }
+
+        float score(int cachePosition, uint32_t remaining) const {
+            if (remaining == 0) {
+                return -1.0f;
+            }
+            float s = cachePosition >= 0 ? cache[cachePosition] : 0.0f;
+            return s + valence[std::min<uint32_t>(remaining, MAX_VALENCE)];
+        }
+    };
+
+}
+
+void MeshOptimizer::Optimize(std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& normals, std::vector<glm::vec2>& uvs,
+    std::vector<uint32_t>& indices, const WeldOptions& options) {
+    TRACE_SCOPE("MeshOptimizer::Optimize", "frontend");
+    auto start = std::chrono::steady_clock::now();
+
+    size_t vertexCount = vertices.size();
+    size_t triangleCount = indices.size() / 3;
+    float acmrBefore = AverageCacheMissRatio(indices, vertexCount);
+
+    WeldVertices(vertices, normals, uvs, indices, options);
+    OptimizeVertexCache(indices, vertices.size());
+    OptimizeVertexFetch(vertices, normals, uvs, indices);
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("loader", "Optimized mesh: %zu -> %zu vertices, %zu -> %zu triangles, ACMR %.3f -> %.3f in %.1f ms",
+        vertexCount, vertices.size(), triangleCount, indices.size() / 3,
+        acmrBefore, AverageCacheMissRatio(indices, vertices.size()), ms);
+}
+
+size_t MeshOptimizer::WeldVertices(std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& normals, std::vector<glm::vec2>& uvs,
+    std::vector<uint32_t>& indices, const WeldOptions& options) {
+    TRACE_SCOPE("MeshOptimizer::WeldVertices", "frontend");
+    size_t count = vertices.size();
+    if (count == 0 || normals.size() != count || uvs.size() != count) {
+        return 0;
+    }
+
+    Bounds bounds = ComputeBounds(vertices);
+    float tolerance = options.positionTolerance * glm::length(bounds.max - bounds.min);
+    float toleranceSq = tolerance * tolerance;
+
+    // Normales normalizadas solo para comparar; se conserva la del representante tal cual
+    std::vector<glm::vec3> unitNormals(count);
+    for (size_t i = 0; i < count; i++) {
+        float len = glm::length(normals[i]);
+        unitNormals[i] = len > 0.0f ? normals[i] / len : glm::vec3(0.0f);
+    }
+
+    // Voraz en orden de entrada: cada vertice se une al primer representante compatible, o pasa a serlo
+    HashGrid grid(bounds, tolerance, count);
+    std::vector<uint32_t> remap(count);
+    std::vector<uint32_t> representatives;
+    representatives.reserve(count);
+    for (uint32_t i = 0; i < (uint32_t)count; i++) {
+        const glm::vec3& p = vertices[i];
+        uint32_t match = grid.find(p, [&](uint32_t r) {
+            if (DistanceSquared(vertices[r], p) > toleranceSq) {
+                return false;
+            }
+            if (fabsf(uvs[r].x - uvs[i].x) > options.uvTolerance || fabsf(uvs[r].y - uvs[i].y) > options.uvTolerance) {
+                return false;
+            }
+            return glm::dot(unitNormals[r], unitNormals[i]) >= options.normalTolerance ||
+                (unitNormals[r] == glm::vec3(0.0f) && unitNormals[i] == glm::vec3(0.0f));
+        });
+        if (match != INVALID) {
+            remap[i] = remap[match];
+        }
+        else {
+            remap[i] = (uint32_t)representatives.size();
+            representatives.push_back(i);
+            grid.insert(p, i);
+        }
+    }
+
+    size_t removed = count - representatives.size();
+    if (removed > 0) {
+        // remap[i] <= i, asi que se puede compactar en el sitio
+        for (size_t r = 0; r < representatives.size(); r++) {
+            uint32_t src = representatives[r];
+            vertices[r] = vertices[src];
+            normals[r] = normals[src];
+            uvs[r] = uvs[src];
+        }
+        vertices.resize(representatives.size());
+        normals.resize(representatives.size());
+        uvs.resize(representatives.size());
+    }
+
+    // Remapear y quitar los triangulos que la soldadura ha colapsado
+    size_t out = 0;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        uint32_t a = remap[indices[t]], b = remap[indices[t + 1]], c = remap[indices[t + 2]];
+        if (a == b || b == c || a == c) {
+            continue;
+        }
+        indices[out++] = a;
+        indices[out++] = b;
+        indices[out++] = c;
+    }
+    if (out != indices.size()) {
+        LOG_DEBUG("loader", "Welding removed %zu degenerate triangles", (indices.size() - out) / 3);
+        indices.resize(out);
+    }
+    return removed;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+    TRACE_SCOPE("MeshOptimizer::OptimizeVertexCache", "frontend");
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || vertexCount == 0) {
+        return;
+    }
+    static const VertexScoreTable table;
+
+    // Adyacencia vertice -> triangulos (CSR). Los triangulos ya emitidos se sacan de la lista de cada vertice
+    std::vector<uint32_t> valence(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        valence[indices[i]]++;
+    }
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) {
+        offsets[v + 1] = offsets[v] + valence[v];
+    }
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (int k = 0; k < 3; k++) {
+                adjacency[fill[indices[t * 3 + k]]++] = (uint32_t)t;
+            }
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        vertexScore[v] = table.score(-1, valence[v]);
+    }
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    uint32_t best = 0;
+    for (size_t t = 0; t < triangleCount; t++) {
+        const uint32_t* tri = &indices[t * 3];
+        triangleScore[t] = vertexScore[tri[0]] + vertexScore[tri[1]] + vertexScore[tri[2]];
+        if (triangleScore[t] > triangleScore[best]) {
+            best = (uint32_t)t;
+        }
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+    uint32_t cache[CACHE_SIZE + 3];
+    uint32_t newCache[CACHE_SIZE + 3];
+    int cacheCount = 0;
+    size_t scan = 0;
+
+    for (size_t step = 0; step < triangleCount; step++) {
+        if (best == INVALID) {
+            // Ningun triangulo pendiente toca la cache: seguir por el primero sin emitir
+            while (emitted[scan]) {
+                scan++;
+            }
+            best = (uint32_t)scan;
+        }
+
+        const uint32_t* tri = &indices[best * 3];
+        emitted[best] = true;
+        int newCount = 0;
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = tri[k];
+            result.push_back(v);
+            newCache[newCount++] = v;
+
+            // Sacar el triangulo de la lista de v
+            uint32_t* first = &adjacency[offsets[v]];
+            uint32_t* last = first + valence[v];
+            uint32_t* it = std::find(first, last, best);
+            *it = *(last - 1);
+            valence[v]--;
+        }
+        for (int i = 0; i < cacheCount; i++) {
+            uint32_t v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                newCache[newCount++] = v;
+            }
+        }
+
+        // Nuevas posiciones: propagar el cambio de puntuacion a los triangulos pendientes de cada vertice
+        best = INVALID;
+        float bestScore = -1.0f;
+        for (int i = 0; i < newCount; i++) {
+            uint32_t v = newCache[i];
+            int position = i < CACHE_SIZE ? i : -1;
+            cachePosition[v] = position;
+            float score = table.score(position, valence[v]);
+            float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+            for (uint32_t j = offsets[v]; j < offsets[v] + valence[v]; j++) {
+                triangleScore[adjacency[j]] += delta;
+            }
+        }
+        for (int i = 0; i < std::min(newCount, CACHE_SIZE); i++) {
+            uint32_t v = newCache[i];
+            for (uint32_t j = offsets[v]; j < offsets[v] + valence[v]; j++) {
+                uint32_t t = adjacency[j];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+
+        cacheCount = std::min(newCount, CACHE_SIZE);
+        memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+    }
+
+    // Restos de una lista que no es multiplo de 3
+    result.insert(result.end(), indices.begin() + triangleCount * 3, indices.end());
+    indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& normals, std::vector<glm::vec2>& uvs,
+    std::vector<uint32_t>& indices) {
+    TRACE_SCOPE("MeshOptimizer::OptimizeVertexFetch", "frontend");
+    size_t count = vertices.size();
+    if (count == 0 || normals.size() != count || uvs.size() != count) {
+        return;
+    }
+
+    std::vector<uint32_t> remap(count, INVALID);
+    uint32_t next = 0;
+    for (uint32_t& index : indices) {
+        if (remap[index] == INVALID) {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+
+    std::vector<glm::vec3> newVertices(next);
+    std::vector<glm::vec3> newNormals(next);
+    std::vector<glm::vec2> newUvs(next);
+    for (size_t v = 0; v < count; v++) {
+        if (remap[v] != INVALID) {
+            newVertices[remap[v]] = vertices[v];
+            newNormals[remap[v]] = normals[v];
+            newUvs[remap[v]] = uvs[v];
+        }
+    }
+    vertices.swap(newVertices);
+    normals.swap(newNormals);
+    uvs.swap(newUvs);
+}
+
+float MeshOptimizer::AverageCacheMissRatio(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || cacheSize == 0) {
+        return 0.0f;
+    }
+
+    // Marca de tiempo de la ultima entrada de cada vertice en la FIFO
+    std::vector<size_t> timestamp(vertexCount, 0);
+    size_t time = cacheSize + 1;
+    size_t misses = 0;
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        uint32_t v = indices[i];
+        if (v >= vertexCount) {
+            continue;
+        }
+        if (time - timestamp[v] > cacheSize) {
+            timestamp[v] = time++;
+            misses++;
+        }
+    }
+    return (float)misses / triangleCount;
+}
+
+size_t MeshOptimizer::CountUniquePositions(const std::vector<glm::vec3>& vertices, float epsilon) {
+    if (vertices.empty()) {
+        return 0;
+    }
+    HashGrid grid(ComputeBounds(vertices), epsilon, vertices.size());
+    float epsilonSq = epsilon * epsilon;
+    size_t unique = 0;
+    for (uint32_t i = 0; i < (uint32_t)vertices.size(); i++) {
+        const glm::vec3& p = vertices[i];
+        uint32_t match = grid.find(p, [&](uint32_t r) {
+            return DistanceSquared(vertices[r], p) < epsilonSq;
+        });
+        if (match == INVALID) {
+            grid.insert(p, i);
+            unique++;
+        }
+    }
+    return unique;
+}
@@ -0,0 +1,570 @@
+#include "objparser.h"
+#include "mappedfile.h"
+#include "parallelfor.h"
+
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "Trace.h"
+#include "Log.h"
+
+namespace {
+
+    const uint32_t NO_INDEX = 0xFFFFFFFFu;
+    const unsigned int MAX_THREADS = 64;
+    const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+    // Esquina de una cara con los indices ya resueltos (base 0, NO_INDEX si falta vt o vn)
+    struct ObjCorner {
+        uint32_t v, vt, vn;
+
+        bool operator==(const ObjCorner& other) const {
+            return v == other.v && vt == other.vt && vn == other.vn;
+        }
+    };
+
+    enum class ObjRecord { Other, Position, Normal, TexCoord, Face };
+
+    struct ObjChunk {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        // Registros del trozo (primera pasada) y primer indice global de cada tipo
+        size_t positions = 0, normals = 0, uvs = 0;
+        size_t positionBase = 0, normalBase = 0, uvBase = 0;
+        std::vector<ObjCorner> corners;     // 3 por triangulo
+        const char* error = nullptr;        // primer registro mal formado
+    };
+
+    // Divide [0, count) en threads rangos contiguos
+    template <typename Fn>
+    void ParallelRanges(unsigned int threads, size_t count, Fn fn) {
+        size_t ranges = std::max<size_t>(1, std::min<size_t>(threads, count));
+        ParallelFor(threads, ranges, [&](size_t r) {
+            fn(count * r / ranges, count * (r + 1) / ranges);
+        });
+    }
+
+    inline bool IsBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    inline bool IsDigit(char c) {
+        return (unsigned char)(c - '0') < 10;
+    }
+
+    inline const char* SkipBlanks(const char* p, const char* end) {
+        while (p < end && IsBlank(*p)) {
+            p++;
+        }
+        return p;
+    }
+
+    inline const char* LineEnd(const char* p, const char* end) {
+        const char* eol = (const char*)memchr(p, '\n', (size_t)(end - p));
+        return eol ? eol : end;
+    }
+
+    // Tipo del registro de la linea; p queda detras de la palabra clave
+    inline ObjRecord Classify(const char*& p, const char* eol) {
+        p = SkipBlanks(p, eol);
+        if (eol - p < 2) {
+            return ObjRecord::Other;
+        }
+        if (p[0] == 'v') {
+            if (IsBlank(p[1])) {
+                p += 2;
+                return ObjRecord::Position;
+            }
+            if (eol - p > 2 && IsBlank(p[2])) {
+                if (p[1] == 'n') {
+                    p += 3;
+                    return ObjRecord::Normal;
+                }
+                if (p[1] == 't') {
+                    p += 3;
+                    return ObjRecord::TexCoord;
+                }
+            }
+        }
+        else if (p[0] == 'f' && IsBlank(p[1])) {
+            p += 2;
+            return ObjRecord::Face;
+        }
+        return ObjRecord::Other;
+    }
+
+    const double POW10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    // [+-]digitos[.digitos][(e|E)[+-]digitos]. Devuelve nullptr si no hay ningun digito
+    const char* ParseFloat(const char* p, const char* end, float& out) {
+        p = SkipBlanks(p, end);
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negative = *p == '-';
+            p++;
+        }
+
+        // Hasta 19 cifras significativas en un entero; el resto solo mueve el exponente
+        uint64_t mantissa = 0;
+        int significant = 0;
+        int exponent = 0;
+        bool digits = false;
+        while (p < end && IsDigit(*p)) {
+            digits = true;
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                significant += mantissa != 0;
+            }
+            else {
+                exponent++;
+            }
+            p++;
+        }
+        if (p < end && *p == '.') {
+            p++;
+            while (p < end && IsDigit(*p)) {
+                digits = true;
+                if (significant < 19) {
+                    mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                    significant += mantissa != 0;
+                    exponent--;
+                }
+                p++;
+            }
+        }
+        if (!digits) {
+            return nullptr;
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            const char* q = p + 1;
+            bool negativeExp = false;
+            if (q < end && (*q == '-' || *q == '+')) {
+                negativeExp = *q == '-';
+                q++;
+            }
+            if (q < end && IsDigit(*q)) {
+                int e = 0;
+                while (q < end && IsDigit(*q)) {
+                    e = std::min(e * 10 + (*q - '0'), 10000);
+                    q++;
+                }
+                exponent += negativeExp ? -e : e;
+                p = q;
+            }
+        }
+
+        double value = (double)mantissa;
+        if (mantissa != 0 && exponent != 0) {
+            if (exponent > 0) {
+                value = exponent <= 22 ? value * POW10[exponent] : value * std::pow(10.0, exponent);
+            }
+            else {
+                value = exponent >= -22 ? value / POW10[-exponent] : value * std::pow(10.0, exponent);
+            }
+        }
+        out = (float)(negative ? -value : value);
+        return p;
+    }
+
+    const char* ParseIndex(const char* p, const char* end, int64_t& out) {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negative = *p == '-';
+            p++;
+        }
+        if (p >= end || !IsDigit(*p)) {
+            return nullptr;
+        }
+        int64_t value = 0;
+        while (p < end && IsDigit(*p)) {
+            value = std::min<int64_t>(value * 10 + (*p - '0'), INT64_C(1) << 40);
+            p++;
+        }
+        out = negative ? -value : value;
+        return p;
+    }
+
+    // Indice OBJ (1..N, o negativo relativo a los ya leidos) a base 0. false si se sale de [0, total)
+    inline bool ResolveIndex(int64_t raw, size_t seen, size_t total, uint32_t& out) {
+        int64_t index = raw > 0 ? raw - 1 : (int64_t)seen + raw;
+        if (raw == 0 || index < 0 || index >= (int64_t)total) {
+            return false;
+        }
+        out = (uint32_t)index;
+        return true;
+    }
+
+    void CountRecords(ObjChunk& chunk) {
+        for (const char* line = chunk.begin; line < chunk.end;) {
+            const char* eol = LineEnd(line, chunk.end);
+            const char* p = line;
+            switch (Classify(p, eol)) {
+            case ObjRecord::Position: chunk.positions++; break;
+            case ObjRecord::Normal: chunk.normals++; break;
+            case ObjRecord::TexCoord: chunk.uvs++; break;
+            default: break;
+            }
+            line = eol + 1;
+        }
+    }
+
+    struct ObjTotals {
+        size_t positions, normals, uvs;
+    };
+
+    void ParseChunk(ObjChunk& chunk, const ObjTotals& totals, glm::vec3* positions, glm::vec3* normals, glm::vec2* uvs) {
+        size_t position = chunk.positionBase, normal = chunk.normalBase, uv = chunk.uvBase;
+        std::vector<ObjCorner> polygon;
+
+        for (const char* line = chunk.begin; line < chunk.end;) {
+            const char* eol = LineEnd(line, chunk.end);
+            const char* p = line;
+            ObjRecord record = Classify(p, eol);
+
+            if (record == ObjRecord::Position || record == ObjRecord::Normal) {
+                glm::vec3 value;
+                if (!(p = ParseFloat(p, eol, value.x)) || !(p = ParseFloat(p, eol, value.y)) || !(p = ParseFloat(p, eol, value.z))) {
+                    chunk.error = line;
+                    return;
+                }
+                // El w opcional de v y los colores por vertice se ignoran
+                if (record == ObjRecord::Position) {
+                    positions[position++] = value;
+                }
+                else {
+                    normals[normal++] = value;
+                }
+            }
+            else if (record == ObjRecord::TexCoord) {
+                glm::vec2 value(0.0f);
+                if (!(p = ParseFloat(p, eol, value.x))) {
+                    chunk.error = line;
+                    return;
+                }
+                // v es opcional
+                ParseFloat(p, eol, value.y);
+                uvs[uv++] = value;
+            }
+            else if (record == ObjRecord::Face) {
+                polygon.clear();
+                while (true) {
+                    p = SkipBlanks(p, eol);
+                    if (p >= eol || *p == '#') {
+                        break;
+                    }
+                    // v, v/vt, v//vn o v/vt/vn
+                    ObjCorner corner = { NO_INDEX, NO_INDEX, NO_INDEX };
+                    int64_t raw = 0;
+                    bool ok = (p = ParseIndex(p, eol, raw)) && ResolveIndex(raw, position, totals.positions, corner.v);
+                    if (ok && p < eol && *p == '/') {
+                        p++;
+                        if (p < eol && *p != '/') {
+                            ok = (p = ParseIndex(p, eol, raw)) && ResolveIndex(raw, uv, totals.uvs, corner.vt);
+                        }
+                        if (ok && p < eol && *p == '/') {
+                            p++;
+                            ok = (p = ParseIndex(p, eol, raw)) && ResolveIndex(raw, normal, totals.normals, corner.vn);
+                        }
+                    }
+                    if (!ok || (p < eol && !IsBlank(*p))) {
+                        chunk.error = line;
+                        return;
+                    }
+                    polygon.push_back(corner);
+                }
+                // Abanico desde la primera esquina, como aiProcess_Triangulate con poligonos convexos
+                for (size_t i = 2; i < polygon.size(); i++) {
+                    chunk.corners.push_back(polygon[0]);
+                    chunk.corners.push_back(polygon[i - 1]);
+                    chunk.corners.push_back(polygon[i]);
+                }
+            }
+            line = eol + 1;
+        }
+    }
+
+    inline uint64_t HashCorner(const ObjCorner& c) {
+        uint64_t h = (uint64_t)c.v * 0x9E3779B97F4A7C15ull ^ (uint64_t)c.vt * 0xC2B2AE3D27D4EB4Full ^ (uint64_t)c.vn * 0x165667B19E3779F9ull;
+        h ^= h >> 31;
+        h *= 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 29;
+        return h;
+    }
+
+    // Tabla hash de direccionamiento abierto esquina -> id local del fragmento
+    class CornerTable {
+    public:
+        explicit CornerTable(size_t expected) {
+            size_t capacity = 64;
+            while (capacity < expected * 2) {
+                capacity <<= 1;
+            }
+            m_slots.assign(capacity, Slot{ { NO_INDEX, NO_INDEX, NO_INDEX }, NO_INDEX });
+        }
+
+        uint32_t insert(const ObjCorner& corner, uint64_t hash) {
+            if ((m_count + 1) * 2 > m_slots.size()) {
+                Grow();
+            }
+            size_t mask = m_slots.size() - 1;
+            for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+                Slot& slot = m_slots[i];
+                if (slot.id == NO_INDEX) {
+                    slot.corner = corner;
+                    slot.id = (uint32_t)m_count++;
+                    return slot.id;
+                }
+                if (slot.corner == corner) {
+                    return slot.id;
+                }
+            }
+        }
+
+        size_t size() const { return m_count; }
+
+    private:
+        struct Slot {
+            ObjCorner corner;
+            uint32_t id;
+        };
+
+        void Grow() {
+            std::vector<Slot> old;
+            old.swap(m_slots);
+            m_slots.assign(old.size() * 2, Slot{ { NO_INDEX, NO_INDEX, NO_INDEX }, NO_INDEX });
+            size_t mask = m_slots.size() - 1;
+            for (const Slot& slot : old) {
+                if (slot.id == NO_INDEX) {
+                    continue;
+                }
+                size_t i = (size_t)HashCorner(slot.corner) & mask;
+                while (m_slots[i].id != NO_INDEX) {
+                    i = (i + 1) & mask;
+                }
+                m_slots[i] = slot;
+            }
+        }
+
+        std::vector<Slot> m_slots;
+        size_t m_count = 0;
+    };
+
+    size_t LineNumber(const char* data, const char* at) {
+        size_t line = 1;
+        for (const char* p = data; p < at && (p = (const char*)memchr(p, '\n', (size_t)(at - p))); p++) {
+            line++;
+        }
+        return line;
+    }
+}
+
+bool ObjParser::parse(const std::string& path, ObjMeshData& out, const ObjParseOptions& options) {
+    TRACE_SCOPE_DETAIL("ObjParser::parse", "frontend", path);
+    auto start = std::chrono::steady_clock::now();
+
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+    if (!parseMemory(file.data(), file.size(), out, options)) {
+        LOG_ERROR("loader", "Failed to parse %s", path.c_str());
+        return false;
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("loader", "Parsed %s: %zu vertices, %zu triangles in %.1f ms", path.c_str(), out.vertices.size(),
+        out.indices.size() / 3, ms);
+    return true;
+}
+
+bool ObjParser::parseMemory(const char* data, size_t size, ObjMeshData& out, const ObjParseOptions& options) {
+    out = ObjMeshData();
+    if (size == 0) {
+        return true;
+    }
+
+    unsigned int threads = options.threads ? options.threads : DefaultParallelThreads();
+    threads = std::max(1u, std::min(threads, MAX_THREADS));
+
+    // Trozos terminados en fin de linea; varios por hilo para repartir mejor las zonas con muchas caras
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>((size_t)threads * 4, size / MIN_CHUNK_BYTES));
+    std::vector<ObjChunk> chunks;
+    chunks.reserve(chunkCount);
+    const char* end = data + size;
+    const char* begin = data;
+    for (size_t i = 1; i <= chunkCount && begin < end; i++) {
+        const char* split = (i == chunkCount) ? end : std::max(begin, data + size * i / chunkCount);
+        split = (split < end) ? LineEnd(split, end) + 1 : end;
+        if (split > end) {
+            split = end;
+        }
+        if (split <= begin) {
+            continue;
+        }
+        ObjChunk chunk;
+        chunk.begin = begin;
+        chunk.end = split;
+        chunks.push_back(std::move(chunk));
+        begin = split;
+    }
+
+    // 1: contar registros para saber donde escribe cada trozo y resolver los indices negativos
+    {
+        TRACE_SCOPE("CountRecords", "frontend");
+        ParallelFor(threads, chunks.size(), [&](size_t i) { CountRecords(chunks[i]); });
+    }
+    ObjTotals totals = { 0, 0, 0 };
+    for (ObjChunk& chunk : chunks) {
+        chunk.positionBase = totals.positions;
+        chunk.normalBase = totals.normals;
+        chunk.uvBase = totals.uvs;
+        totals.positions += chunk.positions;
+        totals.normals += chunk.normals;
+        totals.uvs += chunk.uvs;
+    }
+
+    // 2: parsear cada trozo directamente en los arrays globales de atributos
+    std::vector<glm::vec3> positions(totals.positions);
+    std::vector<glm::vec3> normals(totals.normals);
+    std::vector<glm::vec2> uvs(totals.uvs);
+    {
+        TRACE_SCOPE("ParseChunks", "frontend");
+        ParallelFor(threads, chunks.size(), [&](size_t i) {
+            ParseChunk(chunks[i], totals, positions.data(), normals.data(), uvs.data());
+        });
+    }
+    size_t cornerCount = 0;
+    std::vector<size_t> cornerBase(chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (chunks[i].error) {
+            const char* eol = LineEnd(chunks[i].error, end);
+            LOG_ERROR("loader", "OBJ: malformed record at line %zu: %.*s", LineNumber(data, chunks[i].error),
+                (int)std::min<ptrdiff_t>(eol - chunks[i].error, 80), chunks[i].error);
+            return false;
+        }
+        cornerBase[i] = cornerCount;
+        cornerCount += chunks[i].corners.size();
+    }
+    if (cornerCount >= (size_t)NO_INDEX) {
+        LOG_ERROR("loader", "OBJ: %zu face corners exceed 32-bit indices", cornerCount);
+        return false;
+    }
+
+    std::vector<ObjCorner> corners(cornerCount);
+    ParallelFor(threads, chunks.size(), [&](size_t i) {
+        std::copy(chunks[i].corners.begin(), chunks[i].corners.end(), corners.begin() + cornerBase[i]);
+        std::vector<ObjCorner>().swap(chunks[i].corners);
+    });
+
+    // 3: una esquina v/vt/vn distinta = un vertice. Cada hilo deduplica las esquinas de su fragmento del hash
+    // y despues se numeran por orden de primer uso, que conserva la localidad del fichero
+    TRACE_SCOPE("WeldCorners", "frontend");
+    unsigned int shards = std::max(1u, std::min<unsigned int>(threads, 255));
+    size_t ranges = std::max<size_t>(1, std::min<size_t>(threads, cornerCount));
+    std::vector<uint8_t> shardOf(cornerCount);
+    std::vector<uint32_t> localId(cornerCount);
+    // Las esquinas se agrupan por fragmento antes de deduplicar, asi cada fragmento recorre solo las suyas:
+    // cada rango cuenta sus esquinas por fragmento y despues las escribe en su hueco, en el orden del fichero
+    std::vector<size_t> rangeCount(ranges * shards, 0);
+    ParallelFor(threads, ranges, [&](size_t r) {
+        size_t* count = &rangeCount[r * shards];
+        for (size_t i = cornerCount * r / ranges; i < cornerCount * (r + 1) / ranges; i++) {
+            shardOf[i] = (uint8_t)((HashCorner(corners[i]) >> 40) % shards);
+            count[shardOf[i]]++;
+        }
+    });
+    std::vector<size_t> shardStart(shards + 1, 0);
+    std::vector<size_t> rangeStart(ranges * shards);
+    size_t offset = 0;
+    for (unsigned int s = 0; s < shards; s++) {
+        shardStart[s] = offset;
+        for (size_t r = 0; r < ranges; r++) {
+            rangeStart[r * shards + s] = offset;
+            offset += rangeCount[r * shards + s];
+        }
+    }
+    shardStart[shards] = offset;
+    std::vector<uint32_t> bucketed(cornerCount);
+    ParallelFor(threads, ranges, [&](size_t r) {
+        size_t* next = &rangeStart[r * shards];
+        for (size_t i = cornerCount * r / ranges; i < cornerCount * (r + 1) / ranges; i++) {
+            bucketed[next[shardOf[i]]++] = (uint32_t)i;
+        }
+    });
+    std::vector<size_t> shardSize(shards + 1, 0);
+    ParallelFor(threads, shards, [&](size_t s) {
+        CornerTable table((shardStart[s + 1] - shardStart[s]) / 4);
+        for (size_t k = shardStart[s]; k < shardStart[s + 1]; k++) {
+            uint32_t i = bucketed[k];
+            localId[i] = table.insert(corners[i], HashCorner(corners[i]));
+        }
+        shardSize[s + 1] = table.size();
+    });
+    for (unsigned int s = 0; s < shards; s++) {
+        shardSize[s + 1] += shardSize[s];
+    }
+    size_t vertexCount = shardSize[shards];
+
+    std::vector<uint32_t> remap(vertexCount, NO_INDEX);
+    std::vector<ObjCorner> sources;
+    sources.reserve(vertexCount);
+    out.indices.resize(cornerCount);
+    for (size_t i = 0; i < cornerCount; i++) {
+        uint32_t& id = remap[shardSize[shardOf[i]] + localId[i]];
+        if (id == NO_INDEX) {
+            id = (uint32_t)sources.size();
+            sources.push_back(corners[i]);
+        }
+        out.indices[i] = id;
+    }
+
+    out.vertices.resize(vertexCount);
+    out.normals.resize(vertexCount);
+    out.uvs.resize(vertexCount);
+    std::atomic<bool> missingNormals{ false };
+    ParallelRanges(threads, vertexCount, [&](size_t first, size_t last) {
+        bool missing = false;
+        for (size_t v = first; v < last; v++) {
+            const ObjCorner& src = sources[v];
+            out.vertices[v] = positions[src.v];
+            out.normals[v] = (src.vn != NO_INDEX) ? normals[src.vn] : glm::vec3(0.0f);
+            missing |= src.vn == NO_INDEX;
+            glm::vec2 uv = (src.vt != NO_INDEX) ? uvs[src.vt] : glm::vec2(0.0f);
+            out.uvs[v] = options.flipUVs ? glm::vec2(uv.x, 1.0f - uv.y) : uv;
+        }
+        if (missing) {
+            missingNormals = true;
+        }
+    });
+
+    // 4: normales suaves (por posicion, ponderadas por area) para los vertices sin vn
+    if (options.generateNormals && missingNormals) {
+        TRACE_SCOPE("GenerateNormals", "frontend");
+        std::vector<glm::vec3> accumulated(positions.size(), glm::vec3(0.0f));
+        for (size_t i = 0; i + 2 < cornerCount; i += 3) {
+            uint32_t a = corners[i].v, b = corners[i + 1].v, c = corners[i + 2].v;
+            glm::vec3 n = glm::cross(positions[b] - positions[a], positions[c] - positions[a]);
+            accumulated[a] += n;
+            accumulated[b] += n;
+            accumulated[c] += n;
+        }
+        ParallelRanges(threads, vertexCount, [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; v++) {
+                if (sources[v].vn != NO_INDEX) {
+                    continue;
+                }
+                glm::vec3 n = accumulated[sources[v].v];
+                float length = glm::length(n);
+                out.normals[v] = (length > 0.0f) ? n / length : glm::vec3(0.0f, 1.0f, 0.0f);
+            }
+        });
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <stddef.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Uso interno de los loaders (objparser, gltfloader): no es parte de la interfaz del front end
+
+/**
+ * @brief Threads that a loader called on this thread may use when it is not given an explicit count. The workers of
+ * AssetLoader split the cores among themselves, so several loads in flight do not each start one thread per core
+ * @return 0 = no budget (std::thread::hardware_concurrency())
+ */
+inline unsigned int& ParallelThreadBudget() {
+    thread_local unsigned int budget = 0;
+    return budget;
+}
+
+/**
+ * @brief Thread count for a ParallelFor without an explicit one: the budget of this thread, or every core
+ */
+inline unsigned int DefaultParallelThreads() {
+    unsigned int budget = ParallelThreadBudget();
+    return budget > 0 ? budget : std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief Runs fn(i) for every i in [0, count) on up to threads threads. The caller is one of them, and the
+ * indices are handed out with an atomic counter, so tasks of uneven cost are balanced
+ * @param threads maximum number of threads, the caller included (0 or 1 runs everything on the caller)
+ * @param count number of tasks
+ * @param fn callable taking the task index
+ */
+template <typename Fn>
+void ParallelFor(unsigned int threads, size_t count, Fn fn) {
+    threads = (unsigned int)std::min<size_t>(threads, count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            fn(i);
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned int t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+}
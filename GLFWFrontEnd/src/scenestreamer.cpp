@@ -0,0 +1,188 @@
+#include "scenestreamer.h"
+#include <algorithm>
+#include <thread>
+
+#include "meshcache.h"
+#include "Trace.h"
+#include "Log.h"
+
+SceneStreamer::SceneStreamer(Renderer& renderer, unsigned int threads)
+    : m_renderer(renderer), m_loader(threads), m_start(std::chrono::steady_clock::now()) {
+}
+
+size_t SceneStreamer::request(const std::string& path, const std::vector<StreamPlacement>& placements) {
+    TRACE_SCOPE_DETAIL("streamRequest", "frontend", path);
+    std::unique_ptr<Request> request(new Request());
+    request->path = path;
+    request->placements = placements;
+    request->future = m_loader.load(path);
+    // Solo la cabecera de la cache, sin leer la geometria: la validacion completa la hace el AssetLoader en su hilo
+    glm::vec3 bmin, bmax;
+    if (MeshCache::ReadBounds(path, bmin, bmax)) {
+        addProxy(*request, bmin, bmax);
+    }
+    m_requests.push_back(std::move(request));
+    m_pending++;
+    return m_requests.size() - 1;
+}
+
+void SceneStreamer::addProxy(Request& request, const glm::vec3& bmin, const glm::vec3& bmax) {
+    if (!(bmin.x <= bmax.x && bmin.y <= bmax.y && bmin.z <= bmax.z)) {
+        return;
+    }
+    std::vector<glm::vec3> vertices, normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<uint32_t> indices;
+    BoxMesh(bmin, bmax, vertices, normals, uvs, indices);
+    request.proxy = m_renderer.defineMesh(vertices, normals, uvs, indices);
+    request.hasProxy = true;
+    if (request.placements.empty()) {
+        m_renderer.addMesh(glm::mat4(1.0f), glm::vec3(0.5f), request.proxy);
+        return;
+    }
+    for (const StreamPlacement& placement : request.placements) {
+        m_renderer.addMesh(placement.transform, glm::vec3(0.5f), request.proxy);
+    }
+}
+
+size_t SceneStreamer::update(float budgetMs) {
+    if (m_pending == 0) {
+        return 0;
+    }
+    TRACE_SCOPE("streamUpdate", "frontend");
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedMs = [&]() {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    size_t defined = 0;
+    for (std::unique_ptr<Request>& request : m_requests) {
+        if (request->done) {
+            continue;
+        }
+        if (!request->parsed) {
+            if (request->future.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+                continue;
+            }
+            request->asset = request->future.get();
+            request->parsed = true;
+            if (!request->asset.ok) {
+                LOG_ERROR("frontend", "Cannot stream %s", request->path.c_str());
+                finish(*request);
+                continue;
+            }
+        }
+
+        // Una malla cada vez: un glTF con muchas primitivas se reparte entre varios frames
+        std::vector<AssetMesh>& meshes = request->asset.meshes;
+        while (request->nextMesh < meshes.size() && (defined == 0 || elapsedMs() < budgetMs)) {
+            AssetMesh& mesh = meshes[request->nextMesh++];
+            request->ids.push_back(m_renderer.defineMesh(mesh.vertices, mesh.normals, mesh.uvs, mesh.indices));
+            mesh = AssetMesh();  // el renderer guarda su copia
+            defined++;
+        }
+        if (request->nextMesh < meshes.size()) {
+            // Sin cache no habia limites al pedirlo: el proxy sale de los del AssetLoader mientras se definen las demas
+            if (!request->hasProxy) {
+                addProxy(*request, request->asset.boundsMin, request->asset.boundsMax);
+            }
+            break;
+        }
+        finish(*request);
+        if (elapsedMs() >= budgetMs) {
+            break;
+        }
+    }
+    return defined;
+}
+
+void SceneStreamer::finish(Request& request) {
+    // El proxy sale antes de anadir las instancias reales: el numero de instancias nunca pasa del de la escena final.
+    // removeMesh quita sus instancias y libera su definicion
+    if (request.hasProxy) {
+        m_renderer.removeMesh(request.proxy);
+        request.hasProxy = false;
+    }
+
+    if (request.asset.ok) {
+        std::vector<AssetInstance> instances = request.asset.instances;
+        if (instances.empty()) {
+            for (size_t i = 0; i < request.ids.size(); i++) {
+                instances.push_back({ i, glm::mat4(1.0f), glm::vec3(1.0f) });
+            }
+        }
+        // Un modelo con mas instancias de las que admite el renderer se queda a medias, con un error, sin parar el programa
+        size_t added = 0, total = instances.size() * std::max<size_t>(request.placements.size(), 1);
+        bool full = false;
+        if (request.placements.empty()) {
+            for (size_t i = 0; i < instances.size() && !full; i++) {
+                full = !m_renderer.addMesh(instances[i].transform, instances[i].color, request.ids[instances[i].mesh]);
+                added += full ? 0 : 1;
+            }
+        }
+        for (size_t p = 0; p < request.placements.size() && !full; p++) {
+            const StreamPlacement& placement = request.placements[p];
+            for (size_t i = 0; i < instances.size() && !full; i++) {
+                glm::mat4 transform = placement.transform * instances[i].transform;
+                full = placement.light
+                    ? !m_renderer.addLight(transform, request.ids[instances[i].mesh], placement.color, placement.lightId, placement.textureId)
+                    : !m_renderer.addMesh(transform, placement.color, request.ids[instances[i].mesh]);
+                added += full ? 0 : 1;
+            }
+        }
+        if (added < total) {
+            LOG_ERROR("frontend", "%s: only %zu of its %zu instances fit in the scene", request.path.c_str(), added, total);
+        }
+        m_resident++;
+    }
+    request.asset = LoadedAsset();
+    request.done = true;
+    m_pending--;
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    if (request.ids.size() > 0) {
+        LOG_INFO("frontend", "%s resident after %.1f ms (%zu left)", request.path.c_str(), ms, m_pending);
+    }
+    if (m_pending == 0) {
+        LOG_INFO("frontend", "Scene complete after %.1f ms: %zu of %zu models", ms, m_resident, m_requests.size());
+    }
+}
+
+void SceneStreamer::waitForFirstModel() {
+    TRACE_SCOPE("waitForFirstModel", "frontend");
+    while (m_resident == 0 && m_pending > 0) {
+        if (update() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+void SceneStreamer::BoxMesh(const glm::vec3& bmin, const glm::vec3& bmax, std::vector<glm::vec3>& vertices,
+    std::vector<glm::vec3>& normals, std::vector<glm::vec2>& uvs, std::vector<uint32_t>& indices) {
+    // Cuatro vertices por cara para que cada una tenga su normal
+    static const int faces[6][4] = {
+        { 1, 3, 7, 5 }, { 0, 4, 6, 2 },     // +X, -X
+        { 2, 6, 7, 3 }, { 0, 1, 5, 4 },     // +Y, -Y
+        { 4, 5, 7, 6 }, { 0, 2, 3, 1 }      // +Z, -Z
+    };
+    static const glm::vec3 faceNormals[6] = {
+        { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }
+    };
+    vertices.clear();
+    normals.clear();
+    uvs.clear();
+    indices.clear();
+    for (int f = 0; f < 6; f++) {
+        uint32_t base = (uint32_t)vertices.size();
+        for (int k = 0; k < 4; k++) {
+            int corner = faces[f][k];
+            vertices.push_back(glm::vec3((corner & 1) ? bmax.x : bmin.x, (corner & 2) ? bmax.y : bmin.y,
+                (corner & 4) ? bmax.z : bmin.z));
+            normals.push_back(faceNormals[f]);
+            uvs.push_back(glm::vec2((k == 1 || k == 2) ? 1.0f : 0.0f, (k >= 2) ? 1.0f : 0.0f));
+        }
+        indices.insert(indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+/**
+ * Leveled logging with categories and an asynchronous sink, used instead of printf across the renderers and front ends.
+ *
+ *     LOG_INFO("core", "Device created");
+ *     LOG_DEBUG("rt", "BLAS %u: %u triangles", index, triangles);
+ *
+ * Calls below RENDERER_LOG_MIN_LEVEL (0 = debug, 1 = info, 2 = warning, 3 = error) expand to nothing, arguments
+ * included. It defaults to info when NDEBUG is defined (release builds) and to debug otherwise, and can be set with the
+ * CMake cache variable of the same name. Above that, the level can be raised at run time, globally or per category.
+ * The arguments are only formatted when the message passes the run-time filter.
+ *
+ * Messages are queued and written by a background thread, so a burst of logging does not stall the caller on console
+ * I/O. Errors flush the queue and are written before the call returns.
+ */
+
+#ifndef RENDERER_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define RENDERER_LOG_MIN_LEVEL 1
+#else
+#define RENDERER_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+namespace logging {
+
+    enum class Level {
+        Debug = 0,
+        Info,
+        Warning,
+        Error,
+        Off         ///< only as a filter level: nothing is written
+    };
+
+    /**
+     * @brief Destination of the messages. Called from the logging thread (or the caller's thread for errors and
+     * when the sink is synchronous), one call per message, never concurrently
+     */
+    using Sink = std::function<void(Level level, const char* category, const std::string& message)>;
+
+    /**
+     * @brief Sets the lowest level written for categories without their own level (Info by default)
+     * @param level lowest level written
+     */
+    void setLevel(Level level);
+
+    /**
+     * @brief Returns the lowest level written for categories without their own level
+     * @return level
+     */
+    Level getLevel();
+
+    /**
+     * @brief Overrides the level of one category, e.g. setCategoryLevel("rt", Level::Warning) to silence rebuilds
+     * @param category category name, as passed to the LOG_ macros
+     * @param level lowest level written for that category
+     */
+    void setCategoryLevel(const std::string& category, Level level);
+
+    /**
+     * @brief Removes every per-category level
+     */
+    void clearCategoryLevels();
+
+    /**
+     * @brief Replaces the sink. The default one writes "[level][category] message" to stdout (warnings and errors
+     * to stderr). Pending messages are flushed to the previous sink first
+     * @param sink new sink, or an empty function to restore the default one
+     */
+    void setSink(Sink sink);
+
+    /**
+     * @brief Chooses between the background thread (default) and writing each message before the call returns
+     * @param async false to write synchronously, e.g. while debugging a crash
+     */
+    void setAsync(bool async);
+
+    /**
+     * @brief Blocks until every queued message has been written
+     */
+    void flush();
+
+    /**
+     * @brief Returns whether a message would be written, to skip work that only feeds a log call
+     * @param level message level
+     * @param category message category
+     * @return true if it passes the run-time filter
+     */
+    bool isEnabled(Level level, const char* category);
+
+    /**
+     * @brief Formats (printf style) and queues a message. Use the LOG_ macros, which skip the call entirely when
+     * the level is compiled out or filtered
+     * @param level message level
+     * @param category message category
+     * @param format printf format; a trailing newline is not needed
+     */
+    void write(Level level, const char* category, const char* format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+        __attribute__((format(printf, 3, 4)))
+#endif
+        ;
+
+    /**
+     * @brief Short name of a level ("debug", "info", "warning", "error")
+     * @param level level
+     * @return name
+     */
+    const char* levelName(Level level);
+}
+
+#define LOG_AT(level, category, ...) \
+    do { \
+        if (logging::isEnabled(level, category)) { \
+            logging::write(level, category, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#if RENDERER_LOG_MIN_LEVEL <= 0
+#define LOG_DEBUG(category, ...) LOG_AT(logging::Level::Debug, category, __VA_ARGS__)
+#else
+#define LOG_DEBUG(category, ...) ((void)0)
+#endif
+
+#if RENDERER_LOG_MIN_LEVEL <= 1
+#define LOG_INFO(category, ...) LOG_AT(logging::Level::Info, category, __VA_ARGS__)
+#else
+#define LOG_INFO(category, ...) ((void)0)
+#endif
+
+#if RENDERER_LOG_MIN_LEVEL <= 2
+#define LOG_WARN(category, ...) LOG_AT(logging::Level::Warning, category, __VA_ARGS__)
+#else
+#define LOG_WARN(category, ...) ((void)0)
+#endif
+
+#define LOG_ERROR(category, ...) LOG_AT(logging::Level::Error, category, __VA_ARGS__)
@@ -6,6 +6,32 @@
 #include <vector>
 #include <glm/ext.hpp>
 
+/**
+ * @brief Memory used by one kind of renderer resource (geometry, acceleration structures, scratch, staging,
+ * textures, output images...), as returned by Renderer::getMemoryStats
+ */
+struct RendererMemoryCategory {
+    const char* name;               ///< category name
+    uint64_t deviceBytes;           ///< GPU memory currently allocated
+    uint64_t devicePeakBytes;       ///< highest value of deviceBytes since the last reset
+    uint32_t deviceAllocations;     ///< number of live GPU allocations
+    uint64_t hostBytes;             ///< CPU memory currently held (copies kept by the renderer)
+    uint64_t hostPeakBytes;         ///< highest value of hostBytes since the last reset
+};
+
+/**
+ * @brief Current and high-water memory usage of a renderer, with the scene size it was measured on
+ */
+struct RendererMemoryStats {
+    std::vector<RendererMemoryCategory> categories;
+    uint64_t deviceBytes = 0;       ///< sum over the categories
+    uint64_t devicePeakBytes = 0;   ///< highest total (not the sum of the per-category peaks)
+    uint64_t hostBytes = 0;
+    uint64_t hostPeakBytes = 0;
+    size_t triangles = 0;           ///< triangles over all the instances in the scene
+    uint32_t instances = 0;         ///< instances in the scene
+};
+
 class Renderer {
 public:
     using MeshId = uint32_t;
@@ -37,7 +63,7 @@ the scene with Renderer::addMesh
      * @brief Add a previously defined mesh to the scene
      * @param modelMatrix transformation applied to the mesh
      * @param id the mesh id
-     * @return false if the mesh id does not exists
+     * @return false if the mesh id does not exists, or the scene already holds as many instances as the renderer supports
      */
     virtual bool addMesh(const glm::mat4& modelMatrix, const glm::vec3
         & color, MeshId id) = 0;
@@ -100,4 +126,16 @@ Renderer::copyResultBytes or Renderer::getResultTextureId
 not compatible with GL)
       */
     virtual uint32_t getResultTextureId() = 0;
+
+    /**
+     * @brief Returns the memory allocated by the renderer, per category, and its high-water marks.
+     * Renderers that do not track their allocations return empty stats
+     * @return current and peak bytes, plus the triangle and instance counts of the scene
+     */
+    virtual RendererMemoryStats getMemoryStats() const { return RendererMemoryStats(); }
+
+    /**
+     * @brief Sets the high-water marks returned by Renderer::getMemoryStats to the current values
+     */
+    virtual void resetMemoryPeaks() {}
 };
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+
+/**
+ * Scoped CPU timers that can be dumped as Chrome trace_event JSON (chrome://tracing, Perfetto).
+ *
+ * Compiled in only with RENDERER_TRACING (CMake option of the same name). Without it TRACE_SCOPE
+ * expands to nothing and the trace:: functions are empty inline stubs, so the instrumentation costs nothing.
+ *
+ *     TRACE_SCOPE("buildBlas", "core");
+ *     TRACE_SCOPE_DETAIL("loadOBJ", "frontend", filepath);
+ *     ...
+ *     trace::writeChromeTrace("trace.json");
+ */
+
+#ifdef RENDERER_TRACING
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+// name and category must be string literals (only the pointer is stored)
+#define TRACE_SCOPE(name, category) trace::ScopedTimer TRACE_CONCAT(traceScope_, __LINE__)(name, category)
+#define TRACE_SCOPE_DETAIL(name, category, detail) trace::ScopedTimer TRACE_CONCAT(traceScope_, __LINE__)(name, category, detail)
+
+namespace trace {
+
+    /**
+     * @brief Records a complete event from construction to destruction on the calling thread
+     */
+    class ScopedTimer {
+    public:
+        ScopedTimer(const char* name, const char* category);
+        ScopedTimer(const char* name, const char* category, const std::string& detail);
+        ~ScopedTimer();
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        const char* m_name;
+        const char* m_category;
+        std::string m_detail;
+        long long m_startUs;
+        bool m_active;
+    };
+
+    /**
+     * @brief Starts or pauses recording (enabled by default). Scopes opened while paused are not recorded
+     * @param enabled true to record
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief Returns whether scopes are being recorded
+     * @return true if recording
+     */
+    bool isEnabled();
+
+    /**
+     * @brief Discards every recorded event
+     */
+    void clear();
+
+    /**
+     * @brief Writes every event recorded so far, from all threads, as Chrome trace_event JSON
+     * @param filename destination file
+     * @return false if the file could not be written
+     */
+    bool writeChromeTrace(const std::string& filename);
+}
+
+#else
+
+#define TRACE_SCOPE(name, category) ((void)0)
+#define TRACE_SCOPE_DETAIL(name, category, detail) ((void)0)
+
+namespace trace {
+    inline void setEnabled(bool) {}
+    inline bool isEnabled() { return false; }
+    inline void clear() {}
+    inline bool writeChromeTrace(const std::string&) { return false; }
+}
+
+#endif
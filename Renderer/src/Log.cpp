@@ -0,0 +1,231 @@
+#include "Log.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace logging {
+
+    namespace {
+
+        // La categoria se copia como el mensaje: en modo asincrono el registro sobrevive a la llamada
+        struct Record {
+            Level level;
+            std::string category;
+            std::string message;
+        };
+
+        void DefaultSink(Level level, const char* category, const std::string& message) {
+            FILE* out = (level >= Level::Warning) ? stderr : stdout;
+            fprintf(out, "[%s][%s] %s\n", levelName(level), category, message.c_str());
+        }
+
+        /*
+        * El hilo de escritura se crea con el primer mensaje asincrono. El logger no se destruye nunca (los destructores
+        * estaticos de otros modulos pueden seguir escribiendo); al salir se vacia la cola y se pasa a modo sincrono
+        */
+        struct Logger {
+            std::atomic<int> level{ (int)Level::Info };
+            std::atomic<bool> hasCategoryLevels{ false };
+            std::atomic<bool> async{ true };
+
+            std::mutex categoryMutex;
+            std::map<std::string, Level> categoryLevels;
+
+            std::mutex queueMutex;
+            std::condition_variable queueReady;
+            std::condition_variable queueDrained;
+            std::deque<Record> queue;
+            bool writing = false;       // el hilo tiene un lote fuera de la cola
+            bool stopped = false;
+            std::thread worker;
+
+            // Serializa las llamadas al sink (hilo de escritura, errores y modo sincrono)
+            std::mutex sinkMutex;
+            Sink sink = DefaultSink;
+
+            void Write(const Record& record) {
+                std::lock_guard<std::mutex> lock(sinkMutex);
+                sink(record.level, record.category.c_str(), record.message);
+            }
+
+            void Run() {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                while (true) {
+                    queueReady.wait(lock, [this] { return stopped || !queue.empty(); });
+                    if (queue.empty()) {
+                        break;
+                    }
+                    std::deque<Record> batch;
+                    batch.swap(queue);
+                    writing = true;
+                    lock.unlock();
+                    for (const Record& record : batch) {
+                        Write(record);
+                    }
+                    fflush(stdout);
+                    lock.lock();
+                    writing = false;
+                    queueDrained.notify_all();
+                }
+                writing = false;
+                queueDrained.notify_all();
+            }
+
+            // Devuelve false si ya no hay hilo (salida del programa): el mensaje se escribe en el llamante
+            bool Enqueue(Record&& record) {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                if (stopped) {
+                    return false;
+                }
+                if (!worker.joinable()) {
+                    worker = std::thread([this] { Run(); });
+                    atexit(Shutdown);
+                }
+                queue.push_back(std::move(record));
+                queueReady.notify_one();
+                return true;
+            }
+
+            void Flush() {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueDrained.wait(lock, [this] { return stopped || (queue.empty() && !writing); });
+            }
+
+            static void Shutdown();
+        };
+
+        Logger& GetLogger() {
+            static Logger* logger = new Logger();
+            return *logger;
+        }
+
+        void Logger::Shutdown() {
+            Logger& logger = GetLogger();
+            {
+                std::lock_guard<std::mutex> lock(logger.queueMutex);
+                logger.stopped = true;
+                logger.queueReady.notify_one();
+            }
+            if (logger.worker.joinable()) {
+                logger.worker.join();
+            }
+            // Lo que quedase en la cola (el hilo la vacia antes de salir, pero por si acaso)
+            for (const Record& record : logger.queue) {
+                logger.Write(record);
+            }
+            logger.queue.clear();
+            fflush(stdout);
+        }
+    }
+
+    void setLevel(Level level) {
+        GetLogger().level.store((int)level, std::memory_order_relaxed);
+    }
+
+    Level getLevel() {
+        return (Level)GetLogger().level.load(std::memory_order_relaxed);
+    }
+
+    void setCategoryLevel(const std::string& category, Level level) {
+        Logger& logger = GetLogger();
+        std::lock_guard<std::mutex> lock(logger.categoryMutex);
+        logger.categoryLevels[category] = level;
+        logger.hasCategoryLevels.store(true, std::memory_order_release);
+    }
+
+    void clearCategoryLevels() {
+        Logger& logger = GetLogger();
+        std::lock_guard<std::mutex> lock(logger.categoryMutex);
+        logger.categoryLevels.clear();
+        logger.hasCategoryLevels.store(false, std::memory_order_release);
+    }
+
+    void setSink(Sink sink) {
+        Logger& logger = GetLogger();
+        logger.Flush();
+        std::lock_guard<std::mutex> lock(logger.sinkMutex);
+        logger.sink = sink ? sink : Sink(DefaultSink);
+    }
+
+    void setAsync(bool async) {
+        Logger& logger = GetLogger();
+        if (!async) {
+            logger.Flush();
+        }
+        logger.async.store(async, std::memory_order_relaxed);
+    }
+
+    void flush() {
+        GetLogger().Flush();
+    }
+
+    bool isEnabled(Level level, const char* category) {
+        Logger& logger = GetLogger();
+        // Camino rapido: sin niveles por categoria basta una comparacion
+        if (!logger.hasCategoryLevels.load(std::memory_order_acquire)) {
+            return (int)level >= logger.level.load(std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lock(logger.categoryMutex);
+        auto it = logger.categoryLevels.find(category);
+        int minLevel = (it != logger.categoryLevels.end()) ? (int)it->second : logger.level.load(std::memory_order_relaxed);
+        return (int)level >= minLevel;
+    }
+
+    void write(Level level, const char* category, const char* format, ...) {
+        char stackBuffer[512];
+        va_list args;
+        va_start(args, format);
+        va_list argsCopy;
+        va_copy(argsCopy, args);
+        int length = vsnprintf(stackBuffer, sizeof(stackBuffer), format, args);
+        va_end(args);
+
+        Record record{ level, category, std::string() };
+        if (length < 0) {
+            record.message = format;
+        }
+        else if ((size_t)length < sizeof(stackBuffer)) {
+            record.message.assign(stackBuffer, (size_t)length);
+        }
+        else {
+            record.message.resize((size_t)length + 1);
+            vsnprintf(&record.message[0], record.message.size(), format, argsCopy);
+            record.message.resize((size_t)length);
+        }
+        va_end(argsCopy);
+
+        // Los mensajes ya traen saltos de linea propios de la epoca de printf; el sink pone el suyo
+        while (!record.message.empty() && record.message.back() == '\n') {
+            record.message.pop_back();
+        }
+
+        Logger& logger = GetLogger();
+        if (level >= Level::Error || !logger.async.load(std::memory_order_relaxed)) {
+            // Un error se escribe antes de volver, detras de lo que ya estuviera en la cola
+            logger.Flush();
+            logger.Write(record);
+            fflush(stdout);
+            return;
+        }
+        if (!logger.Enqueue(std::move(record))) {
+            logger.Write(record);
+        }
+    }
+
+    const char* levelName(Level level) {
+        switch (level) {
+        case Level::Debug: return "debug";
+        case Level::Info: return "info";
+        case Level::Warning: return "warning";
+        case Level::Error: return "error";
+        default: return "off";
+        }
+    }
+}
@@ -0,0 +1,166 @@
+#include "Trace.h"
+
+#ifdef RENDERER_TRACING
+
+#include "Log.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trace {
+
+    namespace {
+
+        struct Event {
+            const char* name;
+            const char* category;
+            std::string detail;
+            long long startUs;
+            long long durationUs;
+        };
+
+        // Cada hilo escribe en su propio buffer; el mutex solo se disputa mientras se vuelca la traza
+        struct ThreadBuffer {
+            std::mutex mutex;
+            std::vector<Event> events;
+            uint32_t tid = 0;
+        };
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+            std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+            std::atomic<bool> enabled{ true };
+        };
+
+        Registry& GetRegistry() {
+            static Registry registry;
+            return registry;
+        }
+
+        ThreadBuffer& GetThreadBuffer() {
+            thread_local std::shared_ptr<ThreadBuffer> buffer;
+            if (!buffer) {
+                buffer = std::make_shared<ThreadBuffer>();
+                Registry& registry = GetRegistry();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                buffer->tid = (uint32_t)registry.buffers.size() + 1;
+                registry.buffers.push_back(buffer);
+            }
+            return *buffer;
+        }
+
+        long long NowUs() {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - GetRegistry().origin).count();
+        }
+
+        void WriteEscaped(std::ostream& out, const char* str) {
+            for (const char* c = str; *c; c++) {
+                switch (*c) {
+                case '"':  out << "\\\""; break;
+                case '\\': out << "\\\\"; break;
+                case '\n': out << "\\n"; break;
+                case '\t': out << "\\t"; break;
+                default:
+                    if ((unsigned char)*c >= 0x20) {
+                        out << *c;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    ScopedTimer::ScopedTimer(const char* name, const char* category)
+        : m_name(name), m_category(category), m_startUs(0), m_active(GetRegistry().enabled.load(std::memory_order_relaxed)) {
+        if (m_active) {
+            m_startUs = NowUs();
+        }
+    }
+
+    ScopedTimer::ScopedTimer(const char* name, const char* category, const std::string& detail)
+        : ScopedTimer(name, category) {
+        if (m_active) {
+            m_detail = detail;
+        }
+    }
+
+    ScopedTimer::~ScopedTimer() {
+        if (!m_active) {
+            return;
+        }
+        long long endUs = NowUs();
+        ThreadBuffer& buffer = GetThreadBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        buffer.events.push_back({ m_name, m_category, std::move(m_detail), m_startUs, endUs - m_startUs });
+    }
+
+    void setEnabled(bool enabled) {
+        GetRegistry().enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool isEnabled() {
+        return GetRegistry().enabled.load(std::memory_order_relaxed);
+    }
+
+    void clear() {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (auto& buffer : registry.buffers) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            buffer->events.clear();
+        }
+    }
+
+    bool writeChromeTrace(const std::string& filename) {
+        std::ofstream out(filename);
+        if (!out) {
+            LOG_ERROR("trace", "Could not open trace file %s", filename.c_str());
+            return false;
+        }
+
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        size_t eventCount = 0;
+        out << "{\"traceEvents\":[";
+        bool first = true;
+        for (auto& buffer : registry.buffers) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            for (const Event& e : buffer->events) {
+                out << (first ? "\n" : ",\n");
+                first = false;
+                out << "{\"name\":\"";
+                WriteEscaped(out, e.name);
+                out << "\",\"cat\":\"";
+                WriteEscaped(out, e.category);
+                out << "\",\"ph\":\"X\",\"ts\":" << e.startUs << ",\"dur\":" << e.durationUs
+                    << ",\"pid\":1,\"tid\":" << buffer->tid;
+                if (!e.detail.empty()) {
+                    out << ",\"args\":{\"detail\":\"";
+                    WriteEscaped(out, e.detail.c_str());
+                    out << "\"}";
+                }
+                out << "}";
+                eventCount++;
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+        if (!out.good()) {
+            LOG_ERROR("trace", "Could not write trace file %s", filename.c_str());
+            return false;
+        }
+        LOG_INFO("trace", "Wrote %zu trace events to %s", eventCount, filename.c_str());
+        return true;
+    }
+}
+
+#endif
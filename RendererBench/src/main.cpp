@@ -0,0 +1,522 @@
+/*
+* RendererBench: benchmark sin ventana del VulkanRenderer.
+* Carga las escenas con los loaders del front end (OBJ con el parser propio, glTF por tinygltf), traza N frames de
+* calentamiento y M medidos en cada resolucion y escribe los resultados en JSON.
+* En un dispositivo sin ray tracing (lavapipe/SwiftShader) el renderer usa el trazado por compute, asi que
+* corre en CI sin GPU.
+*
+* Las escenas "stress:..." las genera SceneGenerator, para medir como escalan TLAS, descriptores y memoria.
+*
+*   RendererBench --scene ../GLFWFrontEnd/OBJ/Cubo.obj --res 256x256 --res 512x512 --warmup 5 --frames 50 --out bench.json
+*   RendererBench --scene ../GLFWFrontEnd/OBJ/Tesla.obj+../GLFWFrontEnd/OBJ/Cubo.obj
+*   RendererBench --scene stress:instances=8 --scene stress:instances=32 --scene stress:instances=32,tris=20000
+*
+* Nota: el set de descriptores de geometria empieza con 50 instancias y crece con la escena hasta el limite
+* de storage buffers del dispositivo, con el plano del suelo incluido.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <Renderer/VulkanRenderer.h>
+#include "Trace.h"
+#include "SceneGenerator.h"
+
+#include "json.hpp"
+// gltfloader.h incluye tiny_gltf.h: antes de TINYGLTF_IMPLEMENTATION para no compilar la implementacion dos veces
+#include "gltfloader.h"
+#define TINYGLTF_IMPLEMENTATION
+#include "tiny_gltf.h"
+#include "assetloader.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct BenchOptions {
+    std::vector<std::string> scenes;
+    std::vector<std::pair<uint32_t, uint32_t>> resolutions;
+    int warmupFrames = 5;
+    int measuredFrames = 30;
+    bool rayQuery = false;
+    bool rayStats = false;
+    bool meshCache = true;
+    bool lod = true;
+    bool clusters = false;
+    std::string output = "bench.json";
+    std::string tracePath;
+};
+
+static double ElapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Pico del conjunto residente del proceso en MB
+static double PeakMemoryMB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return (double)counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+    }
+    return 0.0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return (double)usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return (double)usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+static double Percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    double rank = p / 100.0 * (double)(values.size() - 1);
+    size_t lo = (size_t)rank;
+    size_t hi = std::min(lo + 1, values.size() - 1);
+    double t = rank - (double)lo;
+    return values[lo] * (1.0 - t) + values[hi] * t;
+}
+
+static nlohmann::json Summary(const std::vector<double>& values) {
+    double sum = 0.0;
+    for (double v : values) {
+        sum += v;
+    }
+    return {
+        { "mean", values.empty() ? 0.0 : sum / (double)values.size() },
+        { "min", Percentile(values, 0.0) },
+        { "p50", Percentile(values, 50.0) },
+        { "p90", Percentile(values, 90.0) },
+        { "p99", Percentile(values, 99.0) },
+        { "max", Percentile(values, 100.0) }
+    };
+}
+
+static glm::mat4 FrameScene(const glm::vec3& bmin, const glm::vec3& bmax, uint32_t width, uint32_t height) {
+    glm::vec3 center = (bmin + bmax) * 0.5f;
+    float radius = std::max(glm::length(bmax - bmin) * 0.5f, 1e-3f);
+    glm::vec3 eye = center + glm::normalize(glm::vec3(1.0f, 0.6f, 1.0f)) * radius * 2.5f;
+
+    // Misma convencion que los front ends: VP en el primer parametro, proyeccion identidad
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, radius * 10.0f);
+    return proj * glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+static nlohmann::json StageTimingsJson(const VulkanRenderer& renderer) {
+    nlohmann::json stages = nlohmann::json::object();
+    for (const RendererStageTiming& t : renderer.getStageTimings()) {
+        stages[t.name] = { { "totalMs", t.totalMs }, { "count", t.count } };
+    }
+    return stages;
+}
+
+static double StageTotalMs(const VulkanRenderer& renderer, const char* name) {
+    for (const RendererStageTiming& t : renderer.getStageTimings()) {
+        if (strcmp(t.name, name) == 0) {
+            return t.totalMs;
+        }
+    }
+    return 0.0;
+}
+
+// Memoria del renderer por categoria y lo que cuesta cada triangulo e instancia de la escena
+static nlohmann::json MemoryJson(const VulkanRenderer& renderer) {
+    RendererMemoryStats stats = renderer.getMemoryStats();
+    nlohmann::json categories = nlohmann::json::object();
+    for (const RendererMemoryCategory& c : stats.categories) {
+        categories[c.name] = {
+            { "deviceBytes", c.deviceBytes },
+            { "devicePeakBytes", c.devicePeakBytes },
+            { "deviceAllocations", c.deviceAllocations },
+            { "hostBytes", c.hostBytes },
+            { "hostPeakBytes", c.hostPeakBytes }
+        };
+    }
+    double totalBytes = (double)(stats.deviceBytes + stats.hostBytes);
+    return {
+        { "deviceBytes", stats.deviceBytes },
+        { "devicePeakBytes", stats.devicePeakBytes },
+        { "hostBytes", stats.hostBytes },
+        { "hostPeakBytes", stats.hostPeakBytes },
+        { "bytesPerTriangle", stats.triangles > 0 ? totalBytes / (double)stats.triangles : 0.0 },
+        { "bytesPerInstance", stats.instances > 0 ? totalBytes / (double)stats.instances : 0.0 },
+        { "categories", categories }
+    };
+}
+
+// Contadores del ultimo frame con los shaders instrumentados (--ray-stats)
+static nlohmann::json RayStatsJson(const VulkanRenderer& renderer) {
+    RendererRayStats stats = renderer.getRayStatistics();
+    uint64_t rays = 0, hits = 0;
+    for (size_t d = 0; d < stats.raysPerDepth.size(); d++) {
+        rays += stats.raysPerDepth[d];
+        hits += stats.hitsPerDepth[d];
+    }
+    return {
+        { "pixels", stats.pixels },
+        { "rays", rays },
+        { "raysPerPixel", stats.pixels > 0 ? (double)rays / (double)stats.pixels : 0.0 },
+        { "hitRatio", rays > 0 ? (double)hits / (double)rays : 0.0 },
+        { "raysPerDepth", stats.raysPerDepth },
+        { "hitsPerDepth", stats.hitsPerDepth },
+        { "missesPerDepth", stats.missesPerDepth },
+        { "bounceHistogram", stats.bounceHistogram },
+        { "maxCost", stats.maxCost },
+        { "costUnit", stats.clockCost ? "cycles" : "rays" }
+    };
+}
+
+static nlohmann::json RunFrames(VulkanRenderer& renderer, const glm::vec3& bmin, const glm::vec3& bmax,
+    const BenchOptions& options, nlohmann::json result);
+
+static nlohmann::json RunScene(VulkanRenderer& renderer, const std::string& scene, const BenchOptions& options) {
+    TRACE_SCOPE_DETAIL("benchScene", "bench", scene);
+    nlohmann::json result;
+    result["scene"] = scene;
+
+    renderer.clearScene();
+    renderer.resetMemoryPeaks();
+
+    // Escenas procedurales: el generador define y anade las mallas directamente
+    if (scene == "default" || scene.rfind("stress:", 0) == 0) {
+        StressSceneParams params;
+        if (scene != "default" && !SceneGenerator::ParseParams(scene.substr(7), params)) {
+            result["error"] = "invalid stress scene parameters";
+            return result;
+        }
+        SceneGenerator generator;
+        auto generateStart = Clock::now();
+        GeneratedScene generated = generator.generate(renderer, params);
+        double generateMs = ElapsedMs(generateStart);
+
+        result["stress"] = SceneGenerator::DescribeParams(params);
+        result["meshes"] = generated.meshIds.size();
+        result["instances"] = generated.instances;
+        result["uniqueTriangles"] = generated.uniqueTriangles;
+        result["triangles"] = generated.instancedTriangles;
+        result["load"] = { { "parseMs", 0.0 }, { "uploadMs", generateMs }, { "totalMs", generateMs } };
+        return RunFrames(renderer, generated.boundsMin, generated.boundsMax, options, result);
+    }
+
+    // Carga: parseo con AssetLoader (cache, parser de OBJ o tinygltf) y subida con defineMesh/addMesh.
+    // "a.obj+b.glb" parsea los ficheros en paralelo y los junta en una sola escena
+    std::vector<std::string> paths;
+    for (size_t start = 0, end; start <= scene.size(); start = end + 1) {
+        end = std::min(scene.find('+', start), scene.size());
+        paths.push_back(scene.substr(start, end - start));
+    }
+    auto loadStart = Clock::now();
+    AssetLoader assets((unsigned int)paths.size());
+    std::vector<std::future<LoadedAsset>> futures = assets.loadAll(paths, options.meshCache);
+    std::vector<AssetMesh> meshes;
+    std::vector<AssetInstance> instances;
+    bool loaded = true, cached = true;
+    double slowestAssetMs = 0.0;
+    for (std::future<LoadedAsset>& future : futures) {
+        LoadedAsset asset = future.get();
+        loaded = loaded && asset.ok;
+        cached = cached && asset.cached;
+        slowestAssetMs = std::max(slowestAssetMs, asset.parseMs);
+        size_t base = meshes.size();
+        // Sin instancias (OBJ) cada malla va una vez en el origen
+        if (asset.instances.empty()) {
+            for (size_t i = 0; i < asset.meshes.size(); i++) {
+                instances.push_back({ base + i, glm::mat4(1.0f), glm::vec3(0.8f) });
+            }
+        }
+        for (const AssetInstance& instance : asset.instances) {
+            instances.push_back({ base + instance.mesh, instance.transform, instance.color });
+        }
+        for (AssetMesh& mesh : asset.meshes) {
+            meshes.push_back(std::move(mesh));
+        }
+    }
+    if (!loaded || meshes.empty()) {
+        result["error"] = "load failed";
+        return result;
+    }
+    double parseMs = ElapsedMs(loadStart);
+
+    // Cada malla se define una vez y se anade una vez por instancia
+    size_t uniqueTriangles = 0, triangles = 0;
+    auto uploadStart = Clock::now();
+    std::vector<Renderer::MeshId> ids(meshes.size());
+    for (size_t i = 0; i < meshes.size(); i++) {
+        const AssetMesh& mesh = meshes[i];
+        ids[i] = renderer.defineMesh(mesh.vertices, mesh.normals, mesh.uvs, mesh.indices);
+        uniqueTriangles += mesh.indices.size() / 3;
+    }
+    for (const AssetInstance& instance : instances) {
+        if (!renderer.addMesh(instance.transform, instance.color, ids[instance.mesh])) {
+            result["error"] = "too many instances";
+            return result;
+        }
+        triangles += meshes[instance.mesh].indices.size() / 3;
+    }
+    double uploadMs = ElapsedMs(uploadStart);
+
+    // Limites de la escena: las 8 esquinas de la caja de cada malla, transformadas por cada instancia
+    std::vector<glm::vec3> meshMin(meshes.size(), glm::vec3(1e30f)), meshMax(meshes.size(), glm::vec3(-1e30f));
+    for (size_t i = 0; i < meshes.size(); i++) {
+        for (const glm::vec3& v : meshes[i].vertices) {
+            meshMin[i] = glm::min(meshMin[i], v);
+            meshMax[i] = glm::max(meshMax[i], v);
+        }
+    }
+    glm::vec3 bmin(1e30f), bmax(-1e30f);
+    for (const AssetInstance& instance : instances) {
+        if (meshes[instance.mesh].vertices.empty()) {
+            continue;
+        }
+        for (int corner = 0; corner < 8; corner++) {
+            glm::vec3 p((corner & 1) ? meshMax[instance.mesh].x : meshMin[instance.mesh].x,
+                (corner & 2) ? meshMax[instance.mesh].y : meshMin[instance.mesh].y,
+                (corner & 4) ? meshMax[instance.mesh].z : meshMin[instance.mesh].z);
+            glm::vec3 world = glm::vec3(instance.transform * glm::vec4(p, 1.0f));
+            bmin = glm::min(bmin, world);
+            bmax = glm::max(bmax, world);
+        }
+    }
+
+    result["meshes"] = meshes.size();
+    result["instances"] = instances.size();
+    result["uniqueTriangles"] = uniqueTriangles;
+    result["triangles"] = triangles;
+    result["load"] = { { "parseMs", parseMs }, { "uploadMs", uploadMs }, { "totalMs", parseMs + uploadMs }, { "cached", cached },
+        { "assets", paths.size() }, { "slowestAssetMs", slowestAssetMs } };
+    return RunFrames(renderer, bmin, bmax, options, result);
+}
+
+// Primer frame (construccion de la escena) y frames medidos en cada resolucion
+static nlohmann::json RunFrames(VulkanRenderer& renderer, const glm::vec3& bmin, const glm::vec3& bmax,
+    const BenchOptions& options, nlohmann::json result) {
+    std::string scene = result["scene"];
+
+    // El primer render construye BLAS/TLAS (o la BVH del trazado por software)
+    uint32_t firstWidth = options.resolutions.front().first;
+    uint32_t firstHeight = options.resolutions.front().second;
+    renderer.setOutputResolution(firstWidth, firstHeight);
+    renderer.setCamera(FrameScene(bmin, bmax, firstWidth, firstHeight), glm::mat4(1.0f));
+    renderer.resetStageTimings();
+    auto buildStart = Clock::now();
+    renderer.render();
+    double firstFrameMs = ElapsedMs(buildStart);
+    result["build"] = {
+        { "firstFrameMs", firstFrameMs },
+        { "blasMs", StageTotalMs(renderer, "BLAS build") },
+        { "tlasMs", StageTotalMs(renderer, "TLAS build") },
+        { "descriptorUpdateMs", StageTotalMs(renderer, "Descriptor update") }
+    };
+
+    nlohmann::json runs = nlohmann::json::array();
+    for (const auto& res : options.resolutions) {
+        uint32_t width = res.first;
+        uint32_t height = res.second;
+        TRACE_SCOPE("benchResolution", "bench");
+
+        renderer.setOutputResolution(width, height);
+        renderer.setCamera(FrameScene(bmin, bmax, width, height), glm::mat4(1.0f));
+        std::vector<uint8_t> pixels((size_t)width * height * 4);
+
+        for (int i = 0; i < options.warmupFrames; i++) {
+            renderer.render();
+        }
+
+        renderer.resetStageTimings();
+        std::vector<double> frameMs, readbackMs;
+        frameMs.reserve(options.measuredFrames);
+        readbackMs.reserve(options.measuredFrames);
+        for (int i = 0; i < options.measuredFrames; i++) {
+            auto frameStart = Clock::now();
+            renderer.render();
+            frameMs.push_back(ElapsedMs(frameStart));
+
+            auto readStart = Clock::now();
+            renderer.copyResultBytes(pixels.data(), pixels.size());
+            readbackMs.push_back(ElapsedMs(readStart));
+        }
+
+        double totalFrameMs = 0.0;
+        for (double ms : frameMs) {
+            totalFrameMs += ms;
+        }
+        // Solo rayos primarios (1 muestra por pixel y frame); los rebotes no se cuentan
+        double primaryRays = (double)width * (double)height * (double)frameMs.size();
+        double mrays = (totalFrameMs > 0.0) ? primaryRays / (totalFrameMs * 1e-3) / 1e6 : 0.0;
+
+        nlohmann::json run = {
+            { "width", width },
+            { "height", height },
+            { "warmupFrames", options.warmupFrames },
+            { "measuredFrames", options.measuredFrames },
+            { "frameMs", Summary(frameMs) },
+            { "readbackMs", Summary(readbackMs) },
+            { "primaryMraysPerSec", mrays },
+            { "gpuStages", StageTimingsJson(renderer) }
+        };
+        if (renderer.isRayStatisticsEnabled()) {
+            run["rayStats"] = RayStatsJson(renderer);
+        }
+        runs.push_back(run);
+        printf("%s %ux%u: p50 %.3f ms, %.2f Mrays/s\n", scene.c_str(), width, height, Percentile(frameMs, 50.0), mrays);
+    }
+    result["runs"] = runs;
+    result["memory"] = MemoryJson(renderer);
+    result["peakMemoryMB"] = PeakMemoryMB();
+    return result;
+}
+
+static bool ParseResolution(const char* str, std::pair<uint32_t, uint32_t>& res) {
+    unsigned int w = 0, h = 0;
+    if (sscanf(str, "%ux%u", &w, &h) != 2 || w == 0 || h == 0) {
+        return false;
+    }
+    res = { w, h };
+    return true;
+}
+
+static void PrintUsage() {
+    printf("Usage: RendererBench [options]\n"
+        "  --scene <file.obj|file.gltf|file.glb>           scene to load (repeatable)\n"
+        "  --scene <file>+<file>+...                       files parsed in parallel into one scene\n"
+        "  --scene stress:instances=N,meshes=M,tris=K,...  procedural scene (keys: instances, meshes, tris,\n"
+        "                                                  spheres, extent, seed, ground)\n"
+        "  --scene default                                 procedural scene with default parameters (the default)\n"
+        "  --res <WxH>                                     output resolution (repeatable)\n"
+        "  --warmup <N>                                    unmeasured frames per resolution (default 5)\n"
+        "  --frames <M>                                    measured frames per resolution (default 30)\n"
+        "  --ray-query                                     use the hybrid ray query mode if available\n"
+        "  --ray-stats                                     trace with the instrumented shaders and record ray\n"
+        "                                                  counters per depth (slower, not with --ray-query)\n"
+        "  --no-cache                                      always parse the scene files, without reading or\n"
+        "                                                  writing <file>.meshcache\n"
+        "  --no-lod                                        trace the full meshes, without per-instance LOD\n"
+        "  --clusters                                      split meshes over 64k triangles into one BLAS\n"
+        "                                                  geometry per spatial cluster\n"
+        "  --out <file.json|->                             results file (default bench.json, - = stdout)\n"
+        "  --trace <file.json>                             dump the CPU trace (needs RENDERER_TRACING)\n");
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--scene" && hasValue) {
+            options.scenes.push_back(argv[++i]);
+        }
+        else if (arg == "--res" && hasValue) {
+            std::pair<uint32_t, uint32_t> res;
+            if (ParseResolution(argv[++i], res)) {
+                options.resolutions.push_back(res);
+            }
+            else {
+                printf("Invalid resolution %s, expected <WxH>\n", argv[i]);
+            }
+        }
+        else if (arg == "--warmup" && hasValue) {
+            options.warmupFrames = std::max(0, atoi(argv[++i]));
+        }
+        else if (arg == "--frames" && hasValue) {
+            options.measuredFrames = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--ray-query") {
+            options.rayQuery = true;
+        }
+        else if (arg == "--ray-stats") {
+            options.rayStats = true;
+        }
+        else if (arg == "--no-cache") {
+            options.meshCache = false;
+        }
+        else if (arg == "--no-lod") {
+            options.lod = false;
+        }
+        else if (arg == "--clusters") {
+            options.clusters = true;
+        }
+        else if (arg == "--out" && hasValue) {
+            options.output = argv[++i];
+        }
+        else if (arg == "--trace" && hasValue) {
+            options.tracePath = argv[++i];
+        }
+        else {
+            PrintUsage();
+            return (arg == "--help" || arg == "-h") ? 0 : 1;
+        }
+    }
+    if (options.scenes.empty()) {
+        options.scenes.push_back("default");
+    }
+    if (options.resolutions.empty()) {
+        options.resolutions = { { 512, 512 }, { 1280, 720 }, { 1920, 1080 } };
+    }
+
+    VulkanRenderer renderer;
+    auto initStart = Clock::now();
+    if (!renderer.init()) {
+        std::cerr << "Renderer init failed" << std::endl;
+        return 2;
+    }
+    double initMs = ElapsedMs(initStart);
+    // Cada frame medido traza una muestra nueva
+    renderer.setTargetSamplesPerPixel(0);
+    if (options.rayQuery && !renderer.setRayQueryMode(true)) {
+        printf("Ray query mode not available, using the default trace mode\n");
+    }
+    if (options.rayStats && !renderer.setRayStatistics(true)) {
+        printf("Ray statistics not available in this mode\n");
+    }
+    renderer.setLodSelection(options.lod);
+    renderer.setClusterSplitting(options.clusters);
+
+    nlohmann::json report;
+    report["initMs"] = initMs;
+    report["mode"] = renderer.isSoftwareRayTracing() ? "software" : (renderer.isRayQueryMode() ? "ray_query" : "ray_tracing_pipeline");
+    report["lod"] = renderer.isLodSelectionEnabled();
+    report["clusters"] = renderer.isClusterSplittingEnabled();
+
+    nlohmann::json scenes = nlohmann::json::array();
+    for (const std::string& scene : options.scenes) {
+        scenes.push_back(RunScene(renderer, scene, options));
+    }
+    report["scenes"] = scenes;
+    report["peakMemoryMB"] = PeakMemoryMB();
+
+    std::string text = report.dump(2);
+    if (options.output == "-") {
+        std::cout << text << std::endl;
+    }
+    else {
+        std::ofstream out(options.output);
+        if (!out) {
+            std::cerr << "Could not write " << options.output << std::endl;
+            return 3;
+        }
+        out << text << std::endl;
+        printf("Results written to %s\n", options.output.c_str());
+    }
+
+    if (!options.tracePath.empty()) {
+        trace::writeChromeTrace(options.tracePath);
+    }
+    return 0;
+}
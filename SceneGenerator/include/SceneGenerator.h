@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Renderer.h"
+
+/**
+ * @brief Parameters of a procedural stress scene. The same parameters (and seed) always produce the same scene
+ */
+struct StressSceneParams {
+    uint32_t meshCount = 4;             ///< M distinct meshes, alternating sphere / plane according to sphereRatio
+    uint32_t instanceCount = 16;        ///< N instances, assigned round-robin to the meshes
+    uint32_t trianglesPerMesh = 2048;   ///< K, approximate triangle count of each tessellated mesh
+    float sphereRatio = 0.5f;           ///< fraction of the meshes that are spheres (the rest are planes)
+    float extent = 20.0f;               ///< instances are scattered over [-extent, extent] on XZ
+    uint32_t seed = 1;                  ///< seed of the random transforms and colors
+    bool groundPlane = true;            ///< adds a 2-triangle ground plane under the instances (one more mesh and instance)
+};
+
+/**
+ * @brief Geometry of one generated mesh
+ */
+struct GeneratedMesh {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<uint32_t> indices;
+};
+
+/**
+ * @brief What SceneGenerator::generate added to the renderer
+ */
+struct GeneratedScene {
+    std::vector<Renderer::MeshId> meshIds;  ///< defined meshes, including the ground plane
+    uint32_t instances = 0;                 ///< instances successfully added with Renderer::addMesh
+    size_t uniqueTriangles = 0;             ///< triangles over the defined meshes
+    size_t instancedTriangles = 0;          ///< triangles over all the instances
+    glm::vec3 boundsMin = glm::vec3(0.0f);  ///< world-space bounds of all the instances
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+};
+
+/**
+ * @brief Builds parameterized workloads through the Renderer API (any backend): N instances of M tessellated
+ * spheres and planes with random transforms from a fixed seed. Used to measure how TLAS, descriptors and memory
+ * scale with instance count, triangle count and resolution
+ */
+class SceneGenerator {
+public:
+    /**
+     * @brief Defines the meshes and adds the instances to the renderer. The scene is not cleared first
+     * @param renderer destination renderer
+     * @param params scene parameters
+     * @return ids, counts and bounds of what was added
+     */
+    GeneratedScene generate(Renderer& renderer, const StressSceneParams& params);
+
+    /**
+     * @brief UV sphere of radius 1 centered at the origin with about targetTriangles triangles (no degenerate poles)
+     * @param targetTriangles requested triangle count (at least 8)
+     * @param out generated mesh
+     */
+    static void TessellatedSphere(uint32_t targetTriangles, GeneratedMesh& out);
+
+    /**
+     * @brief 2x2 plane on XZ facing +Y, as a grid with about targetTriangles triangles
+     * @param targetTriangles requested triangle count (at least 2)
+     * @param out generated mesh
+     */
+    static void TessellatedPlane(uint32_t targetTriangles, GeneratedMesh& out);
+
+    /**
+     * @brief Parses a "key=value,key=value" description, e.g. "instances=64,meshes=4,tris=10000,seed=7".
+     * Keys: instances, meshes, tris, spheres, extent, seed, ground. Missing keys keep their current value
+     * @param spec description
+     * @param params parsed parameters
+     * @return false on an unknown key or a malformed value
+     */
+    static bool ParseParams(const std::string& spec, StressSceneParams& params);
+
+    /**
+     * @brief Inverse of ParseParams, to record the exact scene in benchmark results
+     * @param params scene parameters
+     * @return description accepted by ParseParams
+     */
+    static std::string DescribeParams(const StressSceneParams& params);
+};
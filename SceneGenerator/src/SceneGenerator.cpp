@@ -0,0 +1,231 @@
+#include "SceneGenerator.h"
+#include "Log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <glm/ext.hpp>
+
+namespace {
+
+    // std::uniform_real_distribution depende de la implementacion; mt19937 no, asi que se mapea a mano
+    class SceneRandom {
+    public:
+        explicit SceneRandom(uint32_t seed) : m_engine(seed) {}
+
+        float next() {
+            return (float)(m_engine() >> 8) * (1.0f / 16777216.0f);
+        }
+
+        float range(float lo, float hi) {
+            return lo + (hi - lo) * next();
+        }
+
+    private:
+        std::mt19937 m_engine;
+    };
+
+    const float PI = 3.14159265358979f;
+}
+
+void SceneGenerator::TessellatedSphere(uint32_t targetTriangles, GeneratedMesh& out) {
+    // rings anillos y 2 * rings segmentos: 4 * rings * (rings - 1) triangulos, sin triangulos degenerados en los polos
+    uint32_t rings = std::max(2u, (uint32_t)std::lround(0.5 + std::sqrt(0.25 + std::max(8u, targetTriangles) / 4.0)));
+    uint32_t segments = rings * 2;
+
+    out = GeneratedMesh();
+    out.vertices.reserve((size_t)(rings + 1) * (segments + 1));
+    for (uint32_t r = 0; r <= rings; r++) {
+        float v = (float)r / (float)rings;
+        float theta = v * PI;
+        for (uint32_t s = 0; s <= segments; s++) {
+            float u = (float)s / (float)segments;
+            float phi = u * 2.0f * PI;
+            glm::vec3 n(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            out.vertices.push_back(n);
+            out.normals.push_back(n);
+            out.uvs.push_back(glm::vec2(u, v));
+        }
+    }
+
+    uint32_t stride = segments + 1;
+    for (uint32_t r = 0; r < rings; r++) {
+        for (uint32_t s = 0; s < segments; s++) {
+            uint32_t i0 = r * stride + s;
+            uint32_t i1 = i0 + 1;
+            uint32_t i2 = i0 + stride;
+            uint32_t i3 = i2 + 1;
+            if (r != 0) {
+                out.indices.insert(out.indices.end(), { i0, i1, i2 });
+            }
+            if (r != rings - 1) {
+                out.indices.insert(out.indices.end(), { i1, i3, i2 });
+            }
+        }
+    }
+}
+
+void SceneGenerator::TessellatedPlane(uint32_t targetTriangles, GeneratedMesh& out) {
+    // Rejilla de cells x cells quads: 2 * cells^2 triangulos
+    uint32_t cells = std::max(1u, (uint32_t)std::lround(std::sqrt(std::max(2u, targetTriangles) / 2.0)));
+
+    out = GeneratedMesh();
+    out.vertices.reserve((size_t)(cells + 1) * (cells + 1));
+    for (uint32_t z = 0; z <= cells; z++) {
+        for (uint32_t x = 0; x <= cells; x++) {
+            glm::vec2 uv((float)x / (float)cells, (float)z / (float)cells);
+            out.vertices.push_back(glm::vec3(uv.x * 2.0f - 1.0f, 0.0f, uv.y * 2.0f - 1.0f));
+            out.normals.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
+            out.uvs.push_back(uv);
+        }
+    }
+
+    uint32_t stride = cells + 1;
+    for (uint32_t z = 0; z < cells; z++) {
+        for (uint32_t x = 0; x < cells; x++) {
+            uint32_t i0 = z * stride + x;
+            uint32_t i1 = i0 + 1;
+            uint32_t i2 = i0 + stride;
+            uint32_t i3 = i2 + 1;
+            out.indices.insert(out.indices.end(), { i0, i2, i1, i1, i2, i3 });
+        }
+    }
+}
+
+GeneratedScene SceneGenerator::generate(Renderer& renderer, const StressSceneParams& params) {
+    GeneratedScene scene;
+    SceneRandom random(params.seed);
+
+    // Mallas: las primeras round(M * sphereRatio) son esferas, el resto planos
+    uint32_t meshCount = std::max(1u, params.meshCount);
+    uint32_t sphereCount = (uint32_t)std::lround(meshCount * std::min(1.0f, std::max(0.0f, params.sphereRatio)));
+    std::vector<size_t> meshTriangles;
+    std::vector<glm::vec3> meshHalfSize;
+    for (uint32_t m = 0; m < meshCount; m++) {
+        GeneratedMesh mesh;
+        bool sphere = m < sphereCount;
+        if (sphere) {
+            TessellatedSphere(params.trianglesPerMesh, mesh);
+        }
+        else {
+            TessellatedPlane(params.trianglesPerMesh, mesh);
+        }
+        scene.meshIds.push_back(renderer.defineMesh(mesh.vertices, mesh.normals, mesh.uvs, mesh.indices));
+        meshTriangles.push_back(mesh.indices.size() / 3);
+        meshHalfSize.push_back(sphere ? glm::vec3(1.0f) : glm::vec3(1.0f, 0.0f, 1.0f));
+        scene.uniqueTriangles += mesh.indices.size() / 3;
+    }
+
+    glm::vec3 bmin(1e30f), bmax(-1e30f);
+    auto addInstance = [&](uint32_t mesh, const glm::mat4& model, const glm::vec3& color) {
+        if (!renderer.addMesh(model, color, scene.meshIds[mesh])) {
+            return;
+        }
+        scene.instances++;
+        scene.instancedTriangles += meshTriangles[mesh];
+        // Caja transformada: las 8 esquinas de la caja local
+        for (int c = 0; c < 8; c++) {
+            glm::vec3 corner((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f);
+            glm::vec3 p = glm::vec3(model * glm::vec4(corner * meshHalfSize[mesh], 1.0f));
+            bmin = glm::min(bmin, p);
+            bmax = glm::max(bmax, p);
+        }
+    };
+
+    // Siempre se consumen los mismos numeros aleatorios por instancia, asi N instancias son un prefijo de N + 1
+    for (uint32_t i = 0; i < params.instanceCount; i++) {
+        glm::vec3 position(random.range(-params.extent, params.extent), random.range(0.0f, 2.0f),
+            random.range(-params.extent, params.extent));
+        glm::vec3 axis = glm::normalize(glm::vec3(random.range(-1.0f, 1.0f), 1.0f, random.range(-1.0f, 1.0f)));
+        float angle = random.range(0.0f, 2.0f * PI);
+        float scale = random.range(0.5f, 1.5f);
+        glm::vec3 color(random.range(0.2f, 1.0f), random.range(0.2f, 1.0f), random.range(0.2f, 1.0f));
+
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+        model = glm::rotate(model, angle, axis);
+        model = glm::scale(model, glm::vec3(scale));
+        addInstance(i % meshCount, model, color);
+    }
+
+    if (params.groundPlane) {
+        GeneratedMesh ground;
+        TessellatedPlane(2, ground);
+        scene.meshIds.push_back(renderer.defineMesh(ground.vertices, ground.normals, ground.uvs, ground.indices));
+        meshTriangles.push_back(ground.indices.size() / 3);
+        meshHalfSize.push_back(glm::vec3(1.0f, 0.0f, 1.0f));
+        scene.uniqueTriangles += ground.indices.size() / 3;
+
+        float size = params.extent * 1.5f + 2.0f;
+        glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.5f, 0.0f)), glm::vec3(size, 1.0f, size));
+        addInstance((uint32_t)scene.meshIds.size() - 1, model, glm::vec3(0.8f));
+    }
+
+    if (scene.instances > 0) {
+        scene.boundsMin = bmin;
+        scene.boundsMax = bmax;
+    }
+    LOG_INFO("scene", "Stress scene: %zu meshes, %u instances, %zu unique / %zu instanced triangles",
+        scene.meshIds.size(), scene.instances, scene.uniqueTriangles, scene.instancedTriangles);
+    return scene;
+}
+
+bool SceneGenerator::ParseParams(const std::string& spec, StressSceneParams& params) {
+    std::stringstream stream(spec);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            LOG_ERROR("scene", "Scene parameter without value: %s", item.c_str());
+            return false;
+        }
+        std::string key = item.substr(0, eq);
+        std::string value = item.substr(eq + 1);
+        char* end = nullptr;
+        double number = strtod(value.c_str(), &end);
+        if (value.empty() || *end != '\0' || number < 0.0) {
+            LOG_ERROR("scene", "Invalid value for scene parameter %s: %s", key.c_str(), value.c_str());
+            return false;
+        }
+
+        if (key == "instances") {
+            params.instanceCount = (uint32_t)number;
+        }
+        else if (key == "meshes") {
+            params.meshCount = (uint32_t)number;
+        }
+        else if (key == "tris") {
+            params.trianglesPerMesh = (uint32_t)number;
+        }
+        else if (key == "spheres") {
+            params.sphereRatio = (float)number;
+        }
+        else if (key == "extent") {
+            params.extent = (float)number;
+        }
+        else if (key == "seed") {
+            params.seed = (uint32_t)number;
+        }
+        else if (key == "ground") {
+            params.groundPlane = number != 0.0;
+        }
+        else {
+            LOG_ERROR("scene", "Unknown scene parameter: %s", key.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string SceneGenerator::DescribeParams(const StressSceneParams& params) {
+    std::stringstream stream;
+    stream << "instances=" << params.instanceCount << ",meshes=" << params.meshCount << ",tris=" << params.trianglesPerMesh
+        << ",spheres=" << params.sphereRatio << ",extent=" << params.extent << ",seed=" << params.seed
+        << ",ground=" << (params.groundPlane ? 1 : 0);
+    return stream.str();
+}
@@ -5,6 +5,30 @@
 #include <vector>
 #include <glm/glm.hpp>
 
+/**
+ * @brief Time spent in one renderer stage, as returned by VulkanRenderer::getStageTimings
+ */
+struct RendererStageTiming {
+    const char* name;   ///< stage name
+    double lastMs;      ///< duration the last time the stage ran (summed over its submits, e.g. one per BLAS)
+    double totalMs;     ///< accumulated duration since the last reset
+    uint32_t count;     ///< number of measurements accumulated in totalMs
+};
+
+/**
+ * @brief Ray counters of the last frame traced with VulkanRenderer::setRayStatistics enabled.
+ * Depth 0 are the primary rays; the last entry of each list also counts every deeper ray
+ */
+struct RendererRayStats {
+    std::vector<uint32_t> raysPerDepth;     ///< rays traced at each depth
+    std::vector<uint32_t> hitsPerDepth;     ///< rays that hit geometry at each depth
+    std::vector<uint32_t> missesPerDepth;   ///< rays that reached the miss shader at each depth
+    std::vector<uint32_t> bounceHistogram;  ///< number of pixels whose path had 0, 1, 2... bounces
+    uint32_t pixels = 0;                    ///< pixels traced in the frame (reprojected pixels are not traced)
+    uint32_t maxCost = 0;                   ///< highest per-pixel cost, mapped to red in the heatmap
+    bool clockCost = false;                 ///< cost in shader clock cycles (VK_KHR_shader_clock), otherwise rays per pixel
+};
+
 class VulkanRenderer : public Renderer {
 public:
     VulkanRenderer();
@@ -121,12 +145,224 @@ public:
      */
     uint32_t getResultTextureId() override;
 
+    /**
+     * @brief Returns the memory allocated through VulkanCore (buffers and images, tagged by use) and the CPU copies
+     * of the meshes (SimpleMesh vertices, normals and indices), with their high-water marks.
+     * Temporary allocations (scratch, staging) only show up in the peaks
+     * @return current and peak bytes per category, plus the triangle and instance counts of the scene
+     */
+    RendererMemoryStats getMemoryStats() const override;
+
+    /**
+     * @brief Sets the high-water marks returned by getMemoryStats to the current values
+     */
+    void resetMemoryPeaks() override;
+
     /**
      * @brief Enable/disable saving rendered images
      * @param s save flag
      */
     void save(bool s);
 
+    /**
+     * @brief Renders several views of the current scene in a single ray tracing dispatch.
+     * Each view is written to its own layer of the output image (output resolution applies to all of them)
+     * @param viewMatrices view matrix of each view
+     * @param projMatrices projection matrix of each view (same size as viewMatrices)
+     * @return false if the camera lists are empty or their sizes differ, or if the compute fallback is in use
+     */
+    bool renderBatch(const std::vector<glm::mat4>& viewMatrices, const std::vector<glm::mat4>& projMatrices);
+
+    /**
+     * @brief Copies all the images of the last VulkanRenderer::renderBatch into buffer, one after another
+     * @param buffer destination buffer
+     * @param bufferSize size of buffer (width * height * 4 * number of views)
+     * @return the number of bytes written to buffer
+     */
+    size_t copyBatchResultBytes(uint8_t* buffer, size_t bufferSize);
+
+    /**
+     * @brief Sets how many jittered samples per pixel are accumulated while the camera and scene stay still.
+     * Each call to render() adds one sample until the target is reached; moving the camera or changing the scene restarts it
+     * @param spp target samples per pixel (1 = no accumulation, 0 = accumulate forever)
+     */
+    void setTargetSamplesPerPixel(uint32_t spp);
+
+    /**
+     * @brief Returns the target samples per pixel
+     * @return target samples per pixel (0 = unlimited)
+     */
+    uint32_t getTargetSamplesPerPixel() const;
+
+    /**
+     * @brief Returns how many samples per pixel the current result image holds
+     * @return accumulated samples per pixel
+     */
+    uint32_t getAccumulatedSamples() const;
+
+    /**
+     * @brief Returns a counter that increases every time render() actually traces a new image.
+     * render() does not retrace when the scene, camera and resolution did not change (and accumulation is complete),
+     * so front ends can skip copyResultBytes while this value stays the same
+     * @return result image version
+     */
+    uint64_t getResultVersion() const;
+
+    /**
+     * @brief Enables dynamic resolution. While the camera or scene keep changing, each frame is traced at a reduced
+     * internal resolution chosen from a moving average of the measured trace time and upscaled (bilinear) to the
+     * output size. When nothing changes the image is refined at full resolution
+     * @param enabled true to enable dynamic resolution
+     * @param targetFrameMs trace time budget per frame, in milliseconds
+     * @param minScale lowest allowed fraction of the output resolution (per axis)
+     */
+    void setDynamicResolution(bool enabled, float targetFrameMs = 16.6f, float minScale = 0.25f);
+
+    /**
+     * @brief Returns the resolution scale (per axis) used to trace the current result image
+     * @return 1 for full resolution, lower when dynamic resolution reduced it
+     */
+    float getResolutionScale() const;
+
+    /**
+     * @brief Enables an edge-aware a-trous denoiser on the traced image. It runs as a compute pass after the trace,
+     * guided by the normal and distance of the primary hit, so low sample counts (1-4 spp) give a clean image
+     * @param enabled true to filter the result image
+     * @param iterations number of filter passes (step 1, 2, 4, 8...)
+     */
+    void setDenoiser(bool enabled, int iterations = 4);
+
+    /**
+     * @brief Returns whether the denoiser is applied to the result image
+     * @return true if enabled
+     */
+    bool isDenoiserEnabled() const;
+
+    /**
+     * @brief Enables temporal reprojection. On the first frame after a camera change, the primary hits of the
+     * previous frame are reprojected into the new view and their colour is reused; only disoccluded pixels and a
+     * rotating subset of 1 in refreshPeriod pixels are traced. Once the camera stops, the image is traced in full again
+     * @param enabled true to reuse the previous frame while the camera moves
+     * @param refreshPeriod a reused pixel is retraced at least once every refreshPeriod moving frames (0 = never)
+     */
+    void setTemporalReprojection(bool enabled, uint32_t refreshPeriod = 8);
+
+    /**
+     * @brief Returns whether temporal reprojection is enabled
+     * @return true if enabled
+     */
+    bool isTemporalReprojectionEnabled() const;
+
+    /**
+     * @brief Per-instance level of detail (enabled by default). Meshes of 512 triangles or more get up to three
+     * simplified levels, built the first time one of their instances covers less than half the image. Each instance
+     * then traces the simplest level whose geometric error projects to at most pixelError pixels with the camera of
+     * setCamera; only the instances that change level rebuild their BLAS
+     * @param enabled false to trace the defined meshes
+     * @param pixelError maximum projected error in pixels
+     */
+    void setLodSelection(bool enabled, float pixelError = 1.0f);
+
+    /**
+     * @brief Returns whether the level of detail is selected per instance
+     * @return true if enabled
+     */
+    bool isLodSelectionEnabled() const;
+
+    /**
+     * @brief Splits the meshes defined from now on into spatial clusters of 65536 triangles when they are larger than
+     * that. The triangles are reordered cluster by cluster and the BLAS gets one geometry per cluster with its own
+     * tight bounds, which helps elongated parts. Meshes already defined are not changed
+     * @param enabled true to split large meshes in defineMesh
+     */
+    void setClusterSplitting(bool enabled);
+
+    /**
+     * @brief Returns whether defineMesh splits large meshes into clusters
+     * @return true if enabled
+     */
+    bool isClusterSplittingEnabled() const;
+
+    /**
+     * @brief Returns whether the device lacks VK_KHR_ray_tracing_pipeline and the scene is traced by a compute
+     * shader over a BVH built on the CPU. The image matches the hardware path; renderBatch and temporal
+     * reprojection are not available in this mode
+     * @return true if the compute fallback is in use
+     */
+    bool isSoftwareRayTracing() const;
+
+    /**
+     * @brief Switches between the ray tracing pipeline (vkCmdTraceRaysKHR) and the hybrid mode, where a compute
+     * shader generates the primary rays in 8x8 tiles and traces them and their reflections with VK_KHR_ray_query
+     * over the same acceleration structures. Both modes produce the same image
+     * @param enabled true for the ray query mode
+     * @return false if the requested mode is not available on this device
+     */
+    bool setRayQueryMode(bool enabled);
+
+    /**
+     * @brief Returns whether the hybrid ray query mode is in use
+     * @return true if enabled
+     */
+    bool isRayQueryMode() const;
+
+    /**
+     * @brief Moving average of the trace time (submit to completion), normalised to full resolution.
+     * It restarts when the trace mode changes, so both modes can be benchmarked against each other
+     * @return milliseconds per frame
+     */
+    float getAverageTraceMs() const;
+
+    /**
+     * @brief Per-stage durations measured with GPU timestamp queries: BLAS build, TLAS build, descriptor update,
+     * ray tracing (vkCmdTraceRaysKHR or the compute dispatch), layout transitions and readback copy.
+     * Descriptor updates are not recorded in a command buffer, so that stage is measured on the CPU.
+     * The list is empty if profiling is disabled or the queue does not support timestamps
+     * @return one entry per stage, in pipeline order
+     */
+    std::vector<RendererStageTiming> getStageTimings() const;
+
+    /**
+     * @brief Clears the accumulated stage timings
+     */
+    void resetStageTimings();
+
+    /**
+     * @brief Enables or disables the timestamp queries (enabled by default)
+     * @param enabled false to record no queries at all
+     */
+    void setProfilingEnabled(bool enabled);
+
+    /**
+     * @brief Switches to a debug build of the ray tracing shaders that counts rays, hits and misses per depth and
+     * bounces per pixel with atomics, and writes a per-pixel cost heatmap (blue = cheap, red = the most expensive pixel
+     * of the previous frame). The cost is measured in shader clock cycles when VK_KHR_shader_clock is available and in
+     * rays per pixel otherwise. Tracing is slower while enabled; only the ray tracing pipeline is instrumented
+     * @param enabled true to trace with the instrumented shaders
+     * @return false if not available (compute fallback or ray query mode)
+     */
+    bool setRayStatistics(bool enabled);
+
+    /**
+     * @brief Returns whether the next frames are traced with the instrumented shaders
+     * @return true if enabled and available in the current mode
+     */
+    bool isRayStatisticsEnabled() const;
+
+    /**
+     * @brief Returns the counters of the last frame traced with ray statistics enabled
+     * @return empty lists if no such frame has been traced yet
+     */
+    RendererRayStats getRayStatistics() const;
+
+    /**
+     * @brief Copies the cost heatmap of the last frame traced with ray statistics enabled (RGBA8, output resolution)
+     * @param buffer destination buffer
+     * @param bufferSize size of buffer (width * height * 4)
+     * @return the number of bytes written to buffer, 0 if there is no heatmap
+     */
+    size_t copyRayHeatmapBytes(uint8_t* buffer, size_t bufferSize);
+
 private:
     class Impl;
     std::unique_ptr<Impl> pImpl;
@@ -9,6 +9,7 @@
 #include "core/core_wrapper.h"
 #include "core/core_queue.h"
 #include "core/utils.h"
+#include "core/core_memory.h"
 #include <glm/ext.hpp>
 
 #include "3rdParty/stb_image.h"
@@ -52,9 +53,14 @@ namespace core {
 		const VkImage& GetImage(int Index) const;
 		core::PhysicalDevice GetSelectedPhysicalDevice();
 		VulkanQueue* GetQueue() { return &m_queue; }
+		uint32_t GetQueueFamily() const { return m_queueFamily; }
 		VkRenderPass CreateSimpleRenderPass();
 		VkDevice& GetDevice() { return m_device; }
 		VkCommandPool GetCommandPool() { return m_cmdBufPool; }
+		// false en dispositivos sin VK_KHR_ray_tracing_pipeline (p.ej. lavapipe): el Raytracer usa el camino por compute
+		bool IsRayTracingSupported() const { return m_rayTracingSupported; }
+		bool IsRayQuerySupported() const { return m_rayQuerySupported; }
+		bool IsShaderClockSupported() const { return m_shaderClockSupported; }
 		std::vector<VkFramebuffer> CreateFrameBuffers(VkRenderPass RenderPass);
 		BufferMemory CreateVertexBuffer(const void* pVertices, size_t Size, bool rt = false);
 		BufferMemory CreateIndexBuffer(const void* pIndices, size_t Size, bool rt = false);
@@ -64,9 +70,11 @@ namespace core {
 		std::vector<BufferMemory> CreateUniformBuffers(size_t Size);
 		void CreateTexture(const char* filename, VulkanTexture& Tex);
 		void CreateTexture(uint8_t* texels, uint32_t width, uint32_t height, uint32_t bpp, VulkanTexture& Tex);
-		void CreateTextureImage(VulkanTexture& Tex, uint32_t ImageWidth, uint32_t ImageHeight, VkFormat TexFormat);
-		BufferMemory CreateBufferBlas(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags flags);
-		BufferMemory CreateBufferACC(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags flags);
+		void CreateTextureImage(VulkanTexture& Tex, uint32_t ImageWidth, uint32_t ImageHeight, VkFormat TexFormat, MemoryCategory Category = MemoryCategory::Output);
+		void CreateTextureImageArray(VulkanTexture& Tex, uint32_t ImageWidth, uint32_t ImageHeight, uint32_t LayerCount, VkFormat TexFormat, MemoryCategory Category = MemoryCategory::Output);
+		// category: a que se cuenta la reserva en MemoryTracker
+		BufferMemory CreateBufferBlas(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags flags, MemoryCategory category = MemoryCategory::Other);
+		BufferMemory CreateBufferACC(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags flags, MemoryCategory category = MemoryCategory::Other);
 
 		void TransitionImageLayout(VkImage& Image, VkFormat Format, VkImageLayout OldLayout, VkImageLayout NewLayout);
 		size_t copyResultBytes(uint8_t* buffer, size_t bufferSize, VulkanTexture* tex, int width, int height);
@@ -83,14 +91,15 @@ namespace core {
 		void CreateSwapChain();
 		void CreateCommandBufferPool();
 		
-		BufferMemory CreateBuffer(VkDeviceSize Size, VkBufferUsageFlags Usage, VkMemoryPropertyFlags Properties, bool rt=false);
+		BufferMemory CreateBuffer(VkDeviceSize Size, VkBufferUsageFlags Usage, VkMemoryPropertyFlags Properties, bool rt=false, MemoryCategory Category = MemoryCategory::Other);
+		VkBufferUsageFlags GetRtBufferUsage() const;
 		uint32_t GetMemoryTypeIndex(uint32_t MemTypeBitsMask, VkMemoryPropertyFlags ReqMemPropFlags);
 
 		BufferMemory CreateUniformBuffer(size_t Size);
 		void CreateTextureFromData(const void* pPixels, int ImageWidth, int ImageHeight, VulkanTexture& Tex);
 		void CreateTextureImageFromData(VulkanTexture& Tex, const void* pPixels, uint32_t ImageWidth, uint32_t ImageHeight, VkFormat TexFormat, uint32_t bpp = 100000);
 		void UpdateTextureImage(VulkanTexture& Tex, uint32_t ImageWidth, uint32_t ImageHeight,VkFormat TexFormat, const void* pPixels, uint32_t bpp = 1000000);
-		void CreateImage(VulkanTexture& Tex, uint32_t ImageWidth, uint32_t ImageHeight, VkFormat TexFormat,VkImageUsageFlags UsageFlags, VkMemoryPropertyFlagBits PropertyFlags);
+		void CreateImage(VulkanTexture& Tex, uint32_t ImageWidth, uint32_t ImageHeight, VkFormat TexFormat,VkImageUsageFlags UsageFlags, VkMemoryPropertyFlagBits PropertyFlags, uint32_t LayerCount = 1, MemoryCategory Category = MemoryCategory::Textures);
 		
 		
 		void CopyBufferToImage(VkImage Dst, VkBuffer Src, uint32_t ImageWidth, uint32_t ImageHeight);
@@ -108,6 +117,9 @@ namespace core {
 		VulkanPhysicalDevices m_physDevices;
 		uint32_t m_queueFamily = 0;
 		VkDevice m_device = VK_NULL_HANDLE;
+		bool m_rayTracingSupported = false;
+		bool m_rayQuerySupported = false;
+		bool m_shaderClockSupported = false;
 		VkSwapchainKHR m_swapChain = VK_NULL_HANDLE;
 		VkSurfaceFormatKHR m_swapChainSurfaceFormat;
 		//ImageView -> acceso
@@ -0,0 +1,88 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+
+#include "core/core_simple_mesh.h"
+
+namespace core {
+
+	// Nodo linealizado y cuantizado (16 bytes, uvec4 en raytrace_soft.comp).
+	// Las cajas se guardan en 16 bits por eje relativas a la caja de la escena, redondeadas hacia fuera.
+	// Nodo interno: index = hijo izquierdo (el derecho es index + 1). Hoja: index = primer triangulo, count > 0
+	struct BvhNode {
+		uint32_t minXY;		// minX | minY << 16
+		uint32_t minZmaxX;	// minZ | maxX << 16
+		uint32_t maxYZ;		// maxY | maxZ << 16
+		uint32_t indexCount;	// index (28 bits) | count << 28
+	};
+
+	// Triangulo ya transformado a mundo; v0.w = indice de la mesh
+	struct BvhTriangle {
+		glm::vec4 v0, v1, v2;
+		glm::vec4 n0, n1, n2;
+	};
+
+	// Material por mesh, mismo criterio que colorBuffer/textureIndexBuffers en raytrace.rchit
+	struct BvhMeshInfo {
+		glm::vec4 color;
+		int32_t texIndex;
+		int32_t pad[3];
+	};
+
+	struct BvhHit {
+		float t = 0.0f;
+		uint32_t triangle = 0;
+		float u = 0.0f, v = 0.0f;	// baricentricas de v1 y v2
+	};
+
+	/*
+	* BVH construida en CPU (SAH por bins) para el trazado por compute cuando no hay VK_KHR_ray_tracing_pipeline.
+	* intersect() recorre exactamente los mismos nodos cuantizados que el shader, asi que sirve de referencia en CPU
+	*/
+	class Bvh {
+	public:
+		static const uint32_t MaxLeafSize = 4;		// por debajo no se intenta dividir
+		static const uint32_t MaxLeafCount = 15;	// limite de los 4 bits de count
+		static const uint32_t MaxStackDepth = 64;	// la pila nunca pasa de la profundidad del arbol
+		// Por debajo solo se divide por la mediana: cada nivel reparte a la mitad y 28 niveles bastan para
+		// los 2^28 triangulos direccionables, asi que ninguna hoja queda a mas de MaxStackDepth
+		static const uint32_t MaxSahDepth = MaxStackDepth - 28;
+		static const uint32_t MaxTriangles = 1u << 28;	// limite de los 28 bits de index
+
+		void build(const std::vector<SimpleMesh>& meshes);
+		bool intersect(const glm::vec3& origin, const glm::vec3& dir, float tmin, float tmax, BvhHit& hit) const;
+
+		bool empty() const { return m_nodes.empty(); }
+		const std::vector<BvhNode>& getNodes() const { return m_nodes; }
+		const std::vector<BvhTriangle>& getTriangles() const { return m_triangles; }
+		const std::vector<BvhMeshInfo>& getMeshInfos() const { return m_meshInfos; }
+		// Descuantizacion: p = boundsMin + q * quantScale
+		const glm::vec3& getBoundsMin() const { return m_boundsMin; }
+		const glm::vec3& getQuantScale() const { return m_quantScale; }
+
+	private:
+		struct BuildNode {
+			glm::vec3 bmin, bmax;
+			uint32_t leftFirst = 0;
+			uint32_t count = 0;
+		};
+
+		void Subdivide(uint32_t nodeIdx, std::vector<BuildNode>& nodes, uint32_t& nodesUsed, uint32_t depth);
+		void UpdateBounds(BuildNode& node) const;
+		float FindBestSplit(const BuildNode& node, int& axis, float& splitPos) const;
+		void Quantize(const std::vector<BuildNode>& nodes, uint32_t nodesUsed);
+		void DequantizeNode(const BvhNode& node, glm::vec3& bmin, glm::vec3& bmax) const;
+
+		std::vector<BvhNode> m_nodes;
+		std::vector<BvhTriangle> m_triangles;
+		std::vector<BvhMeshInfo> m_meshInfos;
+		glm::vec3 m_boundsMin = glm::vec3(0.0f);
+		glm::vec3 m_quantScale = glm::vec3(0.0f);
+		uint32_t m_depth = 0;		// profundidad de la hoja mas profunda
+
+		// Solo durante la construccion
+		std::vector<uint32_t> m_triIndices;
+		std::vector<glm::vec3> m_centroids;
+		std::vector<glm::vec3> m_triMin, m_triMax;
+	};
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+namespace core {
+
+	/*
+	* Particion de mallas grandes en clusters espaciales de ClusterTriangles triangulos para construir la BLAS con
+	* una geometria por cluster. Todos los clusters tienen exactamente ClusterTriangles triangulos salvo el ultimo,
+	* asi los shaders recuperan el triangulo de la malla como gl_GeometryIndexEXT * ClusterTriangles + gl_PrimitiveID
+	* sin tablas adicionales (CreateShaderModuleFromText define CLUSTER_TRIANGLES con este valor en los shaders)
+	*/
+	class MeshClusters {
+	public:
+		static const uint32_t ClusterTriangles = 65536;
+
+		/*
+		* Reordena los triangulos de inds por clusters: biseccion por la mediana de los centroides en el eje mas largo,
+		* con cortes en multiplos de ClusterTriangles. Dentro de cada cluster se conserva el orden original
+		* (el de la cache de vertices). Los vertices no cambian
+		* @return numero de clusters (1 si la malla no pasa de ClusterTriangles o inds no es multiplo de 3, y no se ha tocado)
+		*/
+		static uint32_t Reorder(const std::vector<glm::vec3>& verts, std::vector<uint32_t>& inds);
+
+		// Numero de geometrias de una malla ya reordenada
+		static uint32_t Count(size_t triangles) {
+			return triangles <= ClusterTriangles ? 1 : (uint32_t)((triangles + ClusterTriangles - 1) / ClusterTriangles);
+		}
+	};
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include <vector>
+
+#include "core/core.h"
+
+namespace core {
+
+	// Parametros del filtro a-trous (edge-avoiding wavelet), compartidos por la version GPU y la CPU
+	struct DenoiseSettings {
+		int iterations = 4;			// pasos de 1, 2, 4, 8... pixeles
+		float sigmaColor = 0.6f;	// se divide entre 2 en cada iteracion
+		float sigmaNormal = 64.0f;	// exponente del peso de normales
+		float sigmaDepth = 0.05f;	// diferencia relativa de distancia permitida por paso
+	};
+
+	// Push constants de denoise_atrous.comp
+	struct DenoisePushConstants {
+		int32_t width;
+		int32_t height;
+		int32_t stepWidth;
+		float sigmaColor;
+		float sigmaNormal;
+		float sigmaDepth;
+	};
+
+	/*
+	* Version CPU del mismo filtro, para verificar la GPU y para nodos sin GPU.
+	* color: rgba en [0,1], normalDepth: normal en xyz y distancia del primer impacto en w (< 0 = fondo).
+	* Entre iteraciones se cuantiza a 8 bits igual que la imagen rgba8 de la GPU
+	*/
+	void AtrousDenoiseCPU(const std::vector<glm::vec4>& color, const std::vector<glm::vec4>& normalDepth,
+		int width, int height, const DenoiseSettings& settings, std::vector<glm::vec4>& result);
+
+	class Denoiser {
+	public:
+		Denoiser() {}
+		~Denoiser() {}
+
+		// traceStage: etapa que escribe color y guia antes del filtro (compute en el trazado por software)
+		void init(VulkanCore* core, VkShaderModule compModule, int width, int height,
+			VkPipelineStageFlags traceStage = VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR);
+		// Imagen a filtrar (se sobrescribe con el resultado) y guia normal/profundidad escrita por raytrace.rgen
+		void setImages(VulkanTexture* color, VulkanTexture* guide);
+		// Nueva imagen ping-pong para otro tamano de salida; hay que volver a llamar a setImages
+		void resize(int width, int height);
+		void denoise(VkCommandBuffer cmdBuf, int width, int height, const DenoiseSettings& settings);
+		bool isReady() const { return m_pipeline != VK_NULL_HANDLE; }
+		void cleanup();
+
+	private:
+		void CreateDescriptorSets();
+		void CreatePipeline(VkShaderModule compModule);
+		void CopyTmpToColor(VkCommandBuffer cmdBuf, int width, int height);
+
+		VulkanCore* m_vkcore = nullptr;
+		VkDevice m_device = VK_NULL_HANDLE;
+
+		VkPipelineStageFlags m_traceStage = VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
+		VulkanTexture m_tmpTexture;			// ping-pong
+		VulkanTexture* m_color = nullptr;
+
+		VkDescriptorPool m_descPool = VK_NULL_HANDLE;
+		VkDescriptorSetLayout m_descSetLayout = VK_NULL_HANDLE;
+		VkDescriptorSet m_descSets[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };	// 0: color -> tmp, 1: tmp -> color
+
+		VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+		VkPipeline m_pipeline = VK_NULL_HANDLE;
+	};
+}
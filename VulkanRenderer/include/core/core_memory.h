@@ -0,0 +1,68 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include <stdint.h>
+#include <mutex>
+#include <unordered_map>
+
+namespace core {
+
+	// Uso de cada reserva, para saber cuanto cuesta cada parte de la escena
+	enum class MemoryCategory {
+		Geometry = 0,			// vertices, normales, indices, uvs y datos por instancia
+		AccelerationStructure,	// BLAS, TLAS, buffer de instancias y BVH del trazado por compute
+		Scratch,				// scratch de construccion de las AS (temporal)
+		Staging,				// subidas y lecturas a traves de memoria visible desde CPU (temporal)
+		Textures,				// texturas de la escena
+		Output,					// imagenes de salida e intermedias (acumulacion, denoiser, reproyeccion...)
+		Other,					// uniformes, SBT...
+		Count
+	};
+
+	struct MemoryCategoryStats {
+		uint64_t deviceBytes = 0;
+		uint64_t devicePeakBytes = 0;
+		uint32_t deviceAllocations = 0;
+		uint64_t hostBytes = 0;
+		uint64_t hostPeakBytes = 0;
+	};
+
+	/*
+	* Contabilidad de las reservas de memoria. Cada vkAllocateMemory que hace VulkanCore se registra con su
+	* categoria y se da de baja en BufferMemory::Destroy / VulkanTexture::Destroy (o con release() si se libera a mano).
+	* La memoria de CPU (copias de la geometria en SimpleMesh) se suma y resta con addHost().
+	* Es global porque las liberaciones solo conocen el VkDevice
+	*/
+	class MemoryTracker {
+	public:
+		static MemoryTracker& Get();
+
+		void track(VkDeviceMemory mem, VkDeviceSize size, MemoryCategory category);
+		void release(VkDeviceMemory mem);
+		void addHost(MemoryCategory category, int64_t bytes);
+
+		MemoryCategoryStats get(MemoryCategory category) const;
+		uint64_t deviceBytes() const;
+		uint64_t devicePeakBytes() const;
+		uint64_t hostBytes() const;
+		uint64_t hostPeakBytes() const;
+		// Los maximos pasan a ser los valores actuales
+		void resetPeaks();
+		static const char* CategoryName(MemoryCategory category);
+
+	private:
+		MemoryTracker() {}
+
+		struct Allocation {
+			VkDeviceSize size;
+			MemoryCategory category;
+		};
+
+		mutable std::mutex m_mutex;
+		std::unordered_map<VkDeviceMemory, Allocation> m_allocations;
+		MemoryCategoryStats m_stats[(int)MemoryCategory::Count];
+		uint64_t m_deviceBytes = 0;
+		uint64_t m_devicePeakBytes = 0;
+		uint64_t m_hostBytes = 0;
+		uint64_t m_hostPeakBytes = 0;
+	};
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include <vector>
+
+#include "core/core.h"
+
+namespace core {
+
+	// Etapas medidas por el Raytracer
+	enum class GpuStage {
+		BlasBuild = 0,
+		TlasBuild,
+		DescriptorUpdate,	// solo CPU: vkUpdateDescriptorSets no se graba en un command buffer
+		TraceRays,			// vkCmdTraceRaysKHR o el dispatch de compute (ray query / software)
+		LayoutTransition,
+		Readback,
+		SoftBvhBuild,		// solo CPU: la BVH del trazado por software se construye en el host
+		Count
+	};
+
+	struct GpuStageTiming {
+		double lastMs = 0.0;	// suma de los intervalos del ultimo collect() con datos de esta etapa
+		double totalMs = 0.0;
+		uint32_t count = 0;		// numero de intervalos acumulados en totalMs
+	};
+
+	/*
+	* Profiler con timestamps (VkQueryPool). begin/end escriben un par de consultas alrededor de los comandos
+	* de una etapa; collect() lee los resultados despues del WaitIdle del submit correspondiente.
+	* Una etapa puede abrirse varias veces por command buffer (una BLAS por submit, por ejemplo) y los tiempos se suman
+	*/
+	class GpuProfiler {
+	public:
+		GpuProfiler() {}
+		~GpuProfiler() {}
+
+		// maxScopes: pares begin/end que caben entre dos collect()
+		void init(VulkanCore* core, uint32_t maxScopes = 64);
+		void begin(VkCommandBuffer cmdBuf, GpuStage stage);
+		void end(VkCommandBuffer cmdBuf, GpuStage stage);
+		// Lee los timestamps pendientes; la cola debe estar en reposo
+		void collect();
+		// Tiempo medido en CPU para etapas que no pasan por la cola
+		void addCpuTime(GpuStage stage, double ms);
+
+		const GpuStageTiming& get(GpuStage stage) const { return m_timings[(int)stage]; }
+		void reset();
+		void setEnabled(bool enabled) { m_enabled = enabled; }
+		bool isEnabled() const { return m_enabled && m_queryPool != VK_NULL_HANDLE; }
+		static const char* StageName(GpuStage stage);
+		void cleanup();
+
+	private:
+		void Accumulate(GpuStage stage, double ms);
+
+		VkDevice m_device = VK_NULL_HANDLE;
+		VkQueryPool m_queryPool = VK_NULL_HANDLE;
+		uint32_t m_maxScopes = 0;
+		float m_timestampPeriod = 1.0f;		// ns por tick
+		uint64_t m_validMask = ~0ull;
+		bool m_enabled = true;
+
+		// Consultas escritas desde el ultimo collect(): la etapa de cada par y si se cerro
+		std::vector<GpuStage> m_scopeStages;
+		std::vector<bool> m_scopeClosed;
+		int m_openScope[(int)GpuStage::Count] = { -1, -1, -1, -1, -1, -1 };
+
+		GpuStageTiming m_timings[(int)GpuStage::Count];
+	};
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include <vector>
+
+#include "core/core.h"
+
+namespace core {
+
+	// Profundidades distintas que se cuentan; las mas profundas se suman en la ultima (RAY_STATS_DEPTHS en los shaders)
+	static const uint32_t RAY_STATS_DEPTHS = 8;
+
+	// Contenido del buffer de estadisticas (set 3, binding 0 de la variante RAY_STATS de raytrace.rgen/rchit/rmiss)
+	struct RayStatsCounters {
+		uint32_t rays[RAY_STATS_DEPTHS];		// rayos trazados por profundidad (0 = primarios)
+		uint32_t hits[RAY_STATS_DEPTHS];
+		uint32_t misses[RAY_STATS_DEPTHS];
+		uint32_t bounces[RAY_STATS_DEPTHS];		// histograma de rebotes por pixel
+		uint32_t pixels;						// pixeles trazados (sin los reproyectados)
+		uint32_t maxCost;						// mayor coste por pixel del frame
+		uint32_t costScale;						// coste que corresponde al rojo del mapa de calor (lo escribe la CPU)
+		uint32_t clockCost;						// 1 = coste en ciclos (shader clock), 0 = coste en rayos por pixel
+	};
+
+	/*
+	* Estadisticas de rayos de la variante de depuracion del pipeline de ray tracing (shaders compilados con RAY_STATS).
+	* Los shaders suman con atomicos en un buffer visible desde CPU y escriben un mapa de calor del coste por pixel:
+	* ciclos desde el primer traceRayEXT hasta el final del camino si hay VK_KHR_shader_clock, si no rayos por pixel.
+	* El mapa se normaliza con el coste maximo del frame anterior
+	*/
+	class RayStatistics {
+	public:
+		RayStatistics() {}
+		~RayStatistics() {}
+
+		void init(VulkanCore* core, int width, int height, bool clockCost);
+		// Mapa de calor con el nuevo tamano de la salida; la cola debe estar en reposo
+		void resize(int width, int height);
+		// Set 3 del pipeline con estadisticas
+		VkDescriptorSetLayout getDescriptorSetLayout() const { return m_descSetLayout; }
+		VkDescriptorSet getDescriptorSet() const { return m_descSet; }
+
+		// Pone los contadores a cero antes del submit; la cola debe estar en reposo
+		void reset();
+		// Transicion del mapa de calor antes del trazado
+		void prepare(VkCommandBuffer cmdBuf);
+		// Lee los contadores tras el WaitIdle del submit y ajusta la escala del siguiente mapa de calor
+		void collect();
+
+		const RayStatsCounters& get() const { return m_counters; }
+		bool hasResults() const { return m_hasResults; }
+		bool isClockCost() const { return m_clockCost; }
+		size_t copyHeatmapBytes(uint8_t* buffer, size_t bufferSize, int width, int height);
+		bool isReady() const { return m_descSet != VK_NULL_HANDLE; }
+		void cleanup();
+
+	private:
+		void CreateDescriptorSet();
+		void WriteHeatmapDescriptor();
+
+		VulkanCore* m_vkcore = nullptr;
+		VkDevice m_device = VK_NULL_HANDLE;
+
+		BufferMemory m_statsBuffer;			// RayStatsCounters, visible desde CPU
+		VulkanTexture m_heatmapTexture;		// RGBA8, mismo tamano que la salida
+		int m_width = 0, m_height = 0;
+		bool m_clockCost = false;
+		uint32_t m_costScale = 0;
+
+		RayStatsCounters m_counters = {};
+		bool m_hasResults = false;
+
+		VkDescriptorPool m_descPool = VK_NULL_HANDLE;
+		VkDescriptorSetLayout m_descSetLayout = VK_NULL_HANDLE;
+		VkDescriptorSet m_descSet = VK_NULL_HANDLE;
+	};
+}
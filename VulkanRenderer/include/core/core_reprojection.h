@@ -0,0 +1,60 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+
+#include "core/core.h"
+
+namespace core {
+
+	// Push constants de reproject.comp
+	struct ReprojectPushConstants {
+		glm::mat4 viewProj;		// inversa de la matriz que usa el raygen: mundo -> espacio de camara del frame actual
+		glm::vec4 origin;		// origen de los rayos primarios del frame actual
+		int32_t srcWidth;
+		int32_t srcHeight;
+		int32_t dstWidth;
+		int32_t dstHeight;
+		int32_t pass;			// 0: test de profundidad, 1: escritura del ganador
+	};
+
+	// Imagenes que usa la reproyeccion, todas propiedad del Raytracer
+	struct ReprojectionImages {
+		VulkanTexture* historyColor = nullptr;		// rgba8, color trazado del frame anterior (antes del denoiser)
+		VulkanTexture* historyGuide = nullptr;		// rgba32f, normal del frame anterior
+		VulkanTexture* historyPosition = nullptr;	// rgba32f, posicion del impacto del frame anterior (w < 0 = fondo)
+		VulkanTexture* depth = nullptr;				// r32ui, distancia minima por pixel destino
+		VulkanTexture* color = nullptr;				// rgba8, color reproyectado (a = 1 si es valido)
+		VulkanTexture* normal = nullptr;			// rgba8, normal reproyectada codificada en [0,1]
+		VulkanTexture* position = nullptr;			// rgba32f, posicion reproyectada
+	};
+
+	/*
+	* Reproyeccion temporal: lleva cada impacto del frame anterior (posicion en mundo) a la vista actual.
+	* El raygen reutiliza el color de los pixeles cubiertos y solo traza las desoclusiones y un subconjunto de refresco
+	*/
+	class Reprojector {
+	public:
+		Reprojector() {}
+		~Reprojector() {}
+
+		void init(VulkanCore* core, VkShaderModule compModule);
+		void setImages(const ReprojectionImages& images);
+		void reproject(VkCommandBuffer cmdBuf, const glm::mat4& invViewProj, int srcWidth, int srcHeight, int dstWidth, int dstHeight);
+		bool isReady() const { return m_pipeline != VK_NULL_HANDLE; }
+		void cleanup();
+
+	private:
+		void CreateDescriptorSet();
+		void CreatePipeline(VkShaderModule compModule);
+
+		VulkanCore* m_vkcore = nullptr;
+		VkDevice m_device = VK_NULL_HANDLE;
+		ReprojectionImages m_images;
+
+		VkDescriptorPool m_descPool = VK_NULL_HANDLE;
+		VkDescriptorSetLayout m_descSetLayout = VK_NULL_HANDLE;
+		VkDescriptorSet m_descSet = VK_NULL_HANDLE;
+
+		VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+		VkPipeline m_pipeline = VK_NULL_HANDLE;
+	};
+}
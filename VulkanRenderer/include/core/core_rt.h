@@ -8,6 +8,11 @@
 #include "core/core.h"
 #include "core/core_simple_mesh.h"
 #include "core/core_vertex.h"
+#include "core/core_denoiser.h"
+#include "core/core_reprojection.h"
+#include "core/core_soft_rt.h"
+#include "core/core_profiler.h"
+#include "core/core_raystats.h"
 #include "3rdParty/stb_image_write.h"
 
 #include <cassert>
@@ -48,6 +53,17 @@ namespace core {
 		// Configures the build information and calculates the necessary size information.
 		VkAccelerationStructureBuildSizesInfoKHR finalizeGeometry(VkDevice device, VkBuildAccelerationStructureFlagsKHR flags, PFN_vkGetAccelerationStructureBuildSizesKHR pfnGetBuildSizes);
 	};
+	// Push constants del raygen (layout en raytrace.rgen)
+	struct RtPushConstants {
+		uint32_t frameIndex = 0;	// muestra acumulada actual, 0 = reinicia la acumulacion
+		uint32_t seed = 0;			// semilla para el jitter de los rayos primarios
+		uint32_t reproject = 0;		// 1 = reutilizar los pixeles reproyectados del frame anterior
+		uint32_t refreshPeriod = 0;	// 1 de cada refreshPeriod pixeles se traza siempre (0 = ninguno)
+		uint32_t refreshPhase = 0;	// subconjunto de refresco de este frame
+		uint32_t width = 0;			// tamano del trazado, raytrace_query.comp no tiene gl_LaunchSizeEXT
+		uint32_t height = 0;
+	};
+
 	struct AccelerationStructure {
 		VkAccelerationStructureKHR handle = VK_NULL_HANDLE;
 		core::BufferMemory buffer;
@@ -68,6 +84,13 @@ namespace core {
 		void initRayTracing(core::PhysicalDevice physdev, VkDevice* dev);
 		void setup( VkCommandPool pool, core::VulkanCore* core);
 		void createBottomLevelAS(std::vector<core::SimpleMesh> meshes);
+		// Construye solo las BLAS de meshes[first..] y las anade detras de las existentes (escena que crece por lotes)
+		void appendBottomLevelAS(const std::vector<core::SimpleMesh>& meshes, size_t first);
+		// Destruye la BLAS de la instancia index; las siguientes bajan una posicion, como en la lista de meshes
+		void removeBottomLevelAS(size_t index);
+		// Vuelve a construir las BLAS de las instancias indicadas (nuevo indice de nivel de detalle) sin mover las demas
+		void rebuildBottomLevelAS(const std::vector<core::SimpleMesh>& meshes, const std::vector<size_t>& indices);
+		size_t getBlasCount() const { return m_blas.size(); }
 		void createTopLevelAS();
 
 
@@ -75,36 +98,39 @@ namespace core {
 
 		// Mtodo helper para limpiar recursos
 		void cleanup() {
-			if (m_tlas.handle != VK_NULL_HANDLE) {
-				vkDestroyAccelerationStructureKHR(*m_device, m_tlas.handle, nullptr);
-				vkDestroyBuffer(*m_device, m_tlas.buffer.m_buffer, nullptr);
-				vkFreeMemory(*m_device, m_tlas.buffer.m_mem, nullptr);
-			}
-
-			if (m_instBuffer.m_buffer != VK_NULL_HANDLE) {
-				vkDestroyBuffer(*m_device, m_instBuffer.m_buffer, nullptr);
-				vkFreeMemory(*m_device, m_instBuffer.m_mem, nullptr);
-			}
-			for (auto& blas : m_blas) {
-				if (blas.handle != VK_NULL_HANDLE) {
-					vkDestroyAccelerationStructureKHR(m_device[0], blas.handle, nullptr);
-				}
-				//implementar destroybuffer o simplemente
-				vkDestroyBuffer(m_device[0], blas.buffer.m_buffer, NULL);
-				vkFreeMemory(*m_device, blas.buffer.m_mem, nullptr);
-			}
-			m_blas.clear();
+			ReleaseTlas();
+			ReleaseBlas();
 			for (uint32_t i = 0; i < allBlas.size(); i++) {
-				vkDestroyBuffer(*m_device, allBlas[i].m_transBuffer.m_buffer, NULL);
-				vkFreeMemory(*m_device, allBlas[i].m_transBuffer.m_mem, nullptr);
+				allBlas[i].m_transBuffer.Destroy(*m_device);
 			}
 			allBlas.clear();
 			CleanupMvpDescriptorSet();
 			CleanupGeometryDescriptorSet();
+			CleanupBatchResources();
 
 			vkDestroyDescriptorPool(*m_device, m_rtDescPool, nullptr);
 			vkDestroyDescriptorSetLayout(*m_device, m_rtDescSetLayout, nullptr);
 			m_outTexture->Destroy(*m_device);
+			m_accumTexture.Destroy(*m_device);
+			m_scaledTexture.Destroy(*m_device);
+			m_guideTexture.Destroy(*m_device);
+			m_denoiser.cleanup();
+			m_positionTexture.Destroy(*m_device);
+			m_historyColor.Destroy(*m_device);
+			m_reprojDepth.Destroy(*m_device);
+			m_reprojColor.Destroy(*m_device);
+			m_reprojNormal.Destroy(*m_device);
+			m_reprojPosition.Destroy(*m_device);
+			m_reprojector.cleanup();
+			m_softRt.cleanup();
+			m_profiler.cleanup();
+			CleanupRayStatsPipeline();
+			if (m_rqPipeline != VK_NULL_HANDLE) {
+				vkDestroyPipeline(*m_device, m_rqPipeline, nullptr);
+				vkDestroyPipelineLayout(*m_device, m_rqPipelineLayout, nullptr);
+				m_rqPipeline = VK_NULL_HANDLE;
+				m_rqPipelineLayout = VK_NULL_HANDLE;
+			}
 		}
 		void createRtDescriptorSet();
 		void createMvpDescriptorSet();
@@ -116,19 +142,92 @@ namespace core {
 		void render(int width, int height, bool saveImage = false, const std::string& filename = "");
 
 		void createOutImage(int windowwidth, int windowheight, VulkanTexture* tex);
+		// Vuelve a crear la salida y todas las imagenes auxiliares (acumulacion, guia, reproyeccion, denoiser, mapa de
+		// calor) con el nuevo tamano y reinicia la acumulacion. Espera a que la cola este en reposo
+		void setOutputResolution(int width, int height);
+		int getOutputWidth() const { return m_outputWidth; }
+		int getOutputHeight() const { return m_outputHeight; }
 		void UpdateAccStructure();
 
+		// Acumulacion progresiva: cada render() suma una muestra jittered hasta llegar a m_targetSpp (0 = sin limite)
+		void resetAccumulation() { m_frameIndex = 0; }
+		void setTargetSamples(uint32_t spp) { m_targetSpp = spp; }
+		uint32_t getTargetSamples() const { return m_targetSpp; }
+		uint32_t getAccumulatedSamples() const { return m_frameIndex; }
+		// Un frame a resolucion reducida o reproyectado nunca se considera final: al quedarse quieta la camara se refina trazando todo
+		bool isConverged() const { return m_targetSpp != 0 && m_frameIndex >= m_targetSpp && m_lastTraceScale >= 1.0f && !m_lastReprojected; }
+
+		// Resolucion dinamica: el primer frame tras un cambio se traza a una resolucion interna reducida,
+		// elegida con la media movil del tiempo de trazado frente al presupuesto, y se escala (bilineal) a la salida
+		void setDynamicResolution(bool enabled, float frameBudgetMs, float minScale);
+		float getResolutionScale() const { return m_lastTraceScale; }
+		float getAverageTraceMs() const { return m_traceMsAvg; }
+
+		// Denoiser a-trous sobre la imagen trazada, guiado por la normal y distancia del primer impacto (binding 4)
+		void createDenoiser(VkShaderModule compModule);
+		void setDenoise(bool enabled) { m_denoiseEnabled = enabled; }
+		bool isDenoiseEnabled() const { return m_denoiseEnabled && m_denoiser.isReady(); }
+		void setDenoiseSettings(const DenoiseSettings& settings) { m_denoiseSettings = settings; }
+		const DenoiseSettings& getDenoiseSettings() const { return m_denoiseSettings; }
+
+		// Reproyeccion temporal: el primer frame tras un cambio de camara reutiliza los impactos del frame anterior
+		// y solo traza las desoclusiones y 1 de cada refreshPeriod pixeles
+		void createReprojector(VkShaderModule compModule);
+		void setTemporalReprojection(bool enabled, uint32_t refreshPeriod);
+		bool isTemporalReprojectionEnabled() const { return m_reprojectionEnabled && m_reprojector.isReady() && !m_software; }
+		// Los impactos guardados dejan de valer si cambia la geometria
+		void invalidateHistory() { m_historyValid = false; }
+		bool wasLastFrameReprojected() const { return m_lastReprojected; }
+
+		// Trazado por software (compute + BVH en CPU) cuando el dispositivo no tiene VK_KHR_ray_tracing_pipeline.
+		// Sustituye a TLAS, descriptor sets de RT y pipeline; el render por lotes y la reproyeccion no estan disponibles
+		void createSoftwarePipeline(VkShaderModule compModule);
+		void updateSoftwareScene(const std::vector<core::SimpleMesh>& meshes);
+		bool isSoftware() const { return m_software; }
+		const SoftwareRaytracer& getSoftwareRaytracer() const { return m_softRt; }
+
+		// Modo hibrido: rayos primarios en compute (tiles de 8x8) y reflexiones con VK_KHR_ray_query sobre la misma TLAS,
+		// sin SBT ni recursion. Comparte descriptor sets, reproyeccion y denoiser con el pipeline de ray tracing
+		void createRayQueryPipeline(VkShaderModule compModule);
+		void setRayQuery(bool enabled);
+		bool isRayQuery() const { return m_rayQuery && m_rqPipeline != VK_NULL_HANDLE; }
+
 		void createGeometryDescriptorSet(int maxsize = 10);
+		// Si hay mas meshes que la capacidad del set 2 lo amplia y vuelve a crear sus pipelines;
+		// lanza std::runtime_error si el dispositivo no admite tantos storage buffers
 		void updateGeometryDescriptorSet(std::vector<core::SimpleMesh> meshes);
+		// Numero maximo de meshes que admite el set 2 con los limites de storage buffers del dispositivo
+		size_t getMaxGeometryMeshes();
 		size_t copyResultBytes(uint8_t* buffer, size_t bufferSize, VulkanTexture* tex, int width, int height);
 
+		// Render por lotes: N camaras (inversas de VP) trazadas en un solo vkCmdTraceRaysKHR de profundidad N,
+		// cada vista se escribe en una capa de una imagen layered
+		void createBatchPipeline(VkShaderModule rgenBatchModule, VkShaderModule rmissModule, VkShaderModule rchitModule);
+		void updateBatchCameras(const std::vector<glm::mat4>& invViewProjs, int width, int height);
+		void raytraceBatch(VkCommandBuffer cmdBuf, int width, int height, uint32_t viewCount);
+		void renderBatch();
+		size_t copyBatchResultBytes(uint8_t* buffer, size_t bufferSize);
+		uint32_t getBatchViewCount() const { return m_batchViewCount; }
+
+		// Variante de depuracion del pipeline de ray tracing (shaders con RAY_STATS): rayos, impactos y fallos por
+		// profundidad, histograma de rebotes por pixel y mapa de calor del coste. Solo con vkCmdTraceRaysKHR
+		void createRayStatsPipeline(VkShaderModule rgenModule, VkShaderModule rmissModule, VkShaderModule rchitModule);
+		void setRayStats(bool enabled) { m_rayStatsEnabled = enabled; }
+		bool isRayStatsEnabled() const { return m_rayStatsEnabled && m_statsPipeline != VK_NULL_HANDLE && !m_software && !isRayQuery(); }
+		RayStatistics& getRayStatistics() { return m_rayStats; }
+		const RayStatistics& getRayStatistics() const { return m_rayStats; }
+
+		// Tiempos por etapa medidos con timestamps (BLAS, TLAS, trazado, transiciones, lectura) y en CPU (descriptores)
+		GpuProfiler& getProfiler() { return m_profiler; }
+		const GpuProfiler& getProfiler() const { return m_profiler; }
+
 	private:
 
 
 
 		void loadRayTracingFunctions();
 		auto objectToVkGeometryKHR(const core::SimpleMesh& model);
-		void buildBlas(std::vector<core::BlasInput>& input, VkBuildAccelerationStructureFlagsKHR flags);
+		void buildBlas(std::vector<core::BlasInput>& input, VkBuildAccelerationStructureFlagsKHR flags, bool append = false);
 		void buildTlas(const std::vector<VkAccelerationStructureInstanceKHR>& instances,
 			VkBuildAccelerationStructureFlagsKHR flags);
 		
@@ -151,12 +250,57 @@ namespace core {
 		void CreateGeometryBuffers(std::vector<core::SimpleMesh> meshes);
 		void WriteGeometryDescriptorSet();
 		void CleanupGeometryDescriptorSet();
+		void GrowGeometryDescriptorSet(size_t meshCount);
+		void DestroyGeometryPipelines();
 		
 
+		void WriteShaderBindingTable(VkPipeline pipeline, BufferMemory& sbtBuffer, VkStridedDeviceAddressRegionKHR& rgenRegion,
+			VkStridedDeviceAddressRegionKHR& missRegion, VkStridedDeviceAddressRegionKHR& hitRegion);
+
+		void CreateBatchDescriptorSets();
+		void CreateBatchBuffers(int width, int height, uint32_t capacity);
+		void WriteBatchDescriptorSets();
+		void CleanupBatchBuffers();
+		void CleanupBatchResources();
+		void CleanupRayStatsPipeline();
+
+		void CreateFrameImages(int width, int height);
+		void DestroyFrameImages();
+		void SetReprojectionImages();
+		void WriteTraceTarget(VulkanTexture* target);
+		void UpscaleToOutput(VkCommandBuffer cmdBuf, int srcWidth, int srcHeight, int dstWidth, int dstHeight);
+		void UpdateResolutionScale(float traceMs, float traceScale);
+		void CopyToHistory(VkCommandBuffer cmdBuf, int width, int height);
+		// Etapa que escribe la imagen trazada: ray tracing o compute en el trazado por software
+		VkPipelineStageFlags GetTraceStage() const;
+
 		void saveImageToPNG(const std::string& filename, int width, int height);
 		void createStagingBuffer(VkDeviceSize size, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
 		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 
+		// Destruyen las AS anteriores antes de reconstruirlas (la cola esta en reposo tras cada construccion)
+		void ReleaseBlas() {
+			for (auto& blas : m_blas) {
+				if (blas.handle != VK_NULL_HANDLE) {
+					vkDestroyAccelerationStructureKHR(m_device[0], blas.handle, nullptr);
+				}
+				blas.buffer.Destroy(*m_device);
+			}
+			m_blas.clear();
+		}
+
+		void ReleaseTlas() {
+			if (m_tlas.handle != VK_NULL_HANDLE) {
+				vkDestroyAccelerationStructureKHR(*m_device, m_tlas.handle, nullptr);
+				m_tlas.buffer.Destroy(*m_device);
+				m_tlas = core::AccelerationStructure();
+			}
+			if (m_instBuffer.m_buffer != VK_NULL_HANDLE) {
+				m_instBuffer.Destroy(*m_device);
+				m_instBuffer = core::BufferMemory();
+			}
+		}
+
 		void CleanupMvpDescriptorSet() {
 			m_mvpBufferMemory.Destroy(*m_device);
 
@@ -182,6 +326,67 @@ namespace core {
 		VulkanCore* m_vkcore;
 
 		core::VulkanTexture* m_outTexture;
+		int m_outputWidth = 800, m_outputHeight = 800;	// tamano de la salida y de las imagenes auxiliares
+		core::VulkanTexture m_accumTexture;	// RGBA32F: suma de muestras en rgb, numero de muestras en a
+
+		uint32_t m_frameIndex = 0;
+		uint32_t m_targetSpp = 1;
+		uint32_t m_seed = 0x9E3779B9u;
+
+		// Resolucion dinamica
+		core::VulkanTexture m_scaledTexture;			// destino del trazado a resolucion reducida
+		core::VulkanTexture* m_traceTarget = nullptr;	// imagen escrita actualmente en el binding 2
+		bool m_dynamicRes = false;
+		float m_frameBudgetMs = 16.6f;
+		float m_minScale = 0.25f;
+		float m_resScale = 1.0f;			// escala propuesta para el siguiente frame interactivo
+		float m_lastTraceScale = 1.0f;		// escala con la que se trazo la imagen actual
+		float m_traceMsAvg = 0.0f;			// media movil del coste a resolucion completa
+
+		// Denoiser
+		core::VulkanTexture m_guideTexture;	// RGBA32F: normal en xyz, distancia del primer impacto en w
+		Denoiser m_denoiser;
+		DenoiseSettings m_denoiseSettings;
+		bool m_denoiseEnabled = false;
+
+		// Reproyeccion temporal
+		core::VulkanTexture m_positionTexture;	// RGBA32F: posicion del primer impacto en xyz, distancia en w
+		core::VulkanTexture m_historyColor;		// copia del trazado anterior, antes del denoiser
+		core::VulkanTexture m_reprojDepth;		// R32UI
+		core::VulkanTexture m_reprojColor;
+		core::VulkanTexture m_reprojNormal;
+		core::VulkanTexture m_reprojPosition;
+		Reprojector m_reprojector;
+		glm::mat4 m_invViewProj = glm::mat4(1.0f);	// ultima matriz subida con UpdateMvpMatrix
+		bool m_reprojectionEnabled = false;
+		bool m_reprojectFrame = false;		// el frame que se esta grabando usa la reproyeccion
+		bool m_lastReprojected = false;
+		bool m_historyValid = false;
+		int m_historyWidth = 0, m_historyHeight = 0;
+		uint32_t m_refreshPeriod = 8;
+		uint32_t m_refreshPhase = 0;
+
+		// Trazado por software
+		SoftwareRaytracer m_softRt;
+		bool m_software = false;
+
+		// Modo hibrido (ray query)
+		VkPipeline m_rqPipeline = VK_NULL_HANDLE;
+		VkPipelineLayout m_rqPipelineLayout = VK_NULL_HANDLE;
+		bool m_rayQuery = false;
+
+		// Timestamps por etapa
+		GpuProfiler m_profiler;
+
+		// Estadisticas de rayos: mismo pipeline con los shaders RAY_STATS y el set 3 de RayStatistics
+		RayStatistics m_rayStats;
+		bool m_rayStatsEnabled = false;
+		VkPipeline m_statsPipeline = VK_NULL_HANDLE;
+		VkPipelineLayout m_statsPipelineLayout = VK_NULL_HANDLE;
+		core::BufferMemory m_statsSBTBuffer;
+		VkStridedDeviceAddressRegionKHR m_statsRgenRegion{};
+		VkStridedDeviceAddressRegionKHR m_statsMissRegion{};
+		VkStridedDeviceAddressRegionKHR m_statsHitRegion{};
 
 		int windowwidth, windowheight;
 
@@ -198,20 +403,20 @@ namespace core {
 
 		//Descriptor Sets
 		//nvvk::DescriptorSetBindings                     m_rtDescSetLayoutBind;
-		VkDescriptorPool                                m_rtDescPool;
-		VkDescriptorSetLayout                           m_rtDescSetLayout;
-		VkDescriptorSet                                 m_rtDescSet;
+		VkDescriptorPool                                m_rtDescPool = VK_NULL_HANDLE;
+		VkDescriptorSetLayout                           m_rtDescSetLayout = VK_NULL_HANDLE;
+		VkDescriptorSet                                 m_rtDescSet = VK_NULL_HANDLE;
 		std::vector<VkDescriptorSet>					m_rtDescSets;
 
-		VkDescriptorPool m_mvpDescPool;
-		VkDescriptorSetLayout m_mvpDescSetLayout;
+		VkDescriptorPool m_mvpDescPool = VK_NULL_HANDLE;
+		VkDescriptorSetLayout m_mvpDescSetLayout = VK_NULL_HANDLE;
 		VkDescriptorSet m_mvpDescSet;
 		BufferMemory m_mvpBufferMemory;
 
 		// Geometry descriptor set
-		VkDescriptorPool m_geometryDescPool;
-		VkDescriptorSetLayout m_geometryDescSetLayout;
-		VkDescriptorSet m_geometryDescSet;
+		VkDescriptorPool m_geometryDescPool = VK_NULL_HANDLE;
+		VkDescriptorSetLayout m_geometryDescSetLayout = VK_NULL_HANDLE;
+		VkDescriptorSet m_geometryDescSet = VK_NULL_HANDLE;
 
 		// Buffers para geometry data
 		std::vector<BufferMemory> m_vertexBuffers;
@@ -221,7 +426,14 @@ namespace core {
 		BufferMemory m_colorBuffer;
 		std::vector<VulkanTexture*> m_textures;
 
-		int m_maxsize = 10;
+		int m_maxsize = 10;		// capacidad de los arrays de buffers del set 2, crece con la escena
+		int m_maxTextures = 0;
+
+		// Modulos de los pipelines que usan el set 2 (los destruye VulkanRenderer)
+		VkShaderModule m_rgenModule = VK_NULL_HANDLE, m_rmissModule = VK_NULL_HANDLE, m_rchitModule = VK_NULL_HANDLE;
+		VkShaderModule m_rqModule = VK_NULL_HANDLE;
+		VkShaderModule m_statsModules[3] = { VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE };
+		VkShaderModule m_batchModules[3] = { VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE };
 
 		std::vector<glm::vec4> colors = {};
 
@@ -236,6 +448,26 @@ namespace core {
 		VkStridedDeviceAddressRegionKHR m_hitRegion{};
 		VkStridedDeviceAddressRegionKHR m_callRegion{};
 
+		// Render por lotes (multi-view)
+		VkDescriptorPool m_batchDescPool = VK_NULL_HANDLE;
+		VkDescriptorSetLayout m_batchRtDescSetLayout = VK_NULL_HANDLE;	// set 0: TLAS + imagen layered
+		VkDescriptorSetLayout m_batchCamDescSetLayout = VK_NULL_HANDLE;	// set 1: array de camaras
+		VkDescriptorSet m_batchRtDescSet = VK_NULL_HANDLE;
+		VkDescriptorSet m_batchCamDescSet = VK_NULL_HANDLE;
+		VulkanTexture m_batchOutTexture;
+		BufferMemory m_batchCameraBuffer;
+		BufferMemory m_batchReadbackBuffer;
+		uint32_t m_batchCapacity = 0;
+		uint32_t m_batchViewCount = 0;
+		int m_batchWidth = 0, m_batchHeight = 0;
+
+		VkPipeline m_batchPipeline = VK_NULL_HANDLE;
+		VkPipelineLayout m_batchPipelineLayout = VK_NULL_HANDLE;
+		core::BufferMemory m_batchSBTBuffer;
+		VkStridedDeviceAddressRegionKHR m_batchRgenRegion{};
+		VkStridedDeviceAddressRegionKHR m_batchMissRegion{};
+		VkStridedDeviceAddressRegionKHR m_batchHitRegion{};
+
 	};
 
 
@@ -5,4 +5,7 @@ namespace core {
 
 	VkShaderModule CreateShaderModuleFromBinary(VkDevice& device, const char* pFilename);
 	VkShaderModule CreateShaderModuleFromText(VkDevice& device, const char* pFilename);
+	// Variante del shader con lineas #define insertadas tras #version (p.ej. "#define RAY_STATS\n"); no escribe el .spv.
+	// Las dos versiones definen ademas las constantes compartidas con C++ (CLUSTER_TRIANGLES)
+	VkShaderModule CreateShaderModuleFromText(VkDevice& device, const char* pFilename, const char* pDefines);
 }
\ No newline at end of file
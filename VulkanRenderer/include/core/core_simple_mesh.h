@@ -9,6 +9,7 @@ namespace core{
 
 		std::vector<glm::vec3> verts;
 		std::vector<glm::vec3> norms;
+		std::vector<uint32_t> inds;		// copia en CPU de los indices (BVH del trazado por compute)
 
 
 		BufferMemory m_vb;
@@ -32,6 +33,13 @@ namespace core{
 		VulkanTexture* m_pTex = NULL;
 		int texIndex = -1;
 
+		// Caja en mundo de la instancia y nivel de detalle que traza (0 = malla definida)
+		glm::vec3 m_boundsMin = glm::vec3(0.0f);
+		glm::vec3 m_boundsMax = glm::vec3(0.0f);
+		int lod = 0;
+		// Indices ordenados por clusters de MeshClusters::ClusterTriangles: la BLAS lleva una geometria por cluster
+		bool clustered = false;
+
 		void Destroy(VkDevice device) {
 			m_vb.Destroy(device);
 			if (m_pTex) {
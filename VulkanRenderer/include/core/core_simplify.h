@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+namespace core {
+
+	// Nivel de detalle de una malla definida: indices sobre los mismos vertices, normales y uvs que el nivel 0
+	struct MeshLod {
+		std::vector<uint32_t> inds;
+		float error = 0.0f;		// desviacion de la superficie respecto a la diagonal de la caja de la malla
+	};
+
+	/*
+	* Simplificacion por colapso de aristas con cuadricas de error (Garland-Heckbert). Cada arista colapsa sobre uno
+	* de sus dos vertices, asi que los niveles no crean vertices nuevos y solo cambian los indices.
+	* Los vertices de borde no se mueven: tras soldar, las costuras de normales y uvs tambien quedan como borde,
+	* y asi no se abren grietas ni se estiran las texturas
+	*/
+	class MeshSimplifier {
+	public:
+		static const int MaxLods = 3;				// niveles ademas del original
+		static const size_t MinTriangles = 512;		// por debajo la BLAS ya es pequena
+		static const int LodRatio = 4;				// cada nivel tiene ~1/4 de los triangulos del anterior
+
+		/*
+		* Genera hasta MaxLods niveles en una sola pasada de colapsos: las cuadricas se acumulan desde el original,
+		* asi que el error de cada nivel es respecto a la malla original y no al nivel anterior.
+		* Se para antes si el siguiente colapso supera maxError o ya no queda nada que colapsar
+		*/
+		static void BuildLods(const std::vector<glm::vec3>& verts, const std::vector<uint32_t>& inds,
+			std::vector<MeshLod>& lods, float maxError = 0.05f);
+	};
+}
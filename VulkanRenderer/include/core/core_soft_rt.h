@@ -0,0 +1,76 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include <vector>
+
+#include "core/core.h"
+#include "core/core_bvh.h"
+#include "core/core_simple_mesh.h"
+
+namespace core {
+
+	// Push constants de raytrace_soft.comp
+	struct SoftRtPushConstants {
+		glm::mat4 invViewProj;	// misma matriz que el UBO del raygen
+		glm::vec4 boundsMin;	// descuantizacion de los nodos: p = boundsMin + q * quantScale
+		glm::vec4 quantScale;
+		uint32_t frameIndex;
+		uint32_t seed;
+		uint32_t width;			// equivalente a gl_LaunchSizeEXT
+		uint32_t height;
+	};
+
+	// Imagenes que escribe el trazado, todas propiedad del Raytracer (mismos bindings 2-5 que raytrace.rgen)
+	struct SoftRtImages {
+		VulkanTexture* out = nullptr;		// rgba8
+		VulkanTexture* accum = nullptr;		// rgba32f, suma de muestras
+		VulkanTexture* guide = nullptr;		// rgba32f, normal + distancia
+		VulkanTexture* position = nullptr;	// rgba32f, posicion + distancia
+	};
+
+	/*
+	* Trazado por compute shader para dispositivos sin VK_KHR_ray_tracing_pipeline.
+	* Recorre una BVH construida en CPU y reproduce el sombreado de raytrace.rchit (rebotes, color plano de las mesh texturizadas)
+	*/
+	class SoftwareRaytracer {
+	public:
+		SoftwareRaytracer() {}
+		~SoftwareRaytracer() {}
+
+		void init(VulkanCore* core, VkShaderModule compModule);
+		// Reconstruye la BVH y vuelve a subir nodos, triangulos y materiales
+		void updateScene(const std::vector<SimpleMesh>& meshes);
+		void setImages(const SoftRtImages& images);
+		void trace(VkCommandBuffer cmdBuf, int width, int height, const glm::mat4& invViewProj, uint32_t frameIndex, uint32_t seed);
+		// Referencia en CPU del primer frame (centro del pixel), mismo recorrido y sombreado que el shader
+		void traceCPU(const glm::mat4& invViewProj, int width, int height, std::vector<uint8_t>& rgba) const;
+
+		bool isReady() const { return m_pipeline != VK_NULL_HANDLE; }
+		bool hasScene() const { return !m_bvh.empty(); }
+		const Bvh& getBvh() const { return m_bvh; }
+		void cleanup();
+
+	private:
+		void CreateDescriptorSet();
+		void CreatePipeline(VkShaderModule compModule);
+		void WriteSceneBuffers();
+		void DestroySceneBuffers();
+		BufferMemory CreateStorageBuffer(const void* pData, size_t size, MemoryCategory category);
+		glm::vec3 ShadeCPU(const glm::vec3& origin, const glm::vec3& dir, glm::vec4& guide) const;
+
+		VulkanCore* m_vkcore = nullptr;
+		VkDevice m_device = VK_NULL_HANDLE;
+		SoftRtImages m_images;
+		Bvh m_bvh;
+
+		BufferMemory m_nodeBuffer;
+		BufferMemory m_triangleBuffer;
+		BufferMemory m_meshInfoBuffer;
+
+		VkDescriptorPool m_descPool = VK_NULL_HANDLE;
+		VkDescriptorSetLayout m_descSetLayout = VK_NULL_HANDLE;
+		VkDescriptorSet m_descSet = VK_NULL_HANDLE;
+
+		VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+		VkPipeline m_pipeline = VK_NULL_HANDLE;
+	};
+}
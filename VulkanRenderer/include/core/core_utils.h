@@ -1,11 +1,12 @@
 #pragma once
 
 #include <stdio.h>
+#include "Log.h"
 
 typedef unsigned int uint;
 
 #define CHECK_VK_RESULT(res,msg)\
 	if (res != VK_SUCCESS){\
-		fprintf(stderr, "Error in %s:%d - %s, code %x\n", __FILE__, __LINE__, msg, res); \
+		LOG_ERROR("vulkan", "Error in %s:%d, code %x - %s", __FILE__, __LINE__, (unsigned)res, msg); \
 		exit(1);\
 	}
@@ -9,7 +9,8 @@ namespace core {
 	VkSemaphore CreateSemaphore(VkDevice Device);
 	void ImageMemBarrier(VkCommandBuffer CmdBuf, VkImage Image, VkFormat Format,
 		VkImageLayout OldLayout, VkImageLayout NewLayout);
-	VkImageView CreateImageView(VkDevice Device, VkImage Image, VkFormat Format, VkImageAspectFlags AspectFlags);
+	VkImageView CreateImageView(VkDevice Device, VkImage Image, VkFormat Format, VkImageAspectFlags AspectFlags,
+		VkImageViewType ViewType = VK_IMAGE_VIEW_TYPE_2D, uint32_t LayerCount = 1);
 	VkSampler CreateTextureSampler(VkDevice Device, VkFilter MinFilter, VkFilter MaxFilter, VkSamplerAddressMode AddressMode);
 	
 }
\ No newline at end of file
@@ -15,6 +15,12 @@ namespace core {
 		std::vector<VkPresentModeKHR> m_presentModes;
 		VkPhysicalDeviceFeatures m_features;
 		VkFormat m_depthFormat;
+		// VK_KHR_acceleration_structure + VK_KHR_ray_tracing_pipeline disponibles; si no, se traza con compute
+		bool m_rayTracingSupported = false;
+		// VK_KHR_ray_query, para el modo hibrido (compute + ray queries sobre la misma TLAS)
+		bool m_rayQuerySupported = false;
+		// VK_KHR_shader_clock, para medir el coste por pixel en la variante de depuracion del trazado
+		bool m_shaderClockSupported = false;
 	};
 
 	class VulkanPhysicalDevices {
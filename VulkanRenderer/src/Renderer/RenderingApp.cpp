@@ -3,6 +3,7 @@
 #include <GL/glew.h>
 #include <vector>
 #include "core_fpcamera.h"
+#include "Log.h"
 
 static struct Vertex {
 	Vertex(const glm::vec3& p, const glm::vec2& t, const glm::vec3& n) {
@@ -199,7 +200,7 @@ void VulkanRenderApp::Impl::initRt() {
 
 
 	uint32_t meshid = Renderer.defineMesh(vertData, normData, uvData, indices);
-	printf("Mesh Defined\n");
+	LOG_DEBUG("app", "Mesh Defined");
 
 	Renderer.addMesh(glm::translate(glm::mat4(1.0f), glm::vec3(1.4f, 0.f, 0.f)), glm::vec3(1.0f), meshid);
 	Renderer.addMesh(glm::translate(glm::mat4(1.0f), glm::vec3(1.4f, 0.f, 0.f)), glm::vec3(1.0f), topMeshId);
@@ -216,11 +217,11 @@ void VulkanRenderApp::Impl::initRt() {
 	//Renderer.save(true);
 
 	Renderer.render();
-	printf("Rendered everything\n");
+	LOG_DEBUG("app", "Rendered everything");
 
 
 	uint32_t tex = Renderer.getResultTextureId();
-	printf("texture created at: %zd", tex);
+	LOG_DEBUG("app", "texture created at: %u", tex);
 
 }
 
@@ -234,12 +235,12 @@ void VulkanRenderApp::Impl::loop() {
 	float znear = 0.1f;
 	float zfar = 1000.0f;
 	CreateCamera(pos, FOV, znear, zfar);
-	printf("Created camera");
+	LOG_DEBUG("app", "Created camera");
 }
 
 void VulkanRenderApp::Impl::CreateCamera(glm::vec3 pos, float FOV, float znear, float zfar) {
 	if ((m_windowWidth == 0) || (m_windowHeight == 0)) {
-		printf("Invalid window dims");
+		LOG_ERROR("app", "Invalid window dims");
 		exit(1);
 	}
 
@@ -254,7 +254,7 @@ public:
 
 
 		uint32_t meshid = Renderer.defineMesh(vertData, normData, uvData, indices);
-		printf("Mesh Defined\n");
+		LOG_DEBUG("app", "Mesh Defined");
 		
 		Renderer.addMesh(glm::translate(glm::mat4(1.0f), glm::vec3(.00f, 0.f, 0.f)), glm::vec3(1.0f), meshid);
 		Renderer.addMesh(glm::translate(glm::mat4(1.0f), glm::vec3(.00f, 0.f, 0.f)), glm::vec3(1.0f), topMeshId);
@@ -271,7 +271,7 @@ public:
 
 
 		Renderer.render();
-		printf("Rendered everything\n");
+		LOG_DEBUG("app", "Rendered everything");
 
 
 	}
@@ -543,7 +543,7 @@ private:
 			CHECK_VK_RESULT(res, "vkEndCommandBuffer\n");
 		}
 		
-		printf("Command buffers recorded\n");
+		LOG_DEBUG("app", "Command buffers recorded");
 	}
 
 	void CreateCamera(glm::vec3 pos) {
@@ -552,12 +552,12 @@ private:
 		float znear = 0.1f;
 		float zfar = 1000.0f;
 		CreateCamera(pos, FOV, znear, zfar);
-		printf("Created camera");
+		LOG_DEBUG("app", "Created camera");
 	}
 
 	void CreateCamera(glm::vec3 pos,float FOV, float znear, float zfar) {
 		if ((m_windowWidth == 0) || (m_windowHeight == 0)) {
-			printf("Invalid window dims");
+			LOG_ERROR("app", "Invalid window dims");
 			exit(1);
 		}
 
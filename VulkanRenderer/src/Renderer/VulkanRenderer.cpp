@@ -10,6 +10,8 @@
 
 #include <core/core_simple_mesh.h>
 #include <core/core_rt.h>
+#include <core/core_simplify.h>
+#include <core/core_cluster.h>
 #include <core/core_vertex.h>
 #include "core/utils.h"
 #include <iostream>
@@ -21,13 +23,21 @@
 #include <GL/wglew.h>
 
 #include "Renderer/VulkanRenderer.h"
+#include "Trace.h"
+#include "Log.h"
 
 #include <GL/gl.h>      // Para funciones bsicas de OpenGL
 #include <GL/glu.h>     // Para funciones de utilidad (opcional)
 
 
 
+#include <algorithm>
+#include <cfloat>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 
 
 // Extensiones OpenGL necesarias para memory objects
@@ -55,13 +65,29 @@ class VulkanRenderer::Impl {
     }
 
      ~Impl()  {
+        StopLodWorker();
         vkDestroyShaderModule(m_vkcore.GetDevice(), rgen, nullptr);
         vkDestroyShaderModule(m_vkcore.GetDevice(), rmiss, nullptr);
         vkDestroyShaderModule(m_vkcore.GetDevice(), rchit, nullptr);
+        vkDestroyShaderModule(m_vkcore.GetDevice(), rgenBatch, nullptr);
+        vkDestroyShaderModule(m_vkcore.GetDevice(), denoiseComp, nullptr);
+        vkDestroyShaderModule(m_vkcore.GetDevice(), reprojectComp, nullptr);
+        vkDestroyShaderModule(m_vkcore.GetDevice(), softComp, nullptr);
+        vkDestroyShaderModule(m_vkcore.GetDevice(), queryComp, nullptr);
+        vkDestroyShaderModule(m_vkcore.GetDevice(), rgenStats, nullptr);
+        vkDestroyShaderModule(m_vkcore.GetDevice(), rmissStats, nullptr);
+        vkDestroyShaderModule(m_vkcore.GetDevice(), rchitStats, nullptr);
 
         for (int i = 0; i < meshesC.size(); i++) {
+            TrackHostMesh(meshesC[i], false);
             meshesC[i].Destroy(m_vkcore.GetDevice());
         }
+        for (MeshLods& lods : m_meshLods) {
+            ReleaseLods(lods);
+        }
+        for (int i = 0; i < m_meshesDraw.size(); i++) {
+            ReleaseInstance(m_meshesDraw[i]);
+        }
 
         for (int i = 0; i < texturesC.size(); i++) {
             texturesC[i]->Destroy(m_vkcore.GetDevice());
@@ -95,15 +121,27 @@ class VulkanRenderer::Impl {
 
         m_outTexture = new core::VulkanTexture();
 
-        rgen = core::CreateShaderModuleFromText(m_vkcore.GetDevice(), "../VulkanRenderer/Shaders/raytrace.rgen");
-        rmiss = core::CreateShaderModuleFromText(m_vkcore.GetDevice(), "../VulkanRenderer/Shaders/raytrace.rmiss");
-        rchit = core::CreateShaderModuleFromText(m_vkcore.GetDevice(), "../VulkanRenderer/Shaders/raytrace.rchit");
+        denoiseComp = core::CreateShaderModuleFromText(m_vkcore.GetDevice(), "../VulkanRenderer/Shaders/denoise_atrous.comp");
 
         m_raytracer.initRayTracing(m_vkcore.GetSelectedPhysicalDevice(), &m_device);
         m_raytracer.setup(m_vkcore.GetCommandPool(), &m_vkcore);
 
+        //Sin VK_KHR_ray_tracing_pipeline: BVH propia y trazado por compute, sin TLAS ni pipeline de RT
+        if (m_raytracer.isSoftware()) {
+            softComp = core::CreateShaderModuleFromText(m_vkcore.GetDevice(), "../VulkanRenderer/Shaders/raytrace_soft.comp");
+            m_raytracer.createSoftwarePipeline(softComp);
+            return true;
+        }
+
+        rgen = core::CreateShaderModuleFromText(m_vkcore.GetDevice(), "../VulkanRenderer/Shaders/raytrace.rgen");
+        rmiss = core::CreateShaderModuleFromText(m_vkcore.GetDevice(), "../VulkanRenderer/Shaders/raytrace.rmiss");
+        rchit = core::CreateShaderModuleFromText(m_vkcore.GetDevice(), "../VulkanRenderer/Shaders/raytrace.rchit");
+        rgenBatch = core::CreateShaderModuleFromText(m_vkcore.GetDevice(), "../VulkanRenderer/Shaders/raytrace_batch.rgen");
+        reprojectComp = core::CreateShaderModuleFromText(m_vkcore.GetDevice(), "../VulkanRenderer/Shaders/reproject.comp");
+
         m_raytracer.createRtDescriptorSet();
         m_raytracer.createMvpDescriptorSet();
+        // Capacidad inicial, updateGeometryDescriptorSet la amplia si la escena tiene mas instancias
         m_raytracer.createGeometryDescriptorSet(50);
   
 
@@ -129,6 +167,7 @@ the scene with Renderer::addMesh
         const std::vector<glm::vec3>& nrmls,
         const std::vector<glm::vec2>& uv,
         const std::vector<uint32_t> inds)  {
+        TRACE_SCOPE("defineMesh", "renderer");
 
         core::SimpleMesh mesh;
         //mesh.m_vertexBufferSize = sizeof(vtcs[0]) * vtcs.size();
@@ -136,9 +175,14 @@ the scene with Renderer::addMesh
 
         mesh.verts = vtcs;
         mesh.norms = nrmls;
+        mesh.inds = inds;
+        //Mallas grandes: triangulos reordenados por clusters espaciales, una geometria de la BLAS por cluster
+        if (m_clusterSplitting) {
+            mesh.clustered = core::MeshClusters::Reorder(mesh.verts, mesh.inds) > 1;
+        }
 
         mesh.m_indexBufferSize = sizeof(inds[0]) * inds.size();
-        mesh.m_indexbuffer = m_vkcore.CreateIndexBuffer(inds.data(), mesh.m_indexBufferSize, true);
+        mesh.m_indexbuffer = m_vkcore.CreateIndexBuffer(mesh.inds.data(), mesh.m_indexBufferSize, true);
 
         mesh.m_indexType = VK_INDEX_TYPE_UINT32;
 
@@ -152,8 +196,11 @@ the scene with Renderer::addMesh
         mesh.id = m_baseId++;
 
         meshesC.push_back(mesh);
+        m_meshLods.push_back(MeshLods());
+        TrackHostMesh(mesh, true);
+        QueueLods(mesh);
 
-        printf("Mesh created with id: %zd", mesh.id);
+        LOG_DEBUG("renderer", "Mesh created with id: %zu", (size_t)mesh.id);
 
         return mesh.id;
     }
@@ -174,7 +221,9 @@ the scene with Renderer::addMesh
      */
      bool addMesh(const glm::mat4& modelMatrix, const glm::vec3
         & color, MeshId id)  {
-        dirtyupdate = true;
+        TRACE_SCOPE("addMesh", "renderer");
+        if (SceneFull()) return false;
+        markSceneDirty();
 
         int tid = -1;
         //En principio actualizar las meshes es escribir de nuevo un uniforme
@@ -192,6 +241,7 @@ the scene with Renderer::addMesh
         newMesh.color = glm::vec4(color,1.0f);
 
         m_meshesDraw.push_back(newMesh);
+        TrackHostMesh(newMesh, true);
 
         std::vector<glm::vec4> modelverts = {};
         std::vector<glm::vec4> modelnorms = {};
@@ -217,6 +267,8 @@ the scene with Renderer::addMesh
             modelnorms.push_back(glm::vec4(glm::normalize(glm::vec3(transformedNorm)),0.0f));
         }
 
+        UpdateInstanceBounds(m_meshesDraw.back(), modelverts);
+
         //meshesC[tid].
         m_meshesDraw.back().m_vertexBufferSize = sizeof(modelverts[0]) * modelverts.size();
         m_meshesDraw.back().m_vb = m_vkcore.CreateVertexBuffer(modelverts.data(), m_meshesDraw.back().m_vertexBufferSize, true);
@@ -227,7 +279,7 @@ the scene with Renderer::addMesh
         
         //m_meshesDraw contiene las meshes que se dibujarn
 
-        printf("Color copiado: %f %f %f\n", m_meshesDraw.back().color.r, m_meshesDraw.back().color.g, m_meshesDraw.back().color.b);
+        LOG_DEBUG("renderer", "Color copiado: %f %f %f", m_meshesDraw.back().color.r, m_meshesDraw.back().color.g, m_meshesDraw.back().color.b);
 
         return true;
 
@@ -259,14 +311,14 @@ the scene with Renderer::addMesh
      bool addLight(const glm::mat4& modelMatrix, MeshId id,
         const glm::vec3& color, LightId lid, TextureId tid = 0) {
         //pasarle la textura la id y tal
-         int mid;
+         int mid = -1;
          for (int i = 0; i < meshesC.size(); i++) {
              if (meshesC[i].id == id) {
-                 mid = id;
+                 mid = i;
                  break;
              }
          }
-         if (mid == -1) return false;
+         if (mid == -1 || SceneFull()) return false;
          meshesC[mid].texIndex = tid;
 
          core::SimpleMesh newMesh = meshesC[mid];
@@ -276,6 +328,7 @@ the scene with Renderer::addMesh
          newMesh.color = glm::vec4(color, 1.0f);
 
          m_meshesDraw.push_back(newMesh);
+         TrackHostMesh(newMesh, true);
 
  
 
@@ -303,6 +356,8 @@ the scene with Renderer::addMesh
              modelnorms.push_back(glm::vec4(glm::normalize(glm::vec3(transformedNorm)), 0.0f));
          }
 
+         UpdateInstanceBounds(m_meshesDraw.back(), modelverts);
+
          //meshesC[tid].
          m_meshesDraw.back().m_vertexBufferSize = sizeof(modelverts[0]) * modelverts.size();
          m_meshesDraw.back().m_vb = m_vkcore.CreateVertexBuffer(modelverts.data(), m_meshesDraw.back().m_vertexBufferSize, true);
@@ -310,6 +365,7 @@ the scene with Renderer::addMesh
          size_t normsize = sizeof(modelnorms[0]) * modelnorms.size();
          m_meshesDraw.back().m_normalbuffer = m_vkcore.CreateVertexBuffer(modelnorms.data(), normsize, true);
 
+         markSceneDirty();
         return true;
 
 
@@ -322,23 +378,45 @@ instances in the scene)
       * @return false if the mesh id does not exists
       */
      bool removeMesh(MeshId id) {
-        for (int i = 0; i < m_meshesDraw.size(); i++) {
-            if (m_meshesDraw[i].id == id) {
-                dirtyupdate = true;
-                m_meshesDraw.erase(m_meshesDraw.begin() + i);
-                return true;
+        //meshesC esta indexado por id: la definicion liberada deja su hueco, con un id que no coincide con ninguno
+        if (id >= meshesC.size() || meshesC[id].id != id) {
+            return false;
+        }
+        markSceneDirty();
+        m_pQueue->WaitIdle();
+        for (size_t i = m_meshesDraw.size(); i-- > 0;) {
+            if (m_meshesDraw[i].id != id) {
+                continue;
             }
+            //Su BLAS sale de la lista para que las demas sigan alineadas con m_meshesDraw
+            if (!m_raytracer.isSoftware() && i < m_blasBuilt) {
+                m_raytracer.removeBottomLevelAS(i);
+                m_blasBuilt--;
+            }
+            RemoveStaleIndex(i);
+            ReleaseInstance(m_meshesDraw[i]);
+            m_meshesDraw.erase(m_meshesDraw.begin() + i);
         }
-        return false;
-
+        ReleaseLods(m_meshLods[id]);
+        TrackHostMesh(meshesC[id], false);
+        meshesC[id].Destroy(m_vkcore.GetDevice());
+        meshesC[id] = core::SimpleMesh();
+        meshesC[id].id = RemovedMeshId;
+        return true;
     }
 
     /**
      * @brief removes all the meshes from the scene
      */
      void clearScene() {
-        dirtyupdate = true;
+        markSceneDirty();
+        m_pQueue->WaitIdle();
+        for (core::SimpleMesh& mesh : m_meshesDraw) {
+            ReleaseInstance(mesh);
+        }
         m_meshesDraw = {};
+        m_blasBuilt = 0;
+        m_blasStale.clear();
     }
 
     /**
@@ -348,8 +426,15 @@ instances in the scene)
      */
      void setCamera(const glm::mat4& viewMatrix, const
         glm::mat4& projMatrix) {
-        VP = projMatrix * viewMatrix;
-        VP = glm::affineInverse(VP);
+        glm::mat4 newVP = glm::affineInverse(projMatrix * viewMatrix);
+        //Misma camara que el frame anterior: ni se sube el uniforme ni cambia la generacion
+        if (newVP == VP) {
+            return;
+        }
+        VP = newVP;
+        m_cameraView = projMatrix * viewMatrix;
+        m_lodStale = true;
+        m_generation++;
         //Updatear el buffer que esta en el descriptor set
         m_raytracer.UpdateMvpMatrix(VP);
     }
@@ -362,7 +447,13 @@ instances in the scene)
      void setOutputResolution(uint32_t width, uint32_t height) {
         windowwidth = width;
         windowheight = height;
+        //Todas las imagenes del raytracer (salida, acumulacion, guia, reproyeccion...) pasan a tener el nuevo tamano
+        m_raytracer.setOutputResolution(windowwidth, windowheight);
+        m_outTexture->Destroy(m_vkcore.GetDevice());
+        *m_outTexture = core::VulkanTexture();
         m_raytracer.createOutImage(windowwidth, windowheight, m_outTexture);
+        m_lodStale = true;
+        m_generation++;
     }
 
    
@@ -373,13 +464,38 @@ instances in the scene)
       * @return
       */
      bool render() {
+        //El nivel de detalle depende de la camara: se elige antes de decidir si hay que volver a trazar.
+        //Los niveles que acaban de llegar del hilo de simplificacion tambien obligan a elegir de nuevo
+        if (CollectLods() > 0) {
+            m_lodStale = true;
+        }
+        if (m_lodStale) {
+            selectLods();
+        }
+        bool changed = m_generation != m_renderedGeneration;
+        //Nada ha cambiado y no queda nada por acumular: el resultado anterior sigue siendo valido.
+        //Con el guardado activo el raytracer se llama igual: convergido no traza, solo escribe el PNG
+        if (!changed && m_raytracer.isConverged()) {
+            if (saving) {
+                m_raytracer.render(windowwidth, windowheight, saving, "Test1.png");
+            }
+            return true;
+        }
+        TRACE_SCOPE("render", "renderer");
+
         //Antes de entregar quitar ek guardar en png
         if (dirtyupdate) {
             updateMeshes();
             dirtyupdate = false;
         }
 
+        if (changed) {
+            m_raytracer.resetAccumulation();
+            m_renderedGeneration = m_generation;
+        }
+
         m_raytracer.render(windowwidth, windowheight, saving, "Test1.png");
+        m_resultVersion++;
         return true;
     }
 
@@ -390,6 +506,7 @@ instances in the scene)
      * @return the number of bytes written to buffer
      */
      size_t copyResultBytes(uint8_t* buffer, size_t bufferSize) {
+        TRACE_SCOPE("copyResultBytes", "renderer");
         return m_raytracer.copyResultBytes(buffer, bufferSize, m_outTexture, windowwidth, windowheight);
     }
 
@@ -434,23 +551,23 @@ instances in the scene)
                  wglGetProcAddress("glImportMemoryWin32HandleEXT");
 
              if (!glCreateMemoryObjectsEXT) {
-                 std::cerr << "No se pudo cargar glCreateMemoryObjectsEXT" << std::endl;
+                 LOG_ERROR("renderer", "No se pudo cargar glCreateMemoryObjectsEXT");
                  return 0;
              }
              if (!vkGetMemoryWin32HandleKHR) {
-                 std::cerr << "No se pudo cargar vkGetMemoryWin32HandleKHR" << std::endl;
+                 LOG_ERROR("renderer", "No se pudo cargar vkGetMemoryWin32HandleKHR");
                  return 0;
              }
              if (!glTextureStorageMem2DEXT) {
-                 std::cerr << "No se pudo cargar glTextureStorageMem2DEXT" << std::endl;
+                 LOG_ERROR("renderer", "No se pudo cargar glTextureStorageMem2DEXT");
                  return 0;
              }
              if (!glCreateTextures) {
-                 std::cerr << "No se pudo cargar glCreateTextures" << std::endl;
+                 LOG_ERROR("renderer", "No se pudo cargar glCreateTextures");
                  return 0;
              }
              if (!glImportMemoryWin32HandleEXT) {
-                 std::cerr << "No se pudo cargar glImportMemoryWin32HandleEXT" << std::endl;
+                 LOG_ERROR("renderer", "No se pudo cargar glImportMemoryWin32HandleEXT");
                  return 0;
              }
 
@@ -464,10 +581,10 @@ instances in the scene)
              GLuint memoryObject;
              glCreateMemoryObjectsEXT(1, &memoryObject);
              checkGLError("glCreateMemoryObjectsEXT");
-             std::cout << "memoryObject = " << memoryObject << std::endl;
+             LOG_DEBUG("renderer", "memoryObject = %u", memoryObject);
              glImportMemoryWin32HandleEXT(memoryObject, memReqs.size, GL_HANDLE_TYPE_OPAQUE_WIN32_EXT, memoryHandle);
              checkGLError("glImportMemoryWin32HandleEXT");
-             std::cout << "memoryObject = " << memoryObject << std::endl;
+             LOG_DEBUG("renderer", "memoryObject = %u", memoryObject);
              //GLint dedicated = GL_TRUE;
              //glMemoryObjectParameterivEXT(memoryObject, GL_DEDICATED_MEMORY_OBJECT_EXT, &dedicated);
              //checkGLError("glMemoryObjectParameterivEXT");
@@ -505,7 +622,7 @@ instances in the scene)
              PFNGLTEXSTORAGEMEM2DEXTPROC glTexStorageMem2DEXT =
                  (PFNGLTEXSTORAGEMEM2DEXTPROC)wglGetProcAddress("glTexStorageMem2DEXT");
 
-             printf("Window width: %d, Window height: %d\n", windowwidth, windowheight);
+             LOG_DEBUG("renderer", "Window width: %d, Window height: %d", windowwidth, windowheight);
 
              /*if (glTexStorageMem2DEXT) {
                  glGetError();
@@ -524,7 +641,7 @@ instances in the scene)
                  glTextureStorageMem2DEXT(texture, 1, GL_RGBA8,
                      windowwidth, windowheight, memoryObject, 0);
                  checkGLError("glTextureStorageMem2DEXT");
-                 printf("Usado glTextureStorageMem2DEXT\n");
+                 LOG_DEBUG("renderer", "Usado glTextureStorageMem2DEXT");
              //}
 
              glBindTexture(GL_TEXTURE_2D, texture);
@@ -534,8 +651,8 @@ instances in the scene)
              glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
              glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-             std::cout << "textureID: " << texture << std::endl;
-             std::cout << "glGetString(Version): " << glGetString(GL_VERSION) << std::endl;
+             LOG_DEBUG("renderer", "textureID: %u", texture);
+             LOG_DEBUG("renderer", "glGetString(Version): %s", (const char*)glGetString(GL_VERSION));
 
 
 
@@ -553,13 +670,276 @@ instances in the scene)
          //m_pWindow = window;
      }
 
+     /**
+      * @brief Renders N views of the current scene in a single dispatch, one layer per view
+      * @param viewMatrices view matrix of each view
+      * @param projMatrices projection matrix of each view (same size as viewMatrices)
+      * @return false if the camera lists are empty or their sizes differ
+      */
+     bool renderBatch(const std::vector<glm::mat4>& viewMatrices, const std::vector<glm::mat4>& projMatrices) {
+         if (viewMatrices.empty() || viewMatrices.size() != projMatrices.size()) {
+             return false;
+         }
+         if (m_raytracer.isSoftware()) {
+             LOG_WARN("renderer", "renderBatch requires VK_KHR_ray_tracing_pipeline");
+             return false;
+         }
+
+         if (dirtyupdate) {
+             updateMeshes();
+             dirtyupdate = false;
+         }
+
+         if (!batchPipelineCreated) {
+             m_raytracer.createBatchPipeline(rgenBatch, rmiss, rchit);
+             batchPipelineCreated = true;
+         }
+
+         //Igual que en setCamera, el shader espera la inversa de la VP
+         std::vector<glm::mat4> invVPs(viewMatrices.size());
+         for (size_t i = 0; i < viewMatrices.size(); i++) {
+             invVPs[i] = glm::affineInverse(projMatrices[i] * viewMatrices[i]);
+         }
+
+         m_raytracer.updateBatchCameras(invVPs, windowwidth, windowheight);
+         m_raytracer.renderBatch();
+         return true;
+     }
+
+     /**
+      * @brief Copies every view of the last batch into buffer, one RGBA8 image after another
+      * @param buffer destination
+      * @param bufferSize size of buffer (at least width * height * 4 * number of views)
+      * @return the number of bytes written to buffer
+      */
+     size_t copyBatchResultBytes(uint8_t* buffer, size_t bufferSize) {
+         return m_raytracer.copyBatchResultBytes(buffer, bufferSize);
+     }
+
+     void setTargetSamplesPerPixel(uint32_t spp) {
+         m_raytracer.setTargetSamples(spp);
+     }
+
+     uint32_t getTargetSamplesPerPixel() const {
+         return m_raytracer.getTargetSamples();
+     }
+
+     uint32_t getAccumulatedSamples() const {
+         return m_raytracer.getAccumulatedSamples();
+     }
+
+     uint64_t getResultVersion() const {
+         return m_resultVersion;
+     }
+
+     void setDynamicResolution(bool enabled, float targetFrameMs, float minScale) {
+         m_raytracer.setDynamicResolution(enabled, targetFrameMs, minScale);
+     }
+
+     float getResolutionScale() const {
+         return m_raytracer.getResolutionScale();
+     }
+
+     void setDenoiser(bool enabled, int iterations) {
+         if (enabled) {
+             m_raytracer.createDenoiser(denoiseComp);
+         }
+         core::DenoiseSettings settings = m_raytracer.getDenoiseSettings();
+         settings.iterations = std::max(1, iterations);
+         m_raytracer.setDenoiseSettings(settings);
+         m_raytracer.setDenoise(enabled);
+         // La imagen final cambia aunque la escena no
+         m_generation++;
+     }
+
+     bool isDenoiserEnabled() const {
+         return m_raytracer.isDenoiseEnabled();
+     }
+
+     void setTemporalReprojection(bool enabled, uint32_t refreshPeriod) {
+         if (enabled && m_raytracer.isSoftware()) {
+             LOG_WARN("renderer", "Temporal reprojection is not available with the compute fallback");
+             return;
+         }
+         if (enabled) {
+             m_raytracer.createReprojector(reprojectComp);
+         }
+         m_raytracer.setTemporalReprojection(enabled, refreshPeriod);
+     }
+
+     bool isTemporalReprojectionEnabled() const {
+         return m_raytracer.isTemporalReprojectionEnabled();
+     }
+
+     void setLodSelection(bool enabled, float pixelError) {
+         m_lodEnabled = enabled;
+         m_lodPixelError = std::max(pixelError, 0.01f);
+         m_lodStale = true;
+     }
+
+     bool isLodSelectionEnabled() const {
+         return m_lodEnabled;
+     }
+
+     void setClusterSplitting(bool enabled) {
+         m_clusterSplitting = enabled;
+     }
+
+     bool isClusterSplittingEnabled() const {
+         return m_clusterSplitting;
+     }
+
+     bool isSoftwareRayTracing() const {
+         return m_raytracer.isSoftware();
+     }
+
+     bool setRayQueryMode(bool enabled) {
+         if (enabled) {
+             if (m_raytracer.isSoftware() || !m_vkcore.IsRayQuerySupported()) {
+                 LOG_WARN("renderer", "Ray query mode requires VK_KHR_ray_query");
+                 return false;
+             }
+             if (queryComp == VK_NULL_HANDLE) {
+                 queryComp = core::CreateShaderModuleFromText(m_vkcore.GetDevice(), "../VulkanRenderer/Shaders/raytrace_query.comp");
+                 m_raytracer.createRayQueryPipeline(queryComp);
+             }
+         }
+         m_raytracer.setRayQuery(enabled);
+         // Mismo resultado, pero se vuelve a trazar para poder medir el modo nuevo
+         m_generation++;
+         return m_raytracer.isRayQuery() == enabled;
+     }
+
+     bool isRayQueryMode() const {
+         return m_raytracer.isRayQuery();
+     }
+
+     bool setRayStatistics(bool enabled) {
+         if (enabled) {
+             if (m_raytracer.isSoftware() || m_raytracer.isRayQuery()) {
+                 LOG_WARN("renderer", "Ray statistics require the ray tracing pipeline");
+                 return false;
+             }
+             if (rgenStats == VK_NULL_HANDLE) {
+                 // Misma fuente que rgen/rmiss/rchit, compilada con los contadores
+                 std::string defines = "#define RAY_STATS\n";
+                 if (m_vkcore.IsShaderClockSupported()) {
+                     defines += "#define RAY_STATS_CLOCK\n";
+                 }
+                 rgenStats = core::CreateShaderModuleFromText(m_vkcore.GetDevice(), "../VulkanRenderer/Shaders/raytrace.rgen", defines.c_str());
+                 rmissStats = core::CreateShaderModuleFromText(m_vkcore.GetDevice(), "../VulkanRenderer/Shaders/raytrace.rmiss", defines.c_str());
+                 rchitStats = core::CreateShaderModuleFromText(m_vkcore.GetDevice(), "../VulkanRenderer/Shaders/raytrace.rchit", defines.c_str());
+                 m_raytracer.createRayStatsPipeline(rgenStats, rmissStats, rchitStats);
+             }
+         }
+         m_raytracer.setRayStats(enabled);
+         // Mismo resultado, pero se vuelve a trazar para obtener los contadores
+         m_generation++;
+         return m_raytracer.isRayStatsEnabled() == enabled;
+     }
+
+     bool isRayStatisticsEnabled() const {
+         return m_raytracer.isRayStatsEnabled();
+     }
+
+     RendererRayStats getRayStatistics() const {
+         RendererRayStats stats;
+         const core::RayStatistics& rayStats = m_raytracer.getRayStatistics();
+         if (!rayStats.hasResults()) {
+             return stats;
+         }
+         const core::RayStatsCounters& c = rayStats.get();
+         stats.raysPerDepth.assign(c.rays, c.rays + core::RAY_STATS_DEPTHS);
+         stats.hitsPerDepth.assign(c.hits, c.hits + core::RAY_STATS_DEPTHS);
+         stats.missesPerDepth.assign(c.misses, c.misses + core::RAY_STATS_DEPTHS);
+         stats.bounceHistogram.assign(c.bounces, c.bounces + core::RAY_STATS_DEPTHS);
+         stats.pixels = c.pixels;
+         stats.maxCost = c.maxCost;
+         stats.clockCost = rayStats.isClockCost();
+         return stats;
+     }
+
+     size_t copyRayHeatmapBytes(uint8_t* buffer, size_t bufferSize) {
+         return m_raytracer.getRayStatistics().copyHeatmapBytes(buffer, bufferSize, windowwidth, windowheight);
+     }
+
+     float getAverageTraceMs() const {
+         return m_raytracer.getAverageTraceMs();
+     }
+
+     std::vector<RendererStageTiming> getStageTimings() const {
+         std::vector<RendererStageTiming> timings;
+         const core::GpuProfiler& profiler = m_raytracer.getProfiler();
+         if (!profiler.isEnabled()) {
+             return timings;
+         }
+         for (int s = 0; s < (int)core::GpuStage::Count; s++) {
+             core::GpuStage stage = (core::GpuStage)s;
+             const core::GpuStageTiming& t = profiler.get(stage);
+             timings.push_back({ core::GpuProfiler::StageName(stage), t.lastMs, t.totalMs, t.count });
+         }
+         return timings;
+     }
+
+     void resetStageTimings() {
+         m_raytracer.getProfiler().reset();
+     }
+
+     void setProfilingEnabled(bool enabled) {
+         m_raytracer.getProfiler().setEnabled(enabled);
+     }
+
+     RendererMemoryStats getMemoryStats() const {
+         RendererMemoryStats stats;
+         const core::MemoryTracker& tracker = core::MemoryTracker::Get();
+         for (int c = 0; c < (int)core::MemoryCategory::Count; c++) {
+             core::MemoryCategory category = (core::MemoryCategory)c;
+             core::MemoryCategoryStats s = tracker.get(category);
+             stats.categories.push_back({ core::MemoryTracker::CategoryName(category), s.deviceBytes, s.devicePeakBytes,
+                 s.deviceAllocations, s.hostBytes, s.hostPeakBytes });
+         }
+         stats.deviceBytes = tracker.deviceBytes();
+         stats.devicePeakBytes = tracker.devicePeakBytes();
+         stats.hostBytes = tracker.hostBytes();
+         stats.hostPeakBytes = tracker.hostPeakBytes();
+         for (const core::SimpleMesh& mesh : m_meshesDraw) {
+             stats.triangles += mesh.vertexcount / 3;
+         }
+         stats.instances = (uint32_t)m_meshesDraw.size();
+         return stats;
+     }
+
+     void resetMemoryPeaks() {
+         core::MemoryTracker::Get().resetPeaks();
+     }
+
     private:
 
         void updateMeshes() {
-            m_raytracer.createBottomLevelAS(m_meshesDraw);
+            TRACE_SCOPE("updateMeshes", "renderer");
+            if (m_raytracer.isSoftware()) {
+                m_raytracer.updateSoftwareScene(m_meshesDraw);
+                return;
+            }
+            //Solo se construyen las BLAS de las instancias anadidas desde la ultima actualizacion: una escena que
+            //llega por lotes paga cada malla una vez. La TLAS (una instancia por BLAS) si se reconstruye entera
+            if (m_blasBuilt == 0) {
+                m_raytracer.createBottomLevelAS(m_meshesDraw);
+            }
+            else {
+                m_raytracer.appendBottomLevelAS(m_meshesDraw, m_blasBuilt);
+            }
+            m_blasBuilt = m_meshesDraw.size();
+            //Instancias que han cambiado de nivel de detalle: su BLAS se rehace en el mismo sitio
+            if (!m_blasStale.empty()) {
+                m_raytracer.rebuildBottomLevelAS(m_meshesDraw, m_blasStale);
+                m_blasStale.clear();
+            }
             m_raytracer.createTopLevelAS();
             m_raytracer.UpdateAccStructure();
             m_raytracer.updateGeometryDescriptorSet(m_meshesDraw);
+            //Las posiciones guardadas para reproyectar ya no corresponden a la escena
+            m_raytracer.invalidateHistory();
             if (!pipelineCreated) {
                 m_raytracer.createRtPipeline(rgen, rmiss, rchit);
                 m_raytracer.createRtShaderBindingTable();
@@ -568,10 +948,239 @@ instances in the scene)
 
         }
 
+        // Copias en CPU de la geometria: cada instancia de m_meshesDraw lleva las suyas
+        static void TrackHostMesh(const core::SimpleMesh& mesh, bool added) {
+            int64_t bytes = (int64_t)(mesh.verts.size() * sizeof(glm::vec3) + mesh.norms.size() * sizeof(glm::vec3) +
+                mesh.inds.size() * sizeof(uint32_t));
+            core::MemoryTracker::Get().addHost(core::MemoryCategory::Geometry, added ? bytes : -bytes);
+        }
+
+        // Los buffers de vertices y normales transformados son de la instancia; indices y uvs son de la malla definida
+        void ReleaseInstance(core::SimpleMesh& mesh) {
+            TrackHostMesh(mesh, false);
+            mesh.m_vb.Destroy(m_vkcore.GetDevice());
+            mesh.m_normalbuffer.Destroy(m_vkcore.GetDevice());
+        }
+
+        //El set de geometria crece con la escena, pero no mas alla de los storage buffers del dispositivo:
+        //la instancia se rechaza aqui en vez de fallar al actualizar los descriptores
+        bool SceneFull() {
+            if (m_raytracer.isSoftware() || m_meshesDraw.size() < m_raytracer.getMaxGeometryMeshes()) {
+                return false;
+            }
+            LOG_ERROR("renderer", "Scene is full: the device supports at most %zu mesh instances", m_meshesDraw.size());
+            return true;
+        }
+
+        //Las instancias con el nivel de detalle cambiado se guardan por posicion: la que sale de m_meshesDraw
+        //desaparece de la lista y las siguientes bajan un puesto
+        void RemoveStaleIndex(size_t index) {
+            m_blasStale.erase(std::remove(m_blasStale.begin(), m_blasStale.end(), index), m_blasStale.end());
+            for (size_t& stale : m_blasStale) {
+                if (stale > index) {
+                    stale--;
+                }
+            }
+        }
+
+        void markSceneDirty() {
+            dirtyupdate = true;
+            m_lodStale = true;
+            m_generation++;
+        }
+
+        // Caja en mundo de la instancia a partir de sus vertices ya transformados
+        static void UpdateInstanceBounds(core::SimpleMesh& mesh, const std::vector<glm::vec4>& worldVerts) {
+            mesh.m_boundsMin = glm::vec3(FLT_MAX);
+            mesh.m_boundsMax = glm::vec3(-FLT_MAX);
+            for (const glm::vec4& v : worldVerts) {
+                mesh.m_boundsMin = glm::min(mesh.m_boundsMin, glm::vec3(v));
+                mesh.m_boundsMax = glm::max(mesh.m_boundsMax, glm::vec3(v));
+            }
+        }
+
+        //Diagonal en pixeles de la caja de la instancia proyectada como en raytrace.rgen: el origen de los rayos es
+        //(0,0,2) en el espacio de m_cameraView y el plano z = 0 cubre la imagen de -1 a 1. FLT_MAX si la caja llega
+        //a la camara
+        float ProjectedSize(const core::SimpleMesh& mesh) const {
+            glm::vec2 dmin(FLT_MAX), dmax(-FLT_MAX);
+            for (int corner = 0; corner < 8; corner++) {
+                glm::vec3 p((corner & 1) ? mesh.m_boundsMax.x : mesh.m_boundsMin.x,
+                    (corner & 2) ? mesh.m_boundsMax.y : mesh.m_boundsMin.y,
+                    (corner & 4) ? mesh.m_boundsMax.z : mesh.m_boundsMin.z);
+                glm::vec4 q = m_cameraView * glm::vec4(p, 1.0f);
+                float depth = 2.0f - q.z;
+                if (depth <= 1e-4f) {
+                    return FLT_MAX;
+                }
+                glm::vec2 d = glm::vec2(q.x, q.y) * (2.0f / depth);
+                dmin = glm::min(dmin, d);
+                dmax = glm::max(dmax, d);
+            }
+            glm::vec2 extent = (dmax - dmin) * glm::vec2((float)windowwidth, (float)windowheight) * 0.5f;
+            return glm::length(extent);
+        }
+
+        //Cada instancia traza el nivel mas simple cuyo error proyectado no pasa de m_lodPixelError pixeles.
+        //Solo se reconstruyen las BLAS de las instancias que cambian de nivel
+        void selectLods() {
+            TRACE_SCOPE("selectLods", "renderer");
+            m_lodStale = false;
+            if (windowwidth == 0 || windowheight == 0) {
+                return;
+            }
+            size_t switched = 0;
+            for (size_t i = 0; i < m_meshesDraw.size(); i++) {
+                core::SimpleMesh& instance = m_meshesDraw[i];
+                if (instance.id >= m_meshLods.size()) {
+                    continue;
+                }
+                int lod = 0;
+                if (m_lodEnabled) {
+                    float size = ProjectedSize(instance);
+                    //Sin niveles todavia (se estan simplificando) la instancia se queda en el nivel 0
+                    MeshLods& lods = m_meshLods[instance.id];
+                    for (size_t k = 0; k < lods.levels.size(); k++) {
+                        //Pasar a un nivel mas simple exige margen, asi una camara en el limite no alterna niveles
+                        float limit = ((int)k + 1 > instance.lod) ? 0.75f * m_lodPixelError : m_lodPixelError;
+                        if (lods.levels[k].error * size > limit) {
+                            break;
+                        }
+                        lod = (int)k + 1;
+                    }
+                }
+                if (lod != instance.lod) {
+                    ApplyLod(i, lod);
+                    switched++;
+                }
+            }
+            if (switched > 0) {
+                LOG_DEBUG("renderer", "%zu instances changed their level of detail", switched);
+                markSceneDirty();
+                m_lodStale = false;
+            }
+        }
+
+        //La simplificacion (solo CPU) va en un hilo propio para no parar render(): defineMesh encola una copia de la
+        //malla y CollectLods recoge los niveles y crea sus index buffers en el hilo del renderer
+        void QueueLods(const core::SimpleMesh& mesh) {
+            if (mesh.inds.size() / 3 < core::MeshSimplifier::MinTriangles) {
+                m_meshLods[mesh.id].built = true;
+                return;
+            }
+            LodJob job;
+            job.id = mesh.id;
+            job.verts = mesh.verts;
+            job.inds = mesh.inds;
+            job.clustered = mesh.clustered;
+            std::lock_guard<std::mutex> lock(m_lodMutex);
+            if (!m_lodWorker.joinable()) {
+                m_lodWorker = std::thread([this] { RunLodWorker(); });
+            }
+            m_lodQueue.push_back(std::move(job));
+            m_lodReady.notify_one();
+        }
+
+        void RunLodWorker() {
+            std::unique_lock<std::mutex> lock(m_lodMutex);
+            while (true) {
+                m_lodReady.wait(lock, [this] { return m_lodStop || !m_lodQueue.empty(); });
+                if (m_lodStop) {
+                    break;
+                }
+                LodJob job = std::move(m_lodQueue.front());
+                m_lodQueue.pop_front();
+                lock.unlock();
+                core::MeshSimplifier::BuildLods(job.verts, job.inds, job.levels);
+                //Los niveles comparten el indicador clustered de la malla: tambien se parten si son grandes
+                if (job.clustered) {
+                    for (core::MeshLod& level : job.levels) {
+                        core::MeshClusters::Reorder(job.verts, level.inds);
+                    }
+                }
+                job.verts.clear();
+                lock.lock();
+                m_lodDone.push_back(std::move(job));
+            }
+        }
+
+        void StopLodWorker() {
+            {
+                std::lock_guard<std::mutex> lock(m_lodMutex);
+                m_lodStop = true;
+                m_lodReady.notify_one();
+            }
+            if (m_lodWorker.joinable()) {
+                m_lodWorker.join();
+            }
+        }
+
+        //Devuelve cuantas mallas han recibido niveles de detalle
+        size_t CollectLods() {
+            std::vector<LodJob> done;
+            {
+                std::lock_guard<std::mutex> lock(m_lodMutex);
+                done.swap(m_lodDone);
+            }
+            size_t collected = 0;
+            for (LodJob& job : done) {
+                //La malla se ha eliminado mientras se simplificaba
+                if (job.id >= meshesC.size() || meshesC[job.id].id != job.id) {
+                    continue;
+                }
+                MeshLods& lods = m_meshLods[job.id];
+                lods.built = true;
+                lods.levels = std::move(job.levels);
+                for (core::MeshLod& level : lods.levels) {
+                    size_t bytes = sizeof(uint32_t) * level.inds.size();
+                    lods.buffers.push_back(m_vkcore.CreateIndexBuffer(level.inds.data(), bytes, true));
+                    core::MemoryTracker::Get().addHost(core::MemoryCategory::Geometry, (int64_t)bytes);
+                }
+                if (!lods.levels.empty()) {
+                    LOG_INFO("renderer", "Mesh %u: %zu levels of detail, %zu -> %zu triangles", job.id, lods.levels.size(),
+                        job.inds.size() / 3, lods.levels.back().inds.size() / 3);
+                    collected++;
+                }
+            }
+            return collected;
+        }
+
+        void ReleaseLods(MeshLods& lods) {
+            for (size_t k = 0; k < lods.levels.size(); k++) {
+                core::MemoryTracker::Get().addHost(core::MemoryCategory::Geometry,
+                    -(int64_t)(sizeof(uint32_t) * lods.levels[k].inds.size()));
+                lods.buffers[k].Destroy(m_vkcore.GetDevice());
+            }
+            lods = MeshLods();
+        }
+
+        // Los indices del nivel pasan a la instancia; vertices, normales y uvs son los mismos en todos los niveles
+        void ApplyLod(size_t index, int lod) {
+            core::SimpleMesh& instance = m_meshesDraw[index];
+            const core::SimpleMesh& mesh = meshesC[instance.id];
+            TrackHostMesh(instance, false);
+            if (lod == 0) {
+                instance.inds = mesh.inds;
+                instance.m_indexbuffer = mesh.m_indexbuffer;
+            }
+            else {
+                const MeshLods& lods = m_meshLods[instance.id];
+                instance.inds = lods.levels[lod - 1].inds;
+                instance.m_indexbuffer = lods.buffers[lod - 1];
+            }
+            instance.m_indexBufferSize = sizeof(uint32_t) * instance.inds.size();
+            instance.vertexcount = (int)instance.inds.size();
+            instance.lod = lod;
+            TrackHostMesh(instance, true);
+            if (!m_raytracer.isSoftware() && index < m_blasBuilt) {
+                m_blasStale.push_back(index);
+            }
+        }
+
         void checkGLError(const char* operation) {
             GLenum error = glGetError();
             if (error != GL_NO_ERROR) {
-                std::cerr << "Error OpenGL en " << operation << ": " << error << std::endl;
+                LOG_ERROR("renderer", "Error OpenGL en %s: %u", operation, error);
             }
         }
 
@@ -584,21 +1193,68 @@ instances in the scene)
         VkRenderPass m_renderPass;
         std::vector<VkFramebuffer> m_frameBuffers;
 
-        VkShaderModule rgen, rmiss, rchit;
+        VkShaderModule rgen = VK_NULL_HANDLE, rmiss = VK_NULL_HANDLE, rchit = VK_NULL_HANDLE;
+        VkShaderModule rgenBatch = VK_NULL_HANDLE;
+        bool batchPipelineCreated = false;
+        VkShaderModule denoiseComp = VK_NULL_HANDLE;
+        VkShaderModule reprojectComp = VK_NULL_HANDLE;
+        VkShaderModule softComp = VK_NULL_HANDLE;
+        VkShaderModule queryComp = VK_NULL_HANDLE;
+        VkShaderModule rgenStats = VK_NULL_HANDLE, rmissStats = VK_NULL_HANDLE, rchitStats = VK_NULL_HANDLE;
 
         
         core::VulkanTexture* m_outTexture;
 
-        uint32_t windowwidth, windowheight;
+        uint32_t windowwidth = 0, windowheight = 0;
 
         /////meshes
         bool dirtyupdate = false;
+
+        //Generaciones: cualquier cambio de escena, camara o resolucion incrementa m_generation.
+        //render() solo vuelve a trazar si ha cambiado o si la acumulacion no ha terminado
+        uint64_t m_generation = 0;
+        uint64_t m_renderedGeneration = UINT64_MAX;
+        uint64_t m_resultVersion = 0;
         std::vector<core::SimpleMesh> meshesC;
         std::vector<core::SimpleMesh> m_meshesDraw;
+        //Las primeras m_blasBuilt instancias de m_meshesDraw ya tienen BLAS, en el mismo orden
+        size_t m_blasBuilt = 0;
+
+        //Niveles de detalle de una malla definida, en paralelo a meshesC. Las instancias solo referencian los buffers
+        struct MeshLods {
+            bool built = false;         //niveles recogidos del hilo de simplificacion (o malla demasiado pequena)
+            std::vector<core::MeshLod> levels;
+            std::vector<core::BufferMemory> buffers;
+        };
+        std::vector<MeshLods> m_meshLods;
+        //Cola del hilo de simplificacion: las copias de las mallas entran por m_lodQueue y salen con sus niveles por m_lodDone
+        struct LodJob {
+            MeshId id = 0;
+            std::vector<glm::vec3> verts;
+            std::vector<uint32_t> inds;
+            bool clustered = false;
+            std::vector<core::MeshLod> levels;
+        };
+        std::mutex m_lodMutex;
+        std::condition_variable m_lodReady;
+        std::deque<LodJob> m_lodQueue;
+        std::vector<LodJob> m_lodDone;
+        bool m_lodStop = false;
+        std::thread m_lodWorker;
+        //Instancias con BLAS que han cambiado de nivel desde la ultima actualizacion
+        std::vector<size_t> m_blasStale;
+        //proj * view de setCamera (VP es su inversa), para proyectar las cajas de las instancias
+        glm::mat4 m_cameraView = glm::mat4(1.0f);
+        bool m_lodEnabled = true;
+        float m_lodPixelError = 1.0f;
+        bool m_lodStale = true;
+        //Particion en clusters de las mallas que se definan a partir de ahora
+        bool m_clusterSplitting = false;
 
         uint32_t m_baseId = 0;
+        static const MeshId RemovedMeshId = UINT32_MAX;
 
-        glm::mat4 VP;
+        glm::mat4 VP = glm::mat4(1.0f);
         bool pipelineCreated = false;
 
         bool saving = false;
@@ -681,4 +1337,120 @@ uint32_t VulkanRenderer::getResultTextureId() {
 
 void VulkanRenderer::save(bool s) {
     pImpl->save(s);
+}
+
+bool VulkanRenderer::renderBatch(const std::vector<glm::mat4>& viewMatrices, const std::vector<glm::mat4>& projMatrices) {
+    return pImpl->renderBatch(viewMatrices, projMatrices);
+}
+
+size_t VulkanRenderer::copyBatchResultBytes(uint8_t* buffer, size_t bufferSize) {
+    return pImpl->copyBatchResultBytes(buffer, bufferSize);
+}
+
+void VulkanRenderer::setTargetSamplesPerPixel(uint32_t spp) {
+    pImpl->setTargetSamplesPerPixel(spp);
+}
+
+uint32_t VulkanRenderer::getTargetSamplesPerPixel() const {
+    return pImpl->getTargetSamplesPerPixel();
+}
+
+uint32_t VulkanRenderer::getAccumulatedSamples() const {
+    return pImpl->getAccumulatedSamples();
+}
+
+uint64_t VulkanRenderer::getResultVersion() const {
+    return pImpl->getResultVersion();
+}
+
+void VulkanRenderer::setDynamicResolution(bool enabled, float targetFrameMs, float minScale) {
+    pImpl->setDynamicResolution(enabled, targetFrameMs, minScale);
+}
+
+float VulkanRenderer::getResolutionScale() const {
+    return pImpl->getResolutionScale();
+}
+
+void VulkanRenderer::setDenoiser(bool enabled, int iterations) {
+    pImpl->setDenoiser(enabled, iterations);
+}
+
+bool VulkanRenderer::isDenoiserEnabled() const {
+    return pImpl->isDenoiserEnabled();
+}
+
+void VulkanRenderer::setTemporalReprojection(bool enabled, uint32_t refreshPeriod) {
+    pImpl->setTemporalReprojection(enabled, refreshPeriod);
+}
+
+bool VulkanRenderer::isTemporalReprojectionEnabled() const {
+    return pImpl->isTemporalReprojectionEnabled();
+}
+
+void VulkanRenderer::setLodSelection(bool enabled, float pixelError) {
+    pImpl->setLodSelection(enabled, pixelError);
+}
+
+bool VulkanRenderer::isLodSelectionEnabled() const {
+    return pImpl->isLodSelectionEnabled();
+}
+
+void VulkanRenderer::setClusterSplitting(bool enabled) {
+    pImpl->setClusterSplitting(enabled);
+}
+
+bool VulkanRenderer::isClusterSplittingEnabled() const {
+    return pImpl->isClusterSplittingEnabled();
+}
+
+bool VulkanRenderer::isSoftwareRayTracing() const {
+    return pImpl->isSoftwareRayTracing();
+}
+
+bool VulkanRenderer::setRayQueryMode(bool enabled) {
+    return pImpl->setRayQueryMode(enabled);
+}
+
+bool VulkanRenderer::isRayQueryMode() const {
+    return pImpl->isRayQueryMode();
+}
+
+float VulkanRenderer::getAverageTraceMs() const {
+    return pImpl->getAverageTraceMs();
+}
+
+std::vector<RendererStageTiming> VulkanRenderer::getStageTimings() const {
+    return pImpl->getStageTimings();
+}
+
+void VulkanRenderer::resetStageTimings() {
+    pImpl->resetStageTimings();
+}
+
+void VulkanRenderer::setProfilingEnabled(bool enabled) {
+    pImpl->setProfilingEnabled(enabled);
+}
+
+bool VulkanRenderer::setRayStatistics(bool enabled) {
+    return pImpl->setRayStatistics(enabled);
+}
+
+bool VulkanRenderer::isRayStatisticsEnabled() const {
+    return pImpl->isRayStatisticsEnabled();
+}
+
+RendererRayStats VulkanRenderer::getRayStatistics() const {
+    return pImpl->getRayStatistics();
+}
+
+size_t VulkanRenderer::copyRayHeatmapBytes(uint8_t* buffer, size_t bufferSize) {
+    return pImpl->copyRayHeatmapBytes(buffer, bufferSize);
+}
+
+RendererMemoryStats VulkanRenderer::getMemoryStats() const {
+    return pImpl->getMemoryStats();
+}
+
+void VulkanRenderer::resetMemoryPeaks() {
+    pImpl->resetMemoryPeaks();
 }
\ No newline at end of file
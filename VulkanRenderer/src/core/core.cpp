@@ -4,6 +4,7 @@
 
 #include <vector>
 #include "core/core.h"
+#include "Log.h"
 
 #include <cassert>
 
@@ -24,23 +25,20 @@ namespace core {
 	}
 	VulkanCore::~VulkanCore() {
 
-		printf("\n---------------------------------------\n\n");
-
-
 		vkFreeCommandBuffers(m_device, m_cmdBufPool, 1, &m_copyCmdBuf);
 
 		for (uint32_t i = 0; i < m_frameBuffers.size();i++) {
 			vkDestroyFramebuffer(m_device,m_frameBuffers[i],NULL);
 		}
-		printf("Destroyed FrameBuffers\n");
+		LOG_DEBUG("core", "Destroyed FrameBuffers");
 
 		m_queue.Destroy();
 
-		printf("Destroyed Queue semaphores\n");
+		LOG_DEBUG("core", "Destroyed Queue semaphores");
 		
 		vkDestroyCommandPool(m_device, m_cmdBufPool, NULL);
 
-		printf("Destroyed Command Pool\n");
+		LOG_DEBUG("core", "Destroyed Command Pool");
 
 		for (int i = 0; i < m_imageViews.size(); i++) {
 			vkDestroyImageView(m_device, m_imageViews[i], NULL);
@@ -50,7 +48,7 @@ namespace core {
 
 		//Destruir dispositivos lgicos
 		vkDestroyDevice(m_device, NULL);
-		printf("Device destroyed\n");
+		LOG_DEBUG("core", "Device destroyed");
 
 		//No es necesario destruir los dispositivos fisicos
 
@@ -58,19 +56,19 @@ namespace core {
 		vkDestroyDebugUtilsMessenger = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(m_instance, "vkDestroyDebugUtilsMessengerEXT");
 		vkDestroyDebugUtilsMessenger(m_instance, m_debugMessenger, NULL);
 		if (!vkDestroyDebugUtilsMessenger) {
-			printf("Cannot find addres of vkDestroyDebugUtilsMessenger\n");
+			LOG_ERROR("core", "Cannot find addres of vkDestroyDebugUtilsMessenger");
 		}
-		printf("Destroyed Debug callback\n");
+		LOG_DEBUG("core", "Destroyed Debug callback");
 
 
 		PFN_vkDestroySurfaceKHR vkDestroySurface = VK_NULL_HANDLE;
 		vkDestroySurface = (PFN_vkDestroySurfaceKHR)vkGetInstanceProcAddr(m_instance, "vkDestroySurfaceKHR");
 		vkDestroySurfaceKHR(m_instance, m_surface, NULL);
-		printf("GLFW window surface destroyed\n");
+		LOG_DEBUG("core", "GLFW window surface destroyed");
 
 
 		vkDestroyInstance(m_instance, NULL);
-		printf("Destroyed Instance\n");
+		LOG_DEBUG("core", "Destroyed Instance");
 
 	}
 
@@ -123,14 +121,29 @@ namespace core {
 		const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
 		void* pUserData) 
 	{
-		printf("Debug callback: %s\n", pCallbackData->pMessage);
-		printf("	Severity %s\n", Get_DebugSeverityString(Severity));
-		printf("	Type %s\n", Get_DebugType(Type));
-		printf("	Objects");
+		// El nivel del mensaje de las capas de validacion decide el del log
+		logging::Level level = logging::Level::Debug;
+		if (Severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
+			level = logging::Level::Error;
+		}
+		else if (Severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
+			level = logging::Level::Warning;
+		}
+		else if (Severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) {
+			level = logging::Level::Info;
+		}
+		if (!logging::isEnabled(level, "vulkan")) {
+			return VK_FALSE;
+		}
+
+		std::string objects;
+		char handle[24];
 		for (uint32_t i = 0; i < pCallbackData->objectCount; i++) {
-			printf("%llx ", pCallbackData->pObjects[i].objectHandle);
+			snprintf(handle, sizeof(handle), "%llx ", (unsigned long long)pCallbackData->pObjects[i].objectHandle);
+			objects += handle;
 		}
-		printf("\n");
+		LOG_AT(level, "vulkan", "Debug callback: %s\n	Severity %s\n	Type %s\n	Objects %s", pCallbackData->pMessage,
+			Get_DebugSeverityString(Severity), Get_DebugType(Type), objects.c_str());
 		return VK_FALSE;
 	}
 
@@ -152,12 +165,12 @@ namespace core {
 		PFN_vkCreateDebugUtilsMessengerEXT vkCreateDebugUtilsMessenger = VK_NULL_HANDLE;
 		vkCreateDebugUtilsMessenger = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(m_instance, "vkCreateDebugUtilsMessengerEXT");
 		if (!vkCreateDebugUtilsMessenger) {
-			printf("Couldnt create Callback");
+			LOG_ERROR("core", "Couldnt create Callback");
 			exit(1);
 		}
 		VkResult res = vkCreateDebugUtilsMessenger(m_instance, &MessengerCreateInfo, NULL, &m_debugMessenger);
 		CHECK_VK_RESULT(res, "Debug utils messenger");
-		printf("Debug utils messenger created\n");
+		LOG_DEBUG("core", "Debug utils messenger created");
 
 	}
 
@@ -209,7 +222,7 @@ namespace core {
 		//No allocator
 		VkResult res = vkCreateInstance(&CreateInfo, NULL, &m_instance);
 		CHECK_VK_RESULT(res,"Create instance");
-		printf("Vulkan instance created \n");
+		LOG_INFO("core", "Vulkan instance created");
 
 	}
 
@@ -229,17 +242,17 @@ namespace core {
 
 
 
+		m_rayTracingSupported = m_physDevices.Selected().m_rayTracingSupported;
+		m_rayQuerySupported = m_physDevices.Selected().m_rayQuerySupported;
+		m_shaderClockSupported = m_physDevices.Selected().m_shaderClockSupported;
+
 		std::vector<const char*> DevExts = {
 			VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 			VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME,
-			VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
-			VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
-			VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
 			VK_KHR_SPIRV_1_4_EXTENSION_NAME,                 // Requerida por ray tracing
 			VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME,     // Requerida por SPIRV 1.4
 			VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,       // Requerida por ray tracing
 			VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME,     // Requerida por acceleration structure
-			VK_KHR_RAY_QUERY_EXTENSION_NAME,
 			VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME,
 			VK_KHR_EXTERNAL_SEMAPHORE_EXTENSION_NAME,
 #ifdef WIN32
@@ -251,14 +264,34 @@ namespace core {
 #endif
 		};
 
+		// Sin ray tracing por hardware el dispositivo se crea sin estas extensiones y se traza por compute
+		if (m_rayTracingSupported) {
+			DevExts.push_back(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME);
+			DevExts.push_back(VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME);
+			DevExts.push_back(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME);
+		}
+		else {
+			LOG_WARN("core", "Ray tracing pipeline not supported, using the compute fallback");
+		}
+		if (m_rayQuerySupported) {
+			DevExts.push_back(VK_KHR_RAY_QUERY_EXTENSION_NAME);
+		}
+		else if (m_rayTracingSupported) {
+			// Solo afecta al modo hibrido: el pipeline de ray tracing sigue disponible
+			LOG_WARN("core", "Ray query not supported, the hybrid ray query mode is disabled");
+		}
+		if (m_shaderClockSupported) {
+			DevExts.push_back(VK_KHR_SHADER_CLOCK_EXTENSION_NAME);
+		}
+
 
 
 		VkPhysicalDeviceFeatures DeviceFeatures = { 0 };
 		if (m_physDevices.Selected().m_features.geometryShader == VK_FALSE) {
-			fprintf(stderr, "Geometry shader not supported");
+			LOG_WARN("core", "Geometry shader not supported");
 		}
 		if (m_physDevices.Selected().m_features.tessellationShader == VK_FALSE) {
-			fprintf(stderr, "Tesselation shader not supported");
+			LOG_WARN("core", "Tesselation shader not supported");
 		}
 		DeviceFeatures.geometryShader = VK_TRUE;
 		DeviceFeatures.tessellationShader = VK_TRUE;
@@ -278,9 +311,27 @@ namespace core {
 		rtPipelineFeatures.rayTracingPipeline = VK_TRUE;
 		rtPipelineFeatures.pNext = &asFeatures;
 
+		// Ray queries desde compute (modo hibrido del Raytracer)
+		VkPhysicalDeviceRayQueryFeaturesKHR rayQueryFeatures = {};
+		rayQueryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR;
+		rayQueryFeatures.rayQuery = VK_TRUE;
+		rayQueryFeatures.pNext = &rtPipelineFeatures;
+
 		VkDeviceCreateInfo DeviceCreateInfo = {};
 		DeviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-		DeviceCreateInfo.pNext = &rtPipelineFeatures;
+		DeviceCreateInfo.pNext = m_rayTracingSupported ? (void*)&rtPipelineFeatures : (void*)&bufferDeviceAddressFeatures;
+		if (m_rayQuerySupported) {
+			DeviceCreateInfo.pNext = &rayQueryFeatures;
+		}
+
+		// clock2x32ARB() en los shaders de estadisticas de rayos (shaderSubgroupClock es obligatorio con la extension)
+		VkPhysicalDeviceShaderClockFeaturesKHR shaderClockFeatures = {};
+		shaderClockFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_CLOCK_FEATURES_KHR;
+		shaderClockFeatures.shaderSubgroupClock = VK_TRUE;
+		if (m_shaderClockSupported) {
+			shaderClockFeatures.pNext = (void*)DeviceCreateInfo.pNext;
+			DeviceCreateInfo.pNext = &shaderClockFeatures;
+		}
 		DeviceCreateInfo.flags = 0;
 		DeviceCreateInfo.queueCreateInfoCount = 1;
 		DeviceCreateInfo.pQueueCreateInfos = &qInfo;
@@ -292,16 +343,16 @@ namespace core {
 
 		VkResult res = vkCreateDevice(m_physDevices.Selected().m_physDevice, &DeviceCreateInfo, NULL, &m_device);
 		CHECK_VK_RESULT(res, "Create device\n");
-		printf("\nDevice created\n");
+		LOG_INFO("core", "Device created");
 
 	}
 	/*
 	void VulkanCore::CreateSurface(GLFWwindow* pWindow) {
 		if (glfwCreateWindowSurface(m_instance, pWindow, NULL, &m_surface)) {
-			fprintf(stderr, "Error creating GLFW window surface\n");
+			LOG_ERROR("core", "Error creating GLFW window surface");
 			exit(1);
 		}
-		printf("GLFW window surface created\n");
+		LOG_DEBUG("core", "GLFW window surface created");
 
 
 	}*/
@@ -391,7 +442,7 @@ namespace core {
 		VkResult res = vkCreateSwapchainKHR(m_device, &SwapChainCreateInfo, NULL, &m_swapChain);
 		CHECK_VK_RESULT(res, "vkCreateSwapChainKHR\n");
 
-		printf("Swap chain created\n");
+		LOG_INFO("core", "Swap chain created");
 
 		uint32_t NumSwapChainImages = 0;
 		res = vkGetSwapchainImagesKHR(m_device, m_swapChain, &NumSwapChainImages, NULL);
@@ -399,7 +450,7 @@ namespace core {
 		//Control
 		assert(NumImages == NumSwapChainImages);
 
-		printf("Number of images %d\n", NumSwapChainImages);
+		LOG_INFO("core", "Number of images %d", NumSwapChainImages);
 		m_numImages = NumSwapChainImages;
 		m_images.resize(NumSwapChainImages);
 		m_imageViews.resize(NumSwapChainImages);
@@ -427,7 +478,7 @@ namespace core {
 		VkResult res = vkCreateCommandPool(m_device, &cmdPoolCreateInfo, NULL, &m_cmdBufPool);
 		CHECK_VK_RESULT(res, "vkCreateCommandPool\n");
 
-		printf("Command buffer pool created\n");
+		LOG_DEBUG("core", "Command buffer pool created");
 	}
 
 	/*
@@ -458,7 +509,7 @@ namespace core {
 	const VkImage& VulkanCore::GetImage(int Index) const
 	{
 		if (Index >= m_numImages) {
-			fprintf(stderr, "Error getting image");
+			LOG_ERROR("core", "Error getting image");
 			exit(1);
 		}
 
@@ -530,7 +581,7 @@ namespace core {
 
 		VkResult res = vkCreateRenderPass(m_device, &RenderPassCreateInfo, NULL, &RenderPass);
 		CHECK_VK_RESULT(res, "vkCreateRenderPass\n");
-		printf("Created simple render pass\n");
+		LOG_DEBUG("core", "Created simple render pass");
 
 		return RenderPass;
 	}
@@ -560,7 +611,7 @@ namespace core {
 			CHECK_VK_RESULT(res, "vkCreateFramebuffer\n");
 		}
 
-		printf("Framebuffers created \n");
+		LOG_DEBUG("core", "Framebuffers created");
 
 		return m_frameBuffers;
 
@@ -571,7 +622,7 @@ namespace core {
 		VkBufferUsageFlags Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 		VkMemoryPropertyFlags MemProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
 			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-		BufferMemory StagingVB = CreateBuffer(Size, Usage, MemProps);
+		BufferMemory StagingVB = CreateBuffer(Size, Usage, MemProps, false, MemoryCategory::Staging);
 
 		// Step 2: map the memory of the stage buffer
 		void* pMem = NULL;
@@ -590,10 +641,10 @@ namespace core {
 		// Step 5: create the final buffer
 		Usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT ;
 		if (rt) {
-			Usage = Usage | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+			Usage = Usage | GetRtBufferUsage();
 		}
 		MemProps = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT ;
-		BufferMemory VB = CreateBuffer(Size, Usage, MemProps, rt);
+		BufferMemory VB = CreateBuffer(Size, Usage, MemProps, rt, MemoryCategory::Geometry);
 
 		// Step 6: copy the staging buffer to the final buffer
 		CopyBufferToBuffer(VB.m_buffer, StagingVB.m_buffer, Size);
@@ -609,7 +660,7 @@ namespace core {
 		VkBufferUsageFlags Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 		VkMemoryPropertyFlags MemProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
 			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-		BufferMemory StagingIB = CreateBuffer(Size, Usage, MemProps);
+		BufferMemory StagingIB = CreateBuffer(Size, Usage, MemProps, false, MemoryCategory::Staging);
 
 		// Step 2: map the memory of the staging buffer
 		void* pMem = NULL;
@@ -628,10 +679,10 @@ namespace core {
 		// Step 5: create the final index buffer
 		Usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT ;
 		if (rt) {
-			Usage = Usage | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+			Usage = Usage | GetRtBufferUsage();
 		}
 		MemProps = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT ;
-		BufferMemory IB = CreateBuffer(Size, Usage, MemProps, rt);
+		BufferMemory IB = CreateBuffer(Size, Usage, MemProps, rt, MemoryCategory::Geometry);
 
 		// Step 6: copy the staging buffer to the final buffer
 		CopyBufferToBuffer(IB.m_buffer, StagingIB.m_buffer, Size);
@@ -653,7 +704,7 @@ namespace core {
 		VkBufferUsageFlags Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 		VkMemoryPropertyFlags MemProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
 			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-		BufferMemory StagingBuffer = CreateBuffer(Size, Usage, MemProps);
+		BufferMemory StagingBuffer = CreateBuffer(Size, Usage, MemProps, false, MemoryCategory::Staging);
 
 		// Step 2: map the memory of the stage buffer
 		void* pMem = NULL;
@@ -672,10 +723,10 @@ namespace core {
 		// Step 5: create the final buffer
 		Usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 		if (rt) {
-			Usage = Usage | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+			Usage = Usage | GetRtBufferUsage();
 		}
 		MemProps = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-		BufferMemory NormalBuffer = CreateBuffer(Size, Usage, MemProps, rt);
+		BufferMemory NormalBuffer = CreateBuffer(Size, Usage, MemProps, rt, MemoryCategory::Geometry);
 
 		// Step 6: copy the staging buffer to the final buffer
 		CopyBufferToBuffer(NormalBuffer.m_buffer, StagingBuffer.m_buffer, Size);
@@ -692,7 +743,7 @@ namespace core {
 		VkBufferUsageFlags Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 		VkMemoryPropertyFlags MemProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
 			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-		BufferMemory StagingBuffer = CreateBuffer(Size, Usage, MemProps);
+		BufferMemory StagingBuffer = CreateBuffer(Size, Usage, MemProps, false, MemoryCategory::Staging);
 
 		// Step 2: map the memory of the stage buffer
 		void* pMem = NULL;
@@ -711,10 +762,10 @@ namespace core {
 		// Step 5: create the final buffer
 		Usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 		if (rt) {
-			Usage = Usage | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+			Usage = Usage | GetRtBufferUsage();
 		}
 		MemProps = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-		BufferMemory UVBuffer = CreateBuffer(Size, Usage, MemProps, rt);
+		BufferMemory UVBuffer = CreateBuffer(Size, Usage, MemProps, rt, MemoryCategory::Geometry);
 
 		// Step 6: copy the staging buffer to the final buffer
 		CopyBufferToBuffer(UVBuffer.m_buffer, StagingBuffer.m_buffer, Size);
@@ -725,14 +776,23 @@ namespace core {
 		return UVBuffer;
 	}
 
-	BufferMemory VulkanCore::CreateBufferBlas(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags flags) {
-		return CreateBuffer(size, usage, flags, true);
+	// Uso extra de los buffers de geometria que tambien lee el ray tracing (shaders y build de las BLAS)
+	VkBufferUsageFlags VulkanCore::GetRtBufferUsage() const {
+		VkBufferUsageFlags Usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+		if (m_rayTracingSupported) {
+			Usage |= VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
+		}
+		return Usage;
+	}
+
+	BufferMemory VulkanCore::CreateBufferBlas(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags flags, MemoryCategory category) {
+		return CreateBuffer(size, usage, flags, true, category);
 	}
-	BufferMemory VulkanCore::CreateBufferACC(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags flags) {
-		return CreateBuffer(size, usage, flags, false);
+	BufferMemory VulkanCore::CreateBufferACC(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags flags, MemoryCategory category) {
+		return CreateBuffer(size, usage, flags, false, category);
 	}
 
-	BufferMemory VulkanCore::CreateBuffer(VkDeviceSize Size, VkBufferUsageFlags Usage, VkMemoryPropertyFlags Properties, bool rt) {
+	BufferMemory VulkanCore::CreateBuffer(VkDeviceSize Size, VkBufferUsageFlags Usage, VkMemoryPropertyFlags Properties, bool rt, MemoryCategory Category) {
 		VkBufferCreateInfo vbCreateInfo = {};
 		vbCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 		vbCreateInfo.size = Size;
@@ -750,7 +810,7 @@ namespace core {
 		// Step 2: get the buffer memory requirements
 		VkMemoryRequirements MemReqs = { 0 };
 		vkGetBufferMemoryRequirements(m_device, Buf.m_buffer, &MemReqs);
-		printf("Buffer requires %d bytes\n", (int)MemReqs.size);
+		LOG_DEBUG("core", "Buffer requires %d bytes", (int)MemReqs.size);
 
 		Buf.m_allocationSize = MemReqs.size;
 
@@ -776,6 +836,7 @@ namespace core {
 
 		res = vkAllocateMemory(m_device, &MemAllocInfo, NULL, &Buf.m_mem);
 		CHECK_VK_RESULT(res, "vkAllocateMemory error %d\n");
+		MemoryTracker::Get().track(Buf.m_mem, MemReqs.size, Category);
 
 		// Step 5: bind memory
 		res = vkBindBufferMemory(m_device, Buf.m_buffer, Buf.m_mem, 0);
@@ -799,7 +860,7 @@ namespace core {
 			}
 		}
 
-		printf("Cannot find memory type for type %x requested mem props %x\n", MemTypeBitsMask, ReqMemPropFlags);
+		LOG_ERROR("core", "Cannot find memory type for type %x requested mem props %x", MemTypeBitsMask, ReqMemPropFlags);
 		exit(1);
 		return -1;
 	}
@@ -822,6 +883,7 @@ namespace core {
 	void BufferMemory::Destroy(VkDevice Device)
 	{
 		if (m_mem) {
+			MemoryTracker::Get().release(m_mem);
 			vkFreeMemory(Device, m_mem, NULL);
 		}
 		if (m_buffer) {
@@ -837,7 +899,7 @@ namespace core {
 		UniformBuffers.resize(m_numImages);
 		for (int i = 0; i < UniformBuffers.size(); i++) {
 			UniformBuffers[i] = CreateUniformBuffer(Size);
-			printf("UniformBufferCreado\n");
+			LOG_DEBUG("core", "UniformBufferCreado");
 		}
 
 		return UniformBuffers;
@@ -853,7 +915,7 @@ namespace core {
 		VkMemoryPropertyFlags Memprops = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
 		//El mismo createBuffer de antes
-		Buffer = CreateBuffer(Size, Usage, Memprops);
+		Buffer = CreateBuffer(Size, Usage, Memprops, false, MemoryCategory::Other);
 		return Buffer;
 	}
 
@@ -878,7 +940,7 @@ namespace core {
 		stbi_uc* pPixels = stbi_load(pFilename, &ImageWidth, &ImageHeight, &ImageChannels, STBI_rgb_alpha);
 
 		if (!pPixels) {
-			printf("Error loading texture from '%s'\n", pFilename);
+			LOG_ERROR("core", "Error loading texture from '%s'", pFilename);
 			exit(1);
 		}
 
@@ -900,7 +962,7 @@ namespace core {
 		// Step #5: create the texture sampler
 		Tex.m_sampler = CreateTextureSampler(m_device, MinFilter, MaxFilter, AddressMode);
 
-		printf("Texture from '%s' created\n", pFilename);
+		LOG_DEBUG("core", "Texture from '%s' created", pFilename);
 	}
 
 
@@ -921,21 +983,23 @@ namespace core {
 		// Step #3: create the texture sampler
 		Tex.m_sampler = CreateTextureSampler(m_device, MinFilter, MaxFilter, AddressMode);
 
-		printf("Texture from data created\n");
+		LOG_DEBUG("core", "Texture from data created");
 	}
 
 
 	void VulkanTexture::Destroy(VkDevice Device)
 	{
 		if (m_sampler)
-			printf("\nDestroying sampler\n");
+			LOG_DEBUG("core", "Destroying sampler");
 			vkDestroySampler(Device, m_sampler, NULL);
 		if(m_view)
 			vkDestroyImageView(Device, m_view, NULL);
 		if(m_image)
 			vkDestroyImage(Device, m_image, NULL);
-		if(m_mem)
+		if (m_mem) {
+			MemoryTracker::Get().release(m_mem);
 			vkFreeMemory(Device, m_mem, NULL);
+		}
 	}
 
 	void VulkanCore::CreateTextureImageFromData(VulkanTexture& Tex, const void* pPixels,
@@ -949,21 +1013,32 @@ namespace core {
 
 		UpdateTextureImage(Tex, ImageWidth, ImageHeight, TexFormat, pPixels, bpp);
 	}
-	void VulkanCore::CreateTextureImage(VulkanTexture& Tex, uint32_t ImageWidth, uint32_t ImageHeight, VkFormat TexFormat) {
+	void VulkanCore::CreateTextureImage(VulkanTexture& Tex, uint32_t ImageWidth, uint32_t ImageHeight, VkFormat TexFormat, MemoryCategory Category) {
 		VkImageUsageFlagBits Usage = (VkImageUsageFlagBits)(VK_IMAGE_USAGE_TRANSFER_DST_BIT |
 			VK_IMAGE_USAGE_STORAGE_BIT| VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
 		//device local es en la gpu
 		VkMemoryPropertyFlagBits PropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-		CreateImage(Tex, ImageWidth, ImageHeight, TexFormat, Usage, PropertyFlags);
+		CreateImage(Tex, ImageWidth, ImageHeight, TexFormat, Usage, PropertyFlags, 1, Category);
 
 		VkImageAspectFlags AspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
 		Tex.m_view = CreateImageView(m_device, Tex.m_image, TexFormat, AspectFlags);
 	}
 
+	// Igual que CreateTextureImage pero con varias capas (una por vista en el render por lotes)
+	void VulkanCore::CreateTextureImageArray(VulkanTexture& Tex, uint32_t ImageWidth, uint32_t ImageHeight, uint32_t LayerCount, VkFormat TexFormat, MemoryCategory Category) {
+		VkImageUsageFlagBits Usage = (VkImageUsageFlagBits)(VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+			VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+		VkMemoryPropertyFlagBits PropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		CreateImage(Tex, ImageWidth, ImageHeight, TexFormat, Usage, PropertyFlags, LayerCount, Category);
+
+		VkImageAspectFlags AspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
+		Tex.m_view = CreateImageView(m_device, Tex.m_image, TexFormat, AspectFlags, VK_IMAGE_VIEW_TYPE_2D_ARRAY, LayerCount);
+	}
+
 	void VulkanCore::CreateTexture(uint8_t* texels, uint32_t width, uint32_t height, uint32_t bpp, VulkanTexture& Tex)
 	{
 		if (!texels) {
-			printf("Error: texel data is null\n");
+			LOG_ERROR("core", "Error: texel data is null");
 			exit(1);
 		}
 
@@ -982,11 +1057,11 @@ namespace core {
 		// Step #3: create the texture sampler
 		Tex.m_sampler = CreateTextureSampler(m_device, MinFilter, MaxFilter, AddressMode);
 
-		printf("Texture created from texel data (%dx%d, %d bpp)\n", width, height, bpp);
+		LOG_DEBUG("core", "Texture created from texel data (%dx%d, %d bpp)", width, height, bpp);
 	}
 
 	void VulkanCore::CreateImage(VulkanTexture& Tex, uint32_t ImageWidth, uint32_t ImageHeight, VkFormat TexFormat,
-		VkImageUsageFlags UsageFlags, VkMemoryPropertyFlagBits PropertyFlags)
+		VkImageUsageFlags UsageFlags, VkMemoryPropertyFlagBits PropertyFlags, uint32_t LayerCount, MemoryCategory Category)
 	{
 		VkExternalMemoryImageCreateInfo externalInfoImage = {};
 		externalInfoImage.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO;
@@ -1004,7 +1079,7 @@ namespace core {
 		ex.depth = 1;
 		ImageInfo.extent = ex;
 		ImageInfo.mipLevels = 1;
-		ImageInfo.arrayLayers = 1;
+		ImageInfo.arrayLayers = LayerCount;
 		ImageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 		ImageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 		ImageInfo.usage = UsageFlags;
@@ -1021,11 +1096,11 @@ namespace core {
 		// Step 2: get the buffer memory requirements
 		VkMemoryRequirements MemReqs = { 0 };
 		vkGetImageMemoryRequirements(m_device, Tex.m_image, &MemReqs);
-		printf("Image requires %d bytes\n", (int)MemReqs.size);
+		LOG_DEBUG("core", "Image requires %d bytes", (int)MemReqs.size);
 
 		// Step 3: get the memory type index
 		uint32_t MemoryTypeIndex = GetMemoryTypeIndex(MemReqs.memoryTypeBits, PropertyFlags);
-		printf("Memory type index %d\n", MemoryTypeIndex);
+		LOG_DEBUG("core", "Memory type index %d", MemoryTypeIndex);
 
 		VkExportMemoryAllocateInfo exportAllocInfo = {};
 		exportAllocInfo.sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO;
@@ -1040,6 +1115,7 @@ namespace core {
 
 		res = vkAllocateMemory(m_device, &MemAllocInfo, NULL, &Tex.m_mem);
 		CHECK_VK_RESULT(res, "vkAllocateMemory error");
+		MemoryTracker::Get().track(Tex.m_mem, MemReqs.size, Category);
 
 		// Step 5: bind memory
 		res = vkBindImageMemory(m_device, Tex.m_image, Tex.m_mem, 0);
@@ -1064,7 +1140,7 @@ namespace core {
 		VkMemoryPropertyFlags Properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
 			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-		BufferMemory StagingTex = CreateBuffer(ImageSize, Usage, Properties);
+		BufferMemory StagingTex = CreateBuffer(ImageSize, Usage, Properties, false, MemoryCategory::Staging);
 
 		StagingTex.Update(m_device, pPixels, ImageSize);
 
@@ -1134,7 +1210,7 @@ namespace core {
 			VkImageUsageFlagBits Usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
 			VkMemoryPropertyFlagBits PropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 			CreateImage(m_depthImages[i], m_offscreenWidth, m_offscreenHeight, DepthFormat,
-				Usage, PropertyFlags);
+				Usage, PropertyFlags, 1, MemoryCategory::Output);
 
 			VkImageLayout OldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 			VkImageLayout NewLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
@@ -1156,7 +1232,7 @@ namespace core {
 
 		// Verificar si el buffer es suficientemente grande
 		if (bufferSize < imageSize) {
-			printf("Buffer size insufficient. Required: %zu, Available: %zu\n",
+			LOG_ERROR("core", "Buffer size insufficient. Required: %zu, Available: %zu",
 				(size_t)imageSize, bufferSize);
 			return 0;
 		}
@@ -1164,7 +1240,7 @@ namespace core {
 		// Crear staging buffer
 		BufferMemory stagingBuffer = CreateBuffer(imageSize,
 			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, false, MemoryCategory::Staging);
 
 		// Transicionar la imagen al layout apropiado para lectura
 		TransitionImageLayout(tex->m_image, VK_FORMAT_R8G8B8A8_UNORM,
@@ -1202,7 +1278,7 @@ namespace core {
 		void* pMappedMemory = nullptr;
 		VkResult res = vkMapMemory(m_device, stagingBuffer.m_mem, 0, imageSize, 0, &pMappedMemory);
 		if (res != VK_SUCCESS) {
-			printf("Error mapping memory: %d\n", res);
+			LOG_ERROR("core", "Error mapping memory: %d", res);
 			stagingBuffer.Destroy(m_device);
 			return 0;
 		}
@@ -1283,6 +1359,7 @@ namespace core {
 
 		res = vkAllocateMemory(m_device, &allocInfo, nullptr, &m_offscreenImageMemory);
 		CHECK_VK_RESULT(res, "vkAllocateMemory offscreen");
+		MemoryTracker::Get().track(m_offscreenImageMemory, memReqs.size, MemoryCategory::Output);
 
 		res = vkBindImageMemory(m_device, m_images[0], m_offscreenImageMemory, 0);
 		CHECK_VK_RESULT(res, "vkBindImageMemory offscreen");
@@ -1294,7 +1371,7 @@ namespace core {
 		m_swapChainSurfaceFormat.format = VK_FORMAT_R8G8B8A8_UNORM;
 		m_swapChainSurfaceFormat.colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
 
-		printf("Offscreen image created\n");
+		LOG_DEBUG("core", "Offscreen image created");
 	}
 	// 5. NUEVA FUNCIN: Guardar imagen offscreen a archivo
 	void VulkanCore::SaveOffscreenImage(const char* filename) {
@@ -1303,7 +1380,7 @@ namespace core {
 		// Crear staging buffer
 		BufferMemory stagingBuffer = CreateBuffer(imageSize,
 			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, false, MemoryCategory::Staging);
 
 		// Transition image layout para transfer
 		TransitionImageLayout(m_images[0], VK_FORMAT_R8G8B8A8_UNORM,
@@ -1339,7 +1416,7 @@ namespace core {
 		vkUnmapMemory(m_device, stagingBuffer.m_mem);
 		stagingBuffer.Destroy(m_device);
 
-		printf("Offscreen image saved to %s\n", filename);
+		LOG_INFO("core", "Offscreen image saved to %s", filename);
 	}
 
 }
\ No newline at end of file
@@ -0,0 +1,373 @@
+#include <stdio.h>
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+#include "core/core_bvh.h"
+#include "Log.h"
+
+namespace core {
+
+	static const int s_numBins = 8;
+
+	static float SurfaceArea(const glm::vec3& bmin, const glm::vec3& bmax) {
+		glm::vec3 e = bmax - bmin;
+		return e.x * e.y + e.y * e.z + e.z * e.x;
+	}
+
+	// Moller-Trumbore sin culling (las instancias de la TLAS tienen FACING_CULL_DISABLE)
+	static bool IntersectTriangle(const BvhTriangle& tri, const glm::vec3& o, const glm::vec3& d,
+		float tmin, float tmax, float& t, float& u, float& v) {
+		glm::vec3 v0 = glm::vec3(tri.v0);
+		glm::vec3 e1 = glm::vec3(tri.v1) - v0;
+		glm::vec3 e2 = glm::vec3(tri.v2) - v0;
+		glm::vec3 p = glm::cross(d, e2);
+		float det = glm::dot(e1, p);
+		if (std::fabs(det) < 1e-9f) {
+			return false;
+		}
+		float invDet = 1.0f / det;
+		glm::vec3 s = o - v0;
+		u = glm::dot(s, p) * invDet;
+		if (u < 0.0f || u > 1.0f) {
+			return false;
+		}
+		glm::vec3 q = glm::cross(s, e1);
+		v = glm::dot(d, q) * invDet;
+		if (v < 0.0f || u + v > 1.0f) {
+			return false;
+		}
+		t = glm::dot(e2, q) * invDet;
+		return t > tmin && t < tmax;
+	}
+
+	// Distancia de entrada a la caja, FLT_MAX si no la corta antes de tmax
+	static float IntersectAabb(const glm::vec3& bmin, const glm::vec3& bmax, const glm::vec3& o, const glm::vec3& invDir,
+		float tmin, float tmax) {
+		glm::vec3 t0 = (bmin - o) * invDir;
+		glm::vec3 t1 = (bmax - o) * invDir;
+		glm::vec3 tsmall = glm::min(t0, t1);
+		glm::vec3 tbig = glm::max(t0, t1);
+		float tnear = std::max(std::max(tsmall.x, tsmall.y), std::max(tsmall.z, tmin));
+		float tfar = std::min(std::min(tbig.x, tbig.y), std::min(tbig.z, tmax));
+		return (tnear <= tfar) ? tnear : FLT_MAX;
+	}
+
+	void Bvh::build(const std::vector<SimpleMesh>& meshes) {
+		m_nodes.clear();
+		m_triangles.clear();
+		m_meshInfos.clear();
+
+		// Triangulos en espacio mundo, igual que los buffers que prepara addMesh
+		std::vector<BvhTriangle> tris;
+		for (size_t mi = 0; mi < meshes.size(); mi++) {
+			const SimpleMesh& mesh = meshes[mi];
+
+			BvhMeshInfo info = {};
+			info.color = mesh.color;
+			info.texIndex = mesh.texIndex;
+			m_meshInfos.push_back(info);
+
+			const glm::mat4& M = mesh.m_transMat;
+			for (size_t i = 0; i + 2 < mesh.inds.size(); i += 3) {
+				uint32_t idx[3] = { mesh.inds[i], mesh.inds[i + 1], mesh.inds[i + 2] };
+				if (idx[0] >= mesh.verts.size() || idx[1] >= mesh.verts.size() || idx[2] >= mesh.verts.size()) {
+					continue;
+				}
+				glm::vec4 v[3], n[3];
+				for (int k = 0; k < 3; k++) {
+					v[k] = M * glm::vec4(mesh.verts[idx[k]], 1.0f);
+					n[k] = glm::vec4(0.0f);
+					if (idx[k] < mesh.norms.size()) {
+						n[k] = glm::vec4(glm::normalize(glm::vec3(M * glm::vec4(mesh.norms[idx[k]], 0.0f))), 0.0f);
+					}
+				}
+				BvhTriangle tri;
+				tri.v0 = glm::vec4(glm::vec3(v[0]), (float)mi);
+				tri.v1 = glm::vec4(glm::vec3(v[1]), 0.0f);
+				tri.v2 = glm::vec4(glm::vec3(v[2]), 0.0f);
+				tri.n0 = n[0];
+				tri.n1 = n[1];
+				tri.n2 = n[2];
+				tris.push_back(tri);
+			}
+		}
+
+		if (tris.empty()) {
+			LOG_DEBUG("core", "BVH: empty scene");
+			return;
+		}
+		// Con mas triangulos el indice de las hojas se solaparia con count y apuntaria a otros triangulos
+		if (tris.size() > MaxTriangles) {
+			LOG_ERROR("core", "BVH: %zu triangles exceed the %u addressable by the nodes, scene not built", tris.size(), MaxTriangles);
+			return;
+		}
+
+		uint32_t triCount = (uint32_t)tris.size();
+		m_triIndices.resize(triCount);
+		m_centroids.resize(triCount);
+		m_triMin.resize(triCount);
+		m_triMax.resize(triCount);
+		for (uint32_t i = 0; i < triCount; i++) {
+			glm::vec3 a = glm::vec3(tris[i].v0), b = glm::vec3(tris[i].v1), c = glm::vec3(tris[i].v2);
+			m_triIndices[i] = i;
+			m_triMin[i] = glm::min(a, glm::min(b, c));
+			m_triMax[i] = glm::max(a, glm::max(b, c));
+			m_centroids[i] = (a + b + c) / 3.0f;
+		}
+
+		// Los dos hijos de un nodo siempre quedan consecutivos
+		std::vector<BuildNode> nodes(2 * triCount);
+		uint32_t nodesUsed = 1;
+		nodes[0].leftFirst = 0;
+		nodes[0].count = triCount;
+		UpdateBounds(nodes[0]);
+		m_depth = 0;
+		Subdivide(0, nodes, nodesUsed, 0);
+
+		m_triangles.resize(triCount);
+		for (uint32_t i = 0; i < triCount; i++) {
+			m_triangles[i] = tris[m_triIndices[i]];
+		}
+		Quantize(nodes, nodesUsed);
+
+		m_triIndices.clear();
+		m_centroids.clear();
+		m_triMin.clear();
+		m_triMax.clear();
+
+		LOG_DEBUG("core", "BVH built: %u triangles, %u nodes (%zu bytes), depth %u", triCount, nodesUsed,
+			(size_t)nodesUsed * sizeof(BvhNode), m_depth);
+	}
+
+	void Bvh::UpdateBounds(BuildNode& node) const {
+		node.bmin = glm::vec3(FLT_MAX);
+		node.bmax = glm::vec3(-FLT_MAX);
+		for (uint32_t i = 0; i < node.count; i++) {
+			uint32_t t = m_triIndices[node.leftFirst + i];
+			node.bmin = glm::min(node.bmin, m_triMin[t]);
+			node.bmax = glm::max(node.bmax, m_triMax[t]);
+		}
+	}
+
+	float Bvh::FindBestSplit(const BuildNode& node, int& axis, float& splitPos) const {
+		float bestCost = FLT_MAX;
+		axis = -1;
+
+		glm::vec3 cmin(FLT_MAX), cmax(-FLT_MAX);
+		for (uint32_t i = 0; i < node.count; i++) {
+			const glm::vec3& c = m_centroids[m_triIndices[node.leftFirst + i]];
+			cmin = glm::min(cmin, c);
+			cmax = glm::max(cmax, c);
+		}
+
+		for (int a = 0; a < 3; a++) {
+			if (cmax[a] <= cmin[a]) {
+				continue;
+			}
+			glm::vec3 binMin[s_numBins], binMax[s_numBins];
+			uint32_t binCount[s_numBins] = {};
+			for (int b = 0; b < s_numBins; b++) {
+				binMin[b] = glm::vec3(FLT_MAX);
+				binMax[b] = glm::vec3(-FLT_MAX);
+			}
+
+			float scale = (float)s_numBins / (cmax[a] - cmin[a]);
+			for (uint32_t i = 0; i < node.count; i++) {
+				uint32_t t = m_triIndices[node.leftFirst + i];
+				int b = std::min(s_numBins - 1, (int)((m_centroids[t][a] - cmin[a]) * scale));
+				binCount[b]++;
+				binMin[b] = glm::min(binMin[b], m_triMin[t]);
+				binMax[b] = glm::max(binMax[b], m_triMax[t]);
+			}
+
+			// Barrido por la izquierda y por la derecha
+			float leftArea[s_numBins - 1], rightArea[s_numBins - 1];
+			uint32_t leftCount[s_numBins - 1], rightCount[s_numBins - 1];
+			glm::vec3 lmin(FLT_MAX), lmax(-FLT_MAX), rmin(FLT_MAX), rmax(-FLT_MAX);
+			uint32_t lsum = 0, rsum = 0;
+			for (int i = 0; i < s_numBins - 1; i++) {
+				lsum += binCount[i];
+				leftCount[i] = lsum;
+				lmin = glm::min(lmin, binMin[i]);
+				lmax = glm::max(lmax, binMax[i]);
+				leftArea[i] = lsum ? SurfaceArea(lmin, lmax) : 0.0f;
+
+				int r = s_numBins - 1 - i;
+				rsum += binCount[r];
+				rightCount[r - 1] = rsum;
+				rmin = glm::min(rmin, binMin[r]);
+				rmax = glm::max(rmax, binMax[r]);
+				rightArea[r - 1] = rsum ? SurfaceArea(rmin, rmax) : 0.0f;
+			}
+
+			for (int i = 0; i < s_numBins - 1; i++) {
+				if (leftCount[i] == 0 || rightCount[i] == 0) {
+					continue;
+				}
+				float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+				if (cost < bestCost) {
+					bestCost = cost;
+					axis = a;
+					splitPos = cmin[a] + (cmax[a] - cmin[a]) * (float)(i + 1) / (float)s_numBins;
+				}
+			}
+		}
+		return bestCost;
+	}
+
+	void Bvh::Subdivide(uint32_t nodeIdx, std::vector<BuildNode>& nodes, uint32_t& nodesUsed, uint32_t depth) {
+		BuildNode& node = nodes[nodeIdx];
+		m_depth = std::max(m_depth, depth);
+		if (node.count <= MaxLeafSize) {
+			return;
+		}
+		// Arbol SAH muy desequilibrado (geometria degenerada): se termina por la mediana para acotar la pila
+		bool sah = depth < MaxSahDepth;
+		if (!sah && node.count <= MaxLeafCount) {
+			return;
+		}
+		assert(depth < MaxStackDepth);
+
+		int axis = -1;
+		float splitPos = 0.0f;
+		float splitCost = sah ? FindBestSplit(node, axis, splitPos) : FLT_MAX;
+		float leafCost = node.count * SurfaceArea(node.bmin, node.bmax);
+
+		uint32_t first = node.leftFirst;
+		uint32_t last = node.leftFirst + node.count;
+		uint32_t mid = first;
+		if (axis >= 0 && splitCost < leafCost) {
+			uint32_t* begin = m_triIndices.data();
+			mid = (uint32_t)(std::partition(begin + first, begin + last,
+				[&](uint32_t t) { return m_centroids[t][axis] < splitPos; }) - begin);
+		}
+		else if (sah && node.count <= MaxLeafCount) {
+			// Dividir no sale a cuenta y la hoja cabe en los 4 bits de count
+			return;
+		}
+
+		// Sin particion util (centroides iguales, p.ej.) y hoja demasiado grande: mediana por indice
+		if (mid == first || mid == last) {
+			glm::vec3 extent = node.bmax - node.bmin;
+			int a = (extent.x > extent.y && extent.x > extent.z) ? 0 : (extent.y > extent.z ? 1 : 2);
+			mid = first + node.count / 2;
+			std::nth_element(m_triIndices.begin() + first, m_triIndices.begin() + mid, m_triIndices.begin() + last,
+				[&](uint32_t l, uint32_t r) { return m_centroids[l][a] < m_centroids[r][a]; });
+		}
+
+		uint32_t leftIdx = nodesUsed;
+		nodesUsed += 2;
+		nodes[leftIdx].leftFirst = first;
+		nodes[leftIdx].count = mid - first;
+		nodes[leftIdx + 1].leftFirst = mid;
+		nodes[leftIdx + 1].count = last - mid;
+		node.leftFirst = leftIdx;
+		node.count = 0;
+
+		UpdateBounds(nodes[leftIdx]);
+		UpdateBounds(nodes[leftIdx + 1]);
+		Subdivide(leftIdx, nodes, nodesUsed, depth + 1);
+		Subdivide(leftIdx + 1, nodes, nodesUsed, depth + 1);
+	}
+
+	void Bvh::Quantize(const std::vector<BuildNode>& nodes, uint32_t nodesUsed) {
+		glm::vec3 sceneMin = nodes[0].bmin;
+		glm::vec3 extent = glm::max(nodes[0].bmax - sceneMin, glm::vec3(1e-6f));
+		m_boundsMin = sceneMin;
+		m_quantScale = extent / 65535.0f;
+
+		m_nodes.resize(nodesUsed);
+		for (uint32_t i = 0; i < nodesUsed; i++) {
+			const BuildNode& n = nodes[i];
+			// Redondeo hacia fuera y un paso de margen: la caja cuantizada siempre contiene a la original
+			glm::vec3 qmin = glm::floor((n.bmin - sceneMin) / extent * 65535.0f) - 1.0f;
+			glm::vec3 qmax = glm::ceil((n.bmax - sceneMin) / extent * 65535.0f) + 1.0f;
+			qmin = glm::clamp(qmin, glm::vec3(0.0f), glm::vec3(65535.0f));
+			qmax = glm::clamp(qmax, glm::vec3(0.0f), glm::vec3(65535.0f));
+
+			BvhNode& q = m_nodes[i];
+			q.minXY = (uint32_t)qmin.x | ((uint32_t)qmin.y << 16);
+			q.minZmaxX = (uint32_t)qmin.z | ((uint32_t)qmax.x << 16);
+			q.maxYZ = (uint32_t)qmax.y | ((uint32_t)qmax.z << 16);
+			q.indexCount = (n.leftFirst & 0x0FFFFFFFu) | (n.count << 28);
+		}
+	}
+
+	void Bvh::DequantizeNode(const BvhNode& node, glm::vec3& bmin, glm::vec3& bmax) const {
+		glm::vec3 qmin((float)(node.minXY & 0xFFFF), (float)(node.minXY >> 16), (float)(node.minZmaxX & 0xFFFF));
+		glm::vec3 qmax((float)(node.minZmaxX >> 16), (float)(node.maxYZ & 0xFFFF), (float)(node.maxYZ >> 16));
+		bmin = m_boundsMin + qmin * m_quantScale;
+		bmax = m_boundsMin + qmax * m_quantScale;
+	}
+
+	// Mismo recorrido que traverse() en raytrace_soft.comp: pila, hijo mas cercano primero
+	bool Bvh::intersect(const glm::vec3& origin, const glm::vec3& dir, float tmin, float tmax, BvhHit& hit) const {
+		if (m_nodes.empty()) {
+			return false;
+		}
+		glm::vec3 invDir = 1.0f / dir;
+		float closest = tmax;
+		bool found = false;
+
+		glm::vec3 bmin, bmax;
+		DequantizeNode(m_nodes[0], bmin, bmax);
+		if (IntersectAabb(bmin, bmax, origin, invDir, tmin, closest) == FLT_MAX) {
+			return false;
+		}
+
+		uint32_t stack[MaxStackDepth];
+		uint32_t sp = 0;
+		uint32_t nodeIdx = 0;
+		while (true) {
+			const BvhNode& node = m_nodes[nodeIdx];
+			uint32_t index = node.indexCount & 0x0FFFFFFFu;
+			uint32_t count = node.indexCount >> 28;
+
+			if (count > 0) {
+				for (uint32_t i = index; i < index + count; i++) {
+					float t, u, v;
+					if (IntersectTriangle(m_triangles[i], origin, dir, tmin, closest, t, u, v)) {
+						closest = t;
+						hit.t = t;
+						hit.triangle = i;
+						hit.u = u;
+						hit.v = v;
+						found = true;
+					}
+				}
+				if (sp == 0) {
+					break;
+				}
+				nodeIdx = stack[--sp];
+				continue;
+			}
+
+			uint32_t nearIdx = index, farIdx = index + 1;
+			DequantizeNode(m_nodes[nearIdx], bmin, bmax);
+			float dNear = IntersectAabb(bmin, bmax, origin, invDir, tmin, closest);
+			DequantizeNode(m_nodes[farIdx], bmin, bmax);
+			float dFar = IntersectAabb(bmin, bmax, origin, invDir, tmin, closest);
+			if (dFar < dNear) {
+				std::swap(nearIdx, farIdx);
+				std::swap(dNear, dFar);
+			}
+
+			if (dNear == FLT_MAX) {
+				if (sp == 0) {
+					break;
+				}
+				nodeIdx = stack[--sp];
+				continue;
+			}
+			nodeIdx = nearIdx;
+			if (dFar != FLT_MAX) {
+				// Una entrada por nivel como mucho: build() deja todas las hojas a MaxStackDepth o menos
+				assert(sp < MaxStackDepth);
+				stack[sp++] = farIdx;
+			}
+		}
+		return found;
+	}
+}
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <cfloat>
+
+#include "core/core_cluster.h"
+#include "Trace.h"
+#include "Log.h"
+
+namespace core {
+
+	namespace {
+		// Divide order[first, first + count) hasta que cada parte cabe en un cluster. La parte izquierda siempre es
+		// un multiplo de ClusterTriangles, asi que el unico cluster incompleto es el ultimo
+		void Split(std::vector<uint32_t>& order, const std::vector<glm::vec3>& centroids, size_t first, size_t count) {
+			if (count <= MeshClusters::ClusterTriangles) {
+				return;
+			}
+			glm::vec3 cmin(FLT_MAX), cmax(-FLT_MAX);
+			for (size_t i = first; i < first + count; i++) {
+				cmin = glm::min(cmin, centroids[order[i]]);
+				cmax = glm::max(cmax, centroids[order[i]]);
+			}
+			glm::vec3 extent = cmax - cmin;
+			int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+			size_t clusters = (count + MeshClusters::ClusterTriangles - 1) / MeshClusters::ClusterTriangles;
+			size_t left = (clusters / 2) * MeshClusters::ClusterTriangles;
+			std::nth_element(order.begin() + first, order.begin() + first + left, order.begin() + first + count,
+				[&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+			Split(order, centroids, first, left);
+			Split(order, centroids, first + left, count - left);
+		}
+	}
+
+	uint32_t MeshClusters::Reorder(const std::vector<glm::vec3>& verts, std::vector<uint32_t>& inds) {
+		// Indices sueltos al final: el reordenado los perderia, asi que la malla se deja como esta
+		if (inds.size() % 3 != 0) {
+			LOG_ERROR("core", "Mesh with %zu indices is not a triangle list, not split into clusters", inds.size());
+			return 1;
+		}
+		size_t triCount = inds.size() / 3;
+		if (triCount <= ClusterTriangles) {
+			return 1;
+		}
+		TRACE_SCOPE("clusterMesh", "core");
+
+		std::vector<glm::vec3> centroids(triCount, glm::vec3(0.0f));
+		for (size_t t = 0; t < triCount; t++) {
+			uint32_t a = inds[t * 3], b = inds[t * 3 + 1], c = inds[t * 3 + 2];
+			if (a < verts.size() && b < verts.size() && c < verts.size()) {
+				centroids[t] = (verts[a] + verts[b] + verts[c]) / 3.0f;
+			}
+		}
+		std::vector<uint32_t> order(triCount);
+		for (size_t t = 0; t < triCount; t++) {
+			order[t] = (uint32_t)t;
+		}
+		Split(order, centroids, 0, triCount);
+
+		uint32_t clusters = Count(triCount);
+		std::vector<uint32_t> sorted(triCount * 3);
+		for (uint32_t c = 0; c < clusters; c++) {
+			size_t first = (size_t)c * ClusterTriangles;
+			size_t last = std::min(first + ClusterTriangles, triCount);
+			std::sort(order.begin() + first, order.begin() + last);
+			for (size_t i = first; i < last; i++) {
+				sorted[i * 3] = inds[(size_t)order[i] * 3];
+				sorted[i * 3 + 1] = inds[(size_t)order[i] * 3 + 1];
+				sorted[i * 3 + 2] = inds[(size_t)order[i] * 3 + 2];
+			}
+		}
+		inds.swap(sorted);
+		LOG_DEBUG("core", "Mesh of %zu triangles split into %u clusters", triCount, clusters);
+		return clusters;
+	}
+}
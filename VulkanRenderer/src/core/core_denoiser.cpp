@@ -0,0 +1,348 @@
+#include <stdio.h>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "core/core_denoiser.h"
+#include "Log.h"
+
+namespace core {
+
+#pragma region CPU
+
+	// Pesos del spline B3 para |offset| = 0, 1, 2
+	static const float s_atrousKernel[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+	static float QuantizeUnorm8(float v) {
+		v = std::min(1.0f, std::max(0.0f, v));
+		return std::round(v * 255.0f) / 255.0f;
+	}
+
+	void AtrousDenoiseCPU(const std::vector<glm::vec4>& color, const std::vector<glm::vec4>& normalDepth,
+		int width, int height, const DenoiseSettings& settings, std::vector<glm::vec4>& result) {
+
+		size_t pixelCount = (size_t)width * (size_t)height;
+		if (color.size() < pixelCount || normalDepth.size() < pixelCount) {
+			LOG_ERROR("core", "AtrousDenoiseCPU: buffers smaller than %dx%d", width, height);
+			result = color;
+			return;
+		}
+
+		std::vector<glm::vec4> src(color.begin(), color.begin() + pixelCount);
+		std::vector<glm::vec4> dst(pixelCount);
+
+		for (int it = 0; it < settings.iterations; it++) {
+			int stepWidth = 1 << it;
+			float sigmaColor = settings.sigmaColor / (float)stepWidth;
+
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+					size_t p = (size_t)y * width + x;
+					const glm::vec4& centerColor = src[p];
+					const glm::vec4& centerGuide = normalDepth[p];
+
+					// El fondo se copia sin filtrar
+					if (centerGuide.w < 0.0f) {
+						dst[p] = centerColor;
+						continue;
+					}
+
+					glm::vec3 sum(0.0f);
+					float weightSum = 0.0f;
+					float depthScale = settings.sigmaDepth * centerGuide.w * (float)stepWidth + 1e-4f;
+
+					for (int dy = -2; dy <= 2; dy++) {
+						for (int dx = -2; dx <= 2; dx++) {
+							int qx = x + dx * stepWidth;
+							int qy = y + dy * stepWidth;
+							if (qx < 0 || qy < 0 || qx >= width || qy >= height) {
+								continue;
+							}
+							size_t q = (size_t)qy * width + qx;
+							const glm::vec4& guide = normalDepth[q];
+							if (guide.w < 0.0f) {
+								continue;
+							}
+							glm::vec3 c = glm::vec3(src[q]);
+
+							glm::vec3 dc = c - glm::vec3(centerColor);
+							float wColor = std::exp(-glm::dot(dc, dc) / (sigmaColor * sigmaColor));
+							float wNormal = std::pow(std::max(glm::dot(glm::vec3(centerGuide), glm::vec3(guide)), 0.0f), settings.sigmaNormal);
+							float wDepth = std::exp(-std::fabs(guide.w - centerGuide.w) / depthScale);
+
+							float w = s_atrousKernel[std::abs(dx)] * s_atrousKernel[std::abs(dy)] * wColor * wNormal * wDepth;
+							sum += c * w;
+							weightSum += w;
+						}
+					}
+
+					glm::vec3 filtered = (weightSum > 0.0f) ? sum / weightSum : glm::vec3(centerColor);
+					// La imagen intermedia de la GPU es rgba8
+					dst[p] = glm::vec4(QuantizeUnorm8(filtered.r), QuantizeUnorm8(filtered.g), QuantizeUnorm8(filtered.b), centerColor.a);
+				}
+			}
+			std::swap(src, dst);
+		}
+
+		result = src;
+	}
+
+#pragma endregion
+
+#pragma region GPU
+
+	void Denoiser::init(VulkanCore* core, VkShaderModule compModule, int width, int height, VkPipelineStageFlags traceStage) {
+		m_vkcore = core;
+		m_device = core->GetDevice();
+		m_traceStage = traceStage;
+
+		m_vkcore->CreateTextureImage(m_tmpTexture, width, height, VK_FORMAT_R8G8B8A8_UNORM);
+		CreateDescriptorSets();
+		CreatePipeline(compModule);
+		LOG_DEBUG("core", "Denoiser created");
+	}
+
+	void Denoiser::CreateDescriptorSets() {
+		VkDescriptorPoolSize poolSize = {};
+		poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		poolSize.descriptorCount = 2 * 3; // entrada, guia y salida por cada sentido del ping-pong
+
+		VkDescriptorPoolCreateInfo PoolInfo = {};
+		PoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		PoolInfo.flags = 0;
+		PoolInfo.maxSets = 2;
+		PoolInfo.poolSizeCount = 1;
+		PoolInfo.pPoolSizes = &poolSize;
+
+		VkResult res = vkCreateDescriptorPool(m_device, &PoolInfo, NULL, &m_descPool);
+		CHECK_VK_RESULT(res, "vkCreateDescriptorPool");
+
+		std::vector<VkDescriptorSetLayoutBinding> LayoutBindings;
+		for (uint32_t i = 0; i < 3; i++) {
+			VkDescriptorSetLayoutBinding binding = {};
+			binding.binding = i;
+			binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			binding.descriptorCount = 1;
+			binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			LayoutBindings.push_back(binding);
+		}
+
+		VkDescriptorSetLayoutCreateInfo LayoutInfo = {};
+		LayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		LayoutInfo.bindingCount = (uint32_t)LayoutBindings.size();
+		LayoutInfo.pBindings = LayoutBindings.data();
+
+		res = vkCreateDescriptorSetLayout(m_device, &LayoutInfo, NULL, &m_descSetLayout);
+		CHECK_VK_RESULT(res, "vkCreateDescriptorSetLayout\n");
+
+		VkDescriptorSetLayout layouts[2] = { m_descSetLayout, m_descSetLayout };
+		VkDescriptorSetAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+		allocateInfo.descriptorPool = m_descPool;
+		allocateInfo.descriptorSetCount = 2;
+		allocateInfo.pSetLayouts = layouts;
+		res = vkAllocateDescriptorSets(m_device, &allocateInfo, m_descSets);
+		CHECK_VK_RESULT(res, "vkAllocateDescriptorSets");
+	}
+
+	void Denoiser::CreatePipeline(VkShaderModule compModule) {
+		VkPushConstantRange pushRange{};
+		pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushRange.offset = 0;
+		pushRange.size = sizeof(DenoisePushConstants);
+
+		VkPipelineLayoutCreateInfo layoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+		layoutInfo.setLayoutCount = 1;
+		layoutInfo.pSetLayouts = &m_descSetLayout;
+		layoutInfo.pushConstantRangeCount = 1;
+		layoutInfo.pPushConstantRanges = &pushRange;
+
+		VkResult res = vkCreatePipelineLayout(m_device, &layoutInfo, nullptr, &m_pipelineLayout);
+		CHECK_VK_RESULT(res, "vkCreatePipelineLayout");
+
+		VkPipelineShaderStageCreateInfo stage{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+		stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		stage.module = compModule;
+		stage.pName = "main";
+
+		VkComputePipelineCreateInfo pipelineInfo{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+		pipelineInfo.stage = stage;
+		pipelineInfo.layout = m_pipelineLayout;
+
+		res = vkCreateComputePipelines(m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline);
+		CHECK_VK_RESULT(res, "vkCreateComputePipelines");
+	}
+
+	void Denoiser::resize(int width, int height) {
+		if (m_device == VK_NULL_HANDLE) {
+			return;
+		}
+		m_tmpTexture.Destroy(m_device);
+		m_tmpTexture = VulkanTexture();
+		m_vkcore->CreateTextureImage(m_tmpTexture, width, height, VK_FORMAT_R8G8B8A8_UNORM);
+	}
+
+	void Denoiser::setImages(VulkanTexture* color, VulkanTexture* guide) {
+		if (m_descPool == VK_NULL_HANDLE) {
+			return;
+		}
+		m_color = color;
+
+		// Set 0: color -> tmp, set 1: tmp -> color
+		VkImageView inputs[2] = { color->m_view, m_tmpTexture.m_view };
+		VkImageView outputs[2] = { m_tmpTexture.m_view, color->m_view };
+
+		VkDescriptorImageInfo ImageInfos[2][3] = {};
+		std::vector<VkWriteDescriptorSet> WriteDescriptorSet;
+		for (int s = 0; s < 2; s++) {
+			VkImageView views[3] = { inputs[s], guide->m_view, outputs[s] };
+			for (uint32_t b = 0; b < 3; b++) {
+				ImageInfos[s][b].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+				ImageInfos[s][b].imageView = views[b];
+				ImageInfos[s][b].sampler = NULL;
+
+				VkWriteDescriptorSet wds = {};
+				wds.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				wds.dstSet = m_descSets[s];
+				wds.dstBinding = b;
+				wds.dstArrayElement = 0;
+				wds.descriptorCount = 1;
+				wds.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+				wds.pImageInfo = &ImageInfos[s][b];
+				WriteDescriptorSet.push_back(wds);
+			}
+		}
+
+		vkUpdateDescriptorSets(m_device, (uint32_t)WriteDescriptorSet.size(), WriteDescriptorSet.data(), 0, NULL);
+	}
+
+	/*
+	* Graba las iteraciones del filtro en cmdBuf. Se espera que el trazado ya este grabado en el mismo command buffer
+	* y que color y guia esten en GENERAL. El resultado queda en la imagen de color, en GENERAL
+	*/
+	void Denoiser::denoise(VkCommandBuffer cmdBuf, int width, int height, const DenoiseSettings& settings) {
+		if (!isReady() || m_color == nullptr || settings.iterations <= 0) {
+			return;
+		}
+
+		// El ray tracing escribe color y guia antes de que los lea el compute
+		VkMemoryBarrier rtToCompute{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		rtToCompute.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		rtToCompute.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		// tmp no conserva nada entre frames
+		VkImageMemoryBarrier tmpBarrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+		tmpBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		tmpBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		tmpBarrier.srcAccessMask = 0;
+		tmpBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		tmpBarrier.image = m_tmpTexture.m_image;
+		tmpBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+		vkCmdPipelineBarrier(cmdBuf, m_traceStage | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &rtToCompute, 0, nullptr, 1, &tmpBarrier);
+
+		vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+
+		uint32_t groupsX = (uint32_t)(width + 7) / 8;
+		uint32_t groupsY = (uint32_t)(height + 7) / 8;
+
+		for (int it = 0; it < settings.iterations; it++) {
+			DenoisePushConstants pc;
+			pc.width = width;
+			pc.height = height;
+			pc.stepWidth = 1 << it;
+			pc.sigmaColor = settings.sigmaColor / (float)pc.stepWidth;
+			pc.sigmaNormal = settings.sigmaNormal;
+			pc.sigmaDepth = settings.sigmaDepth;
+
+			vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout,
+				0, 1, &m_descSets[it % 2], 0, nullptr);
+			vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DenoisePushConstants), &pc);
+			vkCmdDispatch(cmdBuf, groupsX, groupsY, 1);
+
+			VkMemoryBarrier passBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+			passBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			passBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				0, 1, &passBarrier, 0, nullptr, 0, nullptr);
+		}
+
+		// Con un numero impar de iteraciones el resultado ha quedado en tmp
+		if (settings.iterations % 2 == 1) {
+			CopyTmpToColor(cmdBuf, width, height);
+		}
+
+		VkMemoryBarrier done{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		done.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		done.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &done, 0, nullptr, 0, nullptr);
+	}
+
+	void Denoiser::CopyTmpToColor(VkCommandBuffer cmdBuf, int width, int height) {
+		VkImageMemoryBarrier barriers[2] = {};
+		barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barriers[0].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barriers[0].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barriers[0].image = m_tmpTexture.m_image;
+		barriers[0].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+		barriers[1] = barriers[0];
+		barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barriers[1].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barriers[1].image = m_color->m_image;
+
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 2, barriers);
+
+		VkImageCopy region{};
+		region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.extent = { (uint32_t)width, (uint32_t)height, 1 };
+		vkCmdCopyImage(cmdBuf, m_tmpTexture.m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			m_color->m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		// Ambas vuelven a GENERAL
+		barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barriers[0].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barriers[0].dstAccessMask = 0;
+		barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 2, barriers);
+	}
+
+	void Denoiser::cleanup() {
+		if (m_device == VK_NULL_HANDLE) {
+			return;
+		}
+		if (m_pipeline != VK_NULL_HANDLE) {
+			vkDestroyPipeline(m_device, m_pipeline, nullptr);
+			m_pipeline = VK_NULL_HANDLE;
+		}
+		if (m_pipelineLayout != VK_NULL_HANDLE) {
+			vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+			m_pipelineLayout = VK_NULL_HANDLE;
+		}
+		if (m_descPool != VK_NULL_HANDLE) {
+			vkDestroyDescriptorPool(m_device, m_descPool, nullptr);
+			m_descPool = VK_NULL_HANDLE;
+		}
+		if (m_descSetLayout != VK_NULL_HANDLE) {
+			vkDestroyDescriptorSetLayout(m_device, m_descSetLayout, nullptr);
+			m_descSetLayout = VK_NULL_HANDLE;
+		}
+		m_tmpTexture.Destroy(m_device);
+		m_tmpTexture = VulkanTexture();
+		m_color = nullptr;
+		m_device = VK_NULL_HANDLE;
+	}
+
+#pragma endregion
+}
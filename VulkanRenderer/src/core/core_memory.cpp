@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <algorithm>
+
+#include "core/core_memory.h"
+#include "Log.h"
+
+namespace core {
+
+	MemoryTracker& MemoryTracker::Get() {
+		static MemoryTracker tracker;
+		return tracker;
+	}
+
+	void MemoryTracker::track(VkDeviceMemory mem, VkDeviceSize size, MemoryCategory category) {
+		if (mem == VK_NULL_HANDLE) {
+			return;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_allocations[mem] = { size, category };
+
+		MemoryCategoryStats& stats = m_stats[(int)category];
+		stats.deviceBytes += size;
+		stats.deviceAllocations++;
+		stats.devicePeakBytes = std::max(stats.devicePeakBytes, stats.deviceBytes);
+		m_deviceBytes += size;
+		m_devicePeakBytes = std::max(m_devicePeakBytes, m_deviceBytes);
+	}
+
+	void MemoryTracker::release(VkDeviceMemory mem) {
+		if (mem == VK_NULL_HANDLE) {
+			return;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_allocations.find(mem);
+		// Memoria que no paso por track() (swapchain, query pools...)
+		if (it == m_allocations.end()) {
+			return;
+		}
+		MemoryCategoryStats& stats = m_stats[(int)it->second.category];
+		stats.deviceBytes -= it->second.size;
+		stats.deviceAllocations--;
+		m_deviceBytes -= it->second.size;
+		m_allocations.erase(it);
+	}
+
+	void MemoryTracker::addHost(MemoryCategory category, int64_t bytes) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		MemoryCategoryStats& stats = m_stats[(int)category];
+		if (bytes < 0 && (uint64_t)(-bytes) > stats.hostBytes) {
+			LOG_WARN("core", "MemoryTracker: releasing more host memory than tracked in %s", CategoryName(category));
+			bytes = -(int64_t)stats.hostBytes;
+		}
+		stats.hostBytes += bytes;
+		stats.hostPeakBytes = std::max(stats.hostPeakBytes, stats.hostBytes);
+		m_hostBytes += bytes;
+		m_hostPeakBytes = std::max(m_hostPeakBytes, m_hostBytes);
+	}
+
+	MemoryCategoryStats MemoryTracker::get(MemoryCategory category) const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_stats[(int)category];
+	}
+
+	uint64_t MemoryTracker::deviceBytes() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_deviceBytes;
+	}
+
+	uint64_t MemoryTracker::devicePeakBytes() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_devicePeakBytes;
+	}
+
+	uint64_t MemoryTracker::hostBytes() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_hostBytes;
+	}
+
+	uint64_t MemoryTracker::hostPeakBytes() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_hostPeakBytes;
+	}
+
+	void MemoryTracker::resetPeaks() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (MemoryCategoryStats& stats : m_stats) {
+			stats.devicePeakBytes = stats.deviceBytes;
+			stats.hostPeakBytes = stats.hostBytes;
+		}
+		m_devicePeakBytes = m_deviceBytes;
+		m_hostPeakBytes = m_hostBytes;
+	}
+
+	const char* MemoryTracker::CategoryName(MemoryCategory category) {
+		switch (category) {
+		case MemoryCategory::Geometry: return "Geometry";
+		case MemoryCategory::AccelerationStructure: return "Acceleration structures";
+		case MemoryCategory::Scratch: return "Scratch";
+		case MemoryCategory::Staging: return "Staging";
+		case MemoryCategory::Textures: return "Textures";
+		case MemoryCategory::Output: return "Output";
+		case MemoryCategory::Other: return "Other";
+		default: return "Unknown";
+		}
+	}
+}
@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <vector>
+
+#include "core/core_profiler.h"
+#include "Log.h"
+
+namespace core {
+
+	void GpuProfiler::init(VulkanCore* core, uint32_t maxScopes) {
+		m_device = core->GetDevice();
+		m_maxScopes = maxScopes;
+
+		core::PhysicalDevice physDev = core->GetSelectedPhysicalDevice();
+		m_timestampPeriod = physDev.m_devProps.limits.timestampPeriod;
+
+		// Sin bits validos la cola no admite timestamps: el profiler queda desactivado
+		uint32_t validBits = 0;
+		uint32_t family = core->GetQueueFamily();
+		if (family < physDev.m_qFamilyProps.size()) {
+			validBits = physDev.m_qFamilyProps[family].timestampValidBits;
+		}
+		if (validBits == 0 || m_timestampPeriod <= 0.0f) {
+			LOG_WARN("core", "GpuProfiler: timestamps not supported on this queue, profiling disabled");
+			return;
+		}
+		m_validMask = (validBits >= 64) ? ~0ull : ((1ull << validBits) - 1);
+
+		VkQueryPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = m_maxScopes * 2;
+		VkResult res = vkCreateQueryPool(m_device, &poolInfo, nullptr, &m_queryPool);
+		CHECK_VK_RESULT(res, "vkCreateQueryPool\n");
+
+		m_scopeStages.reserve(m_maxScopes);
+		m_scopeClosed.reserve(m_maxScopes);
+		reset();
+		LOG_DEBUG("core", "GpuProfiler: %u scopes, %.3f ns per tick, %u valid bits", m_maxScopes, m_timestampPeriod, validBits);
+	}
+
+	void GpuProfiler::begin(VkCommandBuffer cmdBuf, GpuStage stage) {
+		if (!isEnabled()) {
+			return;
+		}
+		if (m_scopeStages.size() >= m_maxScopes) {
+			LOG_WARN("core", "GpuProfiler: out of scopes, call collect() after each submit");
+			return;
+		}
+		uint32_t scope = (uint32_t)m_scopeStages.size();
+		m_scopeStages.push_back(stage);
+		m_scopeClosed.push_back(false);
+		m_openScope[(int)stage] = (int)scope;
+
+		vkCmdResetQueryPool(cmdBuf, m_queryPool, scope * 2, 2);
+		vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, scope * 2);
+	}
+
+	void GpuProfiler::end(VkCommandBuffer cmdBuf, GpuStage stage) {
+		if (!isEnabled()) {
+			return;
+		}
+		int scope = m_openScope[(int)stage];
+		if (scope < 0) {
+			return;
+		}
+		m_openScope[(int)stage] = -1;
+		m_scopeClosed[scope] = true;
+		vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, scope * 2 + 1);
+	}
+
+	void GpuProfiler::collect() {
+		if (m_queryPool == VK_NULL_HANDLE || m_scopeStages.empty()) {
+			return;
+		}
+
+		uint32_t queryCount = (uint32_t)m_scopeStages.size() * 2;
+		std::vector<uint64_t> ticks(queryCount, 0);
+		VkResult res = vkGetQueryPoolResults(m_device, m_queryPool, 0, queryCount, ticks.size() * sizeof(uint64_t),
+			ticks.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+		if (res == VK_SUCCESS) {
+			double stageMs[(int)GpuStage::Count] = {};
+			bool stageSeen[(int)GpuStage::Count] = {};
+			for (size_t i = 0; i < m_scopeStages.size(); i++) {
+				if (!m_scopeClosed[i]) {
+					continue;
+				}
+				uint64_t start = ticks[i * 2] & m_validMask;
+				uint64_t stop = ticks[i * 2 + 1] & m_validMask;
+				uint64_t delta = (stop - start) & m_validMask;
+				int s = (int)m_scopeStages[i];
+				stageMs[s] += (double)delta * m_timestampPeriod * 1e-6;
+				stageSeen[s] = true;
+			}
+			for (int s = 0; s < (int)GpuStage::Count; s++) {
+				if (stageSeen[s]) {
+					Accumulate((GpuStage)s, stageMs[s]);
+				}
+			}
+		}
+		else {
+			LOG_ERROR("core", "GpuProfiler: vkGetQueryPoolResults error %d", res);
+		}
+
+		m_scopeStages.clear();
+		m_scopeClosed.clear();
+		for (int s = 0; s < (int)GpuStage::Count; s++) {
+			m_openScope[s] = -1;
+		}
+	}
+
+	void GpuProfiler::addCpuTime(GpuStage stage, double ms) {
+		if (!m_enabled) {
+			return;
+		}
+		Accumulate(stage, ms);
+	}
+
+	void GpuProfiler::Accumulate(GpuStage stage, double ms) {
+		GpuStageTiming& timing = m_timings[(int)stage];
+		timing.lastMs = ms;
+		timing.totalMs += ms;
+		timing.count++;
+	}
+
+	void GpuProfiler::reset() {
+		for (int s = 0; s < (int)GpuStage::Count; s++) {
+			m_timings[s] = GpuStageTiming();
+		}
+	}
+
+	const char* GpuProfiler::StageName(GpuStage stage) {
+		switch (stage) {
+		case GpuStage::BlasBuild:			return "BLAS build";
+		case GpuStage::TlasBuild:			return "TLAS build";
+		case GpuStage::DescriptorUpdate:	return "Descriptor update";
+		case GpuStage::TraceRays:			return "Trace rays";
+		case GpuStage::LayoutTransition:	return "Layout transitions";
+		case GpuStage::Readback:			return "Readback copy";
+		case GpuStage::SoftBvhBuild:		return "Software BVH build";
+		default:							return "Unknown";
+		}
+	}
+
+	void GpuProfiler::cleanup() {
+		if (m_queryPool != VK_NULL_HANDLE) {
+			vkDestroyQueryPool(m_device, m_queryPool, nullptr);
+			m_queryPool = VK_NULL_HANDLE;
+		}
+		m_scopeStages.clear();
+		m_scopeClosed.clear();
+	}
+}
@@ -1,5 +1,6 @@
 #include "core/core_queue.h"
 #include "core/core_wrapper.h"
+#include "Log.h"
 namespace core {
 
 	void VulkanQueue::Init(VkDevice Device, VkSwapchainKHR SwapChain, uint32_t QueueFamily, uint32_t QueueIndex) {
@@ -9,7 +10,7 @@ namespace core {
 
 		vkGetDeviceQueue(Device, QueueFamily, QueueIndex, &m_queue);
 
-		printf("Queue acquired\n");
+		LOG_DEBUG("core", "Queue acquired");
 
 		CreateSemaphores();
 	}
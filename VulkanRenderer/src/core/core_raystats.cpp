@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "core/core_raystats.h"
+#include "Log.h"
+
+namespace core {
+
+	void RayStatistics::init(VulkanCore* core, int width, int height, bool clockCost) {
+		m_vkcore = core;
+		m_device = core->GetDevice();
+		m_width = width;
+		m_height = height;
+		m_clockCost = clockCost;
+		// Primer frame sin historial: el rojo es un camino con todos los rebotes, o ~64k ciclos
+		m_costScale = clockCost ? 65536 : 3;
+
+		m_statsBuffer = m_vkcore->CreateBufferACC(sizeof(RayStatsCounters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Other);
+		m_vkcore->CreateTextureImage(m_heatmapTexture, width, height, VK_FORMAT_R8G8B8A8_UNORM);
+
+		CreateDescriptorSet();
+		reset();
+		LOG_DEBUG("core", "Ray statistics created (%s cost)", clockCost ? "shader clock" : "ray count");
+	}
+
+	void RayStatistics::CreateDescriptorSet() {
+		std::vector<VkDescriptorPoolSize> poolSizes = {
+			{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1},
+			{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1}
+		};
+
+		VkDescriptorPoolCreateInfo PoolInfo = {};
+		PoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		PoolInfo.flags = 0;
+		PoolInfo.maxSets = 1;
+		PoolInfo.poolSizeCount = (uint32_t)poolSizes.size();
+		PoolInfo.pPoolSizes = poolSizes.data();
+
+		VkResult res = vkCreateDescriptorPool(m_device, &PoolInfo, NULL, &m_descPool);
+		CHECK_VK_RESULT(res, "vkCreateDescriptorPool");
+
+		// Los contadores se escriben en raygen, closest hit y miss; el mapa de calor solo en raygen
+		VkDescriptorSetLayoutBinding LayoutBindings[2] = {};
+		LayoutBindings[0].binding = 0;
+		LayoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		LayoutBindings[0].descriptorCount = 1;
+		LayoutBindings[0].stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR;
+
+		LayoutBindings[1].binding = 1;
+		LayoutBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		LayoutBindings[1].descriptorCount = 1;
+		LayoutBindings[1].stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+
+		VkDescriptorSetLayoutCreateInfo LayoutInfo = {};
+		LayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		LayoutInfo.bindingCount = 2;
+		LayoutInfo.pBindings = LayoutBindings;
+
+		res = vkCreateDescriptorSetLayout(m_device, &LayoutInfo, NULL, &m_descSetLayout);
+		CHECK_VK_RESULT(res, "vkCreateDescriptorSetLayout\n");
+
+		VkDescriptorSetAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+		allocateInfo.descriptorPool = m_descPool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &m_descSetLayout;
+
+		res = vkAllocateDescriptorSets(m_device, &allocateInfo, &m_descSet);
+		CHECK_VK_RESULT(res, "vkAllocateDescriptorSets");
+
+		VkDescriptorBufferInfo BufferInfo = {};
+		BufferInfo.buffer = m_statsBuffer.m_buffer;
+		BufferInfo.offset = 0;
+		BufferInfo.range = sizeof(RayStatsCounters);
+
+		VkWriteDescriptorSet write = {};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_descSet;
+		write.dstBinding = 0;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		write.pBufferInfo = &BufferInfo;
+
+		vkUpdateDescriptorSets(m_device, 1, &write, 0, NULL);
+		WriteHeatmapDescriptor();
+	}
+
+	void RayStatistics::WriteHeatmapDescriptor() {
+		VkDescriptorImageInfo ImageInfo = {};
+		ImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		ImageInfo.imageView = m_heatmapTexture.m_view;
+		ImageInfo.sampler = NULL;
+
+		VkWriteDescriptorSet write = {};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_descSet;
+		write.dstBinding = 1;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		write.pImageInfo = &ImageInfo;
+
+		vkUpdateDescriptorSets(m_device, 1, &write, 0, NULL);
+	}
+
+	void RayStatistics::resize(int width, int height) {
+		if (m_descSet == VK_NULL_HANDLE) {
+			return;
+		}
+		m_heatmapTexture.Destroy(m_device);
+		m_heatmapTexture = VulkanTexture();
+		m_vkcore->CreateTextureImage(m_heatmapTexture, width, height, VK_FORMAT_R8G8B8A8_UNORM);
+		m_width = width;
+		m_height = height;
+		// El mapa anterior ya no corresponde a la salida
+		m_hasResults = false;
+		WriteHeatmapDescriptor();
+	}
+
+	void RayStatistics::reset() {
+		RayStatsCounters counters = {};
+		counters.costScale = std::max(1u, m_costScale);
+		counters.clockCost = m_clockCost ? 1 : 0;
+		m_statsBuffer.Update(m_device, &counters, sizeof(counters));
+	}
+
+	void RayStatistics::prepare(VkCommandBuffer cmdBuf) {
+		// Se reescribe entero en cada frame
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.image = m_heatmapTexture.m_image;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	void RayStatistics::collect() {
+		void* data = nullptr;
+		VkResult res = vkMapMemory(m_device, m_statsBuffer.m_mem, 0, sizeof(RayStatsCounters), 0, &data);
+		if (res != VK_SUCCESS) {
+			LOG_ERROR("core", "RayStatistics: error mapping the counters: %d", res);
+			return;
+		}
+		memcpy(&m_counters, data, sizeof(RayStatsCounters));
+		vkUnmapMemory(m_device, m_statsBuffer.m_mem);
+		m_hasResults = true;
+
+		// El siguiente mapa de calor se normaliza con el maximo de este frame
+		if (m_counters.maxCost > 0) {
+			m_costScale = m_counters.maxCost;
+		}
+	}
+
+	size_t RayStatistics::copyHeatmapBytes(uint8_t* buffer, size_t bufferSize, int width, int height) {
+		if (!buffer || !m_hasResults || width > m_width || height > m_height) {
+			return 0;
+		}
+		VkDeviceSize imageSize = (VkDeviceSize)width * height * 4;
+		if (bufferSize < imageSize) {
+			LOG_ERROR("core", "Buffer size insufficient. Required: %zu, Available: %zu", (size_t)imageSize, bufferSize);
+			return 0;
+		}
+
+		BufferMemory staging = m_vkcore->CreateBufferACC(imageSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Staging);
+
+		VkCommandBuffer cmdBuf;
+		m_vkcore->CreateCommandBuffer(1, &cmdBuf);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(cmdBuf, &beginInfo);
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.image = m_heatmapTexture.m_image;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkBufferImageCopy region{};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { (uint32_t)width, (uint32_t)height, 1 };
+		vkCmdCopyImageToBuffer(cmdBuf, m_heatmapTexture.m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			staging.m_buffer, 1, &region);
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkMemoryBarrier hostBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+			0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+		vkEndCommandBuffer(cmdBuf);
+
+		VulkanQueue* pQueue = m_vkcore->GetQueue();
+		pQueue->SubmitSync(cmdBuf);
+		pQueue->WaitIdle();
+		vkFreeCommandBuffers(m_device, m_vkcore->GetCommandPool(), 1, &cmdBuf);
+
+		size_t copied = 0;
+		void* data = nullptr;
+		if (vkMapMemory(m_device, staging.m_mem, 0, imageSize, 0, &data) == VK_SUCCESS) {
+			memcpy(buffer, data, (size_t)imageSize);
+			vkUnmapMemory(m_device, staging.m_mem);
+			copied = (size_t)imageSize;
+		}
+		staging.Destroy(m_device);
+		return copied;
+	}
+
+	void RayStatistics::cleanup() {
+		if (m_device == VK_NULL_HANDLE) {
+			return;
+		}
+		m_statsBuffer.Destroy(m_device);
+		m_heatmapTexture.Destroy(m_device);
+		if (m_descSetLayout != VK_NULL_HANDLE) {
+			vkDestroyDescriptorSetLayout(m_device, m_descSetLayout, nullptr);
+			m_descSetLayout = VK_NULL_HANDLE;
+		}
+		if (m_descPool != VK_NULL_HANDLE) {
+			vkDestroyDescriptorPool(m_device, m_descPool, nullptr);
+			m_descPool = VK_NULL_HANDLE;
+		}
+		m_descSet = VK_NULL_HANDLE;
+		m_hasResults = false;
+	}
+}
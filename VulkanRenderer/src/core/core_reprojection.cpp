@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <vector>
+
+#include "core/core_reprojection.h"
+#include "Log.h"
+
+namespace core {
+
+	void Reprojector::init(VulkanCore* core, VkShaderModule compModule) {
+		m_vkcore = core;
+		m_device = core->GetDevice();
+
+		CreateDescriptorSet();
+		CreatePipeline(compModule);
+		LOG_DEBUG("core", "Reprojector created");
+	}
+
+	void Reprojector::CreateDescriptorSet() {
+		const uint32_t numBindings = 7;
+
+		VkDescriptorPoolSize poolSize = {};
+		poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		poolSize.descriptorCount = numBindings;
+
+		VkDescriptorPoolCreateInfo PoolInfo = {};
+		PoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		PoolInfo.flags = 0;
+		PoolInfo.maxSets = 1;
+		PoolInfo.poolSizeCount = 1;
+		PoolInfo.pPoolSizes = &poolSize;
+
+		VkResult res = vkCreateDescriptorPool(m_device, &PoolInfo, NULL, &m_descPool);
+		CHECK_VK_RESULT(res, "vkCreateDescriptorPool");
+
+		// 0-2: historial (lectura), 3: profundidad, 4-6: resultado reproyectado
+		std::vector<VkDescriptorSetLayoutBinding> LayoutBindings;
+		for (uint32_t i = 0; i < numBindings; i++) {
+			VkDescriptorSetLayoutBinding binding = {};
+			binding.binding = i;
+			binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			binding.descriptorCount = 1;
+			binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			LayoutBindings.push_back(binding);
+		}
+
+		VkDescriptorSetLayoutCreateInfo LayoutInfo = {};
+		LayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		LayoutInfo.bindingCount = (uint32_t)LayoutBindings.size();
+		LayoutInfo.pBindings = LayoutBindings.data();
+
+		res = vkCreateDescriptorSetLayout(m_device, &LayoutInfo, NULL, &m_descSetLayout);
+		CHECK_VK_RESULT(res, "vkCreateDescriptorSetLayout\n");
+
+		VkDescriptorSetAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+		allocateInfo.descriptorPool = m_descPool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &m_descSetLayout;
+		res = vkAllocateDescriptorSets(m_device, &allocateInfo, &m_descSet);
+		CHECK_VK_RESULT(res, "vkAllocateDescriptorSets");
+	}
+
+	void Reprojector::CreatePipeline(VkShaderModule compModule) {
+		VkPushConstantRange pushRange{};
+		pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushRange.offset = 0;
+		pushRange.size = sizeof(ReprojectPushConstants);
+
+		VkPipelineLayoutCreateInfo layoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+		layoutInfo.setLayoutCount = 1;
+		layoutInfo.pSetLayouts = &m_descSetLayout;
+		layoutInfo.pushConstantRangeCount = 1;
+		layoutInfo.pPushConstantRanges = &pushRange;
+
+		VkResult res = vkCreatePipelineLayout(m_device, &layoutInfo, nullptr, &m_pipelineLayout);
+		CHECK_VK_RESULT(res, "vkCreatePipelineLayout");
+
+		VkPipelineShaderStageCreateInfo stage{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+		stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		stage.module = compModule;
+		stage.pName = "main";
+
+		VkComputePipelineCreateInfo pipelineInfo{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+		pipelineInfo.stage = stage;
+		pipelineInfo.layout = m_pipelineLayout;
+
+		res = vkCreateComputePipelines(m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline);
+		CHECK_VK_RESULT(res, "vkCreateComputePipelines");
+	}
+
+	void Reprojector::setImages(const ReprojectionImages& images) {
+		if (m_descSet == VK_NULL_HANDLE) {
+			return;
+		}
+		m_images = images;
+
+		VulkanTexture* textures[7] = { images.historyColor, images.historyGuide, images.historyPosition,
+			images.depth, images.color, images.normal, images.position };
+
+		VkDescriptorImageInfo ImageInfos[7] = {};
+		std::vector<VkWriteDescriptorSet> WriteDescriptorSet;
+		for (uint32_t b = 0; b < 7; b++) {
+			ImageInfos[b].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			ImageInfos[b].imageView = textures[b]->m_view;
+			ImageInfos[b].sampler = NULL;
+
+			VkWriteDescriptorSet wds = {};
+			wds.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			wds.dstSet = m_descSet;
+			wds.dstBinding = b;
+			wds.dstArrayElement = 0;
+			wds.descriptorCount = 1;
+			wds.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			wds.pImageInfo = &ImageInfos[b];
+			WriteDescriptorSet.push_back(wds);
+		}
+
+		vkUpdateDescriptorSets(m_device, (uint32_t)WriteDescriptorSet.size(), WriteDescriptorSet.data(), 0, NULL);
+	}
+
+	/*
+	* Graba la reproyeccion antes del trazado. El historial (color, guia y posicion) tiene que estar en GENERAL
+	* con el contenido del frame anterior. Deja profundidad, color, normal y posicion reproyectados en GENERAL
+	*/
+	void Reprojector::reproject(VkCommandBuffer cmdBuf, const glm::mat4& invViewProj, int srcWidth, int srcHeight, int dstWidth, int dstHeight) {
+		if (!isReady() || m_images.depth == nullptr) {
+			return;
+		}
+
+		// Profundidad y color se limpian en cada frame: a = 0 marca pixel sin reproyeccion
+		VkImageMemoryBarrier clearBarriers[2] = {};
+		clearBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		clearBarriers[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		clearBarriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		clearBarriers[0].srcAccessMask = 0;
+		clearBarriers[0].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		clearBarriers[0].image = m_images.depth->m_image;
+		clearBarriers[0].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		clearBarriers[1] = clearBarriers[0];
+		clearBarriers[1].image = m_images.color->m_image;
+
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 2, clearBarriers);
+
+		VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		VkClearColorValue farDepth = {};
+		farDepth.uint32[0] = 0xFFFFFFFFu;
+		vkCmdClearColorImage(cmdBuf, m_images.depth->m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &farDepth, 1, &range);
+		VkClearColorValue invalid = {};
+		vkCmdClearColorImage(cmdBuf, m_images.color->m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &invalid, 1, &range);
+
+		for (int i = 0; i < 2; i++) {
+			clearBarriers[i].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			clearBarriers[i].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+			clearBarriers[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			clearBarriers[i].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		}
+
+		// El historial lo escribieron el trazado y la copia del frame anterior
+		VkMemoryBarrier historyBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		historyBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		historyBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &historyBarrier, 0, nullptr, 2, clearBarriers);
+
+		vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+		vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &m_descSet, 0, nullptr);
+
+		ReprojectPushConstants pc;
+		pc.viewProj = glm::inverse(invViewProj);
+		pc.origin = invViewProj * glm::vec4(0, 0, 2, 1);
+		pc.srcWidth = srcWidth;
+		pc.srcHeight = srcHeight;
+		pc.dstWidth = dstWidth;
+		pc.dstHeight = dstHeight;
+
+		uint32_t groupsX = (uint32_t)(srcWidth + 7) / 8;
+		uint32_t groupsY = (uint32_t)(srcHeight + 7) / 8;
+
+		// Dos pasadas: la primera se queda con el impacto mas cercano por pixel destino, la segunda escribe sus datos
+		for (int pass = 0; pass < 2; pass++) {
+			pc.pass = pass;
+			vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ReprojectPushConstants), &pc);
+			vkCmdDispatch(cmdBuf, groupsX, groupsY, 1);
+
+			VkMemoryBarrier passBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+			passBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			passBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			// El resultado lo lee el raygen o, en el modo hibrido, raytrace_query.comp
+			VkPipelineStageFlags dstStage = (pass == 0) ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+				: VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dstStage,
+				0, 1, &passBarrier, 0, nullptr, 0, nullptr);
+		}
+	}
+
+	void Reprojector::cleanup() {
+		if (m_device == VK_NULL_HANDLE) {
+			return;
+		}
+		if (m_pipeline != VK_NULL_HANDLE) {
+			vkDestroyPipeline(m_device, m_pipeline, nullptr);
+			m_pipeline = VK_NULL_HANDLE;
+		}
+		if (m_pipelineLayout != VK_NULL_HANDLE) {
+			vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+			m_pipelineLayout = VK_NULL_HANDLE;
+		}
+		if (m_descPool != VK_NULL_HANDLE) {
+			vkDestroyDescriptorPool(m_device, m_descPool, nullptr);
+			m_descPool = VK_NULL_HANDLE;
+		}
+		if (m_descSetLayout != VK_NULL_HANDLE) {
+			vkDestroyDescriptorSetLayout(m_device, m_descSetLayout, nullptr);
+			m_descSetLayout = VK_NULL_HANDLE;
+		}
+		m_descSet = VK_NULL_HANDLE;
+		m_images = ReprojectionImages();
+		m_device = VK_NULL_HANDLE;
+	}
+}
@@ -1,7 +1,13 @@
 #include "core/core_rt.h"
+#include "core/core_cluster.h"
 #include "core/utils.h"
 #include "core/core_shader.h"
+#include "Trace.h"
+#include "Log.h"
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
 
 namespace core {
     //--------------------------------------------------------------------------------------------------
@@ -23,15 +29,91 @@ namespace core {
 
         m_cmdBufPool = pool;
         m_vkcore = core;
-        loadRayTracingFunctions();
+        m_software = !m_vkcore->IsRayTracingSupported();
+        // Sin las extensiones de ray tracing los punteros no existen, se traza por compute
+        if (!m_software) {
+            loadRayTracingFunctions();
+        }
         m_outTexture = new core::VulkanTexture();
-        createOutImage(800, 800, m_outTexture);
+        CreateFrameImages(m_outputWidth, m_outputHeight);
+        // Timestamps por etapa (se desactiva solo si la cola no los soporta)
+        m_profiler.init(m_vkcore);
+    }
+
+    // Imagenes del tamano de la salida: todas se escriben o se leen con las coordenadas del pixel de salida
+    void Raytracer::CreateFrameImages(int width, int height) {
+        createOutImage(width, height, m_outTexture);
+        // Acumulacion en float del mismo tamao que la salida
+        m_vkcore->CreateTextureImage(m_accumTexture, width, height, VK_FORMAT_R32G32B32A32_SFLOAT);
+        // Destino del trazado a resolucion reducida (resolucion dinamica)
+        m_vkcore->CreateTextureImage(m_scaledTexture, width, height, VK_FORMAT_R8G8B8A8_UNORM);
+        // Normal y distancia del primer impacto, guia del denoiser
+        m_vkcore->CreateTextureImage(m_guideTexture, width, height, VK_FORMAT_R32G32B32A32_SFLOAT);
+        // Reproyeccion temporal: posicion de los impactos, historial y resultado reproyectado
+        m_vkcore->CreateTextureImage(m_positionTexture, width, height, VK_FORMAT_R32G32B32A32_SFLOAT);
+        m_vkcore->CreateTextureImage(m_historyColor, width, height, VK_FORMAT_R8G8B8A8_UNORM);
+        m_vkcore->CreateTextureImage(m_reprojDepth, width, height, VK_FORMAT_R32_UINT);
+        m_vkcore->CreateTextureImage(m_reprojColor, width, height, VK_FORMAT_R8G8B8A8_UNORM);
+        m_vkcore->CreateTextureImage(m_reprojNormal, width, height, VK_FORMAT_R8G8B8A8_UNORM);
+        m_vkcore->CreateTextureImage(m_reprojPosition, width, height, VK_FORMAT_R32G32B32A32_SFLOAT);
+        // El raygen las tiene enlazadas aunque la reproyeccion este desactivada
+        m_vkcore->TransitionImageLayout(m_reprojColor.m_image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+        m_vkcore->TransitionImageLayout(m_reprojNormal.m_image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+        m_vkcore->TransitionImageLayout(m_reprojPosition.m_image, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+    }
+
+    void Raytracer::DestroyFrameImages() {
+        VulkanTexture* textures[] = { m_outTexture, &m_accumTexture, &m_scaledTexture, &m_guideTexture, &m_positionTexture,
+            &m_historyColor, &m_reprojDepth, &m_reprojColor, &m_reprojNormal, &m_reprojPosition };
+        for (VulkanTexture* tex : textures) {
+            tex->Destroy(*m_device);
+            *tex = VulkanTexture();
+        }
+    }
+
+    void Raytracer::setOutputResolution(int width, int height) {
+        if (width == m_outputWidth && height == m_outputHeight) {
+            return;
+        }
+        TRACE_SCOPE("setOutputResolution", "core");
+        // Las imagenes pueden seguir en uso por el ultimo submit
+        m_vkcore->GetQueue()->WaitIdle();
+        DestroyFrameImages();
+        m_outputWidth = width;
+        m_outputHeight = height;
+        CreateFrameImages(width, height);
+
+        if (m_denoiser.isReady()) {
+            m_denoiser.resize(width, height);
+        }
+        if (m_rayStats.isReady()) {
+            m_rayStats.resize(width, height);
+        }
+        if (m_reprojector.isReady()) {
+            SetReprojectionImages();
+        }
+        // Bindings 2-8 del set 0 (o las imagenes del trazado por software) apuntan a las imagenes nuevas
+        if (m_software) {
+            WriteTraceTarget(m_outTexture);
+        }
+        else if (m_rtDescSet != VK_NULL_HANDLE) {
+            WriteAccStructure();
+            m_denoiser.setImages(m_traceTarget, &m_guideTexture);
+        }
+
+        // Ni la acumulacion ni el historial tienen sentido con otro tamano
+        m_frameIndex = 0;
+        m_historyValid = false;
+        LOG_INFO("rt", "Output resolution %dx%d", width, height);
     }
 
 
     void Raytracer::initRayTracing(core::PhysicalDevice physdev, VkDevice* dev)
     {
         m_device = dev;
+        if (!physdev.m_rayTracingSupported) {
+            return;
+        }
         // Requesting ray tracing properties
         VkPhysicalDeviceProperties2 prop2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
         prop2.pNext = &m_rtProperties;
@@ -81,12 +163,18 @@ namespace core {
         offset.primitiveOffset = 0;
         offset.transformOffset = 0;
 
-        // Our blas is made from only one geometry, but could be made of many geometries
-  
-        input.asGeometry.emplace_back(asGeom);
-        input.asBuildOffsetInfo.emplace_back(offset);
-        
-        printf("BLAS created for %d triangles\n", maxPrimitiveCount);
+        // Una geometria por cluster sobre los mismos buffers (un rango del buffer de indices cada una); sin clusters
+        // una sola geometria con toda la malla. Los shaders suman gl_GeometryIndexEXT * ClusterTriangles
+        uint32_t geometries = model.clustered ? core::MeshClusters::Count(maxPrimitiveCount) : 1;
+        for (uint32_t g = 0; g < geometries; g++) {
+            uint32_t first = g * core::MeshClusters::ClusterTriangles;
+            offset.primitiveOffset = first * 3 * sizeof(uint32_t);
+            offset.primitiveCount = (g + 1 < geometries) ? core::MeshClusters::ClusterTriangles : maxPrimitiveCount - first;
+            input.asGeometry.emplace_back(asGeom);
+            input.asBuildOffsetInfo.emplace_back(offset);
+        }
+
+        LOG_DEBUG("rt", "BLAS input for %u triangles in %u geometries", maxPrimitiveCount, geometries);
 
         return input;
     }
@@ -94,20 +182,18 @@ namespace core {
     // Tambin necesitars actualizar tu mtodo createBottomLevelAS:
     void Raytracer::createBottomLevelAS(std::vector<core::SimpleMesh> meshes) {
         // BLAS - Storing each primitive in a geometry
-        m_blas.clear();
+        ReleaseBlas();
         allBlas.clear();
         allBlas.reserve(meshes.size());
 
         colors.clear();
 
-        printf("\n");
-
         for (const core::SimpleMesh& obj : meshes) {
             //Da error aqui
             auto blas = objectToVkGeometryKHR(obj);
             allBlas.emplace_back(blas);
             colors.push_back(glm::vec4(obj.color.r,obj.color.g,obj.color.g,1.0f));
-            printf("color en createBLAS: %f %f %f\n", obj.color.r, obj.color.g, obj.color.b);
+            LOG_DEBUG("rt", "BLAS %zu color: %f %f %f", allBlas.size() - 1, obj.color.r, obj.color.g, obj.color.b);
         }
 
         //printf("size of allblas: %d\n", allBlas.size());
@@ -119,7 +205,60 @@ namespace core {
         buildBlas(allBlas, VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR);
     }
 
-    void Raytracer::buildBlas(std::vector<core::BlasInput>& input, VkBuildAccelerationStructureFlagsKHR flags) {
+    void Raytracer::appendBottomLevelAS(const std::vector<core::SimpleMesh>& meshes, size_t first) {
+        if (first >= meshes.size()) {
+            return;
+        }
+        std::vector<core::BlasInput> inputs;
+        inputs.reserve(meshes.size() - first);
+        for (size_t i = first; i < meshes.size(); i++) {
+            inputs.emplace_back(objectToVkGeometryKHR(meshes[i]));
+            allBlas.push_back(inputs.back());
+        }
+        buildBlas(inputs, VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR, true);
+    }
+
+    void Raytracer::removeBottomLevelAS(size_t index) {
+        if (index >= m_blas.size()) {
+            return;
+        }
+        if (m_blas[index].handle != VK_NULL_HANDLE) {
+            vkDestroyAccelerationStructureKHR(*m_device, m_blas[index].handle, nullptr);
+        }
+        m_blas[index].buffer.Destroy(*m_device);
+        m_blas.erase(m_blas.begin() + index);
+        if (index < allBlas.size()) {
+            allBlas[index].m_transBuffer.Destroy(*m_device);
+            allBlas.erase(allBlas.begin() + index);
+        }
+    }
+
+    void Raytracer::rebuildBottomLevelAS(const std::vector<core::SimpleMesh>& meshes, const std::vector<size_t>& indices) {
+        std::vector<core::BlasInput> inputs;
+        inputs.reserve(indices.size());
+        for (size_t i : indices) {
+            inputs.emplace_back(objectToVkGeometryKHR(meshes[i]));
+        }
+        // Las nuevas se construyen detras de las existentes y despues ocupan el sitio de las que sustituyen
+        size_t first = m_blas.size();
+        buildBlas(inputs, VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR, true);
+        for (size_t k = 0; k < indices.size(); k++) {
+            size_t index = indices[k];
+            if (m_blas[index].handle != VK_NULL_HANDLE) {
+                vkDestroyAccelerationStructureKHR(*m_device, m_blas[index].handle, nullptr);
+            }
+            m_blas[index].buffer.Destroy(*m_device);
+            m_blas[index] = m_blas[first + k];
+            if (index < allBlas.size()) {
+                allBlas[index].m_transBuffer.Destroy(*m_device);
+                allBlas[index] = inputs[k];
+            }
+        }
+        m_blas.resize(first);
+    }
+
+    void Raytracer::buildBlas(std::vector<core::BlasInput>& input, VkBuildAccelerationStructureFlagsKHR flags, bool append) {
+        TRACE_SCOPE("buildBlas", "core");
         uint32_t nbBlas = static_cast<uint32_t>(input.size());
         VkDeviceSize maxScratchSize{ 0 };
 
@@ -142,13 +281,17 @@ namespace core {
 
 
         core::BufferMemory blasScratchBuffer = m_vkcore[0].CreateBufferBlas(maxScratchSize, VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, MemoryCategory::Scratch);
 
         // Obtener la direccin del device del buffer de scratch
         VkDeviceAddress scratchAddress = GetBufferDeviceAddress(*m_device, blasScratchBuffer.m_buffer);
-        m_blas.clear();
+        // Al anadir se conservan las BLAS ya construidas y las nuevas van detras
+        size_t base = append ? m_blas.size() : 0;
+        if (!append) {
+            ReleaseBlas();
+        }
         // 3. Crear y construir cada BLAS
-        m_blas.resize(nbBlas);
+        m_blas.resize(base + nbBlas);
 
         for (uint32_t idx = 0; idx < nbBlas; idx++) {
             // Crear buffer para almacenar la acceleration structure
@@ -156,7 +299,7 @@ namespace core {
 
             core::BufferMemory asBuffer = m_vkcore[0].CreateBufferBlas(buildSizes[idx].accelerationStructureSize,
                 VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::AccelerationStructure);
 
             // Crear la acceleration structure
             VkAccelerationStructureCreateInfoKHR createInfo = {};
@@ -183,7 +326,7 @@ namespace core {
             addressInfo.accelerationStructure = accelerationStructure;
             blas.address = vkGetAccelerationStructureDeviceAddressKHR(*m_device, &addressInfo);
 
-            m_blas[idx] = blas;
+            m_blas[base + idx] = blas;
 
             // 4. Construir la acceleration structure
             VkCommandBufferAllocateInfo allocInfo = {};
@@ -199,6 +342,7 @@ namespace core {
             beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
             beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
             vkBeginCommandBuffer(commandBuffer, &beginInfo);
+            m_profiler.begin(commandBuffer, GpuStage::BlasBuild);
 
             // Configurar la informacin de construccin
             buildAs[idx].buildInfo.dstAccelerationStructure = accelerationStructure;
@@ -224,6 +368,7 @@ namespace core {
                 VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
                 0, 1, &barrier, 0, nullptr, 0, nullptr);
 
+            m_profiler.end(commandBuffer, GpuStage::BlasBuild);
             vkEndCommandBuffer(commandBuffer);
 
             // Submit y esperar
@@ -237,15 +382,16 @@ namespace core {
 
             m_pQueue->SubmitSync(commandBuffer);
             m_pQueue->WaitIdle();
+            m_profiler.collect();
 
             // Liberar command buffer
             vkFreeCommandBuffers(*m_device, m_cmdBufPool, 1, &commandBuffer);
         }
 
-        printf("Tamao m_blas: %d", m_blas.size());
+        LOG_DEBUG("rt", "%u BLAS built (%zu in total)", nbBlas, m_blas.size());
 
         // 5. Limpiar buffer de scratch
-        vkDestroyBuffer(*m_device, blasScratchBuffer.m_buffer, NULL);
+        blasScratchBuffer.Destroy(*m_device);
 
     }
 
@@ -264,8 +410,9 @@ namespace core {
     {
         std::vector<VkAccelerationStructureInstanceKHR> instances;
 
-        printf("\n=== DEBUG TLAS CREATION ===\n");
-        printf("Number of BLAS: %zu\n", m_blas.size());
+        LOG_DEBUG("rt", "Creating TLAS over %zu BLAS", m_blas.size());
+        // Una linea por instancia: se comprueba una vez fuera del bucle
+        bool logInstances = logging::isEnabled(logging::Level::Debug, "rt");
         // Crear instancia para cada BLAS
         for (size_t i = 0; i < m_blas.size(); i++) {
             VkAccelerationStructureInstanceKHR instance{};
@@ -278,14 +425,11 @@ namespace core {
             instance.instanceShaderBindingTableRecordOffset = 0; // Offset en la shader binding table para hit shaders
             instances.push_back(instance);
 
-            printf("Instance %zu:\n", i);
-            printf("  instanceCustomIndex = %u\n", instance.instanceCustomIndex);
-            printf("  accelerationStructureReference = 0x%llx\n", instance.accelerationStructureReference);
-            printf("  mask = 0x%02x\n", instance.mask);
-            printf("  flags = 0x%08x\n", instance.flags);
-            printf("\n");
+            if (logInstances) {
+                LOG_DEBUG("rt", "Instance %zu: customIndex %u, BLAS 0x%llx, mask 0x%02x, flags 0x%08x", i,
+                    instance.instanceCustomIndex, (unsigned long long)instance.accelerationStructureReference, instance.mask, instance.flags);
+            }
         }
-        printf("\n%zd instances pre build\n", instances.size());
 
         buildTlas(instances, VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR);
     }
@@ -293,16 +437,20 @@ namespace core {
     void Raytracer::buildTlas(const std::vector<VkAccelerationStructureInstanceKHR>& instances,
         VkBuildAccelerationStructureFlagsKHR flags)
     {
+        TRACE_SCOPE("buildTlas", "core");
         // 1. Crear buffer para las instancias
         VkDeviceSize instanceBufferSize = instances.size() * sizeof(VkAccelerationStructureInstanceKHR);
 
+        // La TLAS anterior ya no se usa: las construcciones esperan a la cola
+        ReleaseTlas();
         m_instBuffer = m_vkcore[0].CreateBufferBlas(
             instanceBufferSize,
             VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
             VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
-            VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
+            VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+            MemoryCategory::AccelerationStructure
         );
 
         // 2. Copiar datos de instancias al buffer
@@ -318,7 +466,7 @@ namespace core {
         instancesVk.arrayOfPointers = VK_FALSE;
         instancesVk.data.deviceAddress = GetBufferDeviceAddress(*m_device, m_instBuffer.m_buffer);
 
-        printf("Building TLAS\n");
+        LOG_DEBUG("rt", "Building TLAS");
 
         // 4. Configurar la geometra
         VkAccelerationStructureGeometryKHR topASGeometry{
@@ -348,7 +496,8 @@ namespace core {
         core::BufferMemory scratchBuffer = m_vkcore[0].CreateBufferBlas(
             sizeInfo.buildScratchSize,
             VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+            MemoryCategory::Scratch
         );
         VkDeviceAddress scratchAddress = GetBufferDeviceAddress(*m_device, scratchBuffer.m_buffer);
 
@@ -357,7 +506,8 @@ namespace core {
             sizeInfo.accelerationStructureSize,
             VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
             VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            MemoryCategory::AccelerationStructure
         );
 
         // 9. Crear la acceleration structure
@@ -368,13 +518,13 @@ namespace core {
         createInfo.size = sizeInfo.accelerationStructureSize;
         createInfo.type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
 
-        printf("Creating AS\n");
+        LOG_DEBUG("rt", "Creating AS");
 
         VkResult result = vkCreateAccelerationStructureKHR(*m_device, &createInfo, nullptr, &m_tlas.handle);
         if (result != VK_SUCCESS) {
             throw std::runtime_error("Failed to create top level acceleration structure");
         }
-        printf("Created AS\n");
+        LOG_DEBUG("rt", "Created AS");
         m_tlas.buffer = tlasBuffer;
 
         // 10. Obtener la direccin de la TLAS
@@ -394,6 +544,7 @@ namespace core {
         };
         beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
         vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        m_profiler.begin(commandBuffer, GpuStage::TlasBuild);
 
         // Configurar la informacin de construccin
         buildData.buildInfo.dstAccelerationStructure = m_tlas.handle;
@@ -402,10 +553,10 @@ namespace core {
         // Preparar punteros a la informacin de rangos
         VkAccelerationStructureBuildRangeInfoKHR* pBuildRangeInfo = &buildData.rangeInfo[0];
 
-        printf("Building TLAS\n");
+        LOG_DEBUG("rt", "Building TLAS");
         // Construir la acceleration structure
         vkCmdBuildAccelerationStructuresKHR(commandBuffer, 1, &buildData.buildInfo, &pBuildRangeInfo);
-        printf("Built TLAS\n");
+        LOG_DEBUG("rt", "Built TLAS");
 
         // Aadir barrier
         VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
@@ -417,19 +568,20 @@ namespace core {
             VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
             0, 1, &barrier, 0, nullptr, 0, nullptr);
 
+        m_profiler.end(commandBuffer, GpuStage::TlasBuild);
         vkEndCommandBuffer(commandBuffer);
 
         // Submit y esperar
         core::VulkanQueue* pQueue = m_vkcore[0].GetQueue();
         pQueue->SubmitSync(commandBuffer);
         pQueue->WaitIdle();
+        m_profiler.collect();
 
         // Limpiar
         vkFreeCommandBuffers(*m_device, m_cmdBufPool, 1, &commandBuffer);
-        vkDestroyBuffer(*m_device, scratchBuffer.m_buffer, nullptr);
-        vkFreeMemory(*m_device, scratchBuffer.m_mem, nullptr);
+        scratchBuffer.Destroy(*m_device);
 
-        printf("TLAS created with %zd instances\n", instances.size());
+        LOG_DEBUG("rt", "TLAS created with %zd instances", instances.size());
     }
 
     VkAccelerationStructureBuildSizesInfoKHR AccelerationStructureBuildData::finalizeGeometry(VkDevice device, VkBuildAccelerationStructureFlagsKHR flags, PFN_vkGetAccelerationStructureBuildSizesKHR pfnGetBuildSizes)
@@ -467,12 +619,12 @@ namespace core {
 
     void Raytracer::createRtDescriptorSet() {
         CreateRtDescriptorPool(1);
-        printf("Creating RT descriptor set layout\n");
+        LOG_DEBUG("rt", "Creating RT descriptor set layout");
         CreateRtDescriptorSetLayout();
         //IMPORTANTE, A ESTE DESCRIPTOR SET SE LE DEBER AADIR EL OTRO DESCRIPTOR SET DE INFO GENERAL DE LA ESCENA PARA QUE VAYA OK :)
-        printf("Allocating RT Descriptor set\n");
+        LOG_DEBUG("rt", "Allocating RT Descriptor set");
         AllocateRtDescriptorSet();
-        printf("Writing RT Descriptor set\n");
+        LOG_DEBUG("rt", "Writing RT Descriptor set");
         WriteAccStructure();
     }
 
@@ -498,7 +650,7 @@ namespace core {
         // Pool para texturas
         VkDescriptorPoolSize samplerPoolSize = {};
         samplerPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        samplerPoolSize.descriptorCount = (uint32_t)NumImages;
+        samplerPoolSize.descriptorCount = (uint32_t)NumImages * 7; // salida + acumulacion + guia + posicion + 3 reproyectadas
         poolSizes.push_back(samplerPoolSize);
 
         VkDescriptorPoolCreateInfo PoolInfo = {};
@@ -513,7 +665,7 @@ namespace core {
 
         VkResult res = vkCreateDescriptorPool(*m_device, &PoolInfo, NULL, &m_rtDescPool);
         CHECK_VK_RESULT(res, "vkCreateDescriptorPool");
-        printf("Descriptor pool created\n");
+        LOG_DEBUG("rt", "Descriptor pool created");
 
     }
 
@@ -526,7 +678,8 @@ namespace core {
         AccStructureLayoutBinding_Uniform.descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
         AccStructureLayoutBinding_Uniform.descriptorCount = 1;
         //Obviamente si es necesario ampliar esto
-        AccStructureLayoutBinding_Uniform.stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+        // Compute: tambien lo usa raytrace_query.comp (modo hibrido)
+        AccStructureLayoutBinding_Uniform.stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT;
 
 
         LayoutBindings.push_back(AccStructureLayoutBinding_Uniform);
@@ -536,10 +689,32 @@ namespace core {
         FragmentShaderLayoutBinding.binding = 2;
         FragmentShaderLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
         FragmentShaderLayoutBinding.descriptorCount = 1;
-        FragmentShaderLayoutBinding.stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+        FragmentShaderLayoutBinding.stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT;
 
         LayoutBindings.push_back(FragmentShaderLayoutBinding);
 
+        // Imagen de acumulacion (rgba32f)
+        VkDescriptorSetLayoutBinding AccumLayoutBinding = {};
+        AccumLayoutBinding.binding = 3;
+        AccumLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        AccumLayoutBinding.descriptorCount = 1;
+        AccumLayoutBinding.stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT;
+
+        LayoutBindings.push_back(AccumLayoutBinding);
+
+        // Guia del denoiser (rgba32f)
+        VkDescriptorSetLayoutBinding GuideLayoutBinding = AccumLayoutBinding;
+        GuideLayoutBinding.binding = 4;
+
+        LayoutBindings.push_back(GuideLayoutBinding);
+
+        // Reproyeccion temporal: posicion (5), color (6), normal (7) y posicion (8) reproyectados
+        for (uint32_t binding = 5; binding <= 8; binding++) {
+            VkDescriptorSetLayoutBinding ReprojLayoutBinding = AccumLayoutBinding;
+            ReprojLayoutBinding.binding = binding;
+            LayoutBindings.push_back(ReprojLayoutBinding);
+        }
+
 
         VkDescriptorSetLayoutCreateInfo LayoutInfo = {};
         LayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -554,6 +729,7 @@ namespace core {
     }
 
     void Raytracer::UpdateAccStructure(){
+        auto updateStart = std::chrono::high_resolution_clock::now();
         std::vector<VkWriteDescriptorSet> WriteDescriptorSet;
         //solo hay un m_rtDescSet
         VkAccelerationStructureKHR tlas = m_tlas.handle;
@@ -570,7 +746,16 @@ namespace core {
         wds_t.pNext = &descASInfo;
         WriteDescriptorSet.push_back(wds_t);
 
+        // El set del render por lotes tambien apunta a la TLAS
+        if (m_batchRtDescSet != VK_NULL_HANDLE) {
+            VkWriteDescriptorSet wds_b = wds_t;
+            wds_b.dstSet = m_batchRtDescSet;
+            WriteDescriptorSet.push_back(wds_b);
+        }
+
         vkUpdateDescriptorSets(*m_device, (uint32_t)WriteDescriptorSet.size(), WriteDescriptorSet.data(), 0, NULL);
+        m_profiler.addCpuTime(GpuStage::DescriptorUpdate,
+            std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - updateStart).count());
     }
 
     void Raytracer::WriteAccStructure() {
@@ -604,6 +789,34 @@ namespace core {
         wds_i.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
         wds_i.pImageInfo = &ImageInfo;
         WriteDescriptorSet.push_back(wds_i);
+        m_traceTarget = m_outTexture;
+
+        VkDescriptorImageInfo AccumInfo = {};
+        AccumInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        AccumInfo.imageView = m_accumTexture.m_view;
+        AccumInfo.sampler = NULL;
+        VkWriteDescriptorSet wds_a = wds_i;
+        wds_a.dstBinding = 3;
+        wds_a.pImageInfo = &AccumInfo;
+        WriteDescriptorSet.push_back(wds_a);
+
+        VkDescriptorImageInfo GuideInfo = AccumInfo;
+        GuideInfo.imageView = m_guideTexture.m_view;
+        VkWriteDescriptorSet wds_g = wds_i;
+        wds_g.dstBinding = 4;
+        wds_g.pImageInfo = &GuideInfo;
+        WriteDescriptorSet.push_back(wds_g);
+
+        VulkanTexture* reprojTextures[4] = { &m_positionTexture, &m_reprojColor, &m_reprojNormal, &m_reprojPosition };
+        VkDescriptorImageInfo ReprojInfos[4] = {};
+        for (uint32_t i = 0; i < 4; i++) {
+            ReprojInfos[i] = AccumInfo;
+            ReprojInfos[i].imageView = reprojTextures[i]->m_view;
+            VkWriteDescriptorSet wds_r = wds_i;
+            wds_r.dstBinding = 5 + i;
+            wds_r.pImageInfo = &ReprojInfos[i];
+            WriteDescriptorSet.push_back(wds_r);
+        }
        
         vkUpdateDescriptorSets(*m_device, (uint32_t)WriteDescriptorSet.size(), WriteDescriptorSet.data(), 0, NULL);
     }
@@ -615,13 +828,13 @@ namespace core {
 
     void Raytracer::createMvpDescriptorSet() {
         CreateMvpDescriptorPool(1);
-        printf("Creating MVP descriptor set layout\n");
+        LOG_DEBUG("rt", "Creating MVP descriptor set layout");
         CreateMvpDescriptorSetLayout();
-        printf("Creating MVP Buffer\n");
+        LOG_DEBUG("rt", "Creating MVP Buffer");
         CreateMvpBuffer();
-        printf("Allocating MVP Descriptor set\n");
+        LOG_DEBUG("rt", "Allocating MVP Descriptor set");
         AllocateMvpDescriptorSet();
-        printf("Writing MVP Descriptor set\n");
+        LOG_DEBUG("rt", "Writing MVP Descriptor set");
         WriteMvpBuffer();
     }
     // Crear el pool de descriptores para MVP
@@ -643,7 +856,7 @@ namespace core {
 
         VkResult res = vkCreateDescriptorPool(*m_device, &PoolInfo, NULL, &m_mvpDescPool);
         CHECK_VK_RESULT(res, "vkCreateDescriptorPool MVP");
-        printf("MVP Descriptor pool created\n");
+        LOG_DEBUG("rt", "MVP Descriptor pool created");
     }
 
     // Crear el layout del descriptor set para MVP
@@ -655,7 +868,7 @@ namespace core {
         MvpLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         MvpLayoutBinding.descriptorCount = 1;
         // Puedes usar VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_RAYGEN_BIT_KHR dependiendo de dnde lo uses
-        MvpLayoutBinding.stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+        MvpLayoutBinding.stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT;
 
         LayoutBindings.push_back(MvpLayoutBinding);
 
@@ -688,10 +901,11 @@ namespace core {
         m_mvpBufferMemory = m_vkcore->CreateBufferACC(
             bufferSize,
             VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            MemoryCategory::Other
         );
 
-        printf("MVP Buffer created successfully\n");
+        LOG_DEBUG("rt", "MVP Buffer created successfully");
     }
 
     // Escribir/actualizar el buffer MVP
@@ -715,7 +929,11 @@ namespace core {
 
     // Mtodo para actualizar la matriz MVP en runtime
     void Raytracer::UpdateMvpMatrix(const glm::mat4& mvpMatrix) {
-        m_mvpBufferMemory.Update(*m_device, &mvpMatrix, sizeof(glm::mat4));
+        // El trazado por software recibe la matriz por push constants
+        if (m_mvpBufferMemory.m_mem) {
+            m_mvpBufferMemory.Update(*m_device, &mvpMatrix, sizeof(glm::mat4));
+        }
+        m_invViewProj = mvpMatrix;
     }
 #pragma endregion
 
@@ -723,10 +941,14 @@ namespace core {
 
     void Raytracer::createGeometryDescriptorSet( int maxsize) {
         m_maxsize = maxsize;
+        // Las texturas no dependen del numero de instancias: su array conserva el tamano inicial al crecer el set
+        if (m_maxTextures == 0) {
+            m_maxTextures = maxsize;
+        }
         CreateGeometryDescriptorPool(maxsize);
-        printf("Creating Geometry layout\n");
+        LOG_DEBUG("rt", "Creating Geometry layout");
         CreateGeometryDescriptorSetLayout(maxsize);
-        printf("Allocating layout\n");
+        LOG_DEBUG("rt", "Allocating layout");
         AllocateGeometryDescriptorSet();
 
     }
@@ -735,7 +957,7 @@ namespace core {
         // Por cada mesh: vertex buffer + index buffer + normal buffer + texture index buffer + color + texture sampler
         std::vector<VkDescriptorPoolSize> poolSizes = {
             {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, static_cast<uint32_t>(numMeshes * 5)}, // vertex, index, normal, texture index, color
-            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, static_cast<uint32_t>(numMeshes)} // texturas
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, static_cast<uint32_t>(m_maxTextures)} // texturas
         };
 
         VkDescriptorPoolCreateInfo poolInfo{};
@@ -752,13 +974,14 @@ namespace core {
 
     void Raytracer::CreateGeometryDescriptorSetLayout(int maxsize) {
         std::vector<VkDescriptorSetLayoutBinding> bindings;
+        // Compute: raytrace_query.comp lee la geometria igual que el closest hit
 
         // Binding 0: Array de vertex buffers
         VkDescriptorSetLayoutBinding vertexBinding{};
         vertexBinding.binding = 0;
         vertexBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         vertexBinding.descriptorCount = maxsize;
-        vertexBinding.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+        vertexBinding.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT;
         vertexBinding.pImmutableSamplers = nullptr;
         bindings.push_back(vertexBinding);
 
@@ -767,7 +990,7 @@ namespace core {
         indexBinding.binding = 1;
         indexBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         indexBinding.descriptorCount = maxsize;
-        indexBinding.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+        indexBinding.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT;
         indexBinding.pImmutableSamplers = nullptr;
         bindings.push_back(indexBinding);
 
@@ -776,7 +999,7 @@ namespace core {
         normalBinding.binding = 2;
         normalBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         normalBinding.descriptorCount = maxsize;
-        normalBinding.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+        normalBinding.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT;
         normalBinding.pImmutableSamplers = nullptr;
         bindings.push_back(normalBinding);
 
@@ -785,7 +1008,7 @@ namespace core {
         textureIndexBinding.binding = 3;
         textureIndexBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         textureIndexBinding.descriptorCount = 1;
-        textureIndexBinding.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+        textureIndexBinding.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT;
         textureIndexBinding.pImmutableSamplers = nullptr;
         bindings.push_back(textureIndexBinding);
 
@@ -793,7 +1016,7 @@ namespace core {
         colorBinding.binding = 4;
         colorBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         colorBinding.descriptorCount = 1;
-        colorBinding.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+        colorBinding.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT;
         colorBinding.pImmutableSamplers = nullptr;
         bindings.push_back(colorBinding);
 
@@ -801,8 +1024,8 @@ namespace core {
         VkDescriptorSetLayoutBinding textureBinding{};
         textureBinding.binding = 5;
         textureBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        textureBinding.descriptorCount = maxsize;
-        textureBinding.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+        textureBinding.descriptorCount = m_maxTextures;
+        textureBinding.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT;
         textureBinding.pImmutableSamplers = nullptr;
         bindings.push_back(textureBinding);
 
@@ -829,6 +1052,7 @@ namespace core {
     }
 
     void Raytracer::CreateGeometryBuffers(std::vector<core::SimpleMesh> meshes) {
+        TRACE_SCOPE("CreateGeometryBuffers", "core");
         // Limpiar buffers existentes
         for (auto& buffer : m_vertexBuffers) {
             buffer.Destroy(*m_device);
@@ -867,11 +1091,10 @@ namespace core {
             colors.push_back(mesh.color);
         }
 
-        for (size_t i = 0; i < colors.size(); ++i) {
-            std::cout << "Color[" << i << "] = "
-                << colors[i].r << ", "
-                << colors[i].g << ", "
-                << colors[i].b << "\n";
+        if (logging::isEnabled(logging::Level::Debug, "rt")) {
+            for (size_t i = 0; i < colors.size(); ++i) {
+                LOG_DEBUG("rt", "Color[%zu] = %f, %f, %f", i, colors[i].r, colors[i].g, colors[i].b);
+            }
         }
 
 
@@ -879,7 +1102,7 @@ namespace core {
 
         m_textureIndexBuffer = m_vkcore->CreateBufferBlas(sizeof(int) * texindexes.size(), 
             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, MemoryCategory::Geometry);
 
         // Mapear y escribir el texture index
         void* data;
@@ -890,7 +1113,7 @@ namespace core {
 
         m_colorBuffer = m_vkcore->CreateBufferBlas(sizeof(glm::vec4) * colors.size(),
             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Geometry);
 
         // Mapear y escribir el color
         void* colorData;
@@ -903,7 +1126,7 @@ namespace core {
     void Raytracer::WriteGeometryDescriptorSet() {
 
 
-        printf("Writing Geometry descriptor set\n");
+        LOG_DEBUG("rt", "Writing Geometry descriptor set");
 
         std::vector<VkWriteDescriptorSet> descriptorWrites;
 
@@ -1061,18 +1284,97 @@ namespace core {
             vkDestroyDescriptorPool(*m_device, m_geometryDescPool, nullptr);
             m_geometryDescPool = VK_NULL_HANDLE;
         }
-        printf("");
     }
 
     void Raytracer::updateGeometryDescriptorSet(std::vector<core::SimpleMesh> meshes) {
-        if (meshes.size() > m_maxsize) {
-            printf("\nMax size of meshes exceeded, stopping program\nFor more info consult Renderer initRT: method createGeometryDescriptorSet\nCurrent maximum size is %d\n", m_maxsize);
-            exit(1);
+        if (meshes.size() > (size_t)m_maxsize) {
+            GrowGeometryDescriptorSet(meshes.size());
         }
 
-
         CreateGeometryBuffers(meshes);
+        // Solo la escritura de descriptores cuenta como DescriptorUpdate, la subida de buffers va aparte
+        auto updateStart = std::chrono::high_resolution_clock::now();
         WriteGeometryDescriptorSet();
+        m_profiler.addCpuTime(GpuStage::DescriptorUpdate,
+            std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - updateStart).count());
+    }
+
+    // Los arrays del set 2 tienen su tamano en el layout: si la escena no cabe se crea un layout mayor (potencia de dos)
+    // y se vuelven a crear los pipelines que lo usan con los mismos modulos
+    void Raytracer::GrowGeometryDescriptorSet(size_t meshCount) {
+        TRACE_SCOPE("GrowGeometryDescriptorSet", "core");
+        size_t maxMeshes = getMaxGeometryMeshes();
+        if (meshCount > maxMeshes) {
+            LOG_ERROR("rt", "%zu mesh instances exceed the %zu storage buffer arrays supported by the device", meshCount, maxMeshes);
+            throw std::runtime_error("Too many mesh instances for the geometry descriptor set");
+        }
+        size_t newSize = (size_t)std::max(m_maxsize, 1);
+        while (newSize < meshCount) {
+            newSize *= 2;
+        }
+        newSize = std::min(newSize, maxMeshes);
+        LOG_INFO("rt", "Geometry descriptor set grows from %d to %zu meshes", m_maxsize, newSize);
+
+        // Ningun comando en vuelo puede usar los pipelines ni el set antiguos
+        m_vkcore->GetQueue()->WaitIdle();
+        bool rt = m_rtPipeline != VK_NULL_HANDLE;
+        bool rq = m_rqPipeline != VK_NULL_HANDLE;
+        bool stats = m_statsPipeline != VK_NULL_HANDLE;
+        bool batch = m_batchPipeline != VK_NULL_HANDLE;
+        DestroyGeometryPipelines();
+
+        // El set se libera con su pool
+        vkDestroyDescriptorSetLayout(*m_device, m_geometryDescSetLayout, nullptr);
+        vkDestroyDescriptorPool(*m_device, m_geometryDescPool, nullptr);
+        m_geometryDescSetLayout = VK_NULL_HANDLE;
+        m_geometryDescPool = VK_NULL_HANDLE;
+        m_geometryDescSet = VK_NULL_HANDLE;
+        createGeometryDescriptorSet((int)newSize);
+        if (m_rtDescSets.size() == 3) {
+            m_rtDescSets[2] = m_geometryDescSet;
+        }
+
+        if (rt) {
+            createRtPipeline(m_rgenModule, m_rmissModule, m_rchitModule);
+            createRtShaderBindingTable();
+        }
+        if (rq) {
+            createRayQueryPipeline(m_rqModule);
+        }
+        if (stats) {
+            createRayStatsPipeline(m_statsModules[0], m_statsModules[1], m_statsModules[2]);
+        }
+        if (batch) {
+            createBatchPipeline(m_batchModules[0], m_batchModules[1], m_batchModules[2]);
+        }
+    }
+
+    size_t Raytracer::getMaxGeometryMeshes() {
+        // Por mesh: vertices, indices y normales; ademas los buffers de indices de textura, color y estadisticas
+        VkPhysicalDeviceLimits limits = m_vkcore->GetSelectedPhysicalDevice().m_devProps.limits;
+        uint32_t storageLimit = std::min(limits.maxPerStageDescriptorStorageBuffers, limits.maxDescriptorSetStorageBuffers);
+        return storageLimit > 3 ? (storageLimit - 3) / 3 : 0;
+    }
+
+    void Raytracer::DestroyGeometryPipelines() {
+        m_rtSBTBuffer.Destroy(*m_device);
+        m_rtSBTBuffer = BufferMemory();
+        m_statsSBTBuffer.Destroy(*m_device);
+        m_statsSBTBuffer = BufferMemory();
+        m_batchSBTBuffer.Destroy(*m_device);
+        m_batchSBTBuffer = BufferMemory();
+        VkPipeline* pipelines[4] = { &m_rtPipeline, &m_rqPipeline, &m_statsPipeline, &m_batchPipeline };
+        VkPipelineLayout* layouts[4] = { &m_rtPipelineLayout, &m_rqPipelineLayout, &m_statsPipelineLayout, &m_batchPipelineLayout };
+        for (int i = 0; i < 4; i++) {
+            if (*pipelines[i] != VK_NULL_HANDLE) {
+                vkDestroyPipeline(*m_device, *pipelines[i], nullptr);
+                *pipelines[i] = VK_NULL_HANDLE;
+            }
+            if (*layouts[i] != VK_NULL_HANDLE) {
+                vkDestroyPipelineLayout(*m_device, *layouts[i], nullptr);
+                *layouts[i] = VK_NULL_HANDLE;
+            }
+        }
     }
 #pragma endregion
 
@@ -1173,6 +1475,11 @@ namespace core {
         stages[eClosestHit].pNext = nullptr;
         stages[eClosestHit].flags = 0;
 
+        // Para volver a crearlo si crece el set 2
+        m_rgenModule = rgenModule;
+        m_rmissModule = rmissModule;
+        m_rchitModule = rchitModule;
+
         // 2. Crear shader groups
         m_rtShaderGroups.resize(eShaderGroupCount);
 
@@ -1205,12 +1512,20 @@ namespace core {
         std::vector<VkDescriptorSetLayout> rtDescSetLayouts = { m_rtDescSetLayout, m_mvpDescSetLayout, m_geometryDescSetLayout };
         m_rtDescSets = { m_rtDescSet, m_mvpDescSet, m_geometryDescSet };
 
+        // Frame index y semilla para la acumulacion progresiva
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(RtPushConstants);
+
         VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
         pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(rtDescSetLayouts.size());
         pipelineLayoutCreateInfo.pSetLayouts = rtDescSetLayouts.data();
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
 
-        printf("Creating rt pipeline layout\n");
+        LOG_DEBUG("rt", "Creating rt pipeline layout");
 
         VkResult result = vkCreatePipelineLayout(*m_device, &pipelineLayoutCreateInfo, nullptr, &m_rtPipelineLayout);
         if (result != VK_SUCCESS) {
@@ -1227,7 +1542,7 @@ namespace core {
         rayPipelineInfo.maxPipelineRayRecursionDepth = 2; // Ajustar segn necesidades
         rayPipelineInfo.layout = m_rtPipelineLayout;
 
-        printf("Preparing to create RT pipeline\n");
+        LOG_DEBUG("rt", "Preparing to create RT pipeline");
 
         result = vkCreateRayTracingPipelinesKHR(*m_device, VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &rayPipelineInfo, nullptr, &m_rtPipeline);
         if (result != VK_SUCCESS) {
@@ -1239,11 +1554,20 @@ namespace core {
         //vkDestroyShaderModule(*m_device, missModule, nullptr);
         //vkDestroyShaderModule(*m_device, chitModule, nullptr);
 
-        printf("Ray tracing pipeline created successfully\n");
+        LOG_INFO("rt", "Ray tracing pipeline created successfully");
     }
 
 
     void Raytracer::createRtShaderBindingTable() {
+        WriteShaderBindingTable(m_rtPipeline, m_rtSBTBuffer, m_rgenRegion, m_missRegion, m_hitRegion);
+        m_callRegion = {}; // No se usa en este ejemplo
+
+        LOG_DEBUG("rt", "Shader binding table created successfully");
+    }
+
+    // Ambos pipelines (vista unica y por lotes) tienen los mismos 3 grupos: raygen, miss, hit
+    void Raytracer::WriteShaderBindingTable(VkPipeline pipeline, BufferMemory& sbtBuffer, VkStridedDeviceAddressRegionKHR& rgenRegion,
+        VkStridedDeviceAddressRegionKHR& missRegion, VkStridedDeviceAddressRegionKHR& hitRegion) {
         // 1. Obtener el tamao de handle de shader group
         uint32_t groupCount = static_cast<uint32_t>(m_rtShaderGroups.size());
         uint32_t groupHandleSize = m_rtProperties.shaderGroupHandleSize;
@@ -1254,7 +1578,7 @@ namespace core {
         uint32_t sbtDataSize = groupCount * groupHandleSize;
         std::vector<uint8_t> shaderHandleStorage(sbtDataSize);
 
-        VkResult result = vkGetRayTracingShaderGroupHandlesKHR(*m_device, m_rtPipeline, 0, groupCount,
+        VkResult result = vkGetRayTracingShaderGroupHandlesKHR(*m_device, pipeline, 0, groupCount,
             sbtDataSize, shaderHandleStorage.data());
         if (result != VK_SUCCESS) {
             throw std::runtime_error("Failed to get ray tracing shader group handles");
@@ -1264,15 +1588,16 @@ namespace core {
         VkDeviceSize sbtSize = groupCount * groupSizeAligned;
 
         // 4. Crear buffer SBT
-        m_rtSBTBuffer = m_vkcore[0].CreateBufferBlas(
+        sbtBuffer = m_vkcore[0].CreateBufferBlas(
             sbtSize,
             VK_BUFFER_USAGE_SHADER_BINDING_TABLE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+            MemoryCategory::Other
         );
 
         // 5. Mapear y copiar datos al buffer
         void* data;
-        vkMapMemory(*m_device, m_rtSBTBuffer.m_mem, 0, sbtSize, 0, &data);
+        vkMapMemory(*m_device, sbtBuffer.m_mem, 0, sbtSize, 0, &data);
 
         auto* pSBTBuffer = reinterpret_cast<uint8_t*>(data);
         for (uint32_t g = 0; g < groupCount; g++) {
@@ -1280,26 +1605,22 @@ namespace core {
             pSBTBuffer += groupSizeAligned;
         }
 
-        vkUnmapMemory(*m_device, m_rtSBTBuffer.m_mem);
+        vkUnmapMemory(*m_device, sbtBuffer.m_mem);
 
         // 6. Configurar regiones de SBT
-        VkDeviceAddress sbtAddress = GetBufferDeviceAddress(*m_device, m_rtSBTBuffer.m_buffer);
+        VkDeviceAddress sbtAddress = GetBufferDeviceAddress(*m_device, sbtBuffer.m_buffer);
 
-        m_rgenRegion.deviceAddress = sbtAddress;
-        m_rgenRegion.stride = groupSizeAligned;
-        m_rgenRegion.size = groupSizeAligned;
+        rgenRegion.deviceAddress = sbtAddress;
+        rgenRegion.stride = groupSizeAligned;
+        rgenRegion.size = groupSizeAligned;
 
-        m_missRegion.deviceAddress = sbtAddress + groupSizeAligned;
-        m_missRegion.stride = groupSizeAligned;
-        m_missRegion.size = groupSizeAligned;
+        missRegion.deviceAddress = sbtAddress + groupSizeAligned;
+        missRegion.stride = groupSizeAligned;
+        missRegion.size = groupSizeAligned;
 
-        m_hitRegion.deviceAddress = sbtAddress + 2 * groupSizeAligned;
-        m_hitRegion.stride = groupSizeAligned;
-        m_hitRegion.size = groupSizeAligned;
-
-        m_callRegion = {}; // No se usa en este ejemplo
-
-        printf("Shader binding table created successfully\n");
+        hitRegion.deviceAddress = sbtAddress + 2 * groupSizeAligned;
+        hitRegion.stride = groupSizeAligned;
+        hitRegion.size = groupSizeAligned;
     }
 
 #pragma endregion
@@ -1310,6 +1631,11 @@ namespace core {
 
 
     void Raytracer::raytrace(VkCommandBuffer cmdBuf, int width, int height) {
+        // Mismo pase en los dos modos: vkCmdTraceRaysKHR o compute con ray queries
+        bool query = isRayQuery();
+        VkPipelineStageFlags traceStage = GetTraceStage();
+        m_profiler.begin(cmdBuf, GpuStage::LayoutTransition);
+
         // 1. Transicin de imagen a layout correcto
         VkImageMemoryBarrier imageMemoryBarrier{};
         imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -1317,19 +1643,72 @@ namespace core {
         imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
         imageMemoryBarrier.srcAccessMask = 0;
         imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-        imageMemoryBarrier.image = m_outTexture->m_image;
+        imageMemoryBarrier.image = m_traceTarget->m_image;
         imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
 
         vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
             0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
 
-        // 2. Bind pipeline y descriptor sets
-        vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_rtPipeline);
-        vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_rtPipelineLayout,
+        // La guia se reescribe entera en cada frame
+        // (igual que la posicion; la reproyeccion ya las ha leido antes de esta barrera)
+        VkImageMemoryBarrier guideBarriers[2] = { imageMemoryBarrier, imageMemoryBarrier };
+        guideBarriers[0].image = m_guideTexture.m_image;
+        guideBarriers[1].image = m_positionTexture.m_image;
+
+        vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, traceStage,
+            0, 0, nullptr, 0, nullptr, 2, guideBarriers);
+
+        // La acumulacion conserva su contenido entre frames salvo al reiniciar (frame 0)
+        VkImageMemoryBarrier accumBarrier{};
+        accumBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        accumBarrier.oldLayout = (m_frameIndex == 0) ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_GENERAL;
+        accumBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        accumBarrier.srcAccessMask = (m_frameIndex == 0) ? 0 : VK_ACCESS_SHADER_WRITE_BIT;
+        accumBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        accumBarrier.image = m_accumTexture.m_image;
+        accumBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+        vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, traceStage,
+            0, 0, nullptr, 0, nullptr, 1, &accumBarrier);
+        m_profiler.end(cmdBuf, GpuStage::LayoutTransition);
+
+        // 2. Bind pipeline y descriptor sets (los mismos sets en los dos modos)
+        bool stats = isRayStatsEnabled();
+        VkPipelineBindPoint bindPoint = query ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR;
+        VkPipelineLayout layout = query ? m_rqPipelineLayout : (stats ? m_statsPipelineLayout : m_rtPipelineLayout);
+        vkCmdBindPipeline(cmdBuf, bindPoint, query ? m_rqPipeline : (stats ? m_statsPipeline : m_rtPipeline));
+        vkCmdBindDescriptorSets(cmdBuf, bindPoint, layout,
             0,(uint32_t) m_rtDescSets.size(), m_rtDescSets.data(), 0, nullptr);
+        if (stats) {
+            VkDescriptorSet statsSet = m_rayStats.getDescriptorSet();
+            vkCmdBindDescriptorSets(cmdBuf, bindPoint, layout, 3, 1, &statsSet, 0, nullptr);
+            m_rayStats.prepare(cmdBuf);
+        }
+
+        // Semilla distinta en cada frame (hash del frame index)
+        RtPushConstants pc;
+        pc.frameIndex = m_frameIndex;
+        pc.seed = (m_frameIndex + 1) * 0x27d4eb2du ^ m_seed;
+        pc.reproject = m_reprojectFrame ? 1 : 0;
+        pc.refreshPeriod = m_refreshPeriod;
+        pc.refreshPhase = (m_refreshPeriod > 0) ? m_refreshPhase % m_refreshPeriod : 0;
+        pc.width = (uint32_t)width;
+        pc.height = (uint32_t)height;
+        vkCmdPushConstants(cmdBuf, layout, query ? VK_SHADER_STAGE_COMPUTE_BIT : VK_SHADER_STAGE_RAYGEN_BIT_KHR,
+            0, sizeof(RtPushConstants), &pc);
 
         // 3. Ejecutar ray tracing
-        vkCmdTraceRaysKHR(cmdBuf, &m_rgenRegion, &m_missRegion, &m_hitRegion, &m_callRegion, width, height, 1);
+        m_profiler.begin(cmdBuf, GpuStage::TraceRays);
+        if (query) {
+            vkCmdDispatch(cmdBuf, (uint32_t)(width + 7) / 8, (uint32_t)(height + 7) / 8, 1);
+        }
+        else if (stats) {
+            vkCmdTraceRaysKHR(cmdBuf, &m_statsRgenRegion, &m_statsMissRegion, &m_statsHitRegion, &m_callRegion, width, height, 1);
+        }
+        else {
+            vkCmdTraceRaysKHR(cmdBuf, &m_rgenRegion, &m_missRegion, &m_hitRegion, &m_callRegion, width, height, 1);
+        }
+        m_profiler.end(cmdBuf, GpuStage::TraceRays);
 
         // 4. Barrier para asegurar que el ray tracing termine
         VkMemoryBarrier memoryBarrier{};
@@ -1337,13 +1716,44 @@ namespace core {
         memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
         memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-        vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        vkCmdPipelineBarrier(cmdBuf, traceStage, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
             0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
     }
 
 
 
     void Raytracer::render(int width, int height, bool saveImage, const std::string& filename) {
+        // Ya se han acumulado todas las muestras pedidas, la imagen de salida es el resultado final
+        if (isConverged()) {
+            if (saveImage && !filename.empty()) {
+                saveImageToPNG(filename, width, height);
+            }
+            return;
+        }
+        TRACE_SCOPE("render", "core");
+
+        // Resolucion de trazado de este frame
+        float traceScale = 1.0f;
+        m_reprojectFrame = false;
+        if (m_frameIndex > 0 && (m_lastTraceScale < 1.0f || m_lastReprojected)) {
+            // Nada ha cambiado desde un frame reducido o reproyectado: se reinicia la acumulacion trazando todo
+            m_frameIndex = 0;
+        }
+        else if (m_frameIndex == 0) {
+            if (m_dynamicRes) {
+                traceScale = m_resScale;
+            }
+            m_reprojectFrame = isTemporalReprojectionEnabled() && m_historyValid && !m_software;
+        }
+        int traceWidth = std::max(1, (int)(width * traceScale));
+        int traceHeight = std::max(1, (int)(height * traceScale));
+        bool scaled = traceWidth != width || traceHeight != height;
+
+        VulkanTexture* target = scaled ? &m_scaledTexture : m_outTexture;
+        if (target != m_traceTarget) {
+            WriteTraceTarget(target);
+        }
+
         VkCommandBuffer cmdBuf;
         m_vkcore->CreateCommandBuffer(1, &cmdBuf);
 
@@ -1352,8 +1762,31 @@ namespace core {
         beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
         vkBeginCommandBuffer(cmdBuf, &beginInfo);   
 
-        // Ejecutar ray tracing
-        raytrace(cmdBuf, width, height);
+        if (m_software) {
+            uint32_t seed = (m_frameIndex + 1) * 0x27d4eb2du ^ m_seed;
+            m_profiler.begin(cmdBuf, GpuStage::TraceRays);
+            m_softRt.trace(cmdBuf, traceWidth, traceHeight, m_invViewProj, m_frameIndex, seed);
+            m_profiler.end(cmdBuf, GpuStage::TraceRays);
+        }
+        else {
+            if (m_reprojectFrame) {
+                m_reprojector.reproject(cmdBuf, m_invViewProj, m_historyWidth, m_historyHeight, traceWidth, traceHeight);
+            }
+
+            // Ejecutar ray tracing
+            raytrace(cmdBuf, traceWidth, traceHeight);
+        }
+        // El historial guarda el trazado sin filtrar
+        if (m_reprojectionEnabled) {
+            CopyToHistory(cmdBuf, traceWidth, traceHeight);
+        }
+        // El filtro se aplica a resolucion de trazado, antes del escalado
+        if (isDenoiseEnabled()) {
+            m_denoiser.denoise(cmdBuf, traceWidth, traceHeight, m_denoiseSettings);
+        }
+        if (scaled) {
+            UpscaleToOutput(cmdBuf, traceWidth, traceHeight, width, height);
+        }
 
         vkEndCommandBuffer(cmdBuf);
 
@@ -1362,9 +1795,34 @@ namespace core {
         //Offscreen Render
         uint32_t ImageIndex = 0;
 
+        // Los contadores se leen tras el WaitIdle, nada mas los usa entre medias
+        bool stats = isRayStatsEnabled();
+        if (stats) {
+            m_rayStats.reset();
+        }
+
+        auto traceStart = std::chrono::high_resolution_clock::now();
         pQueue->SubmitSync(cmdBuf);
         //pQueue->Present(ImageIndex);
         pQueue->WaitIdle();
+        float traceMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - traceStart).count();
+        m_profiler.collect();
+        if (stats) {
+            m_rayStats.collect();
+        }
+
+        m_frameIndex++;
+        m_lastTraceScale = scaled ? traceScale : 1.0f;
+        m_lastReprojected = m_reprojectFrame;
+        if (m_reprojectFrame) {
+            m_refreshPhase++;
+        }
+        if (m_reprojectionEnabled) {
+            m_historyValid = true;
+            m_historyWidth = traceWidth;
+            m_historyHeight = traceHeight;
+        }
+        UpdateResolutionScale(traceMs, m_lastTraceScale);
 
         if (saveImage && !filename.empty()) {
             saveImageToPNG(filename, width, height);
@@ -1374,6 +1832,341 @@ namespace core {
         vkFreeCommandBuffers(m_vkcore->GetDevice(), m_cmdBufPool, 1, &cmdBuf);
     }
 
+    void Raytracer::WriteTraceTarget(VulkanTexture* target) {
+        if (m_software) {
+            m_traceTarget = target;
+            m_denoiser.setImages(m_traceTarget, &m_guideTexture);
+
+            SoftRtImages images;
+            images.out = target;
+            images.accum = &m_accumTexture;
+            images.guide = &m_guideTexture;
+            images.position = &m_positionTexture;
+            m_softRt.setImages(images);
+            return;
+        }
+
+        VkDescriptorImageInfo ImageInfo = {};
+        ImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        ImageInfo.imageView = target->m_view;
+        ImageInfo.sampler = NULL;
+
+        VkWriteDescriptorSet wds_i = {};
+        wds_i.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        wds_i.dstSet = m_rtDescSet;
+        wds_i.dstBinding = 2;
+        wds_i.dstArrayElement = 0;
+        wds_i.descriptorCount = 1;
+        wds_i.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        wds_i.pImageInfo = &ImageInfo;
+
+        vkUpdateDescriptorSets(*m_device, 1, &wds_i, 0, NULL);
+        m_traceTarget = target;
+        m_denoiser.setImages(m_traceTarget, &m_guideTexture);
+    }
+
+    // Copia la imagen trazada (en GENERAL) al historial de color de la reproyeccion
+    void Raytracer::CopyToHistory(VkCommandBuffer cmdBuf, int width, int height) {
+        VkImageMemoryBarrier barriers[2] = {};
+        barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[0].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barriers[0].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barriers[0].image = m_traceTarget->m_image;
+        barriers[0].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+        barriers[1] = barriers[0];
+        barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barriers[1].srcAccessMask = 0;
+        barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barriers[1].image = m_historyColor.m_image;
+
+        vkCmdPipelineBarrier(cmdBuf, GetTraceStage() | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 2, barriers);
+
+        VkImageCopy region{};
+        region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.extent = { (uint32_t)width, (uint32_t)height, 1 };
+        vkCmdCopyImage(cmdBuf, m_traceTarget->m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            m_historyColor.m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0, 0, nullptr, 0, nullptr, 2, barriers);
+    }
+
+    void Raytracer::createReprojector(VkShaderModule compModule) {
+        if (m_reprojector.isReady()) {
+            return;
+        }
+        m_reprojector.init(m_vkcore, compModule);
+        SetReprojectionImages();
+    }
+
+    void Raytracer::SetReprojectionImages() {
+        ReprojectionImages images;
+        images.historyColor = &m_historyColor;
+        images.historyGuide = &m_guideTexture;
+        images.historyPosition = &m_positionTexture;
+        images.depth = &m_reprojDepth;
+        images.color = &m_reprojColor;
+        images.normal = &m_reprojNormal;
+        images.position = &m_reprojPosition;
+        m_reprojector.setImages(images);
+    }
+
+    void Raytracer::setTemporalReprojection(bool enabled, uint32_t refreshPeriod) {
+        m_reprojectionEnabled = enabled;
+        m_refreshPeriod = refreshPeriod;
+        if (!enabled) {
+            m_historyValid = false;
+        }
+    }
+
+    void Raytracer::createDenoiser(VkShaderModule compModule) {
+        if (m_denoiser.isReady()) {
+            return;
+        }
+        // El modo puede cambiar despues de crear el denoiser
+        VkPipelineStageFlags traceStage = m_software ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+            : VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        m_denoiser.init(m_vkcore, compModule, m_outputWidth, m_outputHeight, traceStage);
+        m_denoiser.setImages(m_traceTarget ? m_traceTarget : m_outTexture, &m_guideTexture);
+    }
+
+    // Escalado bilineal de la esquina trazada (srcWidth x srcHeight) de m_scaledTexture a toda la imagen de salida
+    void Raytracer::UpscaleToOutput(VkCommandBuffer cmdBuf, int srcWidth, int srcHeight, int dstWidth, int dstHeight) {
+        VkImageMemoryBarrier barriers[2] = {};
+        barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[0].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barriers[0].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barriers[0].image = m_scaledTexture.m_image;
+        barriers[0].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+        // La salida se sobrescribe entera, no hace falta conservar su contenido
+        barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barriers[1].srcAccessMask = 0;
+        barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barriers[1].image = m_outTexture->m_image;
+        barriers[1].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+        vkCmdPipelineBarrier(cmdBuf, GetTraceStage() | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, 2, barriers);
+
+        VkImageBlit blit{};
+        blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        blit.srcOffsets[0] = { 0, 0, 0 };
+        blit.srcOffsets[1] = { srcWidth, srcHeight, 1 };
+        blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        blit.dstOffsets[0] = { 0, 0, 0 };
+        blit.dstOffsets[1] = { dstWidth, dstHeight, 1 };
+
+        vkCmdBlitImage(cmdBuf, m_scaledTexture.m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            m_outTexture->m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+        // La salida vuelve a GENERAL, igual que tras un trazado a resolucion completa
+        VkImageMemoryBarrier toGeneral = barriers[1];
+        toGeneral.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        toGeneral.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        toGeneral.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        toGeneral.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+        vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &toGeneral);
+    }
+
+    VkPipelineStageFlags Raytracer::GetTraceStage() const {
+        return (m_software || isRayQuery()) ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
+    }
+
+    // Pipeline de compute del modo hibrido: mismos descriptor sets que el pipeline de ray tracing, sin SBT
+    void Raytracer::createRayQueryPipeline(VkShaderModule compModule) {
+        if (m_rqPipeline != VK_NULL_HANDLE) {
+            return;
+        }
+        if (!m_vkcore->IsRayQuerySupported()) {
+            LOG_WARN("rt", "VK_KHR_ray_query not supported, the ray query mode is not available");
+            return;
+        }
+        m_rqModule = compModule;
+
+        std::vector<VkDescriptorSetLayout> rtDescSetLayouts = { m_rtDescSetLayout, m_mvpDescSetLayout, m_geometryDescSetLayout };
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(RtPushConstants);
+
+        VkPipelineLayoutCreateInfo layoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+        layoutInfo.setLayoutCount = (uint32_t)rtDescSetLayouts.size();
+        layoutInfo.pSetLayouts = rtDescSetLayouts.data();
+        layoutInfo.pushConstantRangeCount = 1;
+        layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        VkResult res = vkCreatePipelineLayout(*m_device, &layoutInfo, nullptr, &m_rqPipelineLayout);
+        CHECK_VK_RESULT(res, "vkCreatePipelineLayout");
+
+        VkPipelineShaderStageCreateInfo stage{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+        stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        stage.module = compModule;
+        stage.pName = "main";
+
+        VkComputePipelineCreateInfo pipelineInfo{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+        pipelineInfo.stage = stage;
+        pipelineInfo.layout = m_rqPipelineLayout;
+
+        res = vkCreateComputePipelines(*m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_rqPipeline);
+        CHECK_VK_RESULT(res, "vkCreateComputePipelines");
+        LOG_INFO("rt", "Ray query pipeline created");
+    }
+
+    // Copia del pipeline de ray tracing con los shaders compilados con RAY_STATS y un set 3 para contadores y mapa de calor
+    void Raytracer::createRayStatsPipeline(VkShaderModule rgenModule, VkShaderModule rmissModule, VkShaderModule rchitModule) {
+        if (m_statsPipeline != VK_NULL_HANDLE) {
+            return;
+        }
+        if (m_rtShaderGroups.empty()) {
+            throw std::runtime_error("createRtPipeline must be called before createRayStatsPipeline");
+        }
+
+        // Al crecer el set 2 solo se vuelve a crear el pipeline, los contadores y el mapa de calor se conservan
+        if (!m_rayStats.isReady()) {
+            m_rayStats.init(m_vkcore, m_outputWidth, m_outputHeight, m_vkcore->IsShaderClockSupported());
+        }
+        m_statsModules[0] = rgenModule;
+        m_statsModules[1] = rmissModule;
+        m_statsModules[2] = rchitModule;
+
+        std::array<VkPipelineShaderStageCreateInfo, 3> stages{};
+        VkShaderStageFlagBits stageBits[3] = { VK_SHADER_STAGE_RAYGEN_BIT_KHR, VK_SHADER_STAGE_MISS_BIT_KHR, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR };
+        VkShaderModule modules[3] = { rgenModule, rmissModule, rchitModule };
+        for (uint32_t i = 0; i < stages.size(); i++) {
+            stages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            stages[i].stage = stageBits[i];
+            stages[i].module = modules[i];
+            stages[i].pName = "main";
+        }
+
+        // Sets 0-2 y push constants iguales que m_rtPipelineLayout, asi m_rtDescSets sirve para los dos
+        std::vector<VkDescriptorSetLayout> statsSetLayouts = { m_rtDescSetLayout, m_mvpDescSetLayout, m_geometryDescSetLayout,
+            m_rayStats.getDescriptorSetLayout() };
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(RtPushConstants);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(statsSetLayouts.size());
+        pipelineLayoutCreateInfo.pSetLayouts = statsSetLayouts.data();
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+        VkResult result = vkCreatePipelineLayout(*m_device, &pipelineLayoutCreateInfo, nullptr, &m_statsPipelineLayout);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create ray statistics pipeline layout");
+        }
+
+        VkRayTracingPipelineCreateInfoKHR rayPipelineInfo{};
+        rayPipelineInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR;
+        rayPipelineInfo.stageCount = static_cast<uint32_t>(stages.size());
+        rayPipelineInfo.pStages = stages.data();
+        rayPipelineInfo.groupCount = static_cast<uint32_t>(m_rtShaderGroups.size());
+        rayPipelineInfo.pGroups = m_rtShaderGroups.data();
+        rayPipelineInfo.maxPipelineRayRecursionDepth = 2;
+        rayPipelineInfo.layout = m_statsPipelineLayout;
+
+        result = vkCreateRayTracingPipelinesKHR(*m_device, VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &rayPipelineInfo, nullptr, &m_statsPipeline);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create ray statistics pipeline");
+        }
+
+        WriteShaderBindingTable(m_statsPipeline, m_statsSBTBuffer, m_statsRgenRegion, m_statsMissRegion, m_statsHitRegion);
+
+        LOG_INFO("rt", "Ray statistics pipeline created successfully");
+    }
+
+    void Raytracer::CleanupRayStatsPipeline() {
+        m_statsSBTBuffer.Destroy(*m_device);
+        m_statsSBTBuffer = BufferMemory();
+        if (m_statsPipeline != VK_NULL_HANDLE) {
+            vkDestroyPipeline(*m_device, m_statsPipeline, nullptr);
+            m_statsPipeline = VK_NULL_HANDLE;
+        }
+        if (m_statsPipelineLayout != VK_NULL_HANDLE) {
+            vkDestroyPipelineLayout(*m_device, m_statsPipelineLayout, nullptr);
+            m_statsPipelineLayout = VK_NULL_HANDLE;
+        }
+        m_rayStats.cleanup();
+    }
+
+    void Raytracer::setRayQuery(bool enabled) {
+        if (enabled == m_rayQuery) {
+            return;
+        }
+        m_rayQuery = enabled;
+        // Cada modo tiene su propio coste, la media movil empieza de cero
+        m_traceMsAvg = 0.0f;
+    }
+
+    void Raytracer::createSoftwarePipeline(VkShaderModule compModule) {
+        if (m_softRt.isReady()) {
+            return;
+        }
+        m_softRt.init(m_vkcore, compModule);
+        WriteTraceTarget(m_outTexture);
+    }
+
+    void Raytracer::updateSoftwareScene(const std::vector<core::SimpleMesh>& meshes) {
+        TRACE_SCOPE("updateSoftwareScene", "core");
+        // La BVH en CPU hace el papel de las BLAS en el trazado por software, pero es tiempo de host
+        auto buildStart = std::chrono::high_resolution_clock::now();
+        m_softRt.updateScene(meshes);
+        m_profiler.addCpuTime(GpuStage::SoftBvhBuild,
+            std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - buildStart).count());
+    }
+
+    void Raytracer::setDynamicResolution(bool enabled, float frameBudgetMs, float minScale) {
+        m_dynamicRes = enabled;
+        m_frameBudgetMs = std::max(0.1f, frameBudgetMs);
+        m_minScale = std::min(1.0f, std::max(0.05f, minScale));
+        if (!enabled) {
+            m_resScale = 1.0f;
+        }
+    }
+
+    void Raytracer::UpdateResolutionScale(float traceMs, float traceScale) {
+        // El coste es aproximadamente proporcional al numero de pixeles, se normaliza a resolucion completa
+        float fullResMs = traceMs / (traceScale * traceScale);
+        const float alpha = 0.2f;
+        m_traceMsAvg = (m_traceMsAvg <= 0.0f) ? fullResMs : m_traceMsAvg + alpha * (fullResMs - m_traceMsAvg);
+
+        if (!m_dynamicRes) {
+            return;
+        }
+
+        float scale = std::sqrt(m_frameBudgetMs / m_traceMsAvg);
+        // Pasos de 1/16 para no cambiar de resolucion en cada frame por el ruido de la medida
+        scale = std::floor(scale * 16.0f) / 16.0f;
+        m_resScale = std::min(1.0f, std::max(m_minScale, scale));
+    }
+
     void Raytracer::saveImageToPNG(const std::string& filename, int width, int height) {
         VkDevice device = m_vkcore->GetDevice();
 
@@ -1410,8 +2203,10 @@ namespace core {
         region.imageOffset = { 0, 0, 0 };
         region.imageExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
 
+        m_profiler.begin(cmdBuf, GpuStage::Readback);
         vkCmdCopyImageToBuffer(cmdBuf, (m_outTexture[0].m_image), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
             stagingBuffer, 1, &region);
+        m_profiler.end(cmdBuf, GpuStage::Readback);
 
 
 
@@ -1425,6 +2220,7 @@ namespace core {
         core::VulkanQueue* pQueue = m_vkcore->GetQueue();
         pQueue->SubmitSync(cmdBuf);
         pQueue->WaitIdle();
+        m_profiler.collect();
 
         // Mapear memoria y leer datos
         void* data;
@@ -1435,15 +2231,16 @@ namespace core {
         int result = stbi_write_png(filename.c_str(), width, height, 4, data, width * 4);
 
         if (result == 0) {
-            printf("Failed to write PNG file: %s\n", filename.c_str());
+            LOG_ERROR("rt", "Failed to write PNG file: %s", filename.c_str());
         }
         else {
-            printf("Successfully saved image to: %s\n", filename.c_str());
+            LOG_INFO("rt", "Successfully saved image to: %s", filename.c_str());
         }
 
         // Limpiar recursos
         vkUnmapMemory(device, stagingBufferMemory);
         vkDestroyBuffer(device, stagingBuffer, nullptr);
+        MemoryTracker::Get().release(stagingBufferMemory);
         vkFreeMemory(device, stagingBufferMemory, nullptr);
         vkFreeCommandBuffers(device, m_cmdBufPool, 1, &cmdBuf);
     }
@@ -1471,6 +2268,7 @@ namespace core {
         if (vkAllocateMemory(m_vkcore->GetDevice(), &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
             throw std::runtime_error("Failed to allocate staging buffer memory!");
         }
+        MemoryTracker::Get().track(bufferMemory, memRequirements.size, MemoryCategory::Staging);
 
         vkBindBufferMemory(m_vkcore->GetDevice(), buffer, bufferMemory, 0);
     }
@@ -1492,6 +2290,7 @@ namespace core {
         if (!tex || !tex->m_image || !buffer) {
             return 0;
         }
+        TRACE_SCOPE("copyResultBytes", "core");
 
         VkDevice device = *m_device;
 
@@ -1500,7 +2299,7 @@ namespace core {
 
         // Verificar si el buffer es suficientemente grande
         if (bufferSize < imageSize) {
-            printf("Buffer size insufficient. Required: %zu, Available: %zu\n",
+            LOG_ERROR("rt", "Buffer size insufficient. Required: %zu, Available: %zu",
                 (size_t)imageSize, bufferSize);
             return 0;
         }
@@ -1537,8 +2336,10 @@ namespace core {
         region.imageOffset = { 0, 0, 0 };
         region.imageExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
 
+        m_profiler.begin(cmdBuf, GpuStage::Readback);
         vkCmdCopyImageToBuffer(cmdBuf, (m_outTexture[0].m_image), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
             stagingBuffer, 1, &region);
+        m_profiler.end(cmdBuf, GpuStage::Readback);
 
         // Restaurar layout original
         m_vkcore->TransitionImageLayout((m_outTexture[0].m_image), VK_FORMAT_R8G8B8A8_UNORM,
@@ -1550,14 +2351,16 @@ namespace core {
         VulkanQueue* pQueue = m_vkcore->GetQueue();
         pQueue->SubmitSync(cmdBuf);
         pQueue->WaitIdle();
+        m_profiler.collect();
 
         // Mapear memoria y copiar datos al buffer del usuario
         void* data;
         VkResult res = vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &data);
         if (res != VK_SUCCESS) {
-            printf("Error mapping memory: %d\n", res);
+            LOG_ERROR("rt", "Error mapping memory: %d", res);
             // Limpiar recursos antes de retornar
             vkDestroyBuffer(device, stagingBuffer, nullptr);
+            MemoryTracker::Get().release(stagingBufferMemory);
             vkFreeMemory(device, stagingBufferMemory, nullptr);
             vkFreeCommandBuffers(device, m_cmdBufPool, 1, &cmdBuf);
             return 0;
@@ -1569,10 +2372,372 @@ namespace core {
         // Limpiar recursos
         vkUnmapMemory(device, stagingBufferMemory);
         vkDestroyBuffer(device, stagingBuffer, nullptr);
+        MemoryTracker::Get().release(stagingBufferMemory);
         vkFreeMemory(device, stagingBufferMemory, nullptr);
         vkFreeCommandBuffers(device, m_cmdBufPool, 1, &cmdBuf);
 
         return (size_t)imageSize;
     }
 #pragma endregion
-}
\ No newline at end of file
+
+#pragma region BatchRendering
+
+    /*
+    * Render por lotes (multi-view): muchas vistas de la misma escena estatica (turntables, fotos de producto)
+    * se trazan en un unico vkCmdTraceRaysKHR con profundidad N. gl_LaunchIDEXT.z selecciona la camara
+    * y la capa de la imagen de salida, asi solo hay un submit y una lectura por lote.
+    *
+    * Requiere que createRtPipeline y createGeometryDescriptorSet se hayan llamado antes (comparte grupos y set 2)
+    */
+    void Raytracer::createBatchPipeline(VkShaderModule rgenBatchModule, VkShaderModule rmissModule, VkShaderModule rchitModule) {
+        if (m_rtShaderGroups.empty()) {
+            throw std::runtime_error("createRtPipeline must be called before createBatchPipeline");
+        }
+
+        // Los sets 0 y 1 del lote no dependen del set 2: se conservan si solo se vuelve a crear el pipeline
+        if (m_batchDescPool == VK_NULL_HANDLE) {
+            LOG_DEBUG("rt", "Creating batch descriptor sets");
+            CreateBatchDescriptorSets();
+        }
+        m_batchModules[0] = rgenBatchModule;
+        m_batchModules[1] = rmissModule;
+        m_batchModules[2] = rchitModule;
+
+        std::array<VkPipelineShaderStageCreateInfo, 3> stages{};
+        VkShaderStageFlagBits stageBits[3] = { VK_SHADER_STAGE_RAYGEN_BIT_KHR, VK_SHADER_STAGE_MISS_BIT_KHR, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR };
+        VkShaderModule modules[3] = { rgenBatchModule, rmissModule, rchitModule };
+        for (uint32_t i = 0; i < stages.size(); i++) {
+            stages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            stages[i].stage = stageBits[i];
+            stages[i].module = modules[i];
+            stages[i].pName = "main";
+        }
+
+        // Mismos sets que el pipeline normal salvo el 0 (imagen layered) y el 1 (array de camaras)
+        std::vector<VkDescriptorSetLayout> batchSetLayouts = { m_batchRtDescSetLayout, m_batchCamDescSetLayout, m_geometryDescSetLayout };
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(batchSetLayouts.size());
+        pipelineLayoutCreateInfo.pSetLayouts = batchSetLayouts.data();
+
+        VkResult result = vkCreatePipelineLayout(*m_device, &pipelineLayoutCreateInfo, nullptr, &m_batchPipelineLayout);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create batch ray tracing pipeline layout");
+        }
+
+        VkRayTracingPipelineCreateInfoKHR rayPipelineInfo{};
+        rayPipelineInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR;
+        rayPipelineInfo.stageCount = static_cast<uint32_t>(stages.size());
+        rayPipelineInfo.pStages = stages.data();
+        rayPipelineInfo.groupCount = static_cast<uint32_t>(m_rtShaderGroups.size());
+        rayPipelineInfo.pGroups = m_rtShaderGroups.data();
+        rayPipelineInfo.maxPipelineRayRecursionDepth = 2;
+        rayPipelineInfo.layout = m_batchPipelineLayout;
+
+        result = vkCreateRayTracingPipelinesKHR(*m_device, VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &rayPipelineInfo, nullptr, &m_batchPipeline);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create batch ray tracing pipeline");
+        }
+
+        WriteShaderBindingTable(m_batchPipeline, m_batchSBTBuffer, m_batchRgenRegion, m_batchMissRegion, m_batchHitRegion);
+
+        LOG_INFO("rt", "Batch ray tracing pipeline created successfully");
+    }
+
+    void Raytracer::CreateBatchDescriptorSets() {
+        std::vector<VkDescriptorPoolSize> poolSizes = {
+            {VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, 1},
+            {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1},
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1}
+        };
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = 2;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+
+        VkResult res = vkCreateDescriptorPool(*m_device, &poolInfo, nullptr, &m_batchDescPool);
+        CHECK_VK_RESULT(res, "vkCreateDescriptorPool batch");
+
+        // Set 0: mismos bindings que m_rtDescSetLayout pero la imagen es image2DArray
+        VkDescriptorSetLayoutBinding asBinding{};
+        asBinding.binding = 1;
+        asBinding.descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+        asBinding.descriptorCount = 1;
+        asBinding.stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+
+        VkDescriptorSetLayoutBinding imageBinding{};
+        imageBinding.binding = 2;
+        imageBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        imageBinding.descriptorCount = 1;
+        imageBinding.stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+
+        std::vector<VkDescriptorSetLayoutBinding> rtBindings = { asBinding, imageBinding };
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(rtBindings.size());
+        layoutInfo.pBindings = rtBindings.data();
+
+        res = vkCreateDescriptorSetLayout(*m_device, &layoutInfo, nullptr, &m_batchRtDescSetLayout);
+        CHECK_VK_RESULT(res, "vkCreateDescriptorSetLayout batch rt");
+
+        // Set 1: array de matrices (inversa de VP por vista), misma binding que el UBO de la MVP
+        VkDescriptorSetLayoutBinding camBinding{};
+        camBinding.binding = 1;
+        camBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        camBinding.descriptorCount = 1;
+        camBinding.stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+
+        layoutInfo.bindingCount = 1;
+        layoutInfo.pBindings = &camBinding;
+
+        res = vkCreateDescriptorSetLayout(*m_device, &layoutInfo, nullptr, &m_batchCamDescSetLayout);
+        CHECK_VK_RESULT(res, "vkCreateDescriptorSetLayout batch cameras");
+
+        VkDescriptorSetLayout layouts[2] = { m_batchRtDescSetLayout, m_batchCamDescSetLayout };
+        VkDescriptorSet sets[2];
+        VkDescriptorSetAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+        allocInfo.descriptorPool = m_batchDescPool;
+        allocInfo.descriptorSetCount = 2;
+        allocInfo.pSetLayouts = layouts;
+
+        res = vkAllocateDescriptorSets(*m_device, &allocInfo, sets);
+        CHECK_VK_RESULT(res, "vkAllocateDescriptorSets batch");
+        m_batchRtDescSet = sets[0];
+        m_batchCamDescSet = sets[1];
+    }
+
+    // Sube las camaras del lote. Solo recrea la imagen y los buffers si el lote no cabe o cambia la resolucion
+    void Raytracer::updateBatchCameras(const std::vector<glm::mat4>& invViewProjs, int width, int height) {
+        uint32_t viewCount = static_cast<uint32_t>(invViewProjs.size());
+        if (viewCount == 0) {
+            m_batchViewCount = 0;
+            return;
+        }
+
+        uint32_t maxLayers = m_vkcore->GetSelectedPhysicalDevice().m_devProps.limits.maxImageArrayLayers;
+        if (viewCount > maxLayers) {
+            throw std::runtime_error("Batch view count exceeds maxImageArrayLayers");
+        }
+
+        if (viewCount > m_batchCapacity || width != m_batchWidth || height != m_batchHeight) {
+            CreateBatchBuffers(width, height, std::max(viewCount, m_batchCapacity));
+            WriteBatchDescriptorSets();
+        }
+
+        m_batchCameraBuffer.Update(*m_device, invViewProjs.data(), sizeof(glm::mat4) * viewCount);
+        m_batchViewCount = viewCount;
+    }
+
+    void Raytracer::CreateBatchBuffers(int width, int height, uint32_t capacity) {
+        // Puede haber un lote anterior en vuelo
+        vkDeviceWaitIdle(*m_device);
+        CleanupBatchBuffers();
+
+        m_batchWidth = width;
+        m_batchHeight = height;
+        m_batchCapacity = capacity;
+
+        m_vkcore->CreateTextureImageArray(m_batchOutTexture, (uint32_t)width, (uint32_t)height, capacity, VK_FORMAT_R8G8B8A8_UNORM);
+
+        m_batchCameraBuffer = m_vkcore->CreateBufferACC(sizeof(glm::mat4) * capacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Other);
+
+        // Buffer de lectura persistente: todas las capas se copian en el mismo submit que el trazado
+        VkDeviceSize readbackSize = (VkDeviceSize)width * height * 4 * capacity;
+        m_batchReadbackBuffer = m_vkcore->CreateBufferACC(readbackSize,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Staging);
+
+        LOG_DEBUG("rt", "Batch buffers created: %dx%d, %u layers", width, height, capacity);
+    }
+
+    void Raytracer::WriteBatchDescriptorSets() {
+        std::vector<VkWriteDescriptorSet> writes;
+
+        VkAccelerationStructureKHR tlas = m_tlas.handle;
+        VkWriteDescriptorSetAccelerationStructureKHR descASInfo{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR };
+        descASInfo.accelerationStructureCount = 1;
+        descASInfo.pAccelerationStructures = &tlas;
+        if (tlas != VK_NULL_HANDLE) {
+            VkWriteDescriptorSet wds_t{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+            wds_t.dstSet = m_batchRtDescSet;
+            wds_t.dstBinding = 1;
+            wds_t.descriptorCount = 1;
+            wds_t.descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+            wds_t.pNext = &descASInfo;
+            writes.push_back(wds_t);
+        }
+
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        imageInfo.imageView = m_batchOutTexture.m_view;
+        VkWriteDescriptorSet wds_i{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        wds_i.dstSet = m_batchRtDescSet;
+        wds_i.dstBinding = 2;
+        wds_i.descriptorCount = 1;
+        wds_i.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        wds_i.pImageInfo = &imageInfo;
+        writes.push_back(wds_i);
+
+        VkDescriptorBufferInfo camInfo{};
+        camInfo.buffer = m_batchCameraBuffer.m_buffer;
+        camInfo.offset = 0;
+        camInfo.range = VK_WHOLE_SIZE;
+        VkWriteDescriptorSet wds_c{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        wds_c.dstSet = m_batchCamDescSet;
+        wds_c.dstBinding = 1;
+        wds_c.descriptorCount = 1;
+        wds_c.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        wds_c.pBufferInfo = &camInfo;
+        writes.push_back(wds_c);
+
+        vkUpdateDescriptorSets(*m_device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+    }
+
+    void Raytracer::raytraceBatch(VkCommandBuffer cmdBuf, int width, int height, uint32_t viewCount) {
+        // Todas las capas a GENERAL, el contenido anterior se descarta. La vista y el descriptor cubren las
+        // m_batchCapacity capas, no solo las viewCount que se trazan: ninguna puede quedar en UNDEFINED
+        VkImageMemoryBarrier imageMemoryBarrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+        imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        imageMemoryBarrier.srcAccessMask = 0;
+        imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        imageMemoryBarrier.image = m_batchOutTexture.m_image;
+        imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, m_batchCapacity };
+
+        vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+            0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+
+        VkDescriptorSet batchSets[3] = { m_batchRtDescSet, m_batchCamDescSet, m_geometryDescSet };
+        vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_batchPipeline);
+        vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_batchPipelineLayout,
+            0, 3, batchSets, 0, nullptr);
+
+        // Profundidad = numero de vistas
+        vkCmdTraceRaysKHR(cmdBuf, &m_batchRgenRegion, &m_batchMissRegion, &m_batchHitRegion, &m_callRegion,
+            width, height, viewCount);
+    }
+
+    void Raytracer::renderBatch() {
+        if (m_batchViewCount == 0 || m_batchPipeline == VK_NULL_HANDLE) {
+            return;
+        }
+
+        VkCommandBuffer cmdBuf;
+        m_vkcore->CreateCommandBuffer(1, &cmdBuf);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(cmdBuf, &beginInfo);
+
+        raytraceBatch(cmdBuf, m_batchWidth, m_batchHeight, m_batchViewCount);
+
+        // Copiar todas las capas al buffer de lectura en el mismo command buffer
+        VkImageMemoryBarrier toTransfer{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+        toTransfer.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        toTransfer.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        toTransfer.image = m_batchOutTexture.m_image;
+        toTransfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, m_batchViewCount };
+
+        vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+        VkBufferImageCopy region{};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = m_batchViewCount;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { static_cast<uint32_t>(m_batchWidth), static_cast<uint32_t>(m_batchHeight), 1 };
+
+        vkCmdCopyImageToBuffer(cmdBuf, m_batchOutTexture.m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            m_batchReadbackBuffer.m_buffer, 1, &region);
+
+        VkMemoryBarrier hostBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+            0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+        vkEndCommandBuffer(cmdBuf);
+
+        core::VulkanQueue* pQueue = m_vkcore->GetQueue();
+        pQueue->SubmitSync(cmdBuf);
+        pQueue->WaitIdle();
+
+        vkFreeCommandBuffers(m_vkcore->GetDevice(), m_cmdBufPool, 1, &cmdBuf);
+    }
+
+    // Copia las N capas del ultimo lote de forma contigua (vista 0, vista 1, ...), RGBA8
+    size_t Raytracer::copyBatchResultBytes(uint8_t* buffer, size_t bufferSize) {
+        if (!buffer || m_batchViewCount == 0) {
+            return 0;
+        }
+
+        size_t imageSize = (size_t)m_batchWidth * m_batchHeight * 4 * m_batchViewCount;
+        if (bufferSize < imageSize) {
+            LOG_ERROR("rt", "Buffer size insufficient. Required: %zu, Available: %zu", (size_t)imageSize, bufferSize);
+            return 0;
+        }
+
+        void* data;
+        VkResult res = vkMapMemory(*m_device, m_batchReadbackBuffer.m_mem, 0, imageSize, 0, &data);
+        if (res != VK_SUCCESS) {
+            LOG_ERROR("rt", "Error mapping memory: %d", res);
+            return 0;
+        }
+        memcpy(buffer, data, imageSize);
+        vkUnmapMemory(*m_device, m_batchReadbackBuffer.m_mem);
+
+        return imageSize;
+    }
+
+    void Raytracer::CleanupBatchBuffers() {
+        m_batchOutTexture.Destroy(*m_device);
+        m_batchOutTexture = VulkanTexture();
+        m_batchCameraBuffer.Destroy(*m_device);
+        m_batchCameraBuffer = BufferMemory();
+        m_batchReadbackBuffer.Destroy(*m_device);
+        m_batchReadbackBuffer = BufferMemory();
+        m_batchCapacity = 0;
+        m_batchViewCount = 0;
+    }
+
+    void Raytracer::CleanupBatchResources() {
+        CleanupBatchBuffers();
+        m_batchSBTBuffer.Destroy(*m_device);
+        m_batchSBTBuffer = BufferMemory();
+
+        if (m_batchPipeline != VK_NULL_HANDLE) {
+            vkDestroyPipeline(*m_device, m_batchPipeline, nullptr);
+            m_batchPipeline = VK_NULL_HANDLE;
+        }
+        if (m_batchPipelineLayout != VK_NULL_HANDLE) {
+            vkDestroyPipelineLayout(*m_device, m_batchPipelineLayout, nullptr);
+            m_batchPipelineLayout = VK_NULL_HANDLE;
+        }
+        if (m_batchRtDescSetLayout != VK_NULL_HANDLE) {
+            vkDestroyDescriptorSetLayout(*m_device, m_batchRtDescSetLayout, nullptr);
+            m_batchRtDescSetLayout = VK_NULL_HANDLE;
+        }
+        if (m_batchCamDescSetLayout != VK_NULL_HANDLE) {
+            vkDestroyDescriptorSetLayout(*m_device, m_batchCamDescSetLayout, nullptr);
+            m_batchCamDescSetLayout = VK_NULL_HANDLE;
+        }
+        if (m_batchDescPool != VK_NULL_HANDLE) {
+            vkDestroyDescriptorPool(*m_device, m_batchDescPool, nullptr);
+            m_batchDescPool = VK_NULL_HANDLE;
+        }
+        m_batchRtDescSet = VK_NULL_HANDLE;
+        m_batchCamDescSet = VK_NULL_HANDLE;
+    }
+#pragma endregion
+}
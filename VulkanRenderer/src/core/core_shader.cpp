@@ -1,5 +1,6 @@
 #include "core/core_utils.h"
 #include "core/core_shader.h"
+#include "core/core_cluster.h"
 #include <stdio.h>
 #include <cassert>
 #include <iostream>
@@ -8,6 +9,8 @@
 #include <vector>
 #include <fstream>
 #include <string>
+#include <algorithm>
+#include "Log.h"
 
 #include <glslang/Include/glslang_c_interface.h>
 
@@ -45,7 +48,7 @@ namespace core {
 			ret = true;
 		}
 		else {
-			fprintf(stderr, "Error opening file %s", pFilename);
+			LOG_ERROR("shader", "Error opening file %s", pFilename);
 			exit(0);
 		}
 		return ret;
@@ -121,17 +124,15 @@ namespace core {
 		glslang_shader_t* shader = glslang_shader_create(&input);
 
 		if (!glslang_shader_preprocess(shader, &input)) {
-			fprintf(stderr, "Couldn compile shader\n");
-			fprintf(stderr, "\n%s", glslang_shader_get_info_log(shader));
-			fprintf(stderr, "\n%s", glslang_shader_get_info_debug_log(shader));
+			LOG_ERROR("shader", "Couldn compile shader\n%s\n%s", glslang_shader_get_info_log(shader),
+				glslang_shader_get_info_debug_log(shader));
 			//PrintShaderSource(input.code);
 			return 0;
 		}
 
 		if (!glslang_shader_parse(shader, &input)) {
-			fprintf(stderr, "Couldn parse shader\n");
-			fprintf(stderr, "\n%s", glslang_shader_get_info_log(shader));
-			fprintf(stderr, "\n%s", glslang_shader_get_info_debug_log(shader));
+			LOG_ERROR("shader", "Couldn parse shader\n%s\n%s", glslang_shader_get_info_log(shader),
+				glslang_shader_get_info_debug_log(shader));
 			//PrintShaderSource(input.code);
 			return 0;
 		}
@@ -140,9 +141,8 @@ namespace core {
 		glslang_program_add_shader(program, shader);
 
 		if (!glslang_program_link(program, GLSLANG_MSG_SPV_RULES_BIT|GLSLANG_MSG_VULKAN_RULES_BIT)) {
-			fprintf(stderr, "Couldn GLSL link\n");
-			fprintf(stderr, "\n%s", glslang_program_get_info_log(program));
-			fprintf(stderr, "\n%s", glslang_program_get_info_debug_log(program));
+			LOG_ERROR("shader", "Couldn GLSL link\n%s\n%s", glslang_program_get_info_log(program),
+				glslang_program_get_info_debug_log(program));
 			//PrintShaderSource(input.code);
 			return 0;
 		}
@@ -155,7 +155,7 @@ namespace core {
 		const char* spirv_messages = glslang_program_SPIRV_get_messages(program);
 
 		if (spirv_messages) {
-			fprintf(stderr, "Spir-v messages: '%s'", spirv_messages);
+			LOG_WARN("shader", "Spir-v messages: '%s'", spirv_messages);
 		}
 
 		VkShaderModuleCreateInfo shaderCreateInfo = {};
@@ -193,6 +193,10 @@ namespace core {
 	}
 
 	VkShaderModule CreateShaderModuleFromText(VkDevice& device, const char* pFilename) {
+		return CreateShaderModuleFromText(device, pFilename, NULL);
+	}
+
+	VkShaderModule CreateShaderModuleFromText(VkDevice& device, const char* pFilename, const char* pDefines) {
 
 		std::string Source;
 
@@ -200,6 +204,24 @@ namespace core {
 			assert(0);
 		}
 
+		// Constantes compartidas con C++: se inyectan en todos los shaders para que no puedan divergir
+		std::string Defines = "#define CLUSTER_TRIANGLES " + std::to_string(MeshClusters::ClusterTriangles) + "u\n";
+
+		// Los #define tienen que ir despues de #version; #line conserva la numeracion de los errores
+		bool variant = pDefines && pDefines[0] != '\0';
+		if (variant) {
+			Defines += pDefines;
+		}
+		size_t version = Source.find("#version");
+		size_t lineEnd = (version == std::string::npos) ? std::string::npos : Source.find('\n', version);
+		if (lineEnd == std::string::npos) {
+			LOG_WARN("shader", "Shader %s has no #version line, defines ignored", pFilename);
+		}
+		else {
+			int versionLine = 1 + (int)std::count(Source.begin(), Source.begin() + lineEnd, '\n');
+			Source.insert(lineEnd + 1, Defines + "#line " + std::to_string(versionLine + 1) + "\n");
+		}
+
 		coreShader ShaderModule;
 
 		glslang_stage_t ShaderStage = ShaderStageFromFilename(pFilename);
@@ -210,10 +232,13 @@ namespace core {
 		bool Success = CompileShader(device, ShaderStage, Source.c_str(), ShaderModule);
 
 		if (Success) {
-			printf("\nCreated shader from text file '%s'\n", pFilename);
+			LOG_DEBUG("shader", "Created shader from text file '%s'", pFilename);
 			m = ShaderModule.ShaderModule;
-			std::string BinaryFilename = std::string(pFilename) + ".spv";
-			WriteBinaryFile(BinaryFilename.c_str(), ShaderModule.SPIRV.data(), (int)ShaderModule.SPIRV.size()*sizeof(uint32_t));
+			// El .spv es siempre el del shader sin defines
+			if (!variant) {
+				std::string BinaryFilename = std::string(pFilename) + ".spv";
+				WriteBinaryFile(BinaryFilename.c_str(), ShaderModule.SPIRV.data(), (int)ShaderModule.SPIRV.size()*sizeof(uint32_t));
+			}
 		}
 		glslang_finalize_process();
 		return m;
@@ -232,7 +257,7 @@ namespace core {
 		VkShaderModule shaderModule;
 		VkResult res = vkCreateShaderModule(device, &shaderCreateInfo, NULL, &shaderModule);
 		CHECK_VK_RESULT(res, "vkCreateShaderModule\n");
-		printf("Created shader from binary %s\n", pFilename);
+		LOG_DEBUG("shader", "Created shader from binary %s", pFilename);
 
 		free(pShaderCode);
 
@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "core/core_simplify.h"
+#include "Trace.h"
+#include "Log.h"
+
+namespace core {
+
+	namespace {
+		// Matriz simetrica 4x4 de la suma de planos (n, d) ponderados por area, w = area acumulada
+		struct Quadric {
+			double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+			double b2 = 0.0, bc = 0.0, bd = 0.0;
+			double c2 = 0.0, cd = 0.0;
+			double d2 = 0.0;
+			double w = 0.0;
+
+			void addPlane(const glm::vec3& n, double d, double weight) {
+				a2 += weight * n.x * n.x; ab += weight * n.x * n.y; ac += weight * n.x * n.z; ad += weight * n.x * d;
+				b2 += weight * n.y * n.y; bc += weight * n.y * n.z; bd += weight * n.y * d;
+				c2 += weight * n.z * n.z; cd += weight * n.z * d;
+				d2 += weight * d * d;
+				w += weight;
+			}
+
+			void add(const Quadric& q) {
+				a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+				b2 += q.b2; bc += q.bc; bd += q.bd;
+				c2 += q.c2; cd += q.cd;
+				d2 += q.d2;
+				w += q.w;
+			}
+
+			// Distancia cuadratica media de p a los planos acumulados
+			double error(const glm::vec3& p) const {
+				if (w <= 0.0) {
+					return 0.0;
+				}
+				double x = p.x, y = p.y, z = p.z;
+				double e = a2 * x * x + b2 * y * y + c2 * z * z + 2.0 * (ab * x * y + ac * x * z + bc * y * z) +
+					2.0 * (ad * x + bd * y + cd * z) + d2;
+				return std::max(e, 0.0) / w;
+			}
+		};
+
+		struct Collapse {
+			float cost;
+			uint32_t from, to;
+		};
+
+		// Copia de inds sin triangulos degenerados ni indices fuera de rango
+		void CleanTriangles(const std::vector<uint32_t>& inds, size_t vertexCount, std::vector<uint32_t>& out) {
+			out.clear();
+			out.reserve(inds.size());
+			for (size_t i = 0; i + 2 < inds.size(); i += 3) {
+				uint32_t a = inds[i], b = inds[i + 1], c = inds[i + 2];
+				if (a >= vertexCount || b >= vertexCount || c >= vertexCount || a == b || b == c || a == c) {
+					continue;
+				}
+				out.push_back(a);
+				out.push_back(b);
+				out.push_back(c);
+			}
+		}
+
+		// Una arista dirigida sin su opuesta es de borde
+		void FindBorderVertices(const std::vector<uint32_t>& tris, std::vector<char>& locked) {
+			std::vector<uint64_t> edges;
+			edges.reserve(tris.size());
+			for (size_t i = 0; i < tris.size(); i += 3) {
+				for (int k = 0; k < 3; k++) {
+					uint64_t a = tris[i + k], b = tris[i + (k + 1) % 3];
+					edges.push_back((a << 32) | b);
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+			for (uint64_t edge : edges) {
+				uint64_t a = edge >> 32, b = edge & 0xffffffffu;
+				if (!std::binary_search(edges.begin(), edges.end(), (b << 32) | a)) {
+					locked[(size_t)a] = 1;
+					locked[(size_t)b] = 1;
+				}
+			}
+		}
+	}
+
+	void MeshSimplifier::BuildLods(const std::vector<glm::vec3>& verts, const std::vector<uint32_t>& inds,
+		std::vector<MeshLod>& lods, float maxError) {
+		TRACE_SCOPE("buildLods", "core");
+		lods.clear();
+		std::vector<uint32_t> tris;
+		CleanTriangles(inds, verts.size(), tris);
+		size_t baseTriangles = tris.size() / 3;
+		if (baseTriangles < MinTriangles) {
+			return;
+		}
+
+		// Posiciones en la caja unidad (dividida por su diagonal): el error sale directamente relativo al tamano
+		glm::vec3 bmin(FLT_MAX), bmax(-FLT_MAX);
+		for (const glm::vec3& v : verts) {
+			bmin = glm::min(bmin, v);
+			bmax = glm::max(bmax, v);
+		}
+		float diagonal = glm::length(bmax - bmin);
+		if (!(diagonal > 0.0f)) {
+			return;
+		}
+		std::vector<glm::vec3> pos(verts.size());
+		for (size_t i = 0; i < verts.size(); i++) {
+			pos[i] = (verts[i] - bmin) / diagonal;
+		}
+
+		std::vector<Quadric> quadrics(verts.size());
+		for (size_t i = 0; i < tris.size(); i += 3) {
+			const glm::vec3& p0 = pos[tris[i]];
+			glm::vec3 n = glm::cross(pos[tris[i + 1]] - p0, pos[tris[i + 2]] - p0);
+			float len = glm::length(n);
+			if (!(len > 0.0f)) {
+				continue;
+			}
+			n = n / len;
+			double d = -(double)glm::dot(n, p0);
+			for (int k = 0; k < 3; k++) {
+				quadrics[tris[i + k]].addPlane(n, d, len * 0.5);
+			}
+		}
+
+		std::vector<char> locked(verts.size(), 0);
+		FindBorderVertices(tris, locked);
+
+		std::vector<uint32_t> remap(verts.size());
+		for (size_t i = 0; i < remap.size(); i++) {
+			remap[i] = (uint32_t)i;
+		}
+
+		double maxErrorSq = (double)maxError * maxError;
+		double reached = 0.0;
+		size_t target = baseTriangles / LodRatio;
+		size_t lastSaved = baseTriangles;
+		std::vector<uint32_t> triOffsets, triList;
+		std::vector<Collapse> collapses;
+		std::vector<char> touched;
+		size_t candidateFactor = 2;
+
+		// Pasadas de colapsos independientes (ningun vertice participa en dos colapsos de la misma pasada)
+		while ((int)lods.size() < MaxLods) {
+			size_t triCount = tris.size() / 3;
+
+			// Triangulos de cada vertice
+			triOffsets.assign(verts.size() + 1, 0);
+			for (uint32_t v : tris) {
+				triOffsets[v + 1]++;
+			}
+			for (size_t i = 0; i < verts.size(); i++) {
+				triOffsets[i + 1] += triOffsets[i];
+			}
+			triList.resize(tris.size());
+			{
+				std::vector<uint32_t> fill(triOffsets.begin(), triOffsets.end() - 1);
+				for (size_t i = 0; i < tris.size(); i++) {
+					triList[fill[tris[i]]++] = (uint32_t)(i / 3);
+				}
+			}
+
+			// Cada arista interior aparece en los dos sentidos: basta con a < b
+			collapses.clear();
+			for (size_t i = 0; i < tris.size(); i += 3) {
+				for (int k = 0; k < 3; k++) {
+					uint32_t a = tris[i + k], b = tris[i + (k + 1) % 3];
+					if (a > b || (locked[a] && locked[b])) {
+						continue;
+					}
+					Quadric q = quadrics[a];
+					q.add(quadrics[b]);
+					double costAB = locked[a] ? DBL_MAX : q.error(pos[b]);
+					double costBA = locked[b] ? DBL_MAX : q.error(pos[a]);
+					if (costAB <= costBA) {
+						collapses.push_back({ (float)costAB, a, b });
+					}
+					else {
+						collapses.push_back({ (float)costBA, b, a });
+					}
+				}
+			}
+			// Cada colapso quita unos dos triangulos: solo se ordenan las candidatas que puede usar esta pasada,
+			// lo que sobre queda para la siguiente
+			size_t removable = triCount > target ? triCount - target : 0;
+			size_t keep = std::max(removable, (size_t)64) * candidateFactor;
+			bool truncated = collapses.size() > keep;
+			auto cheaper = [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; };
+			if (truncated) {
+				std::nth_element(collapses.begin(), collapses.begin() + keep, collapses.end(), cheaper);
+				collapses.resize(keep);
+			}
+			std::sort(collapses.begin(), collapses.end(), cheaper);
+
+			touched.assign(verts.size(), 0);
+			size_t removed = 0, applied = 0;
+			bool errorLimit = false;
+			for (const Collapse& c : collapses) {
+				if (removed >= removable) {
+					break;
+				}
+				if ((double)c.cost > maxErrorSq) {
+					errorLimit = true;
+					break;
+				}
+				if (touched[c.from] || touched[c.to]) {
+					continue;
+				}
+
+				// Sin triangulos que se den la vuelta al mover from sobre to
+				bool flips = false;
+				size_t dying = 0;
+				for (uint32_t k = triOffsets[c.from]; k < triOffsets[c.from + 1] && !flips; k++) {
+					const uint32_t* t = &tris[(size_t)triList[k] * 3];
+					if (t[0] == c.to || t[1] == c.to || t[2] == c.to) {
+						dying++;
+						continue;
+					}
+					glm::vec3 p[3], q[3];
+					for (int j = 0; j < 3; j++) {
+						p[j] = pos[t[j]];
+						q[j] = (t[j] == c.from) ? pos[c.to] : p[j];
+					}
+					glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+					glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+					flips = glm::dot(before, after) <= 0.0f;
+				}
+				if (flips) {
+					continue;
+				}
+
+				// El anillo de from queda fuera del resto de la pasada: su adyacencia ya no es valida
+				for (uint32_t k = triOffsets[c.from]; k < triOffsets[c.from + 1]; k++) {
+					const uint32_t* t = &tris[(size_t)triList[k] * 3];
+					touched[t[0]] = touched[t[1]] = touched[t[2]] = 1;
+				}
+				remap[c.from] = c.to;
+				quadrics[c.to].add(quadrics[c.from]);
+				reached = std::max(reached, (double)c.cost);
+				removed += dying;
+				applied++;
+			}
+
+			if (applied > 0) {
+				for (uint32_t& v : tris) {
+					v = remap[v];
+				}
+				std::vector<uint32_t> kept;
+				CleanTriangles(tris, verts.size(), kept);
+				tris.swap(kept);
+			}
+
+			// Todas las candidatas elegidas daban la vuelta a algun triangulo: la siguiente pasada mira mas
+			if (applied == 0 && truncated && !errorLimit) {
+				candidateFactor *= 2;
+				continue;
+			}
+			candidateFactor = 2;
+			triCount = tris.size() / 3;
+			bool stalled = applied == 0 || errorLimit || triCount == 0;
+			if (triCount == 0) {
+				break;
+			}
+			if (triCount <= target || (stalled && triCount * 4 < lastSaved * 3)) {
+				MeshLod lod;
+				lod.inds = tris;
+				lod.error = (float)std::sqrt(reached);
+				lods.push_back(std::move(lod));
+				lastSaved = triCount;
+				target = triCount / LodRatio;
+			}
+			if (stalled) {
+				break;
+			}
+		}
+
+		for (size_t i = 0; i < lods.size(); i++) {
+			LOG_DEBUG("core", "LOD %zu: %zu -> %zu triangles, error %.5f", i + 1, baseTriangles, lods[i].inds.size() / 3,
+				lods[i].error);
+		}
+	}
+}
@@ -0,0 +1,357 @@
+#include <stdio.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "core/core_soft_rt.h"
+#include "Log.h"
+
+namespace core {
+
+	static const int s_maxDepth = 2;				// MAX_DEPTH de raytrace.rchit
+	static const glm::vec3 s_missColor(0.7f, 0.1f, 0.3f);	// raytrace.rmiss
+
+	void SoftwareRaytracer::init(VulkanCore* core, VkShaderModule compModule) {
+		m_vkcore = core;
+		m_device = core->GetDevice();
+
+		CreateDescriptorSet();
+		CreatePipeline(compModule);
+		LOG_DEBUG("core", "Software raytracer created");
+	}
+
+	void SoftwareRaytracer::CreateDescriptorSet() {
+		// 0-2: nodos, triangulos y materiales; 3-6: salida, acumulacion, guia y posicion
+		VkDescriptorPoolSize poolSizes[2] = {};
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSizes[0].descriptorCount = 3;
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		poolSizes[1].descriptorCount = 4;
+
+		VkDescriptorPoolCreateInfo PoolInfo = {};
+		PoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		PoolInfo.flags = 0;
+		PoolInfo.maxSets = 1;
+		PoolInfo.poolSizeCount = 2;
+		PoolInfo.pPoolSizes = poolSizes;
+
+		VkResult res = vkCreateDescriptorPool(m_device, &PoolInfo, NULL, &m_descPool);
+		CHECK_VK_RESULT(res, "vkCreateDescriptorPool");
+
+		std::vector<VkDescriptorSetLayoutBinding> LayoutBindings;
+		for (uint32_t i = 0; i < 7; i++) {
+			VkDescriptorSetLayoutBinding binding = {};
+			binding.binding = i;
+			binding.descriptorType = (i < 3) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			binding.descriptorCount = 1;
+			binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			LayoutBindings.push_back(binding);
+		}
+
+		VkDescriptorSetLayoutCreateInfo LayoutInfo = {};
+		LayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		LayoutInfo.bindingCount = (uint32_t)LayoutBindings.size();
+		LayoutInfo.pBindings = LayoutBindings.data();
+
+		res = vkCreateDescriptorSetLayout(m_device, &LayoutInfo, NULL, &m_descSetLayout);
+		CHECK_VK_RESULT(res, "vkCreateDescriptorSetLayout\n");
+
+		VkDescriptorSetAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+		allocateInfo.descriptorPool = m_descPool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &m_descSetLayout;
+		res = vkAllocateDescriptorSets(m_device, &allocateInfo, &m_descSet);
+		CHECK_VK_RESULT(res, "vkAllocateDescriptorSets");
+	}
+
+	void SoftwareRaytracer::CreatePipeline(VkShaderModule compModule) {
+		VkPushConstantRange pushRange{};
+		pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushRange.offset = 0;
+		pushRange.size = sizeof(SoftRtPushConstants);
+
+		VkPipelineLayoutCreateInfo layoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+		layoutInfo.setLayoutCount = 1;
+		layoutInfo.pSetLayouts = &m_descSetLayout;
+		layoutInfo.pushConstantRangeCount = 1;
+		layoutInfo.pPushConstantRanges = &pushRange;
+
+		VkResult res = vkCreatePipelineLayout(m_device, &layoutInfo, nullptr, &m_pipelineLayout);
+		CHECK_VK_RESULT(res, "vkCreatePipelineLayout");
+
+		VkPipelineShaderStageCreateInfo stage{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+		stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		stage.module = compModule;
+		stage.pName = "main";
+
+		VkComputePipelineCreateInfo pipelineInfo{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+		pipelineInfo.stage = stage;
+		pipelineInfo.layout = m_pipelineLayout;
+
+		res = vkCreateComputePipelines(m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline);
+		CHECK_VK_RESULT(res, "vkCreateComputePipelines");
+	}
+
+	// Buffer de solo lectura en memoria del dispositivo, subido con un staging buffer
+	BufferMemory SoftwareRaytracer::CreateStorageBuffer(const void* pData, size_t size, MemoryCategory category) {
+		BufferMemory Staging = m_vkcore->CreateBufferACC(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Staging);
+		Staging.Update(m_device, pData, size);
+
+		BufferMemory Buf = m_vkcore->CreateBufferACC(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, category);
+		m_vkcore->CopyBufferToBuffer(Buf.m_buffer, Staging.m_buffer, size);
+
+		Staging.Destroy(m_device);
+		return Buf;
+	}
+
+	void SoftwareRaytracer::updateScene(const std::vector<SimpleMesh>& meshes) {
+		if (m_device == VK_NULL_HANDLE) {
+			return;
+		}
+		// Los buffers pueden estar en uso por el frame anterior
+		vkDeviceWaitIdle(m_device);
+		DestroySceneBuffers();
+
+		m_bvh.build(meshes);
+		if (m_bvh.empty()) {
+			return;
+		}
+
+		const std::vector<BvhNode>& nodes = m_bvh.getNodes();
+		const std::vector<BvhTriangle>& triangles = m_bvh.getTriangles();
+		const std::vector<BvhMeshInfo>& meshInfos = m_bvh.getMeshInfos();
+		// Los nodos hacen de estructura de aceleracion; los triangulos ya transformados y los datos por malla son geometria
+		m_nodeBuffer = CreateStorageBuffer(nodes.data(), nodes.size() * sizeof(BvhNode), MemoryCategory::AccelerationStructure);
+		m_triangleBuffer = CreateStorageBuffer(triangles.data(), triangles.size() * sizeof(BvhTriangle), MemoryCategory::Geometry);
+		m_meshInfoBuffer = CreateStorageBuffer(meshInfos.data(), meshInfos.size() * sizeof(BvhMeshInfo), MemoryCategory::Geometry);
+
+		WriteSceneBuffers();
+	}
+
+	void SoftwareRaytracer::WriteSceneBuffers() {
+		VkDescriptorBufferInfo BufferInfos[3] = {};
+		BufferMemory* buffers[3] = { &m_nodeBuffer, &m_triangleBuffer, &m_meshInfoBuffer };
+
+		std::vector<VkWriteDescriptorSet> WriteDescriptorSet;
+		for (uint32_t b = 0; b < 3; b++) {
+			BufferInfos[b].buffer = buffers[b]->m_buffer;
+			BufferInfos[b].offset = 0;
+			BufferInfos[b].range = VK_WHOLE_SIZE;
+
+			VkWriteDescriptorSet wds = {};
+			wds.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			wds.dstSet = m_descSet;
+			wds.dstBinding = b;
+			wds.dstArrayElement = 0;
+			wds.descriptorCount = 1;
+			wds.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			wds.pBufferInfo = &BufferInfos[b];
+			WriteDescriptorSet.push_back(wds);
+		}
+
+		vkUpdateDescriptorSets(m_device, (uint32_t)WriteDescriptorSet.size(), WriteDescriptorSet.data(), 0, NULL);
+	}
+
+	void SoftwareRaytracer::setImages(const SoftRtImages& images) {
+		if (m_descSet == VK_NULL_HANDLE) {
+			return;
+		}
+		m_images = images;
+
+		VulkanTexture* textures[4] = { images.out, images.accum, images.guide, images.position };
+
+		VkDescriptorImageInfo ImageInfos[4] = {};
+		std::vector<VkWriteDescriptorSet> WriteDescriptorSet;
+		for (uint32_t i = 0; i < 4; i++) {
+			ImageInfos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			ImageInfos[i].imageView = textures[i]->m_view;
+			ImageInfos[i].sampler = NULL;
+
+			VkWriteDescriptorSet wds = {};
+			wds.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			wds.dstSet = m_descSet;
+			wds.dstBinding = 3 + i;
+			wds.dstArrayElement = 0;
+			wds.descriptorCount = 1;
+			wds.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			wds.pImageInfo = &ImageInfos[i];
+			WriteDescriptorSet.push_back(wds);
+		}
+
+		vkUpdateDescriptorSets(m_device, (uint32_t)WriteDescriptorSet.size(), WriteDescriptorSet.data(), 0, NULL);
+	}
+
+	/*
+	* Graba el trazado con las mismas transiciones que Raytracer::raytrace: salida, guia y posicion se reescriben enteras,
+	* la acumulacion solo se descarta en el frame 0. Deja todas las imagenes en GENERAL
+	*/
+	void SoftwareRaytracer::trace(VkCommandBuffer cmdBuf, int width, int height, const glm::mat4& invViewProj, uint32_t frameIndex, uint32_t seed) {
+		if (!isReady() || !hasScene() || m_images.out == nullptr) {
+			return;
+		}
+
+		VkImageMemoryBarrier barriers[4] = {};
+		barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barriers[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barriers[0].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barriers[0].srcAccessMask = 0;
+		barriers[0].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barriers[0].image = m_images.out->m_image;
+		barriers[0].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		barriers[1] = barriers[0];
+		barriers[1].image = m_images.guide->m_image;
+		barriers[2] = barriers[0];
+		barriers[2].image = m_images.position->m_image;
+
+		barriers[3] = barriers[0];
+		barriers[3].oldLayout = (frameIndex == 0) ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_GENERAL;
+		barriers[3].srcAccessMask = (frameIndex == 0) ? 0 : VK_ACCESS_SHADER_WRITE_BIT;
+		barriers[3].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		barriers[3].image = m_images.accum->m_image;
+
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, 4, barriers);
+
+		vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+		vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &m_descSet, 0, nullptr);
+
+		SoftRtPushConstants pc = {};
+		pc.invViewProj = invViewProj;
+		pc.boundsMin = glm::vec4(m_bvh.getBoundsMin(), 0.0f);
+		pc.quantScale = glm::vec4(m_bvh.getQuantScale(), 0.0f);
+		pc.frameIndex = frameIndex;
+		pc.seed = seed;
+		pc.width = (uint32_t)width;
+		pc.height = (uint32_t)height;
+		vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SoftRtPushConstants), &pc);
+
+		vkCmdDispatch(cmdBuf, (uint32_t)(width + 7) / 8, (uint32_t)(height + 7) / 8, 1);
+
+		VkMemoryBarrier memoryBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+	}
+
+#pragma region CPU
+
+	// Mismo sombreado que raytrace.rchit/rmiss desenrollado en un bucle; guide = normal y distancia del primer impacto
+	glm::vec3 SoftwareRaytracer::ShadeCPU(const glm::vec3& origin, const glm::vec3& dir, glm::vec4& guide) const {
+		const std::vector<BvhTriangle>& triangles = m_bvh.getTriangles();
+		const std::vector<BvhMeshInfo>& meshInfos = m_bvh.getMeshInfos();
+
+		guide = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+		glm::vec3 baseColor = s_missColor;
+		glm::vec3 o = origin, d = dir;
+		float tmax = 10000.0f;
+
+		for (int depth = 0; depth <= s_maxDepth; depth++) {
+			BvhHit hit;
+			if (!m_bvh.intersect(o, d, 0.001f, tmax, hit)) {
+				break;
+			}
+			const BvhTriangle& tri = triangles[hit.triangle];
+			uint32_t meshIndex = (uint32_t)tri.v0.w;
+			glm::vec3 v0(tri.v0), v1(tri.v1), v2(tri.v2);
+			glm::vec3 bary(1.0f - hit.u - hit.v, hit.u, hit.v);
+
+			glm::vec3 geometricNormal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
+			glm::vec3 interpolatedNormal = glm::normalize(glm::vec3(tri.n0) * bary.x + glm::vec3(tri.n1) * bary.y + glm::vec3(tri.n2) * bary.z);
+			glm::vec3 hitPosition = v0 * bary.x + v1 * bary.y + v2 * bary.z;
+
+			glm::vec3 finalNormal = geometricNormal;
+			float similarity = glm::dot(geometricNormal, interpolatedNormal);
+			if (std::fabs(similarity) > 0.5f) {
+				finalNormal = (similarity < 0.0f) ? -interpolatedNormal : interpolatedNormal;
+			}
+			if (glm::dot(finalNormal, -d) < 0.0f) {
+				finalNormal = -finalNormal;
+			}
+			finalNormal = glm::normalize(finalNormal);
+
+			if (depth == 0) {
+				guide = glm::vec4(finalNormal, hit.t);
+			}
+
+			// Una mesh texturizada corta la cadena y su color sube hasta el rayo primario
+			const BvhMeshInfo& info = meshInfos[meshIndex];
+			if (info.texIndex >= 0) {
+				return glm::vec3(info.color);
+			}
+			// Si ningun rebote llega a una mesh texturizada se queda el color del primer impacto
+			if (depth == 0) {
+				baseColor = glm::vec3(info.color) * std::max(0.0f, glm::dot(finalNormal, -glm::normalize(d)));
+			}
+
+			o = hitPosition;
+			d = glm::reflect(d, interpolatedNormal);
+			tmax = 1000.0f;
+		}
+		return baseColor;
+	}
+
+	void SoftwareRaytracer::traceCPU(const glm::mat4& invViewProj, int width, int height, std::vector<uint8_t>& rgba) const {
+		rgba.assign((size_t)width * height * 4, 0);
+		glm::vec4 origin = invViewProj * glm::vec4(0, 0, 2, 1);
+
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				glm::vec2 uv = (glm::vec2((float)x, (float)y) + 0.5f) / glm::vec2((float)width, (float)height);
+				glm::vec2 d = uv * 2.0f - 1.0f;
+				glm::vec4 target = invViewProj * glm::vec4(d.x, d.y, 0, 1);
+				glm::vec3 direction = glm::normalize(glm::vec3(target) - glm::vec3(origin));
+
+				glm::vec4 guide;
+				glm::vec3 color = ShadeCPU(glm::vec3(origin), direction, guide);
+
+				size_t i = ((size_t)y * width + x) * 4;
+				for (int c = 0; c < 3; c++) {
+					rgba[i + c] = (uint8_t)(glm::clamp(color[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+				}
+				rgba[i + 3] = 255;
+			}
+		}
+	}
+
+#pragma endregion
+
+	void SoftwareRaytracer::DestroySceneBuffers() {
+		BufferMemory* buffers[3] = { &m_nodeBuffer, &m_triangleBuffer, &m_meshInfoBuffer };
+		for (BufferMemory* buf : buffers) {
+			if (buf->m_buffer != VK_NULL_HANDLE) {
+				buf->Destroy(m_device);
+			}
+			*buf = BufferMemory();
+		}
+	}
+
+	void SoftwareRaytracer::cleanup() {
+		if (m_device == VK_NULL_HANDLE) {
+			return;
+		}
+		DestroySceneBuffers();
+		if (m_pipeline != VK_NULL_HANDLE) {
+			vkDestroyPipeline(m_device, m_pipeline, nullptr);
+			m_pipeline = VK_NULL_HANDLE;
+		}
+		if (m_pipelineLayout != VK_NULL_HANDLE) {
+			vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+			m_pipelineLayout = VK_NULL_HANDLE;
+		}
+		if (m_descPool != VK_NULL_HANDLE) {
+			vkDestroyDescriptorPool(m_device, m_descPool, nullptr);
+			m_descPool = VK_NULL_HANDLE;
+		}
+		if (m_descSetLayout != VK_NULL_HANDLE) {
+			vkDestroyDescriptorSetLayout(m_device, m_descSetLayout, nullptr);
+			m_descSetLayout = VK_NULL_HANDLE;
+		}
+		m_descSet = VK_NULL_HANDLE;
+		m_images = SoftRtImages();
+		m_device = VK_NULL_HANDLE;
+	}
+}
@@ -1,5 +1,6 @@
 
 #include "core/core_wrapper.h"
+#include "Log.h"
 
 namespace core {
 	void BeginCommandBuffer(VkCommandBuffer CommandBuffer, VkCommandBufferUsageFlags UsageFlags) {
@@ -201,7 +202,7 @@ namespace core {
 			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 		}
 		else {
-			printf("Unknown barrier case\n");
+			LOG_WARN("core", "Unknown barrier case");
 			exit(1);
 		}
 
@@ -209,7 +210,8 @@ namespace core {
 			0, 0, NULL, 0, NULL, 1, &barrier);
 	}
 
-	VkImageView CreateImageView(VkDevice Device, VkImage Image, VkFormat Format, VkImageAspectFlags AspectFlags) {
+	VkImageView CreateImageView(VkDevice Device, VkImage Image, VkFormat Format, VkImageAspectFlags AspectFlags,
+		VkImageViewType ViewType, uint32_t LayerCount) {
 
 		VkComponentMapping comps = {};
 		comps.r = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -222,7 +224,7 @@ namespace core {
 		SubresourceRange.baseMipLevel = 0;
 		SubresourceRange.levelCount = 1;
 		SubresourceRange.baseArrayLayer = 0;
-		SubresourceRange.layerCount = 1;
+		SubresourceRange.layerCount = LayerCount;
 
 
 		VkImageViewCreateInfo ViewInfo = {};
@@ -230,7 +232,7 @@ namespace core {
 		ViewInfo.pNext = NULL;
 		ViewInfo.flags = 0;
 		ViewInfo.image = Image;
-		ViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		ViewInfo.viewType = ViewType;
 		ViewInfo.format = Format;
 		ViewInfo.components = comps;
 		ViewInfo.subresourceRange = SubresourceRange;
@@ -7,6 +7,8 @@
 #include <cassert>
 #include "core/utils.h"
 #include <string>
+#include <cstring>
+#include "Log.h"
 
 namespace core {
 
@@ -21,28 +23,49 @@ namespace core {
 	static void PrintImageUsageFlags(const VkImageUsageFlags& flags) {
 
 		if (flags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) {
-			printf("Image usage transfer src is supported\n");
+			LOG_DEBUG("core", "Image usage transfer src is supported");
 		}
 		if (flags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) {
-			printf("Image usage transfer dst is supported\n");
+			LOG_DEBUG("core", "Image usage transfer dst is supported");
 		}
 		if (flags & VK_IMAGE_USAGE_SAMPLED_BIT) {
-			printf("Image usage sampled is supported\n");
+			LOG_DEBUG("core", "Image usage sampled is supported");
 		}
 		if (flags & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) {
-			printf("Image usage color attachment is supported\n");
+			LOG_DEBUG("core", "Image usage color attachment is supported");
 		}
 		if (flags & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) {
-			printf("Image usage depth stencil attachment is supported\n");
+			LOG_DEBUG("core", "Image usage depth stencil attachment is supported");
 		}
 		if (flags & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) {
-			printf("Image usage transient attachment is supported\n");
+			LOG_DEBUG("core", "Image usage transient attachment is supported");
 		}
 		if (flags & VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT) {
-			printf("Image usage input attachment is supported\n");
+			LOG_DEBUG("core", "Image usage input attachment is supported");
 		}
 	}
 
+	static bool SupportsExtensions(VkPhysicalDevice Device, const std::vector<const char*>& Required) {
+		uint32_t NumExts = 0;
+		vkEnumerateDeviceExtensionProperties(Device, NULL, &NumExts, NULL);
+		std::vector<VkExtensionProperties> Exts(NumExts);
+		vkEnumerateDeviceExtensionProperties(Device, NULL, &NumExts, Exts.data());
+
+		for (const char* pName : Required) {
+			bool found = false;
+			for (const VkExtensionProperties& Ext : Exts) {
+				if (strcmp(Ext.extensionName, pName) == 0) {
+					found = true;
+					break;
+				}
+			}
+			if (!found) {
+				return false;
+			}
+		}
+		return true;
+	}
+
 	static VkFormat FindDepthFormat(VkPhysicalDevice Device) {
 
 		std::vector<VkFormat> Candidates = { VK_FORMAT_D32_SFLOAT,
@@ -61,7 +84,7 @@ namespace core {
 		VkResult res = vkEnumeratePhysicalDevices(Instance, &NumDevices, NULL);
 		CHECK_VK_RESULT(res, "vkEnumeratePhysicalDevices Error (1)\n");
 
-		printf("Num phyisical devices %d\n\n", NumDevices);
+		LOG_INFO("core", "Num phyisical devices %d", NumDevices);
 
 		m_devices.resize(NumDevices);
 
@@ -77,9 +100,9 @@ namespace core {
 
 			vkGetPhysicalDeviceProperties(PhysDev, &m_devices[i].m_devProps);
 			
-			printf("Device name: %s\n", m_devices[i].m_devProps.deviceName);
+			LOG_INFO("core", "Device name: %s", m_devices[i].m_devProps.deviceName);
 			uint32_t apiVer = m_devices[i].m_devProps.apiVersion;
-			printf("	API version: %d.%d.%d.%d\n",
+			LOG_INFO("core", "	API version: %d.%d.%d.%d",
 				VK_API_VERSION_VARIANT(apiVer),
 				VK_API_VERSION_MAJOR(apiVer),
 				VK_API_VERSION_MINOR(apiVer),
@@ -88,7 +111,7 @@ namespace core {
 
 			uint32_t NumQFamilies = 0;
 			vkGetPhysicalDeviceQueueFamilyProperties(PhysDev, &NumQFamilies, NULL);
-			printf("	Num of family queues: %d\n", NumQFamilies);
+			LOG_DEBUG("core", "	Num of family queues: %d", NumQFamilies);
 
 			m_devices[i].m_qFamilyProps.resize(NumQFamilies);
 			m_devices[i].m_qSupportsPresent.resize(NumQFamilies);
@@ -98,16 +121,13 @@ namespace core {
 			for (uint32_t q = 0; q < NumQFamilies; q++) {
 				VkQueueFamilyProperties& QFamilyProp = m_devices[i].m_qFamilyProps[q];
 				VkQueueFlags flags = QFamilyProp.queueFlags;
-				printf("	GFX %s, Compute %s, Transfer %s, Sparse binding %s\n",
+				LOG_DEBUG("core", "	GFX %s, Compute %s, Transfer %s, Sparse binding %s, Queue Count: %u",
 					(flags & VK_QUEUE_GRAPHICS_BIT) ? "Yes" : "No",
 					(flags & VK_QUEUE_COMPUTE_BIT) ? "Yes" : "No",
 					(flags & VK_QUEUE_TRANSFER_BIT) ? "Yes" : "No",
-					(flags & VK_QUEUE_SPARSE_BINDING_BIT) ? "Yes" : "No"
+					(flags & VK_QUEUE_SPARSE_BINDING_BIT) ? "Yes" : "No",
+					QFamilyProp.queueCount
 				);
-				uint32_t qcount = QFamilyProp.queueCount;
-				printf("		Queue Count: ");
-				printf(std::to_string(qcount).c_str());
-				printf("\n");
 				if (Surface != VK_NULL_HANDLE) {
 					res = vkGetPhysicalDeviceSurfaceSupportKHR(PhysDev, q, Surface, &(m_devices[i].m_qSupportsPresent[q]));
 					CHECK_VK_RESULT(res, "vkGetPhysicalDeviceSurfaceSupportKHR error\n");
@@ -128,7 +148,7 @@ namespace core {
 
 				for (uint32_t j = 0; j < NumFormats; j++) {
 					const VkSurfaceFormatKHR& SurfaceFormat = m_devices[i].m_surfaceFormats[j];
-					printf("	Format %x color space %x\n", SurfaceFormat.format, SurfaceFormat.colorSpace);
+					LOG_DEBUG("core", "	Format %x color space %x", SurfaceFormat.format, SurfaceFormat.colorSpace);
 				}
 
 				res = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(PhysDev, Surface, &(m_devices[i].m_surfaceCaps));
@@ -147,25 +167,31 @@ namespace core {
 				res = vkGetPhysicalDeviceSurfacePresentModesKHR(PhysDev, Surface, &NumPresentModes, m_devices[i].m_presentModes.data());
 				CHECK_VK_RESULT(res, "vkGetPhysicalDeviceSurfacePresentModesKHR error (2)\n");
 
-				printf("Number of presentation modes %d\n", NumPresentModes);
+				LOG_DEBUG("core", "Number of presentation modes %d", NumPresentModes);
 			}
 			vkGetPhysicalDeviceMemoryProperties(PhysDev, &(m_devices[i].m_memProps));
 
-			printf("Num memory types %d\n", m_devices[i].m_memProps.memoryTypeCount);
+			LOG_DEBUG("core", "Num memory types %d", m_devices[i].m_memProps.memoryTypeCount);
 			for (uint32_t j = 0; j < m_devices[i].m_memProps.memoryTypeCount;j++) {
-				printf("%d: flags %x heap %d\t", j,
+				LOG_DEBUG("core", "%d: flags %x heap %d", j,
 					m_devices[i].m_memProps.memoryTypes[j].propertyFlags,
 					m_devices[i].m_memProps.memoryTypes[j].heapIndex);
 
 			}
 			//Falta aqui un metodo para mostrar los queeu types soportados
-			printf("\n");
-			printf("Num heap types %d\n", m_devices[i].m_memProps.memoryHeapCount);
-			printf("\n");
+			LOG_DEBUG("core", "Num heap types %d", m_devices[i].m_memProps.memoryHeapCount);
 
 			vkGetPhysicalDeviceFeatures(m_devices[i].m_physDevice, &m_devices[i].m_features);
 
 			m_devices[i].m_depthFormat = FindDepthFormat(PhysDev);
+
+			m_devices[i].m_rayTracingSupported = SupportsExtensions(PhysDev, { VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
+				VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME, VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME });
+			m_devices[i].m_rayQuerySupported = m_devices[i].m_rayTracingSupported &&
+				SupportsExtensions(PhysDev, { VK_KHR_RAY_QUERY_EXTENSION_NAME });
+			m_devices[i].m_shaderClockSupported = SupportsExtensions(PhysDev, { VK_KHR_SHADER_CLOCK_EXTENSION_NAME });
+			LOG_INFO("core", "	Ray tracing pipeline %s", m_devices[i].m_rayTracingSupported ? "Yes" : "No");
+			LOG_INFO("core", "	Ray query %s", m_devices[i].m_rayQuerySupported ? "Yes" : "No");
 		}
 	}
 
@@ -176,19 +202,19 @@ namespace core {
 				if ((QFamilyProps.queueFlags & RequiredQueueType) && ((bool)m_devices[i].m_qSupportsPresent[j] == SupportsPresent)) {
 					m_devIndex = i;
 					int QueueFamily = j;
-					printf("Using GFX device %d and queue family %d\n", m_devIndex, QueueFamily);
+					LOG_INFO("core", "Using GFX device %d and queue family %d", m_devIndex, QueueFamily);
 					return QueueFamily;
 				}
 			}
 		}
 
-		fprintf(stderr, "Reqwuired queue type %x and supports present %d not found\n", RequiredQueueType, SupportsPresent);
+		LOG_ERROR("core", "Reqwuired queue type %x and supports present %d not found", RequiredQueueType, SupportsPresent);
 		return 0;
 	}
 
 	const PhysicalDevice& VulkanPhysicalDevices::Selected() const {
 		if (m_devIndex < 0){
-			fprintf(stderr, "Physical device not selected \n");
+			LOG_ERROR("core", "Physical device not selected ");
 		}
 		return m_devices[m_devIndex];
 	}
@@ -1,5 +1,6 @@
 #pragma once
 #include "core/utils.h"
+#include "Log.h"
 
 namespace core {
 
@@ -59,7 +60,7 @@ namespace core {
 		case VK_FORMAT_R32G32B32A32_SFLOAT:
 			return 4 * sizeof(float);
 		default:
-			printf("Unknown format %d\n", Format);
+			LOG_WARN("core", "Unknown format %d", Format);
 			exit(1);
 		}
 
@@ -90,7 +91,7 @@ namespace core {
 			}
 		}
 
-		printf("Failed to find supported format!\n");
+		LOG_ERROR("core", "Failed to find supported format!");
 		exit(1);
 	}
 